@@ -0,0 +1,42 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE -R"
+D=$BUILDDIR/cache-dir-option.tmp
+
+rm -rf $D
+mkdir -p $D
+
+${CTAGS} $O -o $D/ref.tags ./src
+
+echo '# empty cache' 1>&2
+${CTAGS} $O --cache-dir=$D/cache --cache-stats -o $D/tags ./src
+if cmp $D/ref.tags $D/tags; then
+	echo same
+fi
+
+echo '# filled cache' 1>&2
+${CTAGS} $O --cache-dir=$D/cache --cache-stats -o $D/tags ./src
+if cmp $D/ref.tags $D/tags; then
+	echo same
+fi
+
+echo '# --filter-terminator after --cache-dir' 1>&2
+${CTAGS} $O --cache-dir=$D/cache --filter-terminator=__END__ --cache-stats -o $D/tags ./src
+if cmp $D/ref.tags $D/tags; then
+	echo same
+fi
+
+echo '# different options' 1>&2
+${CTAGS} $O --cache-dir=$D/cache --cache-stats --fields=+n -o $D/tags ./src
+
+echo '# eviction'
+${CTAGS} $O --cache-dir=$D/cache --cache-size=1k --fields=+K -o $D/tags ./src
+if [ $(find $D/cache -type f -exec cat {} + | wc -c) -le 1024 ]; then
+	echo evicted
+fi
+
+rm -rf $D
+exit 0
@@ -0,0 +1 @@
+struct three { int x; };
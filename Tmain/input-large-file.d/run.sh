@@ -0,0 +1,34 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE --fields=+n"
+
+# An input file larger than 1MiB is mapped into memory instead of being
+# read with stdio. Its size is made a multiple of the page size, and its
+# last line has no newline, so the tag at the end touches the last byte
+# of the mapping.
+big=$BUILDDIR/input-large-file.c
+rm -f $big
+{
+	echo 'int first_var;'
+	awk 'BEGIN { for (i = 0; i < 20000; i++) printf "/* padding line %05d %s */\n", i, "................................"; }'
+	echo 'int last_var;'
+	printf 'int tail_var;'
+} > $big
+size=$(wc -c < $big)
+pad=$(( 8192 - (size + 5) % 8192 ))
+printf ' /*%*s*/' $pad '' >> $big
+echo "# size is multiple of 8192: $(( $(wc -c < $big) % 8192 == 0 ))"
+
+echo '# C'
+${CTAGS} $O -o - $big | sed -e "s|$big|input.c|"
+
+echo '# --mline-regex'
+${CTAGS} $O --language-force=C \
+		 --mline-regex-C='/int (last_var);\nint (tail_var);/\1\2/Q,lastvars/{mgroup=1}' \
+		 -o - $big | sed -e "s|$big|input.c|"
+
+rm -f $big
+exit 0
@@ -0,0 +1,34 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE --language-force=CTagsSelfTest"
+
+. ../utils.sh
+
+# In a debug build, every non-empty input file is mapped into memory.
+# The 'T' line of the CTagsSelfTest parser truncates the input file;
+# reading the pages of the mapping beyond the new end must not kill
+# ctags. The tags of the truncated file are dropped, and the next input
+# file is parsed as usual.
+is_feature_available $CTAGS debug
+
+cd $BUILDDIR
+truncated=input-truncated.ctst
+rm -f $truncated
+{
+	echo 'N'
+	echo 'T'
+	awk 'BEGIN { for (i = 0; i < 4096; i++) printf "padding line %04d ................................\n", i; }'
+	echo 'N'
+} > $truncated
+
+echo 'N' > input-next.ctst
+
+${CTAGS} $O -o - $truncated input-next.ctst
+s=$?
+echo "# size after parsing: $(wc -c < $truncated)"
+
+rm -f $truncated input-next.ctst
+exit $s
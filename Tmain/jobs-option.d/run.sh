@@ -0,0 +1,23 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE --pseudo-tags=+TAG_KIND_DESCRIPTION"
+
+for s in yes foldcase no; do
+	echo "# --sort=$s"
+	${CTAGS} $O --sort=$s --jobs=1 -R -o - ./src > $BUILDDIR/jobs-1.tags
+	${CTAGS} $O --sort=$s --jobs=3 -R -o - ./src > $BUILDDIR/jobs-3.tags
+	if cmp $BUILDDIR/jobs-1.tags $BUILDDIR/jobs-3.tags; then
+		echo same
+	fi
+	rm -f $BUILDDIR/jobs-1.tags $BUILDDIR/jobs-3.tags
+done
+
+echo '# --sort=no --jobs=8'
+${CTAGS} $O --sort=no --jobs=8 -o - ./src/sub/c.c ./src/a.c ./src/sub/d.sh
+
+echo '# --jobs=0'
+${CTAGS} $O --jobs=0 ./src/a.c
+exit 0
@@ -0,0 +1,3 @@
+int alpha;
+static void beta (void) { }
+struct gamma { int delta; };
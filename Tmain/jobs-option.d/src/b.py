@@ -0,0 +1,5 @@
+class Epsilon:
+    def zeta(self):
+        pass
+def eta():
+    pass
@@ -0,0 +1,2 @@
+#define THETA 1
+int iota (int kappa) { return kappa; }
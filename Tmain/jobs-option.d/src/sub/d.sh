@@ -0,0 +1,2 @@
+lambda() { :; }
+mu=1
@@ -0,0 +1,13 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+O="--quiet --options=NONE"
+
+# a.robot ends in a Keywords section, and c.sml in an unterminated
+# comment. Neither may change the tags of the next file, whichever
+# worker parses it.
+for j in 1 2; do
+	echo "# --jobs=$j"
+	${CTAGS} $O --jobs=$j -o - ./src/a.robot ./src/b.robot ./src/c.sml ./src/d.sml
+done
@@ -0,0 +1,11 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+
+# Keywords are looked up in a table of each language. The words used as
+# keywords in one language are names in another, keywords are matched
+# regardless of case in SQL, Fortran and VHDL, and JavaScript has
+# keywords that differ from others only in case.
+${CTAGS} --quiet --options=NONE --fields=+nK -o - \
+		 src/input.js src/input.sql src/input.f90 src/input.vhd
@@ -0,0 +1,10 @@
+MODULE m1
+  INTEGER :: table = 1
+Contains
+  Subroutine s1 (function)
+    integer, Intent(In) :: function
+  End Subroutine s1
+  integer FUNCTION f1 ()
+    f1 = 0
+  end function f1
+END module m1
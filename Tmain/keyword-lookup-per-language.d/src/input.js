@@ -0,0 +1,6 @@
+var f1 = function (a) { return a; };
+var f2 = new Function ("a", "return a");
+var o1 = new Object ();
+var o2 = { module: 1, TABLE: 2 };
+function FUNCTION () { }
+function Function2 () { }
@@ -0,0 +1,10 @@
+CrEaTe TaBlE t1 (id int, module int);
+create table T2 (Function int);
+CREATE OR REPLACE FUNCTION f1 RETURN number IS
+BEGIN
+  RETURN 1;
+END;
+Create Or Replace Procedure p1 Is
+Begin
+  Null;
+End;
@@ -0,0 +1,7 @@
+ENTITY e1 IS
+END ENTITY e1;
+architecture A1 Of e1 Is
+  SIGNAL s1 : Integer;
+  Constant c1 : integer := 0;
+BeGiN
+End Architecture A1;
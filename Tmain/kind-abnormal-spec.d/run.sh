@@ -5,11 +5,11 @@ CTAGS=$1
 O="--quiet --options=NONE"
 
 echo '# list kinds'
-${CTAGS} ${O} --languages=+CTagsSelfTest --list-kinds=CTagsSelfTest | tr '\0' '_' | grep -v seccomp
+${CTAGS} ${O} --languages=+CTagsSelfTest --list-kinds=CTagsSelfTest | tr '\0' '_' | grep -v -e seccomp -e 'truncate the input file'
 echo
 
 echo '# list kinds-full'
-${CTAGS} ${O} --languages=+CTagsSelfTest --list-kinds-full=CTagsSelfTest | tr '\0' '_' | grep -v seccomp
+${CTAGS} ${O} --languages=+CTagsSelfTest --list-kinds-full=CTagsSelfTest | tr '\0' '_' | grep -v -e seccomp -e 'truncate the input file'
 echo
 
 echo '# +K'
@@ -0,0 +1 @@
+int f = 1;
@@ -0,0 +1 @@
+int g = 1;
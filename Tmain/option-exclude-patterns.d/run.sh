@@ -0,0 +1,29 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS="$1"
+
+echo '# literal, suffix, and glob patterns'
+${CTAGS} --quiet --options=NONE -o - -R \
+		 --exclude=gen --exclude='*.h' --exclude='*.tab.c' --exclude='[g].c' \
+		 input.d
+
+echo '# exception'
+${CTAGS} --quiet --options=NONE -o - -R \
+		 --exclude='*.h' --exclude-exception=keep.h \
+		 input.d
+
+echo '# resetting the patterns'
+${CTAGS} --quiet --options=NONE -o - -R \
+		 --exclude=gen --exclude= --exclude='*.c' \
+		 input.d
+
+echo '# names shorter than the longest suffix'
+(cd input.d &&
+	 ${CTAGS} --quiet --options=NONE -o - \
+			  --exclude='*.c' --exclude='*.tab.c' \
+			  a.c b.h g.c f.tab.c)
+(cd input.d &&
+	 ${CTAGS} --quiet --options=NONE -o - \
+			  --exclude='*.h' --exclude='*.tab.c' --exclude-exception='k*' \
+			  a.c b.h keep.h)
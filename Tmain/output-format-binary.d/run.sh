@@ -0,0 +1,53 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+O="--quiet --options=NONE --fields=* --extras=+pfqr"
+
+. ../utils.sh
+
+skip_if_no_readtags "$READTAGS"
+
+TEXT=$BUILDDIR/output-format-binary.tags
+BIN=$BUILDDIR/output-format-binary.bin
+
+lookup()
+{
+	${READTAGS} -t $1 -D
+	${READTAGS} -t $1 -e -n -l
+	for n in main point Point POINT max_points x X nothing; do
+		echo ";; $n"
+		${READTAGS} -t $1 -e -n - $n
+		${READTAGS} -t $1 -e -n -i - $n
+		${READTAGS} -t $1 -e -n -p - $n
+		${READTAGS} -t $1 -e -n -i -p - $n
+	done
+}
+
+# Reading the tag file in the binary format must give the same
+# result as reading the tag file in the u-ctags format.
+for s in yes foldcase no; do
+	echo "# --sort=$s"
+	${CTAGS} $O --sort=$s -o $TEXT src/a.c src/b.c
+	${CTAGS} $O --sort=$s --output-format=binary -o $BIN src/a.c src/b.c
+	head -c 8 $BIN
+	echo
+	lookup $TEXT > $BUILDDIR/output-format-binary-0.txt
+	lookup $BIN > $BUILDDIR/output-format-binary-1.txt
+	if cmp $BUILDDIR/output-format-binary-0.txt $BUILDDIR/output-format-binary-1.txt; then
+		echo same
+	fi
+	rm -f $BUILDDIR/output-format-binary-0.txt $BUILDDIR/output-format-binary-1.txt
+done
+rm -f $TEXT $BIN
+
+echo '# -o -'
+${CTAGS} $O --output-format=binary -o - src/a.c
+echo '# -a'
+${CTAGS} $O --output-format=binary -a -o $BIN src/a.c
+echo '# --tag-index'
+${CTAGS} $O --output-format=binary --tag-index -o $BIN src/a.c
+rm -f $BIN
+exit 0
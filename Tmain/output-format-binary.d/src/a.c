@@ -0,0 +1,5 @@
+int main (void) { return 0; }
+struct Point { int x; int y; };
+static int point;
+static void POINT_reset (void) { }
+#define MAX_POINTS 16
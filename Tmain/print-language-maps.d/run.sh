@@ -0,0 +1,36 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE"
+
+# The language maps are looked up with hash tables of extensions,
+# literal patterns, and "*SUFFIX" patterns; other patterns are matched
+# with fnmatch(). The tables must follow --langmap and --map-<LANG>.
+d=$BUILDDIR/print-language-maps.tmp
+rm -rf $d
+mkdir -p $d
+for f in x.c x.C x.h x.H x.foo x.lds.S x.S x.s x.29k x.29K x.68k x.X68 x.x68 \
+		 x.A51 x.a51 x.abc x.adoc x.tar.gz x. .c \
+		 Makefile makefile MAKEFILE GNUmakefile Makefile.am x.mak \
+		 Kconfig Kconfig.debug CMakeLists.txt x.cmake vimrc .vimrc _vimrc \
+		 configure.ac configure.in meson.build pom.xml; do
+	: > $d/$f
+done
+
+print_language()
+{
+	echo "# ${*:-default}"
+	(cd $d; ls -A | LC_ALL=C sort | xargs ${CTAGS} $O "$@" --print-language)
+}
+
+print_language
+print_language --langmap=C:+.foo
+print_language --langmap=C:.h --map-C++=+.foo
+print_language --map-C++=+'(*.lds.S)' --map-Asm=-'(*.29[kK])'
+print_language --langmap=Make:'(GNUmakefile)' --map-Sh=+'([Mm]akefile)'
+print_language --map-Vim=-'(vimrc)' --map-Vim=-'([._]vimrc)' --map-Abc=+'(x.S)'
+
+rm -rf $d
+exit 0
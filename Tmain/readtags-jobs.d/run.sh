@@ -0,0 +1,60 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+BUILDDIR=$2
+READTAGS=$3
+
+. ../utils.sh
+
+skip_if_no_readtags "$READTAGS"
+
+O0=$BUILDDIR/readtags-jobs-0.txt
+O1=$BUILDDIR/readtags-jobs-1.txt
+S='(<or> (<> $input &input) (<> $line &line) (<> $name &name))'
+
+# Run readtags with and without -j, and compare the outputs.
+compare ()
+{
+	msg=$1
+	shift
+	${READTAGS} -t output.tags "$@" > $O0 &&
+	for j in 2 3 16; do
+		${READTAGS} -t output.tags -j $j "$@" > $O1 &&
+		if ! cmp $O0 $O1; then
+			echo "$msg: differ with -j $j"
+			return
+		fi
+	done
+	echo "$msg: same"
+}
+
+compare '!_LIST' -ne -l
+compare '!_LIST with filtering' -ne -Q '(eq? $kind "member")' -l
+compare '!_LIST with sorting' -ne -S "$S" -l
+compare '!_LIST with sorting with temporary files' -ne -S "$S" --sort-memory 1k -l
+compare '!_LIST with pseudo tags' -P -S '(<> $name &name)' -l
+compare '!_LIMIT' -ne -L 3 -l
+compare '!_LIMIT with sorting' -ne -S "$S" -L 3 -l
+compare '!_FIND in unsorted' -ne -s0 -p a
+compare '!_FIND in unsorted with ignoring case' -ne -s0 -i -p A
+compare '!_FIND in sorted' -ne -p a
+
+echo '!_TEMPORARY_FILES'
+D=$BUILDDIR/readtags-jobs.tmp
+rm -rf $D
+mkdir -p $D
+TMPDIR=$D ${READTAGS} -t output.tags -j 2 -ne -S "$S" --sort-memory 1k -l > /dev/null
+echo "temporary files left: $(ls $D | wc -l)"
+rm -rf $D
+
+echo '!_ERROR_IN_FILTER'
+${READTAGS} -t output.tags -j 4 -Q '(eq? $no-such-field "x")' -l > /dev/null 2> $O1
+echo $?
+cat $O1
+echo '!_INVALID_JOBS'
+${READTAGS} -t output.tags -j 0 -l 2>&1 | sed 's|.*\(readtags[^:]*\):|readtags:|'
+
+rm -f $O0 $O1
+exit 0
@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+READTAGS=$3
+
+. ../utils.sh
+
+#V="valgrind --leak-check=full -v"
+V=
+
+skip_if_no_readtags "$READTAGS"
+
+echo '# regex on a part of a field'
+${V} ${READTAGS} -e -t output.tags \
+	 -Q '(and $scope-kind (#/^st/ $scope-kind) (eq? $scope-name "abc"))' \
+	 -l
+
+echo '# folded constants'
+${V} ${READTAGS} -e -t output.tags \
+	 -Q '(and (eq? (+ 1 2) 3) $typeref-kind (suffix? $typeref-kind (if (< 1 2) "name" "ct")))' \
+	 -l
+
+echo '# sorter'
+${V} ${READTAGS} -e -t output.tags \
+	 -S '(<or> (<> $kind &kind) (*- (<> $name &name)))' \
+	 -l
+
+echo '# type error'
+${V} ${READTAGS} -e -t output.tags \
+	 -Q '(< $name 1)' \
+	 -l
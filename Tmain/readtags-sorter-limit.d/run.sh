@@ -0,0 +1,51 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+BUILDDIR=$2
+READTAGS=$3
+
+. ../utils.sh
+
+skip_if_no_readtags "$READTAGS"
+
+S='(<or> (<> $input &input) (<> $line &line) (<> $name &name))'
+
+echo '!_LIMIT' &&
+${READTAGS} -t output.tags -ne -L 3 -l &&
+
+echo '!_LIMIT with sorting' &&
+${READTAGS} -t output.tags -ne -S "$S" -L 3 -l &&
+
+echo '!_LIMIT with sorting and filtering' &&
+${READTAGS} -t output.tags -ne -Q '(eq? $kind "member")' -S "(*- $S)" --limit 2 -l &&
+
+echo '!_SORTED_BY_NAME' &&
+${READTAGS} -t output.tags -S '(<> $name &name)' -l &&
+
+echo '!_SORTED_BY_NAME with finding' &&
+${READTAGS} -t output.tags -ne -S '(<> $name &name)' - volume &&
+
+echo '!_SORTING with temporary files' &&
+${READTAGS} -t output.tags -ne -S "$S" -l > $BUILDDIR/readtags-sorter-limit-0.txt &&
+${READTAGS} -t output.tags -ne -S "$S" --sort-memory 1k -l > $BUILDDIR/readtags-sorter-limit-1.txt &&
+if cmp $BUILDDIR/readtags-sorter-limit-0.txt $BUILDDIR/readtags-sorter-limit-1.txt; then
+	echo same
+fi
+rm -f $BUILDDIR/readtags-sorter-limit-0.txt $BUILDDIR/readtags-sorter-limit-1.txt
+
+echo '!_SORTING error with temporary files'
+D=$BUILDDIR/readtags-sorter-limit.tmp
+rm -rf $D
+mkdir -p $D
+TMPDIR=$D ${READTAGS} -t output.tags -S '(<> &name (if (eq? $name "y") #t $name))' --sort-memory 1k -l > /dev/null 2>&1
+echo "exit status: $?"
+echo "temporary files left: $(ls $D | wc -l)"
+rm -rf $D
+
+echo '!_INVALID_LIMIT'
+${READTAGS} -t output.tags -L 0 -l 2>&1 | sed 's|.*\(readtags[^:]*\):|readtags:|'
+echo '!_INVALID_SORT_MEMORY'
+${READTAGS} -t output.tags --sort-memory 1x -l 2>&1 | sed 's|.*\(readtags[^:]*\):|readtags:|'
+exit 0
@@ -0,0 +1,35 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE --sort=yes"
+
+. ../utils.sh
+
+# Entries found while recursing are classified by d_type or fstatat();
+# symbolic links are still followed or skipped as --links says, and
+# special files are skipped without being opened.
+d=$BUILDDIR/recurse-special-entries.tmp
+rm -rf $d
+mkdir -p $d/sub
+echo 'int in_a;' > $d/a.c
+echo 'int in_b;' > $d/sub/b.c
+ln -s a.c $d/link-to-file.c
+ln -s sub $d/link-to-dir
+ln -s nowhere.c $d/dangling.c
+ln -s .. $d/sub/loop
+if ! mkfifo $d/fifo.c 2> /dev/null; then
+	rm -rf $d
+	skip "mkfifo is not available"
+fi
+
+for l in yes no; do
+	echo "# --links=$l"
+	(cd $d; ${CTAGS} $O --links=$l -R -o - .)
+	echo "# --links=$l, directory given as a link"
+	(cd $d; ${CTAGS} $O --links=$l -R -o - link-to-dir)
+done
+
+rm -rf $d
+exit 0
@@ -0,0 +1,15 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+
+stats=$BUILDDIR/regex-stats.txt
+${CTAGS} --quiet --options=NONE --options=./args.ctags --totals=extra -o /dev/null ./input.stats 2> ${stats}
+
+# The patterns are listed in the order of the time spent running them.
+# Drop the time column, and sort the lines by pattern.
+sed -n -e '/^REGEX STATISTICS.*/,$p' ${stats} | head -3
+sed -n -e '/^REGEX STATISTICS.*/,$p' ${stats} | tail -n +4 \
+	| awk '{ $2 = ""; print }' | sort -k3
+rm -f ${stats}
@@ -0,0 +1,23 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE --fields=+n"
+
+. ../utils.sh
+
+is_feature_available ${CTAGS} internal-sort
+
+# Tags are sorted in memory without writing them to the tag file first.
+# rescan.f is parsed twice: the tags of the first pass must be dropped.
+for s in yes foldcase; do
+	echo "# --sort=$s"
+	${CTAGS} $O --sort=$s -o - src/names.c src/rescan.f
+done
+
+echo "# --sort=yes to a file"
+${CTAGS} $O --sort=yes -o $BUILDDIR/sort-in-memory.tags src/names.c src/rescan.f
+grep -v '^!_' $BUILDDIR/sort-in-memory.tags
+rm -f $BUILDDIR/sort-in-memory.tags
+exit 0
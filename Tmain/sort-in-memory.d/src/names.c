@@ -0,0 +1,18 @@
+/* Names sharing prefixes, and names differing only in case */
+int abc;
+int ABC;
+int Abc;
+int abC;
+int ab;
+int a;
+int abcd;
+int abc_1;
+int ABD;
+int abd;
+int _x;
+int Z;
+int z;
+int zz;
+struct s1 { int dup; };
+struct s2 { int dup; };
+struct s3 { int Dup; };
@@ -0,0 +1,9 @@
+module free_mod
+  integer :: counter = 0 ! free form comment
+contains
+  subroutine free_sub(a)
+    integer, intent(in) :: a
+    counter = counter + &
+      a
+  end subroutine free_sub
+end module free_mod
@@ -0,0 +1,36 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE -R"
+
+. ../utils.sh
+
+is_feature_available ${CTAGS} internal-sort
+
+# Sort the tags in runs small enough to be spilled
+# to temporary files, and compare the result with sorting in memory.
+for s in yes foldcase; do
+	echo "# --sort=$s"
+	${CTAGS} $O --sort=$s -o $BUILDDIR/sort-memory-0.tags ./src
+	${CTAGS} $O --sort=$s --sort-memory=1k -o $BUILDDIR/sort-memory-1.tags ./src
+	if cmp $BUILDDIR/sort-memory-0.tags $BUILDDIR/sort-memory-1.tags; then
+		echo same
+	fi
+	rm -f $BUILDDIR/sort-memory-0.tags $BUILDDIR/sort-memory-1.tags
+done
+
+echo '# -x'
+${CTAGS} $O -x ./src > $BUILDDIR/sort-memory-0.tags
+${CTAGS} $O -x --sort-memory=1k ./src > $BUILDDIR/sort-memory-1.tags
+if cmp $BUILDDIR/sort-memory-0.tags $BUILDDIR/sort-memory-1.tags; then
+	echo same
+fi
+rm -f $BUILDDIR/sort-memory-0.tags $BUILDDIR/sort-memory-1.tags
+
+for m in 0 512 1x 1k 2M; do
+	echo "# --sort-memory=$m"
+	${CTAGS} $O --sort-memory=$m --list-features > /dev/null
+done
+exit 0
@@ -0,0 +1,122 @@
+int XXbYca (void) { return 0; }
+int ZaXbb (void) { return 1; }
+int Y_YY (void) { return 2; }
+int ZbaZX (void) { return 3; }
+int XX_Y (void) { return 4; }
+int ac_a_ (void) { return 5; }
+int Y_Xa_c (void) { return 6; }
+int YYZba (void) { return 7; }
+int XYZ (void) { return 8; }
+int YXaXc (void) { return 9; }
+int YZZ (void) { return 10; }
+int aYaY (void) { return 11; }
+int YYY (void) { return 12; }
+int Z_acb_ (void) { return 13; }
+int b_cc_ (void) { return 14; }
+int cY_ (void) { return 15; }
+int cXZXXa (void) { return 16; }
+int ZYY (void) { return 17; }
+int c (void) { return 18; }
+int bZa (void) { return 19; }
+int YbX_ (void) { return 20; }
+int YcaX (void) { return 21; }
+int c_ (void) { return 22; }
+int Y (void) { return 23; }
+int X (void) { return 24; }
+int cc_Xa (void) { return 25; }
+int ZbcYbZ (void) { return 26; }
+int Z_aY (void) { return 27; }
+int cb_ZY (void) { return 28; }
+int YZ_b (void) { return 29; }
+int ZaYaY (void) { return 30; }
+int ZYbX (void) { return 31; }
+int X__ac (void) { return 32; }
+int YcY (void) { return 33; }
+int ZabY (void) { return 34; }
+int ZZ__ca (void) { return 35; }
+int ZX_aYb (void) { return 36; }
+int Z_YZ (void) { return 37; }
+int ac (void) { return 38; }
+int bXZY_Y (void) { return 39; }
+int cY__ (void) { return 40; }
+int YZ_Y (void) { return 41; }
+int ZZZb (void) { return 42; }
+int bcZX (void) { return 43; }
+int Xa (void) { return 44; }
+int cYX (void) { return 45; }
+int Ycbcb (void) { return 46; }
+int cYbb (void) { return 47; }
+int ZYaY (void) { return 48; }
+int caYZc (void) { return 49; }
+int cbc (void) { return 50; }
+int bc___ (void) { return 51; }
+int X_X (void) { return 52; }
+int ccb (void) { return 53; }
+int aXbbZZ (void) { return 54; }
+int bXba (void) { return 55; }
+int XY_YXX (void) { return 56; }
+int acX (void) { return 57; }
+int Z_XX (void) { return 58; }
+int aY_Yc (void) { return 59; }
+int YZbaZ (void) { return 60; }
+int YZ_X (void) { return 61; }
+int Zb (void) { return 62; }
+int bcb (void) { return 63; }
+int ab_cbb (void) { return 64; }
+int aXZ (void) { return 65; }
+int YbXYaa (void) { return 66; }
+int abXcY (void) { return 67; }
+int a (void) { return 68; }
+int bZ_Ycc (void) { return 69; }
+int XZ (void) { return 70; }
+int YXaYa (void) { return 71; }
+int XZZaaY (void) { return 72; }
+int ZZcaa (void) { return 73; }
+int abYa (void) { return 74; }
+int Yca (void) { return 75; }
+int XcY (void) { return 76; }
+int ZYcYcb (void) { return 77; }
+int Z_ (void) { return 78; }
+int aa (void) { return 79; }
+int aZX (void) { return 80; }
+int aZXYc (void) { return 81; }
+int b_ac (void) { return 82; }
+int cXYX (void) { return 83; }
+int X_ (void) { return 84; }
+int cYYXY (void) { return 85; }
+int ZXZY (void) { return 86; }
+int ZbYXcb (void) { return 87; }
+int cXcZcY (void) { return 88; }
+int cZ_ (void) { return 89; }
+int bca (void) { return 90; }
+int ZXYc (void) { return 91; }
+int cXX (void) { return 92; }
+int Z_Y_XZ (void) { return 93; }
+int abZY (void) { return 94; }
+int cY (void) { return 95; }
+int bbY (void) { return 96; }
+int cZ (void) { return 97; }
+int ZYa (void) { return 98; }
+int YXcbc (void) { return 99; }
+int a_YcYb (void) { return 100; }
+int XcZ (void) { return 101; }
+int YXa (void) { return 102; }
+int Za_X (void) { return 103; }
+int b (void) { return 104; }
+int ZZ_ (void) { return 105; }
+int YYa (void) { return 106; }
+int YY (void) { return 107; }
+int acZX (void) { return 108; }
+int ca_ba (void) { return 109; }
+int cZXaYa (void) { return 110; }
+int accZXc (void) { return 111; }
+int YZXbZX (void) { return 112; }
+int bc_ (void) { return 113; }
+int a_Za (void) { return 114; }
+int bcX (void) { return 115; }
+int bY (void) { return 116; }
+int Z (void) { return 117; }
+int ba (void) { return 118; }
+int XZaZ_ (void) { return 119; }
+int dup;
+int Dup;
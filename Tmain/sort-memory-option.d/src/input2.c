@@ -0,0 +1,40 @@
+static int xxByCA (void) { return 0; }
+static int zAxBB (void) { return 1; }
+static int y_yy (void) { return 2; }
+static int zBAzx (void) { return 3; }
+static int xx_y (void) { return 4; }
+static int AC_A_ (void) { return 5; }
+static int y_xA_C (void) { return 6; }
+static int yyzBA (void) { return 7; }
+static int xyz (void) { return 8; }
+static int yxAxC (void) { return 9; }
+static int yzz (void) { return 10; }
+static int AyAy (void) { return 11; }
+static int yyy (void) { return 12; }
+static int z_ACB_ (void) { return 13; }
+static int B_CC_ (void) { return 14; }
+static int Cy_ (void) { return 15; }
+static int CxzxxA (void) { return 16; }
+static int zyy (void) { return 17; }
+static int C (void) { return 18; }
+static int BzA (void) { return 19; }
+static int yBx_ (void) { return 20; }
+static int yCAx (void) { return 21; }
+static int C_ (void) { return 22; }
+static int y (void) { return 23; }
+static int x (void) { return 24; }
+static int CC_xA (void) { return 25; }
+static int zBCyBz (void) { return 26; }
+static int z_Ay (void) { return 27; }
+static int CB_zy (void) { return 28; }
+static int yz_B (void) { return 29; }
+static int zAyAy (void) { return 30; }
+static int zyBx (void) { return 31; }
+static int x__AC (void) { return 32; }
+static int yCy (void) { return 33; }
+static int zABy (void) { return 34; }
+static int zz__CA (void) { return 35; }
+static int zx_AyB (void) { return 36; }
+static int z_yz (void) { return 37; }
+static int AC (void) { return 38; }
+static int Bxzy_y (void) { return 39; }
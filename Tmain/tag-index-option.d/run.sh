@@ -0,0 +1,49 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+O="--quiet --options=NONE --fields=+n"
+
+. ../utils.sh
+
+skip_if_no_readtags "$READTAGS"
+
+TAGS=$BUILDDIR/tag-index.tags
+
+lookup()
+{
+	for n in main point Point POINT max_points x X nothing; do
+		echo ";; $n"
+		${READTAGS} -t $TAGS -e -n - $n
+		${READTAGS} -t $TAGS -e -n -i - $n
+		${READTAGS} -t $TAGS -e -n -p - $n
+		${READTAGS} -t $TAGS -e -n -i -p - $n
+	done
+}
+
+# Look up the tags with the index, and compare the result with
+# looking up the tags without the index.
+for s in yes foldcase no; do
+	echo "# --sort=$s"
+	rm -f $TAGS $TAGS.idx
+	${CTAGS} $O --sort=$s --tag-index -o $TAGS src/a.c src/b.c
+	if ! [ -f $TAGS.idx ]; then
+		echo "no index"
+	fi
+	lookup > $BUILDDIR/tag-index-0.txt
+	rm -f $TAGS.idx
+	lookup > $BUILDDIR/tag-index-1.txt
+	if cmp $BUILDDIR/tag-index-0.txt $BUILDDIR/tag-index-1.txt; then
+		echo same
+	fi
+	rm -f $BUILDDIR/tag-index-0.txt $BUILDDIR/tag-index-1.txt
+done
+rm -f $TAGS
+
+echo '# -o -'
+${CTAGS} $O --tag-index -o - src/a.c > /dev/null
+echo '# -x'
+${CTAGS} $O --tag-index -x src/a.c > /dev/null
+exit 0
@@ -0,0 +1,5 @@
+static int main_loop;
+struct point { int X; };
+static int Point_count;
+static void x (void) { }
+#define max_points 8
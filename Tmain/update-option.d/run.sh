@@ -0,0 +1,62 @@
+# Copyright: 2026 Universal Ctags Team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+O="--quiet --options=NONE --pseudo-tags= -R"
+D=$BUILDDIR/update-option.tmp
+
+. ../utils.sh
+
+is_feature_available ${CTAGS} internal-sort
+
+rm -rf $D
+mkdir -p $D
+cp src/* $D
+touch -t 202001010000 $D/*
+
+${CTAGS} $O -o $D/tags $D
+
+# Modify one.c, remove two.c, and add four.c.
+printf 'int uno (void)\n{\n\treturn 1;\n}\n' > $D/one.c
+rm $D/two.c
+printf 'int four;\n' > $D/four.c
+
+echo '# --update'
+${CTAGS} $O --update -o $D/tags $D
+cut -f1 $D/tags
+
+# The result must be the same as the one made from scratch.
+${CTAGS} $O -o $D/full.tags $D
+if cmp $D/tags $D/full.tags; then
+	echo same
+fi
+
+echo '# --update --extras=+f --fields=+T'
+${CTAGS} $O --extras=+f --fields=+T -o $D/tags $D
+printf 'int dos;\n' > $D/two.c
+touch -t 202001010000 $D/two.c $D/four.c
+${CTAGS} $O --extras=+f --fields=+T --update -o $D/tags $D
+${CTAGS} $O --extras=+f --fields=+T -o $D/full.tags $D
+if cmp $D/tags $D/full.tags; then
+	echo same
+fi
+
+# The pattern of a tag sorted before the file name tag includes
+# "<TAB>epoch:", and the modification time of zz.c after changing it.
+echo '# --update with "epoch:" in a pattern'
+(
+	cd $D
+	printf 'struct S { int A;\tint\tepoch:1577836800; };\n' > zz.c
+	TZ=UTC touch -t 201901010000 zz.c
+	${CTAGS} $O --extras=+f --fields=+T -o zz.tags zz.c
+	printf 'struct S { int A;\tint\tepoch:1577836800; };\nint B;\n' > zz.c
+	TZ=UTC touch -t 202001010000 zz.c
+	${CTAGS} $O --extras=+f --fields=+T --update -o zz.tags zz.c
+	cut -f1 zz.tags
+)
+
+echo '# --update -a'
+${CTAGS} $O --update -a -o $D/tags $D
+rm -rf $D
+exit 0
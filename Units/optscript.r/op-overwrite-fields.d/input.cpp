@@ -0,0 +1,2 @@
+class C { public: int foo(int x) { return x; } };
+// retype
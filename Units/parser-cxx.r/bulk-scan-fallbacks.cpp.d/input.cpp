@@ -0,0 +1,31 @@
+// Runs of identifier characters, blanks and literal contents are
+// scanned at once; each case below ends such a run.
+int crlf_a;
+int crlf_b(int x) { return x; }
+int long_ident\
+ifier_continued = 1;
+int spl\
+it_crlf(int p\
+aram);
+long digits = 1'000'000;
+double digits_f = 0x1'F.8p1 + 1'0.0'1e1'0;
+char q = '\'', dq = '"';
+const char *esc = "a\"b\\" "c\
+{";
+int after_esc(int e);
+const char *raw = R"x(a ")" b
+} "( )x";
+const char *raw2 = u8R"(\)";
+int after_raw(int r);
+struct S\
+2 { int m\
+ember; };
+int last_line = 0;
+#define CONT_MACRO(a) \
+	"a\"\
+"
+#if 0
+char c = '"'; int skipped;
+#endif
+int end\
+_crlf;
@@ -0,0 +1,17 @@
+// co_await, co_yield and co_return are not keywords for the parser but,
+// like return, they may be followed by a lambda.
+task f()
+{
+	co_await [&](auto *p) { return p; };
+}
+
+task g()
+{
+	co_return [](int x) { return x; };
+}
+
+task h()
+{
+	int v = co_yield [=] { return 1; }();
+	int w = a[1];
+}
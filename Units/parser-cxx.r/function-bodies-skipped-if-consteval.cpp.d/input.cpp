@@ -0,0 +1,8 @@
+// The full parser gives up at "if consteval {" and loses the rest of
+// the input; the scanner used when function bodies are skipped does not.
+inline bool f()
+{
+	if consteval { return true; } else { return false; }
+}
+
+#define AFTER 1
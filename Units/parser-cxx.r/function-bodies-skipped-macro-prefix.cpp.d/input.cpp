@@ -0,0 +1,9 @@
+// The full parser takes "YIELD net::post(...);" for the declaration of
+// a member of net. No tag is expected from the function body.
+struct op
+{
+	void operator()()
+	{
+		YIELD net::post(std::move(*this));
+	}
+};
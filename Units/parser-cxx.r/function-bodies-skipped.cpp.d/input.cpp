@@ -0,0 +1,37 @@
+int f(int x)
+{
+	static const struct S { int a; } s = { 1 };
+	auto l = [](int y) { return y + 1; };
+	std::vector<int> v{1,2,3};
+	int arr[3] = {1,2,3};
+	if (x) { enum E { A, B }; return A; }
+	else if (x > 2) {
+#if 0
+		}
+#else
+		x++;
+#endif
+	}
+	for (int i = 0; i < 3; i++) [&]{ x += i; }();
+	switch (x) { case 1: { struct Q { int q; }; } break; default: ; }
+	typedef int myint;
+	using other = long;
+	const char *s2 = "}{";
+	char c = '}';
+	auto r = R"x(})x";
+	do { x--; } while (x > 0);
+	try { throw 1; } catch (...) { class Z {}; }
+	return {};
+}
+class K {
+	int m() { struct In { int z; }; return arr[0]; }
+	int arr[2];
+	void n() const { auto q = [this]() { return 1; }; }
+};
+int g(void) { return 0; }
+void h(int n)
+{
+	CHECK(n) typedef int T1;
+	FOO() struct Q2 { int b; };
+	std::vector<struct V> v; X<int, class W> w;
+}
@@ -20,9 +20,20 @@
 /*
  * TYPES
  */
+typedef struct sDSLInsn DSLInsn;
+
 struct sDSLCode
 {
 	EsObject *expr;
+
+	/* Bytecode; NULL if EXPR has a construct the bytecode cannot express. */
+	DSLInsn *insns;
+	int insn_count;
+	int insn_size;
+
+	/* A buffer for terminating a string with '\0' for regexec (). */
+	char *scratch;
+	size_t scratch_size;
 };
 
 struct sDSLEngine
@@ -118,6 +129,9 @@ static EsObject* macro_string2regexp (EsObject *args);
 static EsObject* macro_regexp_quote (EsObject *args);
 static EsObject* macro_debug_printX (EsObject *args);
 
+static void bc_build (DSLCode *code, DSLEngineType engine);
+static void bc_release (DSLCode *code);
+
 /*
  * DATA DEFINITIONS
  */
@@ -577,7 +591,7 @@ static EsObject *compile (EsObject *expr, void *engine)
 
 DSLCode *dsl_compile (DSLEngineType engine, EsObject *expr)
 {
-	DSLCode *code = malloc (sizeof (DSLCode));
+	DSLCode *code = calloc (1, sizeof (DSLCode));
 	if (code == NULL)
 		return NULL;
 
@@ -593,11 +607,14 @@ DSLCode *dsl_compile (DSLEngineType engine, EsObject *expr)
 		free (code);
 		return NULL;
 	}
+
+	bc_build (code, engine);
 	return code;
 }
 
 void dsl_release (DSLEngineType engine, DSLCode *code)
 {
+	bc_release (code);
 	es_object_unref (code->expr);
 	free (code);
 }
@@ -1047,27 +1064,33 @@ EsObject* dsl_entry_xget_string (const tagEntry *entry, const char* name)
 		return es_false;
 }
 
-EsObject* dsl_entry_xget_integer (const tagEntry *entry, const char* name)
+static int entry_xget_integer (const tagEntry *entry, const char* name, int *value)
 {
 	const char *str = entry_xget(entry, name);
-	EsObject *o;
 
 	if (str)
 	{
-		long value;
+		long l;
 		char *endstr;
 
 		errno = 0;
-		value = strtol (str, &endstr, 10);
+		l = strtol (str, &endstr, 10);
 		if (*endstr == '\0' && str != endstr && errno == 0 &&
-			value <= INT_MAX  && value >= INT_MIN)
+			l <= INT_MAX  && l >= INT_MIN)
 		{
-			o = es_integer_new ((int)value);
-			return es_object_autounref (o);
+			*value = (int)l;
+			return 1;
 		}
-		else
-			return es_false;
 	}
+	return 0;
+}
+
+EsObject* dsl_entry_xget_integer (const tagEntry *entry, const char* name)
+{
+	int value;
+
+	if (entry_xget_integer (entry, name, &value))
+		return es_object_autounref (es_integer_new (value));
 	else
 		return es_false;
 }
@@ -1588,3 +1611,872 @@ void dsl_report_error (const char *msg, EsObject *obj)
 	putc('\n', stderr);
 	mio_unref(mioerr);
 }
+
+/*
+ * Bytecode
+ *
+ * dsl_compile () lowers the expression to a flat sequence of register
+ * based instructions if it can express every construct in the
+ * expression. Sub-expressions having no field access are folded to
+ * constants while lowering.
+ *
+ * dsl_eval_bytecode () runs the instructions without making any
+ * object: a string in a register points to a field of the tag entry
+ * or to a string constant in the expression. If an instruction gets a
+ * value of an unexpected type, the interpreter gives up so that the
+ * caller evaluates the expression with dsl_eval () and reports the
+ * same error as before.
+ */
+#define DSL_BYTECODE_REGISTERS 16
+
+enum eDSLOpcode {
+	DSL_OP_CONST,				/* dst <- constant */
+	DSL_OP_FIELD,				/* dst <- field of entry (a == 0) or alt_entry (a == 1) */
+	DSL_OP_XFIELD,				/* dst <- ($ key a) (b == 0) or (& key a) (b == 1);
+								 * a == 0 means no default value. */
+	DSL_OP_JUMP,				/* goto target */
+	DSL_OP_JUMP_IF_FALSE,		/* if dst is #f, goto target */
+	DSL_OP_JUMP_IF_TRUE,		/* if dst is not #f, goto target */
+	DSL_OP_JUMP_IF_ORDERED,		/* if dst is -1 or 1, goto target */
+	DSL_OP_NOT,					/* dst <- (not a) */
+	DSL_OP_EQ,					/* dst <- (eq? a b) */
+	DSL_OP_LT,					/* dst <- (< a b) */
+	DSL_OP_GT,					/* dst <- (> a b) */
+	DSL_OP_LE,					/* dst <- (<= a b) */
+	DSL_OP_GE,					/* dst <- (>= a b) */
+	DSL_OP_PREFIX,				/* dst <- (prefix? a b) */
+	DSL_OP_SUFFIX,				/* dst <- (suffix? a b) */
+	DSL_OP_SUBSTR,				/* dst <- (substr? a b) */
+	DSL_OP_LENGTH,				/* dst <- (length a) */
+	DSL_OP_ADD,					/* dst <- (+ a b) */
+	DSL_OP_SUB,					/* dst <- (- a b) */
+	DSL_OP_REGEX,				/* dst <- (#/regex/ a) */
+	DSL_OP_CMP,					/* dst <- (<> a b) */
+	DSL_OP_FLIP,				/* dst <- (*- a) */
+};
+
+enum eDSLField {
+	DSL_FIELD_NAME,
+	DSL_FIELD_INPUT,
+	DSL_FIELD_PATTERN,
+	DSL_FIELD_LINE,
+	DSL_FIELD_ACCESS,
+	DSL_FIELD_END,
+	DSL_FIELD_EXTRAS,
+	DSL_FIELD_FILE,
+	DSL_FIELD_INHERITS,
+	DSL_FIELD_IMPLEMENTATION,
+	DSL_FIELD_KIND,
+	DSL_FIELD_LANGUAGE,
+	DSL_FIELD_NTH,
+	DSL_FIELD_SCOPE,
+	DSL_FIELD_SCOPE_KIND,
+	DSL_FIELD_SCOPE_NAME,
+	DSL_FIELD_SIGNATURE,
+	DSL_FIELD_TYPEREF,
+	DSL_FIELD_TYPEREF_KIND,
+	DSL_FIELD_TYPEREF_NAME,
+	DSL_FIELD_ROLES,
+	DSL_FIELD_XPATH,
+	DSL_FIELD_COUNT,
+};
+
+static const char *bc_field_names [DSL_FIELD_COUNT] = {
+	[DSL_FIELD_NAME]           = "name",
+	[DSL_FIELD_INPUT]          = "input",
+	[DSL_FIELD_PATTERN]        = "pattern",
+	[DSL_FIELD_LINE]           = "line",
+	[DSL_FIELD_ACCESS]         = "access",
+	[DSL_FIELD_END]            = "end",
+	[DSL_FIELD_EXTRAS]         = "extras",
+	[DSL_FIELD_FILE]           = "file",
+	[DSL_FIELD_INHERITS]       = "inherits",
+	[DSL_FIELD_IMPLEMENTATION] = "implementation",
+	[DSL_FIELD_KIND]           = "kind",
+	[DSL_FIELD_LANGUAGE]       = "language",
+	[DSL_FIELD_NTH]            = "nth",
+	[DSL_FIELD_SCOPE]          = "scope",
+	[DSL_FIELD_SCOPE_KIND]     = "scope-kind",
+	[DSL_FIELD_SCOPE_NAME]     = "scope-name",
+	[DSL_FIELD_SIGNATURE]      = "signature",
+	[DSL_FIELD_TYPEREF]        = "typeref",
+	[DSL_FIELD_TYPEREF_KIND]   = "typeref-kind",
+	[DSL_FIELD_TYPEREF_NAME]   = "typeref-name",
+	[DSL_FIELD_ROLES]          = "roles",
+	[DSL_FIELD_XPATH]          = "xpath",
+};
+
+struct sDSLInsn {
+	enum eDSLOpcode op;
+	int dst;
+	int a;
+	int b;
+	union {
+		DSLValue constant;
+		enum eDSLField field;
+		const char *key;
+		int target;
+		const EsObject *regex;
+	} u;
+};
+
+static DSLValue bc_false = { .type = DSL_VALUE_FALSE };
+static DSLValue bc_true  = { .type = DSL_VALUE_TRUE };
+
+static int bc_string (const char *str, DSLValue *v)
+{
+	if (str == NULL)
+		return 0;
+
+	v->type = DSL_VALUE_STRING;
+	v->string = str;
+	v->length = strlen (str);
+	return 1;
+}
+
+static void bc_string_or_false (const char *str, DSLValue *v)
+{
+	if (!bc_string (str, v))
+		*v = bc_false;
+}
+
+static void bc_integer (int i, DSLValue *v)
+{
+	v->type = DSL_VALUE_INTEGER;
+	v->integer = i;
+}
+
+/* "KIND:NAME" of scope and typeref fields */
+static void bc_load_kind (const tagEntry *entry, const char *name, DSLValue *v)
+{
+	const char *value = entry_xget (entry, name);
+	const char *colon = value? strchr (value, ':'): NULL;
+
+	if (colon == NULL)
+	{
+		*v = bc_false;
+		return;
+	}
+	v->type = DSL_VALUE_STRING;
+	v->string = value;
+	v->length = colon - value;
+}
+
+static void bc_load_name (const tagEntry *entry, const char *name, DSLValue *v)
+{
+	const char *value = entry_xget (entry, name);
+	const char *colon = value? strchr (value, ':'): NULL;
+
+	if (colon == NULL || *(colon + 1) == '\0')
+		*v = bc_false;
+	else
+		bc_string (colon + 1, v);
+}
+
+static int bc_load_field (const tagEntry *entry, enum eDSLField field, DSLValue *v)
+{
+	int i;
+
+	switch (field)
+	{
+	case DSL_FIELD_NAME:
+		return bc_string (entry->name, v);
+	case DSL_FIELD_INPUT:
+		return bc_string (entry->file, v);
+	case DSL_FIELD_PATTERN:
+		bc_string_or_false (entry->address.pattern, v);
+		break;
+	case DSL_FIELD_LINE:
+		if (entry->address.lineNumber == 0)
+			*v = bc_false;
+		else
+			bc_integer ((int)entry->address.lineNumber, v);
+		break;
+	case DSL_FIELD_FILE:
+		*v = entry->fileScope? bc_true: bc_false;
+		break;
+	case DSL_FIELD_KIND:
+		bc_string_or_false (entry->kind, v);
+		break;
+	case DSL_FIELD_END:
+	case DSL_FIELD_NTH:
+		if (entry_xget_integer (entry, bc_field_names [field], &i))
+			bc_integer (i, v);
+		else
+			*v = bc_false;
+		break;
+	case DSL_FIELD_SCOPE_KIND:
+		bc_load_kind (entry, "scope", v);
+		break;
+	case DSL_FIELD_SCOPE_NAME:
+		bc_load_name (entry, "scope", v);
+		break;
+	case DSL_FIELD_TYPEREF_KIND:
+		bc_load_kind (entry, "typeref", v);
+		break;
+	case DSL_FIELD_TYPEREF_NAME:
+		bc_load_name (entry, "typeref", v);
+		break;
+	default:
+		bc_string_or_false (entry_xget (entry, bc_field_names [field]), v);
+		break;
+	}
+	return 1;
+}
+
+static int bc_equal (const DSLValue *a, const DSLValue *b)
+{
+	if (a->type != b->type)
+		return 0;
+
+	switch (a->type)
+	{
+	case DSL_VALUE_INTEGER:
+		return a->integer == b->integer;
+	case DSL_VALUE_STRING:
+		return a->length == b->length
+			&& memcmp (a->string, b->string, a->length) == 0;
+	default:
+		return 1;
+	}
+}
+
+/* Same as strcmp () but for strings not terminated with '\0' */
+static int bc_strcmp (const DSLValue *a, const DSLValue *b)
+{
+	size_t l = a->length < b->length? a->length: b->length;
+	int r = memcmp (a->string, b->string, l);
+
+	if (r != 0)
+		return r;
+	return (a->length < b->length)? -1: (a->length > b->length)? 1: 0;
+}
+
+static int bc_substr (const DSLValue *target, const DSLValue *substr)
+{
+	if (substr->length == 0)
+		return 1;
+
+	const char *t = target->string;
+	const char *end = target->string + target->length;
+	while ((size_t)(end - t) >= substr->length)
+	{
+		t = memchr (t, substr->string [0], end - t - substr->length + 1);
+		if (t == NULL)
+			return 0;
+		if (memcmp (t, substr->string, substr->length) == 0)
+			return 1;
+		t++;
+	}
+	return 0;
+}
+
+static int bc_regex (DSLCode *code, const EsObject *regex, const DSLValue *v)
+{
+	/* The byte after a string in a register is always readable:
+	 * it is '\0' or the ':' of a scope or typeref field. */
+	if (v->string [v->length] == '\0')
+		return es_regex_exec_cstr (regex, v->string);
+
+	if (code->scratch_size < v->length + 1)
+	{
+		char *scratch = realloc (code->scratch, v->length + 1);
+		if (scratch == NULL)
+			return -1;
+		code->scratch = scratch;
+		code->scratch_size = v->length + 1;
+	}
+	memcpy (code->scratch, v->string, v->length);
+	code->scratch [v->length] = '\0';
+	return es_regex_exec_cstr (regex, code->scratch);
+}
+
+/* Run the instructions from PC to the end.
+ * Return 0 if the instructions cannot evaluate the expression for ENV. */
+static int bc_run (DSLCode *code, int pc, const DSLEnv *env, DSLValue *regs)
+{
+	const DSLInsn *insns = code->insns;
+	const int count = code->insn_count;
+	const tagEntry *entry;
+	int r;
+
+	while (pc < count)
+	{
+		const DSLInsn *insn = insns + pc++;
+		DSLValue *d = regs + insn->dst;
+		const DSLValue *a = regs + insn->a;
+		const DSLValue *b = regs + insn->b;
+
+		switch (insn->op)
+		{
+		case DSL_OP_CONST:
+			*d = insn->u.constant;
+			break;
+		case DSL_OP_FIELD:
+			entry = insn->a? env->alt_entry: env->entry;
+			if (entry == NULL || !bc_load_field (entry, insn->u.field, d))
+				return 0;
+			break;
+		case DSL_OP_XFIELD:
+			entry = insn->b? env->alt_entry: env->entry;
+			if (entry == NULL)
+				return 0;
+			if (!bc_string (entry_xget (entry, insn->u.key), d))
+				*d = (insn->a == 0)? bc_false: *a;
+			break;
+		case DSL_OP_JUMP:
+			pc = insn->u.target;
+			break;
+		case DSL_OP_JUMP_IF_FALSE:
+			if (d->type == DSL_VALUE_FALSE)
+				pc = insn->u.target;
+			break;
+		case DSL_OP_JUMP_IF_TRUE:
+			if (d->type != DSL_VALUE_FALSE)
+				pc = insn->u.target;
+			break;
+		case DSL_OP_JUMP_IF_ORDERED:
+			if (d->type == DSL_VALUE_INTEGER
+				&& (d->integer == -1 || d->integer == 1))
+				pc = insn->u.target;
+			break;
+		case DSL_OP_NOT:
+			*d = (a->type == DSL_VALUE_FALSE)? bc_true: bc_false;
+			break;
+		case DSL_OP_EQ:
+			*d = bc_equal (a, b)? bc_true: bc_false;
+			break;
+		case DSL_OP_LT:
+		case DSL_OP_GT:
+		case DSL_OP_LE:
+		case DSL_OP_GE:
+			if (a->type != DSL_VALUE_INTEGER || b->type != DSL_VALUE_INTEGER)
+				return 0;
+			switch (insn->op)
+			{
+			case DSL_OP_LT: r = a->integer <  b->integer; break;
+			case DSL_OP_GT: r = a->integer >  b->integer; break;
+			case DSL_OP_LE: r = a->integer <= b->integer; break;
+			default:        r = a->integer >= b->integer; break;
+			}
+			*d = r? bc_true: bc_false;
+			break;
+		case DSL_OP_PREFIX:
+		case DSL_OP_SUFFIX:
+		case DSL_OP_SUBSTR:
+			if (a->type != DSL_VALUE_STRING || b->type != DSL_VALUE_STRING)
+				return 0;
+			if (insn->op == DSL_OP_SUBSTR)
+				r = bc_substr (a, b);
+			else if (a->length < b->length)
+				r = 0;
+			else if (insn->op == DSL_OP_PREFIX)
+				r = (memcmp (a->string, b->string, b->length) == 0);
+			else
+				r = (memcmp (a->string + a->length - b->length,
+							 b->string, b->length) == 0);
+			*d = r? bc_true: bc_false;
+			break;
+		case DSL_OP_LENGTH:
+			if (a->type != DSL_VALUE_STRING)
+				return 0;
+			bc_integer ((int)a->length, d);
+			break;
+		case DSL_OP_ADD:
+		case DSL_OP_SUB:
+			if (a->type != DSL_VALUE_INTEGER || b->type != DSL_VALUE_INTEGER)
+				return 0;
+			bc_integer ((insn->op == DSL_OP_ADD)
+						? a->integer + b->integer
+						: a->integer - b->integer, d);
+			break;
+		case DSL_OP_REGEX:
+			if (a->type != DSL_VALUE_STRING)
+				return 0;
+			r = bc_regex (code, insn->u.regex, a);
+			if (r < 0)
+				return 0;
+			*d = r? bc_true: bc_false;
+			break;
+		case DSL_OP_CMP:
+			if (a->type == DSL_VALUE_INTEGER && b->type == DSL_VALUE_INTEGER)
+				r = (a->integer < b->integer)? -1: (a->integer > b->integer)? 1: 0;
+			else if (a->type == DSL_VALUE_STRING && b->type == DSL_VALUE_STRING)
+			{
+				r = bc_strcmp (a, b);
+				r = (r < 0)? -1: (r > 0)? 1: 0;
+			}
+			else
+				return 0;
+			bc_integer (r, d);
+			break;
+		case DSL_OP_FLIP:
+			if (a->type != DSL_VALUE_INTEGER)
+				return 0;
+			bc_integer ((a->integer < 0)? 1: (a->integer == 0)? 0: -1, d);
+			break;
+		}
+	}
+	return 1;
+}
+
+int dsl_eval_bytecode (DSLCode *code, DSLEnv *env, DSLValue *value)
+{
+	DSLValue regs [DSL_BYTECODE_REGISTERS];
+
+	if (code->insns == NULL)
+		return 0;
+
+	if (!bc_run (code, 0, env, regs))
+		return 0;
+
+	*value = regs [0];
+	return 1;
+}
+
+/*
+ * Compiler for the bytecode
+ */
+static int bc_emit (DSLCode *code, enum eDSLOpcode op, int dst, int a, int b)
+{
+	if (code->insn_count == code->insn_size)
+	{
+		int size = code->insn_size? code->insn_size * 2: 16;
+		DSLInsn *insns = realloc (code->insns, sizeof (DSLInsn) * size);
+		if (insns == NULL)
+			return -1;
+		code->insns = insns;
+		code->insn_size = size;
+	}
+
+	DSLInsn *insn = code->insns + code->insn_count;
+	memset (insn, 0, sizeof (*insn));
+	insn->op = op;
+	insn->dst = dst;
+	insn->a = a;
+	insn->b = b;
+	return code->insn_count++;
+}
+
+static int bc_emit_const (DSLCode *code, int dst, const DSLValue *v)
+{
+	int i = bc_emit (code, DSL_OP_CONST, dst, 0, 0);
+	if (i < 0)
+		return 0;
+	code->insns [i].u.constant = *v;
+	return 1;
+}
+
+static void bc_patch (DSLCode *code, int jump)
+{
+	code->insns [jump].u.target = code->insn_count;
+}
+
+/* Emit a jump to be patched with bc_patch_jumps () later.
+ * Jumps to the same place are chained in their targets. */
+static int bc_emit_jump (DSLCode *code, enum eDSLOpcode op, int dst, int *jumps)
+{
+	int i = bc_emit (code, op, dst, 0, 0);
+	if (i < 0)
+		return 0;
+	code->insns [i].u.target = *jumps;
+	*jumps = i;
+	return 1;
+}
+
+static void bc_patch_jumps (DSLCode *code, int jumps)
+{
+	while (jumps >= 0)
+	{
+		int next = code->insns [jumps].u.target;
+		bc_patch (code, jumps);
+		jumps = next;
+	}
+}
+
+static int bc_field (const char *name)
+{
+	for (int i = 0; i < DSL_FIELD_COUNT; i++)
+		if (strcmp (bc_field_names [i], name) == 0)
+			return i;
+	return -1;
+}
+
+/* Return the proc if PB is one of the built-ins in this file. */
+static DSLProc bc_common_proc (const DSLProcBind *pb)
+{
+	if (pb >= pbinds && pb < pbinds + sizeof(pbinds)/sizeof(pbinds [0]))
+		return pb->proc;
+	return NULL;
+}
+
+/* Return 1 if PB is the sorter's procedure named NAME. */
+static int bc_sorter_proc_p (DSLEngineType engine, const DSLProcBind *pb,
+							 const char *name)
+{
+	return engine == DSL_SORTER
+		&& bc_common_proc (pb) == NULL
+		&& strcmp (pb->name, name) == 0;
+}
+
+static int bc_compile (DSLCode *code, DSLEngineType engine, EsObject *expr, int dst);
+
+static int bc_compile_symbol (DSLCode *code, DSLEngineType engine, EsObject *symbol, int dst)
+{
+	DSLProcBind *pb = dsl_lookup (engine, symbol);
+	DSLProc proc;
+	int field;
+	int i;
+
+	if (pb == NULL)
+		return 0;
+
+	proc = bc_common_proc (pb);
+	if (proc == value_true)
+		return bc_emit_const (code, dst, &bc_true);
+	else if (proc == value_false)
+		return bc_emit_const (code, dst, &bc_false);
+
+	if (pb->name [0] == '$' && proc)
+	{
+		field = bc_field (pb->name + 1);
+		if (field < 0)
+			return 0;
+		i = bc_emit (code, DSL_OP_FIELD, dst, 0, 0);
+	}
+	else if (pb->name [0] == '&' && pb->name [1] != '\0'
+			 && bc_sorter_proc_p (engine, pb, pb->name))
+	{
+		field = bc_field (pb->name + 1);
+		if (field < 0)
+			return 0;
+		i = bc_emit (code, DSL_OP_FIELD, dst, 1, 0);
+	}
+	else
+		return 0;
+
+	if (i < 0)
+		return 0;
+	code->insns [i].u.field = field;
+	return 1;
+}
+
+/* Compile ARGS to the registers from DST. */
+static int bc_compile_args (DSLCode *code, DSLEngineType engine, EsObject *args, int dst)
+{
+	for (; !es_null (args); args = es_cdr (args), dst++)
+	{
+		if (!bc_compile (code, engine, es_car (args), dst))
+			return 0;
+	}
+	return 1;
+}
+
+/* Compile (begin ARGS...) */
+static int bc_compile_sequence (DSLCode *code, DSLEngineType engine, EsObject *args, int dst)
+{
+	if (es_null (args))
+		return 0;
+
+	for (; !es_null (args); args = es_cdr (args))
+	{
+		if (!bc_compile (code, engine, es_car (args), dst))
+			return 0;
+	}
+	return 1;
+}
+
+/* Compile (and ARGS...), (or ARGS...), and (<or> ARGS...):
+ * evaluate ARGS till JUMP_OP jumps. */
+static int bc_compile_shortcut (DSLCode *code, DSLEngineType engine, EsObject *args, int dst,
+								enum eDSLOpcode jump_op)
+{
+	int jumps = -1;
+
+	for (; !es_null (args); args = es_cdr (args))
+	{
+		if (!bc_compile (code, engine, es_car (args), dst))
+			return 0;
+		if (es_null (es_cdr (args)))
+			break;
+		if (!bc_emit_jump (code, jump_op, dst, &jumps))
+			return 0;
+	}
+
+	bc_patch_jumps (code, jumps);
+	return 1;
+}
+
+static int bc_compile_if (DSLCode *code, DSLEngineType engine, EsObject *args, int dst)
+{
+	int else_jump, end_jump;
+
+	if (!bc_compile (code, engine, es_car (args), dst))
+		return 0;
+	else_jump = bc_emit (code, DSL_OP_JUMP_IF_FALSE, dst, 0, 0);
+	if (else_jump < 0)
+		return 0;
+
+	args = es_cdr (args);
+	if (!bc_compile (code, engine, es_car (args), dst))
+		return 0;
+	end_jump = bc_emit (code, DSL_OP_JUMP, dst, 0, 0);
+	if (end_jump < 0)
+		return 0;
+
+	bc_patch (code, else_jump);
+	args = es_cdr (args);
+	if (!bc_compile (code, engine, es_car (args), dst))
+		return 0;
+	bc_patch (code, end_jump);
+	return 1;
+}
+
+static int bc_compile_cond (DSLCode *code, DSLEngineType engine, EsObject *args, int dst)
+{
+	int jumps = -1;
+
+	for (; !es_null (args); args = es_cdr (args))
+	{
+		EsObject *clause = es_car (args);
+		int next_jump;
+
+		if (!es_cons_p (clause))
+			return 0;
+
+		if (!bc_compile (code, engine, es_car (clause), dst))
+			return 0;
+
+		if (es_null (es_cdr (clause)))
+		{
+			if (!bc_emit_jump (code, DSL_OP_JUMP_IF_TRUE, dst, &jumps))
+				return 0;
+			continue;
+		}
+
+		next_jump = bc_emit (code, DSL_OP_JUMP_IF_FALSE, dst, 0, 0);
+		if (next_jump < 0)
+			return 0;
+		if (!bc_compile_sequence (code, engine, es_cdr (clause), dst))
+			return 0;
+		if (!bc_emit_jump (code, DSL_OP_JUMP, dst, &jumps))
+			return 0;
+		bc_patch (code, next_jump);
+	}
+
+	if (!bc_emit_const (code, dst, &bc_false))
+		return 0;
+	bc_patch_jumps (code, jumps);
+	return 1;
+}
+
+/* Compile ($ KEY [DEFAULT]) and (& KEY [DEFAULT]) */
+static int bc_compile_xfield (DSLCode *code, DSLEngineType engine, EsObject *args, int dst,
+							  int alt)
+{
+	EsObject *key = es_car (args);
+	EsObject *defaultv = es_cdr (args);
+	int i;
+
+	if (!es_string_p (key))
+		return 0;
+
+	if (!es_null (defaultv))
+	{
+		if (!es_null (es_cdr (defaultv)))
+			return 0;
+		if (!bc_compile (code, engine, es_car (defaultv), dst + 1))
+			return 0;
+	}
+
+	i = bc_emit (code, DSL_OP_XFIELD, dst, es_null (defaultv)? 0: dst + 1, alt);
+	if (i < 0)
+		return 0;
+	code->insns [i].u.key = es_string_get (key);
+	return 1;
+}
+
+static int bc_compile_op (DSLCode *code, DSLEngineType engine, EsObject *args, int dst,
+						  enum eDSLOpcode op, int arity)
+{
+	if (length (args) != arity)
+		return 0;
+	if (!bc_compile_args (code, engine, args, dst))
+		return 0;
+	return bc_emit (code, op, dst, dst, dst + 1) >= 0;
+}
+
+static int bc_compile_call (DSLCode *code, DSLEngineType engine, EsObject *expr, int dst)
+{
+	EsObject *head = es_car (expr);
+	EsObject *args = es_cdr (expr);
+	DSLProcBind *pb;
+	DSLProc proc;
+	int i;
+
+	if (es_regex_p (head))
+	{
+		if (length (args) != 1)
+			return 0;
+		if (!bc_compile (code, engine, es_car (args), dst))
+			return 0;
+		i = bc_emit (code, DSL_OP_REGEX, dst, dst, 0);
+		if (i < 0)
+			return 0;
+		code->insns [i].u.regex = head;
+		return 1;
+	}
+
+	if (!es_symbol_p (head))
+		return 0;
+	pb = dsl_lookup (engine, head);
+	if (pb == NULL)
+		return 0;
+
+	proc = bc_common_proc (pb);
+	if (proc == NULL)
+	{
+		if (bc_sorter_proc_p (engine, pb, "<>"))
+			return bc_compile_op (code, engine, args, dst, DSL_OP_CMP, 2);
+		else if (bc_sorter_proc_p (engine, pb, "*-"))
+			return bc_compile_op (code, engine, args, dst, DSL_OP_FLIP, 1);
+		else if (bc_sorter_proc_p (engine, pb, "<or>"))
+			return !es_null (args)
+				&& bc_compile_shortcut (code, engine, args, dst, DSL_OP_JUMP_IF_ORDERED);
+		else if (bc_sorter_proc_p (engine, pb, "&"))
+			return !es_null (args)
+				&& bc_compile_xfield (code, engine, args, dst, 1);
+		return 0;
+	}
+	else if (proc == sfrom_and)
+	{
+		if (es_null (args))
+			return bc_emit_const (code, dst, &bc_true);
+		return bc_compile_shortcut (code, engine, args, dst, DSL_OP_JUMP_IF_FALSE);
+	}
+	else if (proc == sform_or)
+	{
+		if (es_null (args))
+			return bc_emit_const (code, dst, &bc_false);
+		return bc_compile_shortcut (code, engine, args, dst, DSL_OP_JUMP_IF_TRUE);
+	}
+	else if (proc == sform_if)
+		return (length (args) == 3) && bc_compile_if (code, engine, args, dst);
+	else if (proc == sform_cond)
+		return bc_compile_cond (code, engine, args, dst);
+	else if (proc == sform_begin)
+		return bc_compile_sequence (code, engine, args, dst);
+	else if (proc == sform_begin0)
+		return !es_null (args)
+			&& bc_compile (code, engine, es_car (args), dst)
+			&& (es_null (es_cdr (args))
+				|| bc_compile_sequence (code, engine, es_cdr (args), dst + 1));
+	else if (proc == builtin_entry_ref)
+		return !es_null (args)
+			&& bc_compile_xfield (code, engine, args, dst, 0);
+	else if (proc == builtin_not)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_NOT, 1);
+	else if (proc == builtin_eq)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_EQ, 2);
+	else if (proc == builtin_lt)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_LT, 2);
+	else if (proc == builtin_gt)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_GT, 2);
+	else if (proc == builtin_le)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_LE, 2);
+	else if (proc == builtin_ge)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_GE, 2);
+	else if (proc == builtin_prefix)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_PREFIX, 2);
+	else if (proc == builtin_suffix)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_SUFFIX, 2);
+	else if (proc == builtin_substr)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_SUBSTR, 2);
+	else if (proc == builtin_length)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_LENGTH, 1);
+	else if (proc == builtin_add)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_ADD, 2);
+	else if (proc == builtin_sub)
+		return bc_compile_op (code, engine, args, dst, DSL_OP_SUB, 2);
+
+	return 0;
+}
+
+/* Replace the instructions from START with a constant if they access
+ * no field. */
+static void bc_fold (DSLCode *code, int start, int dst)
+{
+	DSLValue regs [DSL_BYTECODE_REGISTERS];
+
+	if (code->insn_count - start == 1
+		&& code->insns [start].op == DSL_OP_CONST)
+		return;
+
+	for (int i = start; i < code->insn_count; i++)
+	{
+		if (code->insns [i].op == DSL_OP_FIELD
+			|| code->insns [i].op == DSL_OP_XFIELD)
+			return;
+	}
+
+	/* Leave the type error to the interpreter for the tree. */
+	if (!bc_run (code, start, NULL, regs))
+		return;
+
+	code->insn_count = start;
+	bc_emit_const (code, dst, regs + dst);
+}
+
+static int bc_compile (DSLCode *code, DSLEngineType engine, EsObject *expr, int dst)
+{
+	DSLValue v;
+
+	/* Leave a room for the second operand of a binary operator. */
+	if (dst + 1 >= DSL_BYTECODE_REGISTERS)
+		return 0;
+
+	if (es_cons_p (expr))
+	{
+		int start = code->insn_count;
+
+		if (!bc_compile_call (code, engine, expr, dst))
+			return 0;
+		bc_fold (code, start, dst);
+		return 1;
+	}
+	else if (es_symbol_p (expr))
+		return bc_compile_symbol (code, engine, expr, dst);
+	else if (es_string_p (expr))
+	{
+		bc_string (es_string_get (expr), &v);
+		return bc_emit_const (code, dst, &v);
+	}
+	else if (es_integer_p (expr))
+	{
+		bc_integer (es_integer_get (expr), &v);
+		return bc_emit_const (code, dst, &v);
+	}
+	else if (es_boolean_p (expr))
+		return bc_emit_const (code, dst,
+							  es_boolean_get (expr)? &bc_true: &bc_false);
+
+	return 0;
+}
+
+static void bc_build (DSLCode *code, DSLEngineType engine)
+{
+	if (!bc_compile (code, engine, code->expr, 0))
+		bc_release (code);
+}
+
+static void bc_release (DSLCode *code)
+{
+	free (code->insns);
+	code->insns = NULL;
+	code->insn_count = 0;
+	code->insn_size = 0;
+
+	free (code->scratch);
+	code->scratch = NULL;
+	code->scratch_size = 0;
+}
@@ -61,6 +61,24 @@ struct sDSLProcBind {
 
 typedef struct sDSLCode DSLCode;
 
+enum eDSLValueType {
+	DSL_VALUE_FALSE,
+	DSL_VALUE_TRUE,
+	DSL_VALUE_INTEGER,
+	DSL_VALUE_STRING,
+};
+
+/* A value evaluated by dsl_eval_bytecode ().
+ * STRING points to a field of the tag entry or to a constant in the
+ * code; it is not always terminated with '\0'. Use LENGTH. */
+struct sDSLValue {
+	enum eDSLValueType type;
+	int integer;
+	const char *string;
+	size_t length;
+};
+typedef struct sDSLValue DSLValue;
+
 #define DSL_ERR_UNBOUND_VARIABLE    (es_error_intern("unbound-variable"))
 #define DSL_ERR_TOO_FEW_ARGUMENTS   (es_error_intern("too-few-arguments"))
 #define DSL_ERR_TOO_MANY_ARGUMENTS  (es_error_intern("too-many-arguments"))
@@ -91,6 +109,12 @@ void           dsl_help        (DSLEngineType engine, FILE *fp);
 void           dsl_cache_reset (DSLEngineType engine);
 DSLCode       *dsl_compile     (DSLEngineType engine, EsObject *expr);
 EsObject      *dsl_eval        (DSLCode *code, DSLEnv *env);
+
+/* Evaluate CODE with the bytecode built by dsl_compile () without
+ * making any object. Return 0 if CODE has no bytecode, or if the
+ * bytecode cannot evaluate CODE for ENV (e.g. a type error); evaluate
+ * it with dsl_eval () then. */
+int            dsl_eval_bytecode (DSLCode *code, DSLEnv *env, DSLValue *value);
 void           dsl_release     (DSLEngineType engine, DSLCode *code);
 
 /* This should be remove when we have a real compiler. */
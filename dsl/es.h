@@ -158,6 +158,9 @@ EsObject*    es_regex_compile (const char* pat,
 int          es_regex_p       (const EsObject* object);
 EsObject*    es_regex_exec    (const EsObject* regex,
 							   const EsObject* str);
+/* Same as es_regex_exec but STR is a C string; return 1 if matched. */
+int          es_regex_exec_cstr (const EsObject* regex,
+								 const char* str);
 
 /* Return #f if unmatched.
  * Retrun NIL is the associate group is not in REGEX. */
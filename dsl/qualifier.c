@@ -76,12 +76,17 @@ QCode  *q_compile (EsObject *exp)
 enum QRESULT q_is_acceptable  (QCode *code, tagEntry *entry)
 {
 	EsObject *r;
+	DSLValue v;
 	int i;
 
 	DSLEnv env = {
 		.engine = DSL_QUALIFIER,
 		.entry  = entry,
 	};
+
+	if (dsl_eval_bytecode (code->dsl, &env, &v))
+		return (v.type == DSL_VALUE_FALSE)? Q_REJECT: Q_ACCEPT;
+
 	es_autounref_pool_push ();
 	r = dsl_eval (code->dsl, &env);
 	if (es_object_equal (r, es_false))
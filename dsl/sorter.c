@@ -357,6 +357,7 @@ SCode *s_compile (EsObject *exp)
 int s_compare        (const tagEntry * a, const tagEntry * b, SCode *code)
 {
 	EsObject *r;
+	DSLValue v;
 	int i;
 	int exit_code = 0;
 
@@ -365,6 +366,12 @@ int s_compare        (const tagEntry * a, const tagEntry * b, SCode *code)
 		.entry = a,
 		.alt_entry = b,
 	};
+
+	/* Leave the unexpected value to the interpreter for the tree. */
+	if (dsl_eval_bytecode (code->dsl, &env, &v)
+		&& v.type == DSL_VALUE_INTEGER)
+		return (v.integer < 0)? -1: (v.integer == 0)? 0: 1;
+
 	es_autounref_pool_push ();
 	r = dsl_eval (code->dsl, &env);
 
@@ -0,0 +1,356 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   A micro-benchmark comparing hashTable of main/htable.c with the
+*   separately chained table it replaced.
+*
+*   Usage: htable-bench [COUNT [ROUNDS]]
+*
+*   hashTable looks keys up faster, but puts are slower with many keys:
+*   growing doubles the flat arrays, and their page faults dominate.
+*/
+
+#include "general.h"
+
+#include "htable.h"
+#include "routines.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * The separately chained table with djb2 hash, as main/htable.c was
+ * before switching to open addressing.
+ */
+typedef struct sChainedEntry chainedEntry;
+struct sChainedEntry {
+	void *key;
+	void *value;
+	unsigned int hash;
+	chainedEntry *next;
+};
+
+typedef struct sChainedTable {
+	chainedEntry **table;
+	unsigned int size;
+	unsigned int count;
+	hashTableHashFunc hashfn;
+	hashTableEqualFunc equalfn;
+} chainedTable;
+
+static const unsigned int primes[] = {
+	3, 7, 17, 37, 79, 163, 331, 673, 1361, 2729, 5471, 10949, 21911,
+	43853, 87719, 175447, 350899, 701819, 1403641, 2807303, 5614657,
+	11229331, 22458671, 44917381, 89834777, 179669557, 359339171,
+	718678369, 1437356741, 2874713497,
+};
+
+static chainedTable *chainedTableNew (unsigned int size,
+									  hashTableHashFunc hashfn,
+									  hashTableEqualFunc equalfn)
+{
+	chainedTable *t = xMalloc (1, chainedTable);
+
+	if (size < 3)
+		size = 3;
+	if ((size % 2) == 0)
+		size++;
+	t->size = size;
+	t->count = 0;
+	t->table = xCalloc (size, chainedEntry*);
+	t->hashfn = hashfn;
+	t->equalfn = equalfn;
+	return t;
+}
+
+static void chainedTableDelete (chainedTable *t)
+{
+	for (unsigned int i = 0; i < t->size; i++)
+	{
+		chainedEntry *e = t->table[i];
+		while (e)
+		{
+			chainedEntry *next = e->next;
+			eFree (e);
+			e = next;
+		}
+	}
+	eFree (t->table);
+	eFree (t);
+}
+
+static void chainedTableGrow (chainedTable *t)
+{
+	unsigned int new_size = t->size;
+
+	for (unsigned int j = 0; j < sizeof(primes) / sizeof(primes[0]); ++j)
+		if (primes[j] > t->size)
+		{
+			new_size = primes[j];
+			break;
+		}
+	if (new_size <= t->size)
+		return;
+
+	chainedEntry **new_table = xCalloc (new_size, chainedEntry*);
+	for (unsigned int i = 0; i < t->size; i++)
+	{
+		chainedEntry *e;
+		while ((e = t->table[i]))
+		{
+			unsigned int j = e->hash % new_size;
+			t->table[i] = e->next;
+			e->next = new_table[j];
+			new_table[j] = e;
+		}
+	}
+	eFree (t->table);
+	t->table = new_table;
+	t->size = new_size;
+}
+
+static void chainedTablePutItem (chainedTable *t, void *key, void *value)
+{
+	unsigned int h = t->hashfn (key);
+
+	if (((double)t->count / (double)t->size) >= 0.8)
+		chainedTableGrow (t);
+
+	unsigned int i = h % t->size;
+	chainedEntry *e = xMalloc (1, chainedEntry);
+	e->key = key;
+	e->value = value;
+	e->hash = h;
+	e->next = t->table[i];
+	t->table[i] = e;
+	t->count++;
+}
+
+static void *chainedTableGetItem (chainedTable *t, const void *key)
+{
+	unsigned int i = t->hashfn (key) % t->size;
+	chainedEntry **root = t->table + i;
+	chainedEntry *last = NULL;
+
+	for (chainedEntry *e = *root; e; last = e, e = e->next)
+	{
+		if (t->equalfn (key, e->key))
+		{
+			/* Move to front as the old table did. */
+			if (last)
+			{
+				last->next = e->next;
+				e->next = *root;
+				*root = e;
+			}
+			return e->value;
+		}
+	}
+	return NULL;
+}
+
+static bool chainedTableDeleteItem (chainedTable *t, const void *key)
+{
+	chainedEntry **e = t->table + (t->hashfn (key) % t->size);
+
+	for (; *e; e = &(*e)->next)
+	{
+		if (t->equalfn (key, (*e)->key))
+		{
+			chainedEntry *next = (*e)->next;
+			eFree (*e);
+			*e = next;
+			t->count--;
+			return true;
+		}
+	}
+	return false;
+}
+
+static unsigned int djb2hash (const void *x)
+{
+	const unsigned char *str = x;
+	unsigned long hash = 5381;
+	int c;
+
+	while ((c = *str++))
+		hash = ((hash << 5) + hash) + c;
+	return (unsigned int)hash;
+}
+
+/*
+ * Workloads
+ */
+struct workload {
+	char **keys;				/* present in the table */
+	char **misses;				/* not in the table */
+	unsigned int count;
+	unsigned int rounds;
+};
+
+struct result {
+	double put, hit, miss, delete;
+	unsigned long checksum;
+};
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Identifier-like keys of varying length */
+static char *make_key (unsigned int i, const char *prefix)
+{
+	static const char *words[] = {
+		"get", "set", "buffer", "Parser", "token", "x", "value",
+		"initialize", "m_", "Count", "node", "i", "std", "tmp",
+	};
+	char buf[128];
+	unsigned int n = i;
+	size_t len = 0;
+
+	len += snprintf (buf + len, sizeof(buf) - len, "%s", prefix);
+	do
+	{
+		len += snprintf (buf + len, sizeof(buf) - len, "%s",
+						 words[n % (sizeof(words) / sizeof(words[0]))]);
+		n /= sizeof(words) / sizeof(words[0]);
+	}
+	while (n && len < sizeof(buf) - 16);
+	snprintf (buf + len, sizeof(buf) - len, "%u", i);
+	return eStrdup (buf);
+}
+
+static void run_htable (struct workload *w, struct result *r)
+{
+	double t;
+	unsigned long sum = 0;
+
+	memset (r, 0, sizeof (*r));
+	for (unsigned int round = 0; round < w->rounds; round++)
+	{
+		hashTable *h = hashTableNew (11, hashCstrhash, hashCstreq, NULL, NULL);
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			hashTablePutItem (h, w->keys[i], HT_UINT_TO_PTR(i + 1));
+		r->put += now () - t;
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			sum += HT_PTR_TO_UINT(hashTableGetItem (h, w->keys[(i * 7) % w->count]));
+		r->hit += now () - t;
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			sum += HT_PTR_TO_UINT(hashTableGetItem (h, w->misses[i]));
+		r->miss += now () - t;
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			sum += hashTableDeleteItem (h, w->keys[i]);
+		r->delete += now () - t;
+
+		hashTableDelete (h);
+	}
+	r->checksum = sum;
+}
+
+static void run_chained (struct workload *w, struct result *r)
+{
+	double t;
+	unsigned long sum = 0;
+
+	memset (r, 0, sizeof (*r));
+	for (unsigned int round = 0; round < w->rounds; round++)
+	{
+		chainedTable *h = chainedTableNew (11, djb2hash, hashCstreq);
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			chainedTablePutItem (h, w->keys[i], HT_UINT_TO_PTR(i + 1));
+		r->put += now () - t;
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			sum += HT_PTR_TO_UINT(chainedTableGetItem (h, w->keys[(i * 7) % w->count]));
+		r->hit += now () - t;
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			sum += HT_PTR_TO_UINT(chainedTableGetItem (h, w->misses[i]));
+		r->miss += now () - t;
+
+		t = now ();
+		for (unsigned int i = 0; i < w->count; i++)
+			sum += chainedTableDeleteItem (h, w->keys[i]);
+		r->delete += now () - t;
+
+		chainedTableDelete (h);
+	}
+	r->checksum = sum;
+}
+
+static void print_result (const char *name, struct workload *w, struct result *r)
+{
+	double ops = (double)w->count * w->rounds / 1e9;
+
+	printf ("%-12s put: %6.1f  hit: %6.1f  miss: %6.1f  delete: %6.1f  (ns/op)\n",
+			name, r->put / ops, r->hit / ops, r->miss / ops, r->delete / ops);
+}
+
+int main (int argc, char **argv)
+{
+	struct workload w = {
+		.count = 100000,
+		.rounds = 10,
+	};
+	struct result open, chained;
+
+	if (argc > 1)
+		w.count = (unsigned int) strtoul (argv[1], NULL, 10);
+	if (argc > 2)
+		w.rounds = (unsigned int) strtoul (argv[2], NULL, 10);
+	if (w.count == 0 || w.rounds == 0)
+	{
+		fprintf (stderr, "Usage: %s [COUNT [ROUNDS]]\n", argv[0]);
+		return 1;
+	}
+
+	w.keys = xMalloc (w.count, char *);
+	w.misses = xMalloc (w.count, char *);
+	for (unsigned int i = 0; i < w.count; i++)
+	{
+		w.keys[i] = make_key (i, "");
+		w.misses[i] = make_key (i, "_");
+	}
+
+	printf ("%u string keys, %u rounds\n", w.count, w.rounds);
+	run_htable (&w, &open);
+	run_chained (&w, &chained);
+	print_result ("htable", &w, &open);
+	print_result ("chained", &w, &chained);
+
+	for (unsigned int i = 0; i < w.count; i++)
+	{
+		eFree (w.keys[i]);
+		eFree (w.misses[i]);
+	}
+	eFree (w.keys);
+	eFree (w.misses);
+
+	if (open.checksum != chained.checksum)
+	{
+		fprintf (stderr, "checksum mismatch: %lu != %lu\n",
+				 open.checksum, chained.checksum);
+		return 1;
+	}
+	return 0;
+}
@@ -25,9 +25,32 @@
 #include "dsl/formatter.h"
 
 #include <string.h>		/* strerror */
+#include <limits.h>		/* ULONG_MAX */
 #include <stdlib.h>		/* exit */
 #include <stdio.h>		/* stderr */
 #include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+
+#if defined (HAVE_FORK) && defined (HAVE_UNISTD_H) && defined (HAVE_SYS_WAIT_H)
+# define JOBS_SUPPORTED
+#endif
+
+/* The default amount of memory for sorting tags with a sorter */
+#define SORT_MEMORY_DEFAULT (128UL * 1024 * 1024)
+/* The maximum number of runs merged at once */
+#define SORT_MERGE_FANIN 16
+/* The maximum number of spilled runs kept open while sorting */
+#define SORT_MAX_SPILLED_RUNS (SORT_MERGE_FANIN * SORT_MERGE_FANIN)
 
 typedef struct sReadOption {
 	bool sortOverride;
@@ -67,17 +90,70 @@ struct actionSpec {
 	const char *name;			/* for ACTION_FIND */
 	bool canonicalizing;
 	bool absoluteOnly;
-	ptrArray *tagEntryArray;
+	struct tagSorter *tagSorter;
 	void (* walkerfn) (const tagEntry *, void *);
 	void *dataForWalkerFn;
 	QCode *qualifier;
 	SCode *sorter;
 	FCode *formatter;
+	unsigned long limit;		/* 0 means no limit */
+	unsigned long printed;
+	size_t sortMemory;
+	unsigned int jobs;			/* the number of worker processes */
 };
 
+/* A tag copied for sorting */
+typedef struct sCopiedTag {
+	tagEntry entry;
+	/* The order of reading. Tags compared as equal by a sorter are
+	 * printed in this order. */
+	unsigned long seq;
+} copiedTag;
+
+/* A run of sorted tags spilled to a temporary file */
+typedef struct sSpilledRun {
+	FILE *fp;
+	char *name;
+	/* linked in SpilledRuns */
+	struct sSpilledRun *prev;
+	struct sSpilledRun *next;
+} spilledRun;
+
+struct tagSorter {
+	SCode *code;
+	unsigned long seq;
+	/* If limit is not 0, only the first limit tags in the sorted order
+	 * are kept in heap, a max-heap. Otherwise, tags are collected in run
+	 * until they use memoryLimit bytes, and the run is sorted and
+	 * spilled to a temporary file. */
+	unsigned long limit;
+	tagEntry **heap;
+	unsigned long heapCount;
+	unsigned long heapSize;
+	ptrArray *run;
+	size_t memory;
+	size_t memoryLimit;
+	ptrArray *spilledRuns;
+};
+
+#ifdef JOBS_SUPPORTED
+/* A worker process walking a part of the tag file. The worker writes
+ * the tags to be listed to out, in the order of reading or in the
+ * sorted order, and its error messages to err. */
+typedef struct sTagWorker {
+	pid_t pid;
+	spilledRun *out;
+	spilledRun *err;
+} tagWorker;
+#endif
+
 static const char *ProgramName;
 static int debugMode;
 
+/* The spilled runs not deleted yet. removeSpilledRuns() removes their
+ * files when readtags exits on an error in the middle of sorting. */
+static spilledRun *SpilledRuns;
+
 static const char* tagsStrerror (int err)
 {
 	if (err > 0)
@@ -140,9 +216,9 @@ static void freeCopiedTag (tagEntry *e)
 
 static tagEntry *copyTag (tagEntry *o)
 {
-	tagEntry *n;
-
-	n = eCalloc (1, sizeof  (*o));
+	/* The copy is freed with freeCopiedTag() as a tagEntry. */
+	copiedTag *c = xCalloc (1, copiedTag);
+	tagEntry *n = &c->entry;
 
 	n->name = eStrdup (o->name);
 
@@ -176,7 +252,459 @@ static tagEntry *copyTag (tagEntry *o)
 
 static int compareTagEntry (const void *a, const void *b, void *sorter)
 {
-	return s_compare (a, b, sorter);
+	int r = s_compare (a, b, sorter);
+	if (r)
+		return r;
+
+	unsigned long seqA = ((const copiedTag *)a)->seq;
+	unsigned long seqB = ((const copiedTag *)b)->seq;
+	return seqA < seqB? -1: (seqA > seqB);
+}
+
+static size_t sizeOfCopiedTag (const tagEntry *e)
+{
+	size_t size = sizeof (copiedTag) + strlen (e->name) + 1;
+
+	if (e->address.pattern)
+		size += strlen (e->address.pattern) + 1;
+	size += e->fields.count * sizeof (*e->fields.list);
+	for (unsigned short c = 0; c < e->fields.count; c++)
+		size += strlen (e->fields.list[c].value) + 1;
+	return size;
+}
+
+static void failedInSorting (const char *what, const char *fileName)
+{
+	fprintf (stderr, "%s: error in %s the temporary file for sorting (%s): %s\n",
+			 ProgramName, what, fileName, strerror (errno));
+	exit (1);
+}
+
+static void writeSortedString (spilledRun *run, const char *s)
+{
+	size_t len = s? strlen (s): (size_t)-1;
+
+	if (fwrite (&len, sizeof (len), 1, run->fp) != 1
+		|| (s && fwrite (s, 1, len, run->fp) != len))
+		failedInSorting ("writing", run->name);
+}
+
+static void writeSortedTag (spilledRun *run, const tagEntry *e, unsigned long seq)
+{
+	const int fileScope = e->fileScope;
+
+	if (fwrite (&seq, sizeof (seq), 1, run->fp) != 1)
+		failedInSorting ("writing", run->name);
+	writeSortedString (run, e->name);
+	writeSortedString (run, e->file);
+	writeSortedString (run, e->address.pattern);
+	writeSortedString (run, e->kind);
+	if (fwrite (&e->address.lineNumber, sizeof (e->address.lineNumber), 1, run->fp) != 1
+		|| fwrite (&fileScope, sizeof (fileScope), 1, run->fp) != 1
+		|| fwrite (&e->fields.count, sizeof (e->fields.count), 1, run->fp) != 1)
+		failedInSorting ("writing", run->name);
+	for (unsigned short c = 0; c < e->fields.count; c++)
+	{
+		writeSortedString (run, e->fields.list[c].key);
+		writeSortedString (run, e->fields.list[c].value);
+	}
+}
+
+/* Read a string written with writeSortedString(). The string is interned
+ * if interning is true. Otherwise the caller must free it. */
+static const char *readSortedString (spilledRun *run, vString *buf, bool interning)
+{
+	size_t len;
+
+	if (fread (&len, sizeof (len), 1, run->fp) != 1)
+		failedInSorting ("reading", run->name);
+	if (len == (size_t)-1)
+		return NULL;
+
+	vStringClear (buf);
+	for (size_t i = 0; i < len; i++)
+	{
+		int c = getc (run->fp);
+		if (c == EOF)
+			failedInSorting ("reading", run->name);
+		vStringPut (buf, c);
+	}
+	return interning? intern (vStringValue (buf)): eStrdup (vStringValue (buf));
+}
+
+/* Read a tag written with writeSortedTag(). Return NULL at the end of
+ * the run. */
+static tagEntry *readSortedTag (spilledRun *run, vString *buf)
+{
+	unsigned long seq;
+	int fileScope;
+
+	if (fread (&seq, sizeof (seq), 1, run->fp) != 1)
+	{
+		if (ferror (run->fp))
+			failedInSorting ("reading", run->name);
+		return NULL;
+	}
+
+	copiedTag *c = xCalloc (1, copiedTag);
+	tagEntry *e = &c->entry;
+	c->seq = seq;
+	e->name = readSortedString (run, buf, false);
+	e->file = readSortedString (run, buf, true);
+	e->address.pattern = readSortedString (run, buf, false);
+	e->kind = readSortedString (run, buf, true);
+	if (fread (&e->address.lineNumber, sizeof (e->address.lineNumber), 1, run->fp) != 1
+		|| fread (&fileScope, sizeof (fileScope), 1, run->fp) != 1
+		|| fread (&e->fields.count, sizeof (e->fields.count), 1, run->fp) != 1)
+		failedInSorting ("reading", run->name);
+	e->fileScope = (short) fileScope;
+	if (e->fields.count)
+		e->fields.list = xMalloc (e->fields.count, tagExtensionField);
+	for (unsigned short i = 0; i < e->fields.count; i++)
+	{
+		e->fields.list[i].key = readSortedString (run, buf, true);
+		e->fields.list[i].value = readSortedString (run, buf, false);
+	}
+	return e;
+}
+
+static void deleteSpilledRun (void *data)
+{
+	spilledRun *run = data;
+
+	if (run->prev)
+		run->prev->next = run->next;
+	else
+		SpilledRuns = run->next;
+	if (run->next)
+		run->next->prev = run->prev;
+
+	fclose (run->fp);
+	remove (run->name);
+	eFree (run->name);
+	eFree (run);
+}
+
+/* Registered with atexit() */
+static void removeSpilledRuns (void)
+{
+	for (spilledRun *run = SpilledRuns; run; run = run->next)
+	{
+		fclose (run->fp);
+		remove (run->name);
+	}
+	SpilledRuns = NULL;
+}
+
+static spilledRun *newSpilledRun (void)
+{
+	static bool registered;
+	spilledRun *run = xMalloc (1, spilledRun);
+
+	if (!registered)
+	{
+		atexit (removeSpilledRuns);
+		registered = true;
+	}
+
+	run->name = NULL;
+	run->fp = tempFileFP ("w+b", &run->name);
+	if (run->fp == NULL)
+	{
+		eFree (run);
+		fprintf (stderr, "%s: failed to make a temporary file for sorting\n",
+				 ProgramName);
+		exit (1);
+	}
+
+	run->prev = NULL;
+	run->next = SpilledRuns;
+	if (SpilledRuns)
+		SpilledRuns->prev = run;
+	SpilledRuns = run;
+	return run;
+}
+
+static struct tagSorter *newTagSorter (SCode *code, unsigned long limit, size_t memoryLimit)
+{
+	struct tagSorter *sorter = xCalloc (1, struct tagSorter);
+
+	sorter->code = code;
+	sorter->limit = limit;
+	sorter->run = ptrArrayNew ((ptrArrayDeleteFunc)freeCopiedTag);
+	sorter->memoryLimit = memoryLimit;
+	sorter->spilledRuns = ptrArrayNew (deleteSpilledRun);
+	return sorter;
+}
+
+static void deleteTagSorter (struct tagSorter *sorter)
+{
+	for (unsigned long i = 0; i < sorter->heapCount; i++)
+		freeCopiedTag (sorter->heap [i]);
+	if (sorter->heap)
+		eFree (sorter->heap);
+	ptrArrayDelete (sorter->run);
+	ptrArrayDelete (sorter->spilledRuns);
+	eFree (sorter);
+}
+
+static bool isTagSorterEmpty (struct tagSorter *sorter)
+{
+	return sorter->heapCount == 0
+		&& ptrArrayCount (sorter->run) == 0
+		&& ptrArrayCount (sorter->spilledRuns) == 0;
+}
+
+static void mergeSpilledRuns (struct tagSorter *sorter, unsigned int maxRuns);
+
+static void spillRun (struct tagSorter *sorter)
+{
+	spilledRun *run = newSpilledRun ();
+	unsigned int count = ptrArrayCount (sorter->run);
+
+	ptrArraySortR (sorter->run, compareTagEntry, sorter->code);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		copiedTag *c = ptrArrayItem (sorter->run, i);
+		writeSortedTag (run, &c->entry, c->seq);
+	}
+	if (fflush (run->fp) != 0)
+		failedInSorting ("writing", run->name);
+	ptrArrayAdd (sorter->spilledRuns, run);
+
+	if (debugMode)
+		fprintf (stderr, "%s: spilled run %u (%u tags) to %s\n",
+				 ProgramName, ptrArrayCount (sorter->spilledRuns), count, run->name);
+	ptrArrayClear (sorter->run);
+	sorter->memory = 0;
+
+	if (ptrArrayCount (sorter->spilledRuns) >= SORT_MAX_SPILLED_RUNS)
+		mergeSpilledRuns (sorter, SORT_MERGE_FANIN);
+}
+
+/* Sift the tag at i of the heap down. The heap is a max-heap: the last
+ * tag in the sorted order is at the top. */
+static void siftDownTag (tagEntry **heap, unsigned long n, unsigned long i,
+						 int (*compare) (const void *, const void *, void *),
+						 void *code)
+{
+	for (;;)
+	{
+		unsigned long l = 2 * i + 1, r = l + 1, m = i;
+
+		if (l < n && compare (heap [l], heap [m], code) > 0)
+			m = l;
+		if (r < n && compare (heap [r], heap [m], code) > 0)
+			m = r;
+		if (m == i)
+			return;
+
+		tagEntry *t = heap [i];
+		heap [i] = heap [m];
+		heap [m] = t;
+		i = m;
+	}
+}
+
+static void addTagToHeap (struct tagSorter *sorter, tagEntry *e)
+{
+	if (sorter->heapCount == sorter->limit)
+	{
+		/* e is read after the tags in the heap; it must be before the top
+		 * in the sorted order to be kept. */
+		if (s_compare (e, sorter->heap [0], sorter->code) >= 0)
+			return;
+		freeCopiedTag (sorter->heap [0]);
+		sorter->heap [0] = copyTag (e);
+		((copiedTag *)sorter->heap [0])->seq = sorter->seq++;
+		siftDownTag (sorter->heap, sorter->heapCount, 0, compareTagEntry, sorter->code);
+		return;
+	}
+
+	if (sorter->heapCount == sorter->heapSize)
+	{
+		unsigned long size = sorter->heapSize? sorter->heapSize * 2: 16;
+		if (size > sorter->limit)
+			size = sorter->limit;
+		sorter->heap = xRealloc (sorter->heap, size, tagEntry *);
+		sorter->heapSize = size;
+	}
+
+	unsigned long i = sorter->heapCount++;
+	tagEntry *n = copyTag (e);
+	((copiedTag *)n)->seq = sorter->seq++;
+	while (i > 0 && compareTagEntry (sorter->heap [(i - 1) / 2], n, sorter->code) < 0)
+	{
+		sorter->heap [i] = sorter->heap [(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	sorter->heap [i] = n;
+}
+
+static void addTagToSorter (struct tagSorter *sorter, tagEntry *e)
+{
+	if (sorter->limit)
+	{
+		addTagToHeap (sorter, e);
+		return;
+	}
+
+	size_t size = sizeOfCopiedTag (e);
+	if (ptrArrayCount (sorter->run) > 0 && sorter->memory + size > sorter->memoryLimit)
+		spillRun (sorter);
+
+	tagEntry *n = copyTag (e);
+	((copiedTag *)n)->seq = sorter->seq++;
+	ptrArrayAdd (sorter->run, n);
+	sorter->memory += size;
+}
+
+struct mergedRun {
+	spilledRun *spilled;		/* NULL for the run in memory */
+	unsigned int index;
+	tagEntry *current;
+};
+
+static bool advanceMergedRun (struct tagSorter *sorter, struct mergedRun *run, vString *buf)
+{
+	if (run->spilled)
+	{
+		if (run->current)
+			freeCopiedTag (run->current);
+		run->current = readSortedTag (run->spilled, buf);
+	}
+	else if (run->index < ptrArrayCount (sorter->run))
+		run->current = ptrArrayItem (sorter->run, run->index++);
+	else
+		run->current = NULL;
+	return run->current != NULL;
+}
+
+static int compareMergedRuns (const void *a, const void *b, void *code)
+{
+	return compareTagEntry (((const struct mergedRun *)a)->current,
+							((const struct mergedRun *)b)->current, code);
+}
+
+static void siftDownMergedRun (struct mergedRun **heap, unsigned int n, unsigned int i,
+							   void *code)
+{
+	for (;;)
+	{
+		unsigned int l = 2 * i + 1, r = l + 1, m = i;
+
+		if (l < n && compareMergedRuns (heap [l], heap [m], code) < 0)
+			m = l;
+		if (r < n && compareMergedRuns (heap [r], heap [m], code) < 0)
+			m = r;
+		if (m == i)
+			return;
+
+		struct mergedRun *t = heap [i];
+		heap [i] = heap [m];
+		heap [m] = t;
+		i = m;
+	}
+}
+
+/* Merge the spilled runs in [from, to) and the run in memory (if
+ * withMemory is true). The tags are written to out if out is not NULL.
+ * Otherwise, they are passed to actionSpec->walkerfn. */
+static void mergeRuns (struct tagSorter *sorter, unsigned int from, unsigned int to,
+					   bool withMemory, spilledRun *out, struct actionSpec *actionSpec)
+{
+	unsigned int numRuns = to - from + (withMemory? 1: 0);
+	struct mergedRun *runs = xCalloc (numRuns, struct mergedRun);
+	struct mergedRun **heap = xMalloc (numRuns, struct mergedRun *);
+	vString *buf = vStringNew ();
+	unsigned int n = 0;
+
+	for (unsigned int i = from; i < to; i++)
+	{
+		runs [i - from].spilled = ptrArrayItem (sorter->spilledRuns, i);
+		if (fseek (runs [i - from].spilled->fp, 0, SEEK_SET) != 0)
+			failedInSorting ("reading", runs [i - from].spilled->name);
+	}
+
+	for (unsigned int i = 0; i < numRuns; i++)
+		if (advanceMergedRun (sorter, runs + i, buf))
+			heap [n++] = runs + i;
+	for (unsigned int i = n / 2; i > 0; i--)
+		siftDownMergedRun (heap, n, i - 1, sorter->code);
+
+	while (n > 0)
+	{
+		struct mergedRun *run = heap [0];
+
+		if (out)
+			writeSortedTag (out, run->current, ((copiedTag *)run->current)->seq);
+		else if (actionSpec->limit == 0 || actionSpec->printed < actionSpec->limit)
+		{
+			actionSpec->walkerfn (run->current, actionSpec->dataForWalkerFn);
+			actionSpec->printed++;
+		}
+
+		if (! advanceMergedRun (sorter, run, buf))
+			heap [0] = heap [--n];
+		siftDownMergedRun (heap, n, 0, sorter->code);
+	}
+
+	vStringDelete (buf);
+	eFree (heap);
+	eFree (runs);
+}
+
+/* Merge spilled runs into a spilled run until the number of spilled
+ * runs is not more than maxRuns. */
+static void mergeSpilledRuns (struct tagSorter *sorter, unsigned int maxRuns)
+{
+	while (ptrArrayCount (sorter->spilledRuns) > maxRuns)
+	{
+		spilledRun *run = newSpilledRun ();
+
+		mergeRuns (sorter, 0, SORT_MERGE_FANIN, false, run, NULL);
+		if (fflush (run->fp) != 0)
+			failedInSorting ("writing", run->name);
+		for (unsigned int i = 0; i < SORT_MERGE_FANIN; i++)
+			ptrArrayDeleteItem (sorter->spilledRuns, 0);
+		ptrArrayAdd (sorter->spilledRuns, run);
+	}
+}
+
+/* Print the tags in the sorter in the sorted order. The tags are
+ * written to out instead if out is not NULL. */
+static void flushTagSorter (struct tagSorter *sorter, struct actionSpec *actionSpec,
+							spilledRun *out)
+{
+	if (sorter->limit)
+	{
+		/* Sort the heap in place: move the top to the end repeatedly. */
+		for (unsigned long n = sorter->heapCount; n > 1; n--)
+		{
+			tagEntry *t = sorter->heap [0];
+			sorter->heap [0] = sorter->heap [n - 1];
+			sorter->heap [n - 1] = t;
+			siftDownTag (sorter->heap, n - 1, 0, compareTagEntry, sorter->code);
+		}
+		for (unsigned long i = 0; i < sorter->heapCount; i++)
+		{
+			if (out)
+				writeSortedTag (out, sorter->heap [i], ((copiedTag *)sorter->heap [i])->seq);
+			else
+				actionSpec->walkerfn (sorter->heap [i], actionSpec->dataForWalkerFn);
+		}
+		if (out == NULL)
+			actionSpec->printed += sorter->heapCount;
+		return;
+	}
+
+	ptrArraySortR (sorter->run, compareTagEntry, sorter->code);
+
+	/* Merge spilled runs until they can be merged with the run in
+	 * memory at once. */
+	mergeSpilledRuns (sorter, SORT_MERGE_FANIN - 1);
+
+	mergeRuns (sorter, 0, ptrArrayCount (sorter->spilledRuns), true, out, actionSpec);
 }
 
 static const char *canonicalizeFileNameX(tagFileX *const filex, const char *input)
@@ -184,63 +712,394 @@ static const char *canonicalizeFileNameX(tagFileX *const filex, const char *inpu
 	return canonicalizeFileName (filex->canon->cacheTable, input);
 }
 
+/* Return the entry to be listed after canonicalizing its input field
+ * with shadowRec, or NULL if the qualifier rejects it. */
+static tagEntry *acceptTag (tagFileX *const filex, tagEntry *entry, bool on_ptags,
+							tagEntry *shadowRec, struct actionSpec *actionSpec)
+{
+	tagEntry *shadow = entry;
+
+	if (actionSpec->canonicalizing
+		&& (on_ptags == false
+			|| strcmp (entry->name, "!_TAG_PROC_CWD") == 0))
+	{
+		*shadowRec = *entry;
+		shadow = shadowRec;
+		shadow->file = canonicalizeFileNameX (filex, entry->file);
+	}
+
+	if (actionSpec->qualifier)
+	{
+		int i = q_is_acceptable (actionSpec->qualifier, shadow);
+		switch (i)
+		{
+		case Q_REJECT:
+			return NULL;
+		case Q_ERROR:
+			exit (1);
+		}
+	}
+	return shadow;
+}
+
+static void checkWalkError (tagFile *const file)
+{
+	int err = tagsGetErrno (file);
+	if (err != 0)
+	{
+		fprintf (stderr, "%s: error in walkTags(): %s\n",
+				 ProgramName,
+				 tagsStrerror (err));
+		exit (1);
+	}
+}
+
+static bool isLimitReached (struct actionSpec *actionSpec)
+{
+	return actionSpec->limit && actionSpec->printed >= actionSpec->limit;
+}
+
 static void walkTags (tagFileX *const filex, tagEntry *first_entry, bool on_ptags,
 					  tagResult (* nextfn) (tagFile *const, tagEntry *),
 					  void (* actionfn) (const tagEntry *, void *), void *data,
 					  struct actionSpec *actionSpec)
 {
 	tagFile *const file = filex->tagFile;
-	ptrArray *a = actionSpec->tagEntryArray;
+	struct tagSorter *sorter = actionSpec->tagSorter;
+
+	if (sorter == NULL && isLimitReached (actionSpec))
+		return;
 
 	do
 	{
-		tagEntry *shadow = first_entry;
 		tagEntry  shadowRec;
-		if (actionSpec->canonicalizing
-			&& (on_ptags == false
-				|| strcmp (first_entry->name, "!_TAG_PROC_CWD") == 0))
+		tagEntry *shadow = acceptTag (filex, first_entry, on_ptags, &shadowRec, actionSpec);
+		if (shadow == NULL)
+			continue;
+
+		if (sorter)
+			addTagToSorter (sorter, shadow);
+		else
 		{
-			shadowRec = *first_entry;
-			shadow = &shadowRec;
-			shadow->file = canonicalizeFileNameX (filex, first_entry->file);
+			(* actionfn) (shadow, data);
+			if (++actionSpec->printed == actionSpec->limit)
+				return;
 		}
+	} while ( (*nextfn) (file, first_entry) == TagSuccess);
+
+	checkWalkError (file);
+
+	if (sorter)
+	{
+		actionSpec->walkerfn = actionfn;
+		actionSpec->dataForWalkerFn = data;
+	}
+}
 
-		if (actionSpec->qualifier)
+/* If the tags walked from first_entry are already in the order of the
+ * sorter, stop sorting so that walkTags() lists them as they are read.
+ * Return true if the tags are walked for checking the order; the caller
+ * must restart the walk. */
+static bool stopSortingIfSorted (tagFileX *const filex, tagEntry *first_entry,
+								 tagResult (* nextfn) (tagFile *const, tagEntry *),
+								 struct actionSpec *actionSpec)
+{
+	tagFile *const file = filex->tagFile;
+	struct tagSorter *sorter = actionSpec->tagSorter;
+	tagEntry *prev = NULL;
+	bool sorted = true;
+
+	/* Pseudo tags listed with -P are sorted with the regular tags.
+	 * With a limit, the heap of the sorter is small enough. */
+	if (sorter == NULL || sorter->limit || !isTagSorterEmpty (sorter))
+		return false;
+
+	do
+	{
+		tagEntry  shadowRec;
+		tagEntry *shadow = acceptTag (filex, first_entry, false, &shadowRec, actionSpec);
+		if (shadow == NULL)
+			continue;
+
+		if (prev && s_compare (prev, shadow, sorter->code) > 0)
 		{
-			int i = q_is_acceptable (actionSpec->qualifier, shadow);
-			switch (i)
-			{
-			case Q_REJECT:
+			sorted = false;
+			break;
+		}
+		if (prev)
+			freeCopiedTag (prev);
+		prev = copyTag (shadow);
+	} while ( (*nextfn) (file, first_entry) == TagSuccess);
+
+	if (prev)
+		freeCopiedTag (prev);
+	if (!sorted)
+		return true;
+
+	checkWalkError (file);
+	if (debugMode)
+		fprintf (stderr, "%s: tags are listed without sorting\n", ProgramName);
+	deleteTagSorter (sorter);
+	actionSpec->tagSorter = NULL;
+	return true;
+}
+
+#ifdef JOBS_SUPPORTED
+/* Whether tagsFind() searches the tag file without reading all lines.
+ * Dividing the tag file doesn't help the search. */
+static bool isSearchSorted (tagFileX *const filex, readOptions *readOpts)
+{
+	sortType method = readOpts->sortOverride? readOpts->sortMethod: filex->info.file.sort;
+	bool ignorecase = (readOpts->matchOpts & TAG_IGNORECASE) != 0;
+
+	return (method == TAG_SORTED && !ignorecase)
+		|| (method == TAG_FOLDSORTED && ignorecase);
+}
+
+/* Walk the PART-th of actionSpec->jobs parts of the tag file in a worker
+ * process. Tags found with NAME are walked if NAME is not NULL. SEQ is
+ * the order of the first tag read in the part. */
+static void runTagWorker (tagFileX *const filex, const char *const name,
+						  readOptions *readOpts, unsigned int part, tagWorker *w,
+						  unsigned long seq, struct actionSpec *actionSpec)
+{
+	/* Don't share the file position with the main process. */
+	tagFileX workerX = *filex;
+	struct tagSorter *sorter = NULL;
+	unsigned long written = 0;
+	tagEntry entry;
+	tagResult r;
+
+	/* The files of the spilled runs of the main process, including
+	 * w->out, are not ours to remove at exit. */
+	SpilledRuns = NULL;
+
+	if (dup2 (fileno (w->err->fp), STDERR_FILENO) < 0)
+		_exit (1);
+
+	workerX.tagFile = tagsOpen (filex->fileName, &workerX.info);
+	if (workerX.tagFile == NULL || !workerX.info.status.opened)
+	{
+		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
+				 ProgramName, tagsStrerror (workerX.info.status.error_number),
+				 filex->fileName);
+		exit (1);
+	}
+	if (readOpts && readOpts->sortOverride
+		&& tagsSetSortType (workerX.tagFile, readOpts->sortMethod) != TagSuccess)
+	{
+		fprintf (stderr, "%s: cannot set sort type to %d: %s\n",
+				 ProgramName,
+				 readOpts->sortMethod,
+				 tagsStrerror (tagsGetErrno (workerX.tagFile)));
+		exit (1);
+	}
+
+	if (actionSpec->tagSorter)
+	{
+		size_t memory = actionSpec->sortMemory / actionSpec->jobs;
+		sorter = newTagSorter (actionSpec->sorter, actionSpec->limit,
+							   memory? memory: 1);
+		sorter->seq = seq;
+	}
+
+	if (name)
+		r = tagsFindInPart (workerX.tagFile, &entry, name, readOpts->matchOpts,
+							part, actionSpec->jobs);
+	else
+		r = tagsFirstInPart (workerX.tagFile, &entry, part, actionSpec->jobs);
+
+	if (r != TagSuccess)
+	{
+		int err = tagsGetErrno (workerX.tagFile);
+		if (err != 0)
+		{
+			fprintf (stderr, "%s: error in %s(): %s\n",
+					 ProgramName, name? "tagsFind": "tagsFirst",
+					 tagsStrerror (err));
+			exit (1);
+		}
+	}
+	else
+	{
+		do
+		{
+			tagEntry  shadowRec;
+			tagEntry *shadow = acceptTag (&workerX, &entry, false, &shadowRec, actionSpec);
+			if (shadow == NULL)
 				continue;
-			case Q_ERROR:
-				exit (1);
+
+			if (sorter)
+				addTagToSorter (sorter, shadow);
+			else
+			{
+				writeSortedTag (w->out, shadow, seq++);
+				if (++written == actionSpec->limit)
+					break;
 			}
+		} while ((name? tagsFindNext: tagsNext) (workerX.tagFile, &entry) == TagSuccess);
+		checkWalkError (workerX.tagFile);
+	}
+
+	if (sorter)
+	{
+		if (!isTagSorterEmpty (sorter))
+			flushTagSorter (sorter, actionSpec, w->out);
+		/* _exit() doesn't remove the runs spilled by the worker. */
+		deleteTagSorter (sorter);
+	}
+	if (fflush (w->out->fp) != 0)
+		failedInSorting ("writing", w->out->name);
+	fflush (stderr);
+	_exit (0);
+}
+
+static void replayWorkerErrors (tagWorker *w)
+{
+	char buf [4096];
+	size_t n;
+
+	fflush (w->err->fp);
+	if (fseek (w->err->fp, 0, SEEK_SET) != 0)
+		return;
+	while ((n = fread (buf, 1, sizeof (buf), w->err->fp)) > 0)
+		fwrite (buf, 1, n, stderr);
+}
+
+static bool waitTagWorker (tagWorker *w, bool killing)
+{
+	int status = 0;
+
+	if (w->pid <= 0)
+		return true;
+
+	if (killing)
+		kill (w->pid, SIGTERM);
+	while (waitpid (w->pid, &status, 0) < 0)
+	{
+		if (errno != EINTR)
+		{
+			status = -1;
+			break;
 		}
+	}
+	w->pid = 0;
+	return WIFEXITED (status) && WEXITSTATUS (status) == 0;
+}
+
+static void deleteTagWorkers (tagWorker *workers, unsigned int count)
+{
+	for (unsigned int part = 0; part < count; part++)
+	{
+		waitTagWorker (workers + part, true);
+		if (workers [part].out)
+			deleteSpilledRun (workers [part].out);
+		if (workers [part].err)
+			deleteSpilledRun (workers [part].err);
+	}
+	eFree (workers);
+}
+
+/* Do the same as walkTags() with the tag file divided into parts walked
+ * by worker processes in parallel. The tags found by the workers are
+ * collected in the order of the parts, so the result is the same as
+ * walkTags(). */
+static void walkTagsInWorkers (tagFileX *const filex, const char *const name,
+							   readOptions *readOpts,
+							   void (* actionfn) (const tagEntry *, void *), void *data,
+							   struct actionSpec *actionSpec)
+{
+	const unsigned int count = actionSpec->jobs;
+	struct tagSorter *sorter = actionSpec->tagSorter;
+	tagWorker *workers = xCalloc (count, tagWorker);
+	/* Tags read in a part are ordered after the tags in the parts before. */
+	const unsigned long seq = sorter? sorter->seq: 0;
+	const unsigned long seqStride = (ULONG_MAX - seq) / count;
+	vString *buf = vStringNew ();
+
+	if (sorter == NULL && isLimitReached (actionSpec))
+		goto out;
+
+	if (debugMode)
+		fprintf (stderr, "%s: walking tags with %u workers\n", ProgramName, count);
 
-		if (a)
+	/* Nothing buffered must be inherited; a worker may flush it again. */
+	fflush (NULL);
+
+	for (unsigned int part = 0; part < count; part++)
+	{
+		tagWorker *w = workers + part;
+
+		w->out = newSpilledRun ();
+		w->err = newSpilledRun ();
+		w->pid = fork ();
+		if (w->pid < 0)
 		{
-			tagEntry *e = copyTag (shadow);
-			ptrArrayAdd (a, e);
+			fprintf (stderr, "%s: cannot fork a worker: %s\n",
+					 ProgramName, strerror (errno));
+			deleteTagWorkers (workers, count);
+			exit (1);
 		}
-		else
-			(* actionfn) (shadow, data);
-	} while ( (*nextfn) (file, first_entry) == TagSuccess);
+		else if (w->pid == 0)
+			runTagWorker (filex, name, readOpts, part, w,
+						  seq + part * seqStride, actionSpec);
+	}
 
-	int err = tagsGetErrno (file);
-	if (err != 0)
+	for (unsigned int part = 0; part < count; part++)
 	{
-		fprintf (stderr, "%s: error in walkTags(): %s\n",
-				 ProgramName,
-				 tagsStrerror (err));
-		exit (1);
+		tagWorker *w = workers + part;
+		bool failed = !waitTagWorker (w, false);
+
+		/* As walkTags(), the tags read before an error are listed
+		 * unless they are sorted. */
+		if (fseek (w->out->fp, 0, SEEK_SET) != 0)
+			failedInSorting ("reading", w->out->name);
+		if (sorter && !sorter->limit && !failed)
+		{
+			/* The sorted output is merged as a spilled run. */
+			ptrArrayAdd (sorter->spilledRuns, w->out);
+			w->out = NULL;
+		}
+		else if (sorter == NULL || !failed)
+		{
+			tagEntry *e;
+
+			while ((e = readSortedTag (w->out, buf)) != NULL)
+			{
+				if (sorter)
+					addTagToSorter (sorter, e);
+				else if (!isLimitReached (actionSpec))
+				{
+					(* actionfn) (e, data);
+					actionSpec->printed++;
+				}
+				freeCopiedTag (e);
+			}
+		}
+
+		replayWorkerErrors (w);
+		if (failed)
+		{
+			fflush (stdout);
+			deleteTagWorkers (workers, count);
+			vStringDelete (buf);
+			exit (1);
+		}
+		if (sorter == NULL && isLimitReached (actionSpec))
+			break;
 	}
 
-	if (a)
+	if (sorter)
 	{
 		actionSpec->walkerfn = actionfn;
 		actionSpec->dataForWalkerFn = data;
 	}
+
+ out:
+	vStringDelete (buf);
+	deleteTagWorkers (workers, count);
 }
+#endif
 
 static int copyFile (FILE *in, FILE *out)
 {
@@ -444,7 +1303,19 @@ static void findTag (struct inputSpec *inputSpec,
 	if (debugMode)
 		fprintf (stderr, "%s: searching for \"%s\" in \"%s\"\n",
 					 ProgramName, name, fileX->fileName);
-	if (tagsFind (fileX->tagFile, &entry, name, readOpts->matchOpts) == TagSuccess)
+#ifdef JOBS_SUPPORTED
+	if (actionSpec->jobs > 1 && !isSearchSorted (fileX, readOpts))
+	{
+		walkTagsInWorkers (fileX, name, readOpts,
+						   actionSpec->formatter? printTagWithFormatter: printTag,
+						   actionSpec->formatter? (void *)actionSpec: (void *)printOpts,
+						   actionSpec);
+		return;
+	}
+#endif
+	if (tagsFind (fileX->tagFile, &entry, name, readOpts->matchOpts) == TagSuccess
+		&& (!stopSortingIfSorted (fileX, &entry, tagsFindNext, actionSpec)
+			|| tagsFind (fileX->tagFile, &entry, name, readOpts->matchOpts) == TagSuccess))
 		walkTags (fileX, &entry, false, tagsFindNext,
 				  actionSpec->formatter? printTagWithFormatter: printTag,
 				  actionSpec->formatter? (void *)actionSpec: (void *)printOpts,
@@ -501,7 +1372,19 @@ static void listTags (struct inputSpec* inputSpec, bool pseudoTags, tagPrintOpti
 	}
 	else
 	{
-		if (tagsFirst (fileX->tagFile, &entry) == TagSuccess)
+#ifdef JOBS_SUPPORTED
+		if (actionSpec->jobs > 1)
+		{
+			walkTagsInWorkers (fileX, NULL, NULL,
+							   actionSpec->formatter? printTagWithFormatter: printTag,
+							   actionSpec->formatter? (void *)actionSpec: (void *)printOpts,
+							   actionSpec);
+			return;
+		}
+#endif
+		if (tagsFirst (fileX->tagFile, &entry) == TagSuccess
+			&& (!stopSortingIfSorted (fileX, &entry, tagsNext, actionSpec)
+				|| tagsFirst (fileX->tagFile, &entry) == TagSuccess))
 			walkTags (fileX, &entry, false, tagsNext,
 					  actionSpec->formatter? printTagWithFormatter: printTag,
 					  actionSpec->formatter? (void *)actionSpec: (void *)printOpts,
@@ -567,6 +1450,15 @@ static const char *const Usage =
 	"        Filter the tags listed by ACTION with EXP before printing.\n"
 	"    -S EXP | --sorter EXP\n"
 	"        Sort the tags listed by ACTION with EXP before printing.\n"
+	"    -L NUM | --limit NUM\n"
+	"        Print at most NUM tags listed by ACTION.\n"
+	"        With -S, print the first NUM tags in the sorted order.\n"
+	"    --sort-memory SIZE[k|m|g]\n"
+	"        Use SIZE bytes of memory for sorting with -S (default: 128m).\n"
+	"        If more memory is needed, sorted runs are written to temporary files.\n"
+	"    -j NUM | --jobs NUM\n"
+	"        Read the tag file with NUM worker processes (default: 1).\n"
+	"        Not used for NAME if NAME can be searched without reading all tags.\n"
 	;
 
 static void printUsage(FILE* stream, int exitCode)
@@ -644,7 +1536,8 @@ static void run (struct actionSpec *actionSpec, struct inputSpec *inputSpec,
 				 readOptions *readOpts, tagPrintOptions *printOpts)
 {
 	if (actionSpec->sorter)
-		actionSpec->tagEntryArray = ptrArrayNew ((ptrArrayDeleteFunc)freeCopiedTag);
+		actionSpec->tagSorter = newTagSorter (actionSpec->sorter, actionSpec->limit,
+											  actionSpec->sortMemory);
 
 	inputSpec->fileX = openTagsX (inputSpec);
 	if (actionSpec->action & ACTION_LIST_PTAGS)
@@ -655,18 +1548,12 @@ static void run (struct actionSpec *actionSpec, struct inputSpec *inputSpec,
 	else if (actionSpec->action & ACTION_LIST)
 		listTags (inputSpec, false, printOpts, actionSpec);
 
-	if (actionSpec->tagEntryArray)
+	if (actionSpec->tagSorter)
 	{
-		if (actionSpec->sorter)
-			ptrArraySortR (actionSpec->tagEntryArray, compareTagEntry, actionSpec->sorter);
-
-		const size_t entry_count = ptrArrayCount(actionSpec->tagEntryArray);
-		for (unsigned int i = 0; i < entry_count; i++)
-		{
-			tagEntry *e = ptrArrayItem (actionSpec->tagEntryArray, i);
-			actionSpec->walkerfn (e, actionSpec->dataForWalkerFn);
-		}
-		ptrArrayDelete (actionSpec->tagEntryArray);
+		if (!isTagSorterEmpty (actionSpec->tagSorter))
+			flushTagSorter (actionSpec->tagSorter, actionSpec, NULL);
+		deleteTagSorter (actionSpec->tagSorter);
+		actionSpec->tagSorter = NULL;
 	}
 }
 
@@ -676,12 +1563,16 @@ static void initActionSpec (struct actionSpec *actionSpec)
 		.action  = ACTION_NONE,
 		.name = NULL,
 		.canonicalizing = false,
-		.tagEntryArray = NULL,
+		.tagSorter = NULL,
 		.walkerfn = NULL,
 		.dataForWalkerFn = NULL,
 		.qualifier = NULL,
 		.sorter = NULL,
 		.formatter = NULL,
+		.limit = 0,
+		.printed = 0,
+		.sortMemory = SORT_MEMORY_DEFAULT,
+		.jobs = 1,
 	};
 }
 
@@ -724,6 +1615,75 @@ static void finiInputSpec (struct inputSpec *inputSpec)
 	dropCanonFnameCacheTableMaybe (&inputSpec->canon);
 }
 
+static unsigned long parseLimit (const char *const arg, const char *const optname)
+{
+	unsigned long limit;
+
+	if (!strToULong (arg, 10, &limit) || limit == 0)
+	{
+		fprintf (stderr, "%s: invalid number for --%s option: %s\n",
+				 ProgramName, optname, arg);
+		exit (1);
+	}
+	return limit;
+}
+
+static size_t parseSortMemory (const char *const arg, const char *const optname)
+{
+	unsigned long size;
+	unsigned long unit = 1;
+	char *end = NULL;
+
+	errno = 0;
+	size = strtoul (arg, &end, 10);
+	if (end == arg || errno != 0)
+		goto invalid;
+
+	switch (*end)
+	{
+	case 'g': case 'G':
+		unit *= 1024;
+		/* Fall through */
+	case 'm': case 'M':
+		unit *= 1024;
+		/* Fall through */
+	case 'k': case 'K':
+		unit *= 1024;
+		end++;
+		break;
+	}
+
+	if (*end != '\0' || size == 0 || size > ((size_t)-1) / unit)
+		goto invalid;
+	return (size_t) (size * unit);
+
+ invalid:
+	fprintf (stderr, "%s: invalid size for --%s option: %s\n",
+			 ProgramName, optname, arg);
+	exit (1);
+}
+
+static unsigned int parseJobs (const char *const arg, const char *const optname)
+{
+	unsigned int jobs;
+
+	if (!strToUInt (arg, 10, &jobs) || jobs == 0)
+	{
+		fprintf (stderr, "%s: invalid number for --%s option: %s\n",
+				 ProgramName, optname, arg);
+		exit (1);
+	}
+#ifndef JOBS_SUPPORTED
+	if (jobs > 1)
+	{
+		fprintf (stderr, "%s: --%s option is not supported on this platform\n",
+				 ProgramName, optname);
+		jobs = 1;
+	}
+#endif
+	return jobs;
+}
+
 static void printVersion(void)
 {
 	/* readtags uses code of ctags via libutil.
@@ -873,6 +1833,39 @@ static void parseOptions (int argc, char **argv,
 					exit (1);
 				}
 			}
+			else if (strcmp (optname, "limit") == 0)
+			{
+				if (i + 1 < argc)
+					actionSpec->limit = parseLimit (argv[++i], optname);
+				else
+				{
+					fprintf (stderr, "%s: missing number for --%s option\n",
+							 ProgramName, optname);
+					exit (1);
+				}
+			}
+			else if (strcmp (optname, "sort-memory") == 0)
+			{
+				if (i + 1 < argc)
+					actionSpec->sortMemory = parseSortMemory (argv[++i], optname);
+				else
+				{
+					fprintf (stderr, "%s: missing size for --%s option\n",
+							 ProgramName, optname);
+					exit (1);
+				}
+			}
+			else if (strcmp (optname, "jobs") == 0)
+			{
+				if (i + 1 < argc)
+					actionSpec->jobs = parseJobs (argv[++i], optname);
+				else
+				{
+					fprintf (stderr, "%s: missing number for --%s option\n",
+							 ProgramName, optname);
+					exit (1);
+				}
+			}
 			else if (strcmp (optname, "formatter") == 0)
 			{
 				if (i + 1 < argc)
@@ -976,6 +1969,16 @@ static void parseOptions (int argc, char **argv,
 															(void * (*)(EsObject *))s_compile,
 															"sorter");
 					break;
+				case 'L':
+					if (i + 1 == argc)
+						printUsage(stderr, 1);
+					actionSpec->limit = parseLimit (argv[++i], "limit");
+					break;
+				case 'j':
+					if (i + 1 == argc)
+						printUsage(stderr, 1);
+					actionSpec->jobs = parseJobs (argv[++i], "jobs");
+					break;
 				case 'F':
 					if (i + 1 == argc)
 						printUsage(stderr, 1);
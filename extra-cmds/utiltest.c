@@ -236,6 +236,68 @@ static void test_htable_grow(void)
 	hashTableDelete(htable);
 }
 
+static bool collect_chain(const void *key, void *value, void *user_data)
+{
+	intArray *a = user_data;
+	intArrayAdd (a, HT_PTR_TO_INT(value));
+	return true;
+}
+
+static void test_htable_chain(void)
+{
+	hashTable *htable;
+	intArray *a = intArrayNew ();
+	int i;
+	char keyBuf[20];
+
+	htable = hashTableNew (3, hashCstrhash, hashCstreq, eFree, NULL);
+
+	/* Interleave the items for "k" with other items deleted later,
+	 * and let the table grow. */
+	for (i = 1; i <= 100; ++i)
+	{
+		snprintf(keyBuf, sizeof(keyBuf), "str_%d", i);
+		hashTablePutItem (htable, strdup(keyBuf), HT_INT_TO_PTR(i));
+		if (i % 10 == 0)
+			hashTablePutItem (htable, strdup("k"), HT_INT_TO_PTR(i));
+	}
+	for (i = 1; i <= 100; i += 2)
+	{
+		snprintf(keyBuf, sizeof(keyBuf), "str_%d", i);
+		TEST_CHECK (hashTableDeleteItem (htable, keyBuf) == true);
+	}
+	hashTablePutItem (htable, strdup("k"), HT_INT_TO_PTR(110));
+	TEST_CHECK (hashTableCountItem (htable) == 50 + 11);
+
+	/* The newest item comes first. */
+	TEST_CHECK (HT_PTR_TO_INT(hashTableGetItem (htable, "k")) == 110);
+	hashTableForeachItemOnChain (htable, "k", collect_chain, a);
+	TEST_CHECK (intArrayCount (a) == 11);
+	for (i = 0; i < (int)intArrayCount (a); i++)
+		TEST_CHECK (intArrayItem (a, i) == 110 - i * 10);
+
+	TEST_CHECK (hashTableDeleteItem (htable, "k") == true);
+	TEST_CHECK (hashTableDeleteItem (htable, "k") == true);
+	TEST_CHECK (HT_PTR_TO_INT(hashTableGetItem (htable, "k")) == 90);
+	TEST_CHECK (HT_PTR_TO_INT(hashTableGetItem (htable, "str_2")) == 2);
+	TEST_CHECK (hashTableHasItem (htable, "str_3") == false);
+
+	intArrayDelete (a);
+	hashTableDelete(htable);
+}
+
+static void test_htable_casehash(void)
+{
+	const char *long0 = "a_long_identifier_name_longer_than_sixty_four_characters_abcdefghij";
+	const char *long1 = "A_LONG_IDENTIFIER_NAME_LONGER_THAN_SIXTY_FOUR_CHARACTERS_ABCDEFGHIJ";
+
+	TEST_CHECK (hashCstrcasehash ("") == hashCstrcasehash (""));
+	TEST_CHECK (hashCstrcasehash ("Ab") == hashCstrcasehash ("aB"));
+	TEST_CHECK (hashCstrcasehash ("select") == hashCstrcasehash ("SELECT"));
+	TEST_CHECK (hashCstrcasehash (long0) == hashCstrcasehash (long1));
+	TEST_CHECK (hashCstrhash ("select") != hashCstrhash ("SELECT"));
+}
+
 static void test_intern(void)
 {
 	const char *str = "asdfasfaskeopsdfksd";
@@ -348,6 +410,8 @@ TEST_LIST = {
    { "fname/relative",   test_fname_relative   },
    { "htable/update",    test_htable_update    },
    { "htable/grow",      test_htable_grow      },
+   { "htable/chain",     test_htable_chain     },
+   { "htable/casehash",  test_htable_casehash  },
    { "intern",           test_intern           },
    { "numarray",         test_numarray         },
    { "routines/strrstr", test_routines_strrstr },
@@ -23,7 +23,17 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/types.h>  /* to declare off_t */
+#include <sys/stat.h>
+
+#if !defined(_WIN32) && !defined(READTAGS_NO_MMAP)
+#include <unistd.h>
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#define READTAGS_MMAP
+#include <sys/mman.h>
+#endif
+#endif
 
 #include "readtags.h"
 
@@ -32,6 +42,21 @@
 */
 #define TAB '\t'
 
+/* See main/tagindex.c of Universal Ctags for the layout of the index */
+#define TAG_INDEX_MAGIC "CTAGSIDX"
+#define TAG_INDEX_VERSION 1
+#define TAG_INDEX_HEADER_SIZE 64
+#define TAG_INDEX_NAME_ORDERED 1
+#define TAG_INDEX_FOLD_ORDERED 2
+#define TAG_INDEX_DIRECT_SLOT 0x80000000U
+#define TAG_INDEX_SAMPLE_SIZE 4096
+#define TAG_INDEX_SAMPLE_COUNT 64
+
+#define TAG_BINARY_MAGIC "CTAGSBIN"
+#define TAG_BINARY_VERSION 1
+#define TAG_BINARY_HEADER_SIZE 96
+#define TAG_BINARY_NONE 0xffffffffU
+
 
 /*
 *   DATA DECLARATIONS
@@ -66,10 +91,79 @@ struct sTagFile {
 	rt_off_t pos;
 		/* size of tag file in seekable positions */
 	rt_off_t size;
+		/* lines at or after this position are not read; the end of
+		 * the part set by tagsFirstInPart() or tagsFindInPart(), or -1 */
+	rt_off_t partEnd;
 		/* last line read */
 	vstring line;
 		/* name of tag in last line read */
 	vstring name;
+		/* the tag file mapped into memory. If `addr' is not NULL, lines
+		 * are read from here instead of `fp'. Only sorted tag files are
+		 * mapped because the binary search reads lines at random. */
+	struct {
+				/* start of the mapped file */
+			const char *addr;
+				/* size of the mapped file */
+			size_t size;
+				/* file position of the next line to read */
+			rt_off_t pos;
+				/* last line read but not copied to `line' yet, or NULL */
+			const char *line;
+				/* length of `line' */
+			size_t lineLength;
+	} map;
+		/* the index of the tag file ("<tagfile>.idx") written by
+		 * ctags with --tag-index option. If `addr' is not NULL,
+		 * tagsFind() looks up tags with the index. */
+	struct {
+			const unsigned char *addr;
+			size_t size;
+				/* 1 if `addr' is mapped, 0 if allocated */
+			short mapped;
+			unsigned int flags;
+				/* size of the tag file when the index was made */
+			rt_off_t tagFileSize;
+			uint64_t seed;
+				/* number of lines */
+			uint32_t count;
+				/* number of distinct names */
+			uint32_t keyCount;
+			uint32_t bucketCount;
+			const unsigned char *offsets;
+			const unsigned char *displacements;
+			const unsigned char *slots;
+				/* NULL if the order is the line order */
+			const unsigned char *nameOrder;
+			const unsigned char *foldOrder;
+	} index;
+		/* the tag file in the binary format written by ctags with
+		 * --output-format=binary. If `addr' is not NULL, rows are
+		 * read instead of lines, and positions are row numbers. */
+	struct {
+			const unsigned char *addr;
+			size_t size;
+				/* 1 if `addr' is mapped, 0 if allocated */
+			short mapped;
+				/* number of rows */
+			uint32_t count;
+				/* number of interned strings */
+			uint32_t stringCount;
+			const char *pool;
+			size_t poolSize;
+			const unsigned char *strings;
+			const unsigned char *names;
+			const unsigned char *patterns;
+			const unsigned char *files;
+			const unsigned char *records;
+			const unsigned char *data;
+			size_t dataSize;
+				/* row read last, and its name */
+			uint32_t row;
+			const char *name;
+				/* row to read next */
+			uint32_t next;
+	} binary;
 		/* defines tag search state */
 	struct {
 				/* file position of last match for tag */
@@ -82,6 +176,13 @@ struct sTagFile {
 			short partial;
 				/* ignoring case */
 			short ignorecase;
+				/* lines found with the index in the line order,
+				 * or NULL if tagsFindNext() reads the lines after
+				 * the last match */
+			uint32_t *found;
+			uint32_t foundCount;
+				/* index of `found' for the next tagsFindNext() */
+			uint32_t foundNext;
 	} search;
 		/* miscellaneous extension fields */
 	struct {
@@ -291,27 +392,78 @@ static tagResult growString (vstring *s)
 	return result;
 }
 
+static uint32_t getU32 (const unsigned char *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8)
+		| ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t getU64 (const unsigned char *p)
+{
+	return (uint64_t) getU32 (p) | ((uint64_t) getU32 (p + 4) << 32);
+}
+
+/* Return the string at `offset' in the string pool of a tag file in
+ * the binary format, or NULL if `offset' is out of the pool. */
+static const char *binaryString (tagFile *const file, uint32_t offset)
+{
+	return (offset < file->binary.poolSize)? file->binary.pool + offset: NULL;
+}
+
+static const char *binaryInternedString (tagFile *const file, uint64_t id)
+{
+	if (id >= file->binary.stringCount)
+		return NULL;
+	return binaryString (file, getU32 (file->binary.strings + 4 * (size_t) id));
+}
+
+/* Same as readTagLine() but for a tag file in the binary format.
+ * Nothing is copied; only the name of the row is looked up. */
+static int readTagLineBinary (tagFile *const file, int *err)
+{
+	const uint32_t row = file->binary.next;
+
+	file->pos = (rt_off_t) row;
+	if (row >= file->binary.count)
+	{
+		/* EOF */
+		*err = 0;
+		return 0;
+	}
+
+	file->binary.name = binaryString (file, getU32 (file->binary.names + 4 * (size_t) row));
+	if (file->binary.name == NULL)
+	{
+		*err = TagErrnoUnexpectedFormat;
+		return 0;
+	}
+	file->binary.row = row;
+	file->binary.next = row + 1;
+	return 1;
+}
+
 /* Copy name of tag out of tag line */
-static tagResult copyName (tagFile *const file)
+static tagResult copyName (tagFile *const file, const char *const line,
+						   const size_t lineLength)
 {
 	size_t length;
-	const char *end = strchr (file->line.buffer, '\t');
+	const char *end = memchr (line, '\t', lineLength);
 	if (end == NULL)
 	{
-		end = strchr (file->line.buffer, '\n');
+		end = memchr (line, '\n', lineLength);
 		if (end == NULL)
-			end = strchr (file->line.buffer, '\r');
+			end = memchr (line, '\r', lineLength);
 	}
 	if (end != NULL)
-		length = end - file->line.buffer;
+		length = end - line;
 	else
-		length = strlen (file->line.buffer);
+		length = lineLength;
 	while (length >= file->name.size)
 	{
 		if (growString (&file->name) != TagSuccess)
 			return TagFailure;
 	}
-	strncpy (file->name.buffer, file->line.buffer, length);
+	memcpy (file->name.buffer, line, length);
 	file->name.buffer [length] = '\0';
 	return TagSuccess;
 }
@@ -383,7 +535,7 @@ static int readTagLineRaw (tagFile *const file, int *err)
 	} while (reReadLine  &&  result);
 	if (result)
 	{
-		if (copyName (file) != TagSuccess)
+		if (copyName (file, file->line.buffer, strlen (file->line.buffer)) != TagSuccess)
 		{
 			*err = ENOMEM;
 			result = 0;
@@ -392,6 +544,53 @@ static int readTagLineRaw (tagFile *const file, int *err)
 	return result;
 }
 
+/* Same as readTagLineRaw() but for a mapped tag file.
+ * Only the name is copied; the line is copied to `line' when it is
+ * parsed. */
+static int readTagLineMapped (tagFile *const file, int *err)
+{
+	const char *start;
+	const char *end;
+	const char *nul;
+	size_t rest;
+
+	file->pos = file->map.pos;
+	file->map.line = NULL;
+	if (file->map.pos < 0 || (size_t) file->map.pos >= file->map.size)
+	{
+		/* EOF */
+		*err = 0;
+		return 0;
+	}
+
+	start = file->map.addr + file->map.pos;
+	rest = file->map.size - (size_t) file->map.pos;
+	end = memchr (start, '\n', rest);
+	if (end == NULL)
+	{
+		end = start + rest;
+		file->map.pos = (rt_off_t) file->map.size;
+	}
+	else
+		file->map.pos += (end - start) + 1;
+
+	/* Emulate fgets(): a line ends at a null character if it has. */
+	nul = memchr (start, '\0', end - start);
+	if (nul != NULL)
+		end = nul;
+	while (end > start && (end [-1] == '\n' || end [-1] == '\r'))
+		end--;
+
+	file->map.line = start;
+	file->map.lineLength = end - start;
+	if (copyName (file, start, file->map.lineLength) != TagSuccess)
+	{
+		*err = ENOMEM;
+		return 0;
+	}
+	return 1;
+}
+
 /* Return 1 on success.
  * Return 0 on failure or EOF.
  * errno is set to *err unless EOF.
@@ -399,13 +598,515 @@ static int readTagLineRaw (tagFile *const file, int *err)
 static int readTagLine (tagFile *const file, int *err)
 {
 	int result;
-	do
+
+	if (file->binary.addr != NULL)
+		result = readTagLineBinary (file, err);
+	else do
 	{
-		result = readTagLineRaw (file, err);
+		result = (file->map.addr != NULL)
+			? readTagLineMapped (file, err)
+			: readTagLineRaw (file, err);
 	} while (result && *file->name.buffer == '\0');
+
+	if (result && file->partEnd >= 0 && file->pos >= file->partEnd)
+	{
+		/* EOF of the part */
+		*err = 0;
+		result = 0;
+	}
 	return result;
 }
 
+/* Copy the last line read from the mapped tag file to `line'.
+ * parseTagLine() modifies the line in place. */
+static tagResult copyMappedLine (tagFile *const file, int *err)
+{
+	if (file->map.line == NULL)
+		return TagSuccess;
+
+	while (file->map.lineLength >= file->line.size)
+	{
+		if (growString (&file->line) != TagSuccess)
+		{
+			*err = ENOMEM;
+			return TagFailure;
+		}
+	}
+	memcpy (file->line.buffer, file->map.line, file->map.lineLength);
+	file->line.buffer [file->map.lineLength] = '\0';
+	file->map.line = NULL;
+	return TagSuccess;
+}
+
+/* Name of the tag in the last line read */
+static const char *lineName (tagFile *const file)
+{
+	return (file->binary.addr != NULL)? file->binary.name: file->name.buffer;
+}
+
+static rt_off_t tellTagFile (tagFile *const file)
+{
+	if (file->binary.addr != NULL)
+		return (rt_off_t) file->binary.next;
+	if (file->map.addr != NULL)
+		return file->map.pos;
+	return readtags_ftell (file->fp);
+}
+
+static int seekTagFile (tagFile *const file, rt_off_t pos)
+{
+	if (file->binary.addr != NULL)
+	{
+		file->binary.next = (pos >= 0 && pos < (rt_off_t) file->binary.count)
+			? (uint32_t) pos
+			: file->binary.count;
+		return 0;
+	}
+	if (file->map.addr != NULL)
+	{
+		file->map.pos = pos;
+		return 0;
+	}
+	return readtags_fseek (file->fp, pos, SEEK_SET);
+}
+
+static void unmapTagFile (tagFile *const file)
+{
+#ifdef READTAGS_MMAP
+	if (file->map.addr != NULL)
+		munmap ((void *) file->map.addr, file->map.size);
+#endif
+	file->map.addr = NULL;
+	file->map.size = 0;
+	file->map.line = NULL;
+}
+
+/* Map the tag file into memory. The position of `fp' is taken over.
+ * If the file cannot be mapped, it is read with `fp' as before. */
+static void mapTagFile (tagFile *const file)
+{
+#ifdef READTAGS_MMAP
+	struct stat st;
+	rt_off_t pos;
+	void *addr;
+
+	if (file->map.addr != NULL || file->binary.addr != NULL)
+		return;
+
+	if (fstat (fileno (file->fp), &st) < 0
+		|| st.st_size <= 0
+		|| (unsigned long long) st.st_size > (unsigned long long) (size_t) -1)
+		return;
+
+	pos = readtags_ftell (file->fp);
+	if (pos < 0)
+		return;
+
+	addr = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE,
+				 fileno (file->fp), 0);
+	if (addr == MAP_FAILED)
+		return;
+
+	file->map.addr = addr;
+	file->map.size = (size_t) st.st_size;
+	file->map.pos = pos;
+	file->map.line = NULL;
+#endif
+}
+
+/* Remap the tag file if its size is changed since it was mapped,
+ * keeping the position of the next line to read. Reading the mapping
+ * beyond the end of a truncated file raises SIGBUS, so every function
+ * of the external interface reading lines calls this first. */
+static tagResult remapTagFileIfResized (tagFile *const file)
+{
+#ifdef READTAGS_MMAP
+	struct stat st;
+	rt_off_t pos;
+
+	if (file->map.addr == NULL)
+		return TagSuccess;
+
+	if (fstat (fileno (file->fp), &st) < 0)
+	{
+		file->err = errno;
+		return TagFailure;
+	}
+
+	if ((unsigned long long) st.st_size != (unsigned long long) file->map.size)
+	{
+		pos = file->map.pos;
+		unmapTagFile (file);
+		/* mapTagFile() takes over the position of `fp'. If the file
+		 * cannot be mapped again, it is read with `fp'. */
+		if (readtags_fseek (file->fp, pos, SEEK_SET) < 0)
+		{
+			file->err = errno;
+			return TagFailure;
+		}
+		mapTagFile (file);
+	}
+#endif
+	return TagSuccess;
+}
+
+/* The hash functions must be the same as main/tagindex.c of
+ * Universal Ctags. */
+static uint64_t mixHash (uint64_t h)
+{
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return h;
+}
+
+static uint64_t checksumBytes (uint64_t h, const unsigned char *p, size_t length)
+{
+	size_t i;
+	for (i = 0; i < length; i++)
+	{
+		h ^= p [i];
+		h *= UINT64_C(1099511628211);
+	}
+	return h;
+}
+
+static uint64_t hashName (const char *name, size_t length, uint64_t seed)
+{
+	return mixHash (checksumBytes (UINT64_C(14695981039346656037) ^ seed,
+								   (const unsigned char *) name, length));
+}
+
+static uint32_t hashBucket (uint64_t h, uint32_t bucketCount)
+{
+	return (uint32_t) ((h >> 32) % bucketCount);
+}
+
+static uint32_t hashSlot (uint64_t h, uint32_t displacement, uint32_t keyCount)
+{
+	return (uint32_t) (mixHash (h + displacement * UINT64_C(0x9e3779b97f4a7c15)) % keyCount);
+}
+
+/* Only some blocks of a large tag file are hashed. Return 0 if the tag
+ * file cannot be read. */
+static int checksumTagFile (tagFile *const file, uint64_t *sum)
+{
+	unsigned char buf [TAG_INDEX_SAMPLE_SIZE];
+	const uint64_t size = (uint64_t) file->size;
+	const int whole = (size <= (uint64_t) TAG_INDEX_SAMPLE_SIZE * TAG_INDEX_SAMPLE_COUNT);
+	const uint64_t count = whole
+		? (size + TAG_INDEX_SAMPLE_SIZE - 1) / TAG_INDEX_SAMPLE_SIZE
+		: TAG_INDEX_SAMPLE_COUNT;
+	uint64_t h = UINT64_C(14695981039346656037);
+	rt_off_t saved = -1;
+	uint64_t i;
+	int r = 1;
+
+	for (i = 0; i < 8; i++)
+		buf [i] = (unsigned char) (size >> (8 * i));
+	h = checksumBytes (h, buf, 8);
+
+	if (file->map.addr == NULL)
+	{
+		saved = readtags_ftell (file->fp);
+		if (saved < 0)
+			return 0;
+	}
+
+	for (i = 0; i < count && r; i++)
+	{
+		const uint64_t offset = whole
+			? i * TAG_INDEX_SAMPLE_SIZE
+			: (size - TAG_INDEX_SAMPLE_SIZE) * i / (TAG_INDEX_SAMPLE_COUNT - 1);
+		const size_t length = (size - offset < TAG_INDEX_SAMPLE_SIZE)
+			? (size_t) (size - offset)
+			: TAG_INDEX_SAMPLE_SIZE;
+
+		if (file->map.addr != NULL)
+			h = checksumBytes (h, (const unsigned char *) file->map.addr + offset, length);
+		else if (readtags_fseek (file->fp, (rt_off_t) offset, SEEK_SET) < 0
+				 || fread (buf, 1, length, file->fp) != length)
+			r = 0;
+		else
+			h = checksumBytes (h, buf, length);
+	}
+
+	if (saved >= 0 && readtags_fseek (file->fp, saved, SEEK_SET) < 0)
+		r = 0;
+
+	*sum = h;
+	return r;
+}
+
+static void unloadTagIndex (tagFile *const file)
+{
+	if (file->index.addr != NULL)
+	{
+#ifdef READTAGS_MMAP
+		if (file->index.mapped)
+			munmap ((void *) file->index.addr, file->index.size);
+		else
+#endif
+			free ((void *) file->index.addr);
+	}
+	memset (&file->index, 0, sizeof (file->index));
+}
+
+/* Return 1 if the index is valid for the tag file. */
+static int parseTagIndex (tagFile *const file)
+{
+	const unsigned char *p = file->index.addr;
+	uint64_t expected;
+	uint64_t sum;
+
+	if (memcmp (p, TAG_INDEX_MAGIC, 8) != 0
+		|| getU32 (p + 8) != TAG_INDEX_VERSION)
+		return 0;
+
+	file->index.flags = getU32 (p + 12);
+	file->index.tagFileSize = (rt_off_t) getU64 (p + 16);
+	file->index.seed = getU64 (p + 32);
+	file->index.count = getU32 (p + 40);
+	file->index.keyCount = getU32 (p + 44);
+	file->index.bucketCount = getU32 (p + 48);
+
+	if (file->index.tagFileSize != file->size
+		|| file->index.keyCount > file->index.count
+		|| file->index.bucketCount == 0)
+		return 0;
+
+	expected = TAG_INDEX_HEADER_SIZE
+		+ 8 * (uint64_t) file->index.count
+		+ 4 * (uint64_t) file->index.bucketCount
+		+ 4 * (uint64_t) file->index.keyCount;
+	if (!(file->index.flags & TAG_INDEX_NAME_ORDERED))
+		expected += 4 * (uint64_t) file->index.count;
+	if (!(file->index.flags & TAG_INDEX_FOLD_ORDERED))
+		expected += 4 * (uint64_t) file->index.count;
+	if (expected != (uint64_t) file->index.size)
+		return 0;
+
+	p += TAG_INDEX_HEADER_SIZE;
+	file->index.offsets = p;
+	p += 8 * (size_t) file->index.count;
+	file->index.displacements = p;
+	p += 4 * (size_t) file->index.bucketCount;
+	file->index.slots = p;
+	p += 4 * (size_t) file->index.keyCount;
+	if (!(file->index.flags & TAG_INDEX_NAME_ORDERED))
+	{
+		file->index.nameOrder = p;
+		p += 4 * (size_t) file->index.count;
+	}
+	if (!(file->index.flags & TAG_INDEX_FOLD_ORDERED))
+		file->index.foldOrder = p;
+
+	if (!checksumTagFile (file, &sum) || sum != getU64 (file->index.addr + 24))
+		return 0;
+	return 1;
+}
+
+/* Load "<filePath>.idx" if it exists and is made for the tag file.
+ * Without a valid index, tags are found by searching the tag file. */
+static void loadTagIndex (tagFile *const file, const char *const filePath)
+{
+	const size_t pathLength = strlen (filePath);
+	char *indexPath = (char *) malloc (pathLength + sizeof (".idx"));
+	unsigned char *addr = NULL;
+	rt_off_t size;
+	FILE *fp;
+
+	if (indexPath == NULL)
+		return;
+	memcpy (indexPath, filePath, pathLength);
+	memcpy (indexPath + pathLength, ".idx", sizeof (".idx"));
+	fp = fopen (indexPath, "rb");
+	free (indexPath);
+	if (fp == NULL)
+		return;
+
+	/* The checksum covers only some blocks of a large tag file.
+	 * Reject an index older than the tag file to catch the other
+	 * changes. */
+	{
+		struct stat tagStat, indexStat;
+		if (fstat (fileno (file->fp), &tagStat) != 0
+			|| fstat (fileno (fp), &indexStat) != 0
+			|| tagStat.st_mtime > indexStat.st_mtime)
+			goto out;
+	}
+
+	if (readtags_fseek (fp, 0, SEEK_END) < 0)
+		goto out;
+	size = readtags_ftell (fp);
+	if (size < TAG_INDEX_HEADER_SIZE
+		|| (unsigned long long) size > (unsigned long long) (size_t) -1)
+		goto out;
+
+#ifdef READTAGS_MMAP
+	addr = mmap (NULL, (size_t) size, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+	if (addr == MAP_FAILED)
+		addr = NULL;
+	else
+		file->index.mapped = 1;
+#endif
+	if (addr == NULL)
+	{
+		addr = (unsigned char *) malloc ((size_t) size);
+		if (addr == NULL)
+			goto out;
+		if (readtags_fseek (fp, 0, SEEK_SET) < 0
+			|| fread (addr, 1, (size_t) size, fp) != (size_t) size)
+		{
+			free (addr);
+			goto out;
+		}
+	}
+
+	file->index.addr = addr;
+	file->index.size = (size_t) size;
+	if (!parseTagIndex (file))
+		unloadTagIndex (file);
+ out:
+	fclose (fp);
+}
+
+static void unloadBinaryTagFile (tagFile *const file)
+{
+	if (file->binary.addr != NULL)
+	{
+#ifdef READTAGS_MMAP
+		if (file->binary.mapped)
+			munmap ((void *) file->binary.addr, file->binary.size);
+		else
+#endif
+			free ((void *) file->binary.addr);
+	}
+	memset (&file->binary, 0, sizeof (file->binary));
+}
+
+static int isSectionInFile (uint64_t offset, uint64_t length, uint64_t size)
+{
+	return offset <= size && length <= size - offset;
+}
+
+/* Return 1 if the header and the sections of a tag file in the binary
+ * format are valid. The layout is described in main/writer-binary.c of
+ * Universal Ctags. */
+static int parseBinaryHeader (tagFile *const file)
+{
+	const unsigned char *p = file->binary.addr;
+	const uint64_t size = file->binary.size;
+	uint64_t count, stringCount;
+	uint64_t poolOffset, poolSize, stringsOffset, namesOffset, patternsOffset;
+	uint64_t filesOffset, recordsOffset, dataOffset, dataSize;
+
+	if (size < TAG_BINARY_HEADER_SIZE
+		|| memcmp (p, TAG_BINARY_MAGIC, 8) != 0
+		|| getU32 (p + 8) != TAG_BINARY_VERSION)
+		return 0;
+
+	count = getU32 (p + 12);
+	stringCount = getU32 (p + 16);
+	poolOffset = getU64 (p + 24);
+	poolSize = getU64 (p + 32);
+	stringsOffset = getU64 (p + 40);
+	namesOffset = getU64 (p + 48);
+	patternsOffset = getU64 (p + 56);
+	filesOffset = getU64 (p + 64);
+	recordsOffset = getU64 (p + 72);
+	dataOffset = getU64 (p + 80);
+	dataSize = getU64 (p + 88);
+
+	if (!isSectionInFile (poolOffset, poolSize, size)
+		|| !isSectionInFile (stringsOffset, 4 * stringCount, size)
+		|| !isSectionInFile (namesOffset, 4 * count, size)
+		|| !isSectionInFile (patternsOffset, 4 * count, size)
+		|| !isSectionInFile (filesOffset, 4 * count, size)
+		|| !isSectionInFile (recordsOffset, 4 * (count + 1), size)
+		|| !isSectionInFile (dataOffset, dataSize, size))
+		return 0;
+	/* Every string in the pool must be terminated in the pool. */
+	if (poolSize == 0? count > 0: p [poolOffset + poolSize - 1] != '\0')
+		return 0;
+
+	file->binary.count = (uint32_t) count;
+	file->binary.stringCount = (uint32_t) stringCount;
+	file->binary.pool = (const char *) p + poolOffset;
+	file->binary.poolSize = (size_t) poolSize;
+	file->binary.strings = p + stringsOffset;
+	file->binary.names = p + namesOffset;
+	file->binary.patterns = p + patternsOffset;
+	file->binary.files = p + filesOffset;
+	file->binary.records = p + recordsOffset;
+	file->binary.data = p + dataOffset;
+	file->binary.dataSize = (size_t) dataSize;
+	return 1;
+}
+
+/* Load the tag file if it is in the binary format. Return 1 if it is
+ * loaded, 0 if it is not in the binary format, and -1 on error. */
+static int loadBinaryTagFile (tagFile *const file, int *err)
+{
+	char magic [8];
+	unsigned char *addr = NULL;
+
+	if (file->size < TAG_BINARY_HEADER_SIZE)
+		return 0;
+	if (fread (magic, 1, sizeof (magic), file->fp) != sizeof (magic)
+		|| readtags_fseek (file->fp, 0, SEEK_SET) < 0)
+	{
+		*err = errno;
+		return -1;
+	}
+	if (memcmp (magic, TAG_BINARY_MAGIC, sizeof (magic)) != 0)
+		return 0;
+
+	if ((unsigned long long) file->size > (unsigned long long) (size_t) -1)
+	{
+		*err = TagErrnoFileMaybeTooBig;
+		return -1;
+	}
+
+#ifdef READTAGS_MMAP
+	addr = mmap (NULL, (size_t) file->size, PROT_READ, MAP_PRIVATE,
+				 fileno (file->fp), 0);
+	if (addr == MAP_FAILED)
+		addr = NULL;
+	else
+		file->binary.mapped = 1;
+#endif
+	if (addr == NULL)
+	{
+		addr = (unsigned char *) malloc ((size_t) file->size);
+		if (addr == NULL)
+		{
+			*err = ENOMEM;
+			return -1;
+		}
+		if (fread (addr, 1, (size_t) file->size, file->fp) != (size_t) file->size
+			|| readtags_fseek (file->fp, 0, SEEK_SET) < 0)
+		{
+			free (addr);
+			*err = errno;
+			return -1;
+		}
+	}
+
+	file->binary.addr = addr;
+	file->binary.size = (size_t) file->size;
+	if (!parseBinaryHeader (file))
+	{
+		unloadBinaryTagFile (file);
+		*err = TagErrnoUnexpectedFormat;
+		return -1;
+	}
+	file->size = (rt_off_t) file->binary.count;
+	return 1;
+}
+
 static tagResult growFields (tagFile *const file)
 {
 	tagResult result = TagFailure;
@@ -566,12 +1267,111 @@ static char *unescapeInPlace (char *q, char **tab, size_t *p_len)
 	return p;
 }
 
+static int readVarint (const unsigned char **p, const unsigned char *const end,
+					   uint64_t *value)
+{
+	uint64_t v = 0;
+	unsigned int shift = 0;
+
+	while (*p < end && shift < 64)
+	{
+		const unsigned char c = *(*p)++;
+		v |= (uint64_t) (c & 0x7f) << shift;
+		if (!(c & 0x80))
+		{
+			*value = v;
+			return 1;
+		}
+		shift += 7;
+	}
+	return 0;
+}
+
+/* Same as parseTagLine() but for a tag file in the binary format.
+ * The strings of the entry point into the string pool. */
+static tagResult parseBinaryRow (tagFile *file, tagEntry *const entry, int *err)
+{
+	const uint32_t row = file->binary.row;
+	const uint32_t start = getU32 (file->binary.records + 4 * (size_t) row);
+	const uint32_t end = getU32 (file->binary.records + 4 * ((size_t) row + 1));
+	const unsigned char *p = file->binary.data + start;
+	const uint32_t fileId = getU32 (file->binary.files + 4 * (size_t) row);
+	const uint32_t pattern = getU32 (file->binary.patterns + 4 * (size_t) row);
+	uint64_t lineNumber, kind, fileScope, count, key, value;
+	unsigned int i;
+
+	memset (entry, 0, sizeof (*entry));
+
+	if (start > end || end > file->binary.dataSize)
+		goto broken;
+
+	entry->name = file->binary.name;
+	if (fileId != TAG_BINARY_NONE
+		&& (entry->file = binaryInternedString (file, fileId)) == NULL)
+		goto broken;
+	if (pattern != TAG_BINARY_NONE
+		&& (entry->address.pattern = binaryString (file, pattern)) == NULL)
+		goto broken;
+
+	if (!readVarint (&p, file->binary.data + end, &lineNumber)
+		|| !readVarint (&p, file->binary.data + end, &kind)
+		|| !readVarint (&p, file->binary.data + end, &fileScope)
+		|| !readVarint (&p, file->binary.data + end, &count)
+		|| count >= (unsigned short) -1)
+		goto broken;
+	entry->address.lineNumber = (unsigned long) lineNumber;
+	if (kind > 0
+		&& (entry->kind = binaryInternedString (file, kind - 1)) == NULL)
+		goto broken;
+	entry->fileScope = (fileScope != 0);
+
+	for (i = 0; i < count; i++)
+	{
+		if (i == file->fields.max && growFields (file) != TagSuccess)
+		{
+			*err = ENOMEM;
+			return TagFailure;
+		}
+		if (!readVarint (&p, file->binary.data + end, &key)
+			|| !readVarint (&p, file->binary.data + end, &value))
+			goto broken;
+		file->fields.list [i].key = binaryInternedString (file, key);
+		file->fields.list [i].value = binaryInternedString (file, value);
+		if (file->fields.list [i].key == NULL || file->fields.list [i].value == NULL)
+			goto broken;
+	}
+
+	entry->fields.count = (unsigned short) count;
+	if (entry->fields.count > 0)
+		entry->fields.list = file->fields.list;
+	for (; i < file->fields.max; ++i)
+	{
+		file->fields.list [i].key = NULL;
+		file->fields.list [i].value = NULL;
+	}
+	return TagSuccess;
+
+ broken:
+	*err = TagErrnoUnexpectedFormat;
+	return TagFailure;
+}
+
 static tagResult parseTagLine (tagFile *file, tagEntry *const entry, int *err)
 {
 	int i;
-	char *p = file->line.buffer;
-	size_t p_len = strlen (p);
-	char *tab = strchr (p, TAB);
+	char *p;
+	size_t p_len;
+	char *tab;
+
+	if (file->binary.addr != NULL)
+		return parseBinaryRow (file, entry, err);
+
+	if (copyMappedLine (file, err) != TagSuccess)
+		return TagFailure;
+
+	p = file->line.buffer;
+	p_len = strlen (p);
+	tab = strchr (p, TAB);
 
 	memset(entry, 0, sizeof(*entry));
 
@@ -701,7 +1501,7 @@ static int isPseudoTagLine (const char *buffer)
 
 static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 {
-	fpos_t startOfLine;
+	rt_off_t startOfLine = 0;
 	int err = 0;
 	tagResult result = TagSuccess;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
@@ -717,14 +1517,15 @@ static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 
 	while (1)
 	{
-		if (fgetpos (file->fp, &startOfLine) < 0)
+		startOfLine = tellTagFile (file);
+		if (startOfLine < 0)
 		{
 			err = errno;
 			break;
 		}
 		if (! readTagLine (file, &err))
 			break;
-		if (!isPseudoTagLine (file->line.buffer))
+		if (!isPseudoTagLine (lineName (file)))
 			break;
 		else
 		{
@@ -815,7 +1616,7 @@ static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 	if (tag_output_mode_u_ctags && tag_output_filesep_slash)
 		file->inputUCtagsMode = 1;
 
-	if (fsetpos (file->fp, &startOfLine) < 0)
+	if (seekTagFile (file, startOfLine) < 0)
 		err = errno;
 
 	info->status.error_number = err;
@@ -826,14 +1627,14 @@ static tagResult readPseudoTags (tagFile *const file, tagFileInfo *const info)
 
 static int doesFilePointPseudoTag (tagFile *const file, void *unused)
 {
-	return isPseudoTagLine (file->name.buffer);
+	return isPseudoTagLine (lineName (file));
 }
 
 static tagResult gotoFirstLogicalTag (tagFile *const file)
 {
-	fpos_t startOfLine;
+	rt_off_t startOfLine;
 
-	if (readtags_fseek(file->fp, 0, SEEK_SET) == -1)
+	if (seekTagFile (file, 0) == -1)
 	{
 		file->err = errno;
 		return TagFailure;
@@ -841,7 +1642,8 @@ static tagResult gotoFirstLogicalTag (tagFile *const file)
 
 	while (1)
 	{
-		if (fgetpos (file->fp, &startOfLine) < 0)
+		startOfLine = tellTagFile (file);
+		if (startOfLine < 0)
 		{
 			file->err = errno;
 			return TagFailure;
@@ -852,10 +1654,10 @@ static tagResult gotoFirstLogicalTag (tagFile *const file)
 				return TagFailure;
 			break;
 		}
-		if (!isPseudoTagLine (file->line.buffer))
+		if (!isPseudoTagLine (lineName (file)))
 			break;
 	}
-	if (fsetpos (file->fp, &startOfLine) < 0)
+	if (seekTagFile (file, startOfLine) < 0)
 	{
 		file->err = errno;
 		return TagFailure;
@@ -874,6 +1676,7 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 		return NULL;
 	}
 
+	result->partEnd = -1;
 	if (growString (&result->line) != TagSuccess)
 		goto mem_error;
 	if (growString (&result->name) != TagSuccess)
@@ -926,9 +1729,19 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 		goto file_error;
 	}
 
+	if (loadBinaryTagFile (result, &info->status.error_number) < 0)
+		goto file_error;
+
 	if (readPseudoTags (result, info) == TagFailure)
 		goto file_error;
 
+	if (result->binary.addr == NULL)
+	{
+		if (result->sortMethod != TAG_UNSORTED)
+			mapTagFile (result);
+		loadTagIndex (result, filePath);
+	}
+
 	info->status.opened = 1;
 	result->initialized = 1;
 
@@ -939,6 +1752,7 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 	free (result->line.buffer);
 	free (result->name.buffer);
 	free (result->fields.list);
+	unloadBinaryTagFile (result);
 	if (result->fp)
 		fclose (result->fp);
 	free (result);
@@ -948,6 +1762,9 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 
 static void terminate (tagFile *const file)
 {
+	unmapTagFile (file);
+	unloadTagIndex (file);
+	unloadBinaryTagFile (file);
 	fclose (file->fp);
 
 	free (file->line.buffer);
@@ -964,6 +1781,8 @@ static void terminate (tagFile *const file)
 		free (file->program.version);
 	if (file->search.name != NULL)
 		free (file->search.name);
+	if (file->search.found != NULL)
+		free (file->search.found);
 
 	memset (file, 0, sizeof (tagFile));
 
@@ -1010,7 +1829,7 @@ static const char *readFieldValue (
 
 static int readTagLineSeek (tagFile *const file, const rt_off_t pos)
 {
-	if (readtags_fseek (file->fp, pos, SEEK_SET) < 0)
+	if (seekTagFile (file, pos) < 0)
 	{
 		file->err = errno;
 		return 0;
@@ -1027,9 +1846,40 @@ static int readTagLineSeek (tagFile *const file, const rt_off_t pos)
 	return 1;
 }
 
+/* Same as tagnuppercmp() but for a name not escaped */
+static int rawnuppercmp (const char *s1, const char *s2, size_t n)
+{
+	int result;
+	int c1, c2;
+	do
+	{
+		c1 = (unsigned char)*s1++;
+		c2 = (unsigned char)*s2++;
+
+		result = toupper (c1) - toupper (c2);
+	} while (result == 0  &&  --n > 0  &&  c1 != '\0'  &&  c2 != '\0');
+	return result;
+}
+
+/* Names in the binary format are not escaped. */
+static int binaryNameComparison (tagFile *const file)
+{
+	const char *name = file->binary.name;
+
+	if (file->search.ignorecase)
+		return rawnuppercmp (file->search.name, name,
+							 file->search.partial? file->search.nameLength: (size_t) -1);
+	else if (file->search.partial)
+		return strncmp (file->search.name, name, file->search.nameLength);
+	else
+		return strcmp (file->search.name, name);
+}
+
 static int nameComparison (tagFile *const file)
 {
 	int result;
+	if (file->binary.addr != NULL)
+		return binaryNameComparison (file);
 	if (file->search.ignorecase)
 	{
 		if (file->search.partial)
@@ -1137,6 +1987,165 @@ static tagResult findBinary (tagFile *const file)
 	return result;
 }
 
+/* Same as findBinary() but for a tag file in the binary format;
+ * positions are row numbers, so rows can be bisected exactly. */
+static tagResult findBinaryRows (tagFile *const file)
+{
+	uint32_t lower = 0;
+	uint32_t upper = file->binary.count;
+
+	while (lower < upper)
+	{
+		const uint32_t middle = lower + (upper - lower) / 2;
+		file->binary.next = middle;
+		if (! readTagLine (file, &file->err))
+			return TagFailure;
+		if (nameComparison (file) > 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	file->binary.next = lower;
+	if (! readTagLine (file, &file->err))
+		return TagFailure;
+	return (nameComparison (file) == 0)? TagSuccess: TagFailure;
+}
+
+static int isSearchSorted (tagFile *const file)
+{
+	return (file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
+		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase);
+}
+
+static uint32_t indexedLine (const unsigned char *order, uint32_t i)
+{
+	return (order != NULL)? getU32 (order + 4 * (size_t) i): i;
+}
+
+static int readIndexedLine (tagFile *const file, uint32_t line)
+{
+	const rt_off_t offset = (rt_off_t) getU64 (file->index.offsets + 8 * (size_t) line);
+
+	if (seekTagFile (file, offset) < 0)
+	{
+		file->err = errno;
+		return 0;
+	}
+	return readTagLine (file, &file->err);
+}
+
+static int compareIndexedLines (const void *a, const void *b)
+{
+	const uint32_t la = *(const uint32_t *) a;
+	const uint32_t lb = *(const uint32_t *) b;
+	return (la < lb)? -1: (la > lb)? 1: 0;
+}
+
+/* Find the first matching line with the index. An exact match is looked
+ * up with the perfect hash function, and others are found with a binary
+ * search on the lines in the name order. If the matching lines are not
+ * consecutive in the tag file, they are collected for tagsFindNext(). */
+static tagResult findWithIndex (tagFile *const file)
+{
+	const unsigned char *order = file->search.ignorecase
+		? file->index.foldOrder
+		: file->index.nameOrder;
+	uint32_t first;
+	uint32_t allocated;
+	uint32_t i;
+
+	if (file->index.count == 0)
+		return TagFailure;
+
+	if (!file->search.partial && !file->search.ignorecase)
+	{
+		const uint64_t h = hashName (file->search.name, file->search.nameLength,
+									 file->index.seed);
+		const uint32_t d = getU32 (file->index.displacements
+								   + 4 * (size_t) hashBucket (h, file->index.bucketCount));
+		const uint32_t slot = (d & TAG_INDEX_DIRECT_SLOT)
+			? (d & ~TAG_INDEX_DIRECT_SLOT)
+			: hashSlot (h, d, file->index.keyCount);
+
+		if (slot >= file->index.keyCount)
+			return TagFailure;
+		first = getU32 (file->index.slots + 4 * (size_t) slot);
+		if (first >= file->index.count)
+			return TagFailure;
+	}
+	else
+	{
+		uint32_t lower = 0;
+		uint32_t upper = file->index.count;
+
+		while (lower < upper)
+		{
+			const uint32_t middle = lower + (upper - lower) / 2;
+			if (! readIndexedLine (file, indexedLine (order, middle)))
+				return TagFailure;
+			if (nameComparison (file) > 0)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		first = lower;
+		if (first == file->index.count)
+			return TagFailure;
+	}
+
+	if (! readIndexedLine (file, indexedLine (order, first)))
+		return TagFailure;
+	if (nameComparison (file) != 0)
+		return TagFailure;
+
+	/* tagsFindNext() reads the lines after this one. */
+	if (order == NULL && isSearchSorted (file))
+		return TagSuccess;
+
+	allocated = 16;
+	file->search.found = (uint32_t *) malloc (allocated * sizeof (uint32_t));
+	if (file->search.found == NULL)
+	{
+		file->err = ENOMEM;
+		return TagFailure;
+	}
+	file->search.found [0] = indexedLine (order, first);
+	file->search.foundCount = 1;
+	for (i = first + 1; i < file->index.count; i++)
+	{
+		const uint32_t line = indexedLine (order, i);
+		if (! readIndexedLine (file, line))
+		{
+			if (file->err)
+				return TagFailure;
+			break;
+		}
+		if (nameComparison (file) != 0)
+			break;
+		if (file->search.foundCount == allocated)
+		{
+			uint32_t *found = (uint32_t *) realloc (file->search.found,
+													2 * allocated * sizeof (uint32_t));
+			if (found == NULL)
+			{
+				file->err = ENOMEM;
+				return TagFailure;
+			}
+			file->search.found = found;
+			allocated *= 2;
+		}
+		file->search.found [file->search.foundCount++] = line;
+	}
+	qsort (file->search.found, file->search.foundCount, sizeof (uint32_t),
+		   compareIndexedLines);
+
+	file->search.foundNext = 1;
+	if (! readIndexedLine (file, file->search.found [0]))
+		return TagFailure;
+	return TagSuccess;
+}
+
 static tagResult findSequentialFull (tagFile *const file,
 									 int (* isAcceptable) (tagFile *const, void *),
 									 void *data)
@@ -1171,10 +2180,81 @@ static tagResult findSequential (tagFile *const file)
 	return findSequentialFull (file, nameAcceptable, NULL);
 }
 
+/* Update `size' with the current size of the tag file. */
+static tagResult measureTagFile (tagFile *const file)
+{
+	if (remapTagFileIfResized (file) != TagSuccess)
+		return TagFailure;
+	if (file->binary.addr != NULL)
+		file->size = (rt_off_t) file->binary.count;
+	else if (file->map.addr != NULL)
+		file->size = (rt_off_t) file->map.size;
+	else
+	{
+		if (readtags_fseek (file->fp, 0, SEEK_END) < 0)
+		{
+			file->err = errno;
+			return TagFailure;
+		}
+		file->size = readtags_ftell (file->fp);
+		if (file->size == -1)
+		{
+			file->err = errno;
+			return TagFailure;
+		}
+	}
+	return TagSuccess;
+}
+
+/* The offset of the start of the PART-th of COUNT parts of LENGTH */
+static rt_off_t partOffset (rt_off_t length, unsigned int part, unsigned int count)
+{
+	return length / count * part + length % count * part / count;
+}
+
+/* Limit reading lines to the PART-th of COUNT parts of the tag file
+ * between FROM and the end, and seek to the first line in the part.
+ * The parts have about the same size; a line belongs to the part where
+ * the line starts. */
+static tagResult seekToPart (tagFile *const file, rt_off_t from,
+							 unsigned int part, unsigned int count)
+{
+	const rt_off_t length = file->size - from;
+	const rt_off_t start = from + partOffset (length, part, count);
+
+	file->partEnd = -1;
+	if (start > from && file->binary.addr == NULL)
+	{
+		/* Skip the rest of the line having the byte before the start. */
+		if (seekTagFile (file, start - 1) < 0)
+		{
+			file->err = errno;
+			return TagFailure;
+		}
+		if (! ((file->map.addr != NULL)
+			   ? readTagLineMapped (file, &file->err)
+			   : readTagLineRaw (file, &file->err))
+			&& file->err)
+			return TagFailure;
+	}
+	else if (seekTagFile (file, start) < 0)
+	{
+		file->err = errno;
+		return TagFailure;
+	}
+
+	file->partEnd = (part + 1 == count)
+		? file->size
+		: from + partOffset (length, part + 1, count);
+	return TagSuccess;
+}
+
 static tagResult find (tagFile *const file, tagEntry *const entry,
-					   const char *const name, const int options)
+					   const char *const name, const int options,
+					   unsigned int part, unsigned int count)
 {
 	tagResult result;
+	file->partEnd = -1;
 	if (file->search.name != NULL)
 		free (file->search.name);
 	file->search.name = duplicate (name);
@@ -1186,31 +2266,38 @@ static tagResult find (tagFile *const file, tagEntry *const entry,
 	file->search.nameLength = strlen (name);
 	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
 	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
-	if (readtags_fseek (file->fp, 0, SEEK_END) < 0)
+	if (file->search.found != NULL)
 	{
-		file->err = errno;
-		return TagFailure;
+		free (file->search.found);
+		file->search.found = NULL;
 	}
-	file->size = readtags_ftell (file->fp);
-	if (file->size == -1)
-	{
-		file->err = errno;
+	if (measureTagFile (file) != TagSuccess)
 		return TagFailure;
-	}
-	if (readtags_fseek(file->fp, 0, SEEK_SET) == -1)
+	if (seekTagFile (file, 0) == -1)
 	{
 		file->err = errno;
 		return TagFailure;
 	}
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
-		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
+	if (file->index.addr != NULL && file->index.tagFileSize != file->size)
+		unloadTagIndex (file);
+	if (file->index.addr != NULL || isSearchSorted (file))
 	{
-		result = findBinary (file);
+		/* Not divided; the first part has all. */
+		if (part > 0)
+			result = TagFailure;
+		else if (file->index.addr != NULL)
+			result = findWithIndex (file);
+		else
+			result = (file->binary.addr != NULL)
+				? findBinaryRows (file)
+				: findBinary (file);
 		if (result == TagFailure && file->err)
 			return TagFailure;
 	}
 	else
 	{
+		if (count > 1 && seekToPart (file, 0, part, count) != TagSuccess)
+			return TagFailure;
 		result = findSequential (file);
 		if (result == TagFailure && file->err)
 			return TagFailure;
@@ -1236,7 +2323,7 @@ static tagResult findNextFull (tagFile *const file, tagEntry *const entry,
 	tagResult result;
 	if (sorted)
 	{
-		result = tagsNext (file, entry);
+		result = readNext (file, entry);
 		if (result == TagSuccess  && !isAcceptable (file, data))
 			result = TagFailure;
 	}
@@ -1251,10 +2338,17 @@ static tagResult findNextFull (tagFile *const file, tagEntry *const entry,
 
 static tagResult findNext (tagFile *const file, tagEntry *const entry)
 {
-	return findNextFull (file, entry,
-						 (file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
-						 (file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase),
-						 nameAcceptable, NULL);
+	if (file->search.found != NULL)
+	{
+		if (file->search.foundNext >= file->search.foundCount)
+			return TagFailure;
+		if (! readIndexedLine (file, file->search.found [file->search.foundNext++]))
+			return TagFailure;
+		return (entry != NULL)
+			? parseTagLine (file, entry, &file->err)
+			: TagSuccess;
+	}
+	return findNextFull (file, entry, isSearchSorted (file), nameAcceptable, NULL);
 }
 
 static tagResult findPseudoTag (tagFile *const file, int rewindBeforeFinding, tagEntry *const entry)
@@ -1268,9 +2362,13 @@ static tagResult findPseudoTag (tagFile *const file, int rewindBeforeFinding, ta
 		return TagFailure;
 	}
 
+	if (remapTagFileIfResized (file) != TagSuccess)
+		return TagFailure;
+
 	if (rewindBeforeFinding)
 	{
-		if (readtags_fseek(file->fp, 0, SEEK_SET) == -1)
+		file->partEnd = -1;
+		if (seekTagFile (file, 0) == -1)
 		{
 			file->err = errno;
 			return TagFailure;
@@ -1310,6 +2408,8 @@ extern tagResult tagsSetSortType (tagFile *const file, const tagSortType type)
 	case TAG_SORTED:
 	case TAG_FOLDSORTED:
 		file->sortMethod = type;
+		if (type != TAG_UNSORTED)
+			mapTagFile (file);
 		return TagSuccess;
 	default:
 		file->err = TagErrnoUnexpectedSortedMethod;
@@ -1328,11 +2428,44 @@ extern tagResult tagsFirst (tagFile *const file, tagEntry *const entry)
 		return TagFailure;
 	}
 
+	file->partEnd = -1;
+	if (remapTagFileIfResized (file) != TagSuccess)
+		return TagFailure;
 	if (gotoFirstLogicalTag (file) != TagSuccess)
 		return TagFailure;
 	return readNext (file, entry);
 }
 
+extern tagResult tagsFirstInPart (tagFile *const file, tagEntry *const entry,
+								  unsigned int part, unsigned int count)
+{
+	rt_off_t from;
+
+	if (file == NULL)
+		return TagFailure;
+
+	if (!file->initialized || file->err || part >= count)
+	{
+		file->err = TagErrnoInvalidArgument;
+		return TagFailure;
+	}
+
+	file->partEnd = -1;
+	if (measureTagFile (file) != TagSuccess)
+		return TagFailure;
+	if (gotoFirstLogicalTag (file) != TagSuccess)
+		return TagFailure;
+	from = tellTagFile (file);
+	if (from < 0)
+	{
+		file->err = errno;
+		return TagFailure;
+	}
+	if (seekToPart (file, from, part, count) != TagSuccess)
+		return TagFailure;
+	return readNext (file, entry);
+}
+
 extern tagResult tagsNext (tagFile *const file, tagEntry *const entry)
 {
 	if (file == NULL)
@@ -1344,6 +2477,8 @@ extern tagResult tagsNext (tagFile *const file, tagEntry *const entry)
 		return TagFailure;
 	}
 
+	if (remapTagFileIfResized (file) != TagSuccess)
+		return TagFailure;
 	return readNext (file, entry);
 }
 
@@ -1367,7 +2502,23 @@ extern tagResult tagsFind (tagFile *const file, tagEntry *const entry,
 		return TagFailure;
 	}
 
-	return find (file, entry, name, options);
+	return find (file, entry, name, options, 0, 1);
+}
+
+extern tagResult tagsFindInPart (tagFile *const file, tagEntry *const entry,
+								 const char *const name, const int options,
+								 unsigned int part, unsigned int count)
+{
+	if (file == NULL)
+		return TagFailure;
+
+	if (!file->initialized || file->err || part >= count)
+	{
+		file->err = TagErrnoInvalidArgument;
+		return TagFailure;
+	}
+
+	return find (file, entry, name, options, part, count);
 }
 
 extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
@@ -1381,6 +2532,8 @@ extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
 		return TagFailure;
 	}
 
+	if (remapTagFileIfResized (file) != TagSuccess)
+		return TagFailure;
 	return findNext (file, entry);
 }
 
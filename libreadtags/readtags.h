@@ -202,6 +202,20 @@ extern tagResult tagsSetSortType (tagFile *const file, const tagSortType type);
 */
 extern tagResult tagsFirst (tagFile *const file, tagEntry *const entry);
 
+/*
+*  Same as tagsFirst() but reads the first tag in a part of the file.
+*  The regular tags are divided into COUNT parts having about the same
+*  size in bytes (or in rows for the binary format), at the boundaries
+*  of lines. PART, from 0 to COUNT - 1, specifies the part. After this
+*  function, tagsNext() returns TagFailure at the end of the part; the
+*  tags read from all the parts in the order of PART are the same as
+*  the tags read with tagsFirst() and tagsNext(). This is for reading a
+*  tag file with multiple processes or threads, each having its own
+*  tagFile opened with tagsOpen().
+*/
+extern tagResult tagsFirstInPart (tagFile *const file, tagEntry *const entry,
+								  unsigned int part, unsigned int count);
+
 /*
 *  Step to the next tag in the file, if any. It is passed the handle to an
 *  opened tag file and a (possibly null) pointer to a structure which, if not
@@ -257,6 +271,18 @@ extern tagResult tagsFind (tagFile *const file, tagEntry *const entry, const cha
 */
 extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry);
 
+/*
+*  Same as tagsFind() but finds the first tag in a part of the file,
+*  divided as tagsFirstInPart() does. tagsFindNext() finds the next tag
+*  in the same part. If tagsFind() can search the file without reading
+*  all the lines (the file is sorted in the order of the search, or
+*  indexed), the file is not divided: the part 0 has all the tags found,
+*  and the other parts have none.
+*/
+extern tagResult tagsFindInPart (tagFile *const file, tagEntry *const entry,
+								 const char *const name, const int options,
+								 unsigned int part, unsigned int count);
+
 /*
 *  Does the same as tagsFirst(), but is specialized to pseudo tags.
 *  If tagFileInfo doesn't contain pseudo tags you are interested in, read
@@ -0,0 +1,210 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released into the public domain.
+*
+*   Testing tagsFirstInPart() and tagsFindInPart() API functions
+*/
+
+#include "readtags.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX_TAGS 64
+#define MAX_PARTS 40
+#define KEY_SIZE 256
+
+struct walk {
+	unsigned int count;
+	char keys [MAX_TAGS][KEY_SIZE];
+};
+
+static void
+make_key (tagEntry *e, char *key)
+{
+	snprintf (key, KEY_SIZE, "%s\t%s\t%s",
+			  e->name, e->address.pattern, e->kind? e->kind: "");
+}
+
+static int
+add_tag (struct walk *w, tagEntry *e)
+{
+	if (w->count == MAX_TAGS)
+	{
+		fprintf (stderr, "too many tags\n");
+		return 1;
+	}
+	make_key (e, w->keys [w->count++]);
+	return 0;
+}
+
+/* Walk the whole tag file (NAME == NULL), or the tags found with NAME. */
+static int
+walk_all (tagFile *t, const char *name, int options, struct walk *w)
+{
+	tagEntry e;
+	tagResult r;
+
+	w->count = 0;
+	for (r = name? tagsFind (t, &e, name, options): tagsFirst (t, &e);
+		 r == TagSuccess;
+		 r = name? tagsFindNext (t, &e): tagsNext (t, &e))
+	{
+		if (add_tag (w, &e))
+			return 1;
+	}
+	if (tagsGetErrno (t) != 0)
+	{
+		fprintf (stderr, "error in walking: %d\n", tagsGetErrno (t));
+		return 1;
+	}
+	return 0;
+}
+
+static int
+walk_parts (tagFile *t, const char *name, int options, unsigned int count,
+			struct walk *w)
+{
+	tagEntry e;
+	tagResult r;
+
+	w->count = 0;
+	for (unsigned int part = 0; part < count; part++)
+	{
+		for (r = name
+				 ? tagsFindInPart (t, &e, name, options, part, count)
+				 : tagsFirstInPart (t, &e, part, count);
+			 r == TagSuccess;
+			 r = name? tagsFindNext (t, &e): tagsNext (t, &e))
+		{
+			if (add_tag (w, &e))
+				return 1;
+		}
+		if (tagsGetErrno (t) != 0)
+		{
+			fprintf (stderr, "error in walking the part %u of %u: %d\n",
+					 part, count, tagsGetErrno (t));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int
+compare_walks (struct walk *expected, struct walk *actual, unsigned int count)
+{
+	if (expected->count != actual->count)
+	{
+		fprintf (stderr, "unexpected number of tags in %u parts: %u (expected: %u)\n",
+				 count, actual->count, expected->count);
+		return 1;
+	}
+	for (unsigned int i = 0; i < expected->count; i++)
+	{
+		if (strcmp (expected->keys [i], actual->keys [i]) != 0)
+		{
+			fprintf (stderr, "unexpected tag at %u in %u parts: %s (expected: %s)\n",
+					 i, count, actual->keys [i], expected->keys [i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int
+check_file (const char *file)
+{
+	static struct walk expected, actual;
+	static const struct {
+		const char *name;
+		int options;
+	} searches [] = {
+		{ NULL, 0 },
+		{ "n", TAG_FULLMATCH },
+		{ "n", TAG_FULLMATCH | TAG_IGNORECASE },
+		{ "m", TAG_PARTIALMATCH },
+	};
+	tagFileInfo info;
+	tagFile *t;
+	tagEntry e;
+	int r = 1;
+
+	fprintf (stderr, "opening %s...", file);
+	t = tagsOpen (file, &info);
+	if (t == NULL || info.status.opened == 0)
+	{
+		fprintf (stderr, "unexpected result (t: %p, opened: %d)\n",
+				 t, info.status.opened);
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "rejecting an invalid part...");
+	if (tagsFirstInPart (t, &e, 2, 2) != TagFailure
+		|| tagsGetErrno (t) != TagErrnoInvalidArgument)
+	{
+		fprintf (stderr, "unexpected result\n");
+		goto out;
+	}
+	tagsClose (t);
+	t = tagsOpen (file, &info);
+	if (t == NULL)
+	{
+		fprintf (stderr, "failed to reopen\n");
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	for (unsigned int s = 0; s < sizeof (searches) / sizeof (searches [0]); s++)
+	{
+		fprintf (stderr, "walking parts (name: %s, options: %d)...",
+				 searches [s].name? searches [s].name: "(null)", searches [s].options);
+		if (walk_all (t, searches [s].name, searches [s].options, &expected))
+			goto out;
+		if (expected.count == 0)
+		{
+			fprintf (stderr, "no tag found\n");
+			goto out;
+		}
+		for (unsigned int count = 1; count <= MAX_PARTS; count++)
+		{
+			if (walk_parts (t, searches [s].name, searches [s].options, count, &actual))
+				goto out;
+			if (compare_walks (&expected, &actual, count))
+				goto out;
+		}
+		fprintf (stderr, "ok\n");
+	}
+
+	fprintf (stderr, "walking after a part...");
+	if (walk_all (t, NULL, 0, &expected)
+		|| tagsFirstInPart (t, &e, 0, MAX_PARTS) != TagSuccess
+		|| walk_all (t, NULL, 0, &actual)
+		|| compare_walks (&expected, &actual, 1))
+		goto out;
+	fprintf (stderr, "ok\n");
+
+	r = 0;
+ out:
+	tagsClose (t);
+	return r;
+}
+
+int
+main (void)
+{
+	static const char *files [] = {
+		"./duplicated-names--sorted-no.tags",
+		"./duplicated-names--sorted-yes.tags",
+		"./duplicated-names--sorted-foldcase.tags",
+	};
+
+	for (unsigned int i = 0; i < sizeof (files) / sizeof (files [0]); i++)
+	{
+		if (check_file (files [i]))
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,249 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released into the public domain.
+*
+*   Testing the lines read from a sorted (memory mapped) tags file:
+*   CRLF line endings, a null character in a line, and the last line
+*   having no newline. Testing reading lines after the tags file is
+*   truncated and rewritten while it is open.
+*/
+
+#include "readtags.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define	TAGS "./remove-me-after-testing-tagsNext.tags"
+
+static const char tags [] =
+	"!_TAG_FILE_FORMAT\t2\t/extended format; --format=1 will not append ;\" to lines/\r\n"
+	"!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\r\n"
+	"alpha\ta.c\t/^alpha$/;\"\tf\r\n"
+	"beta\tb.c\t/^beta$/;\"\tv\tline:2\r\n"
+	"gamma\tg.c\t/^gamma$/;\"\tf\0garbage\n"
+	"omega\to.c\t/^omega$/;\"\tm";
+
+struct expectation {
+	const char *name;
+	const char *file;
+	const char *kind;
+	unsigned long lineNumber;
+};
+
+static struct expectation expectations [] = {
+	{ "alpha", "a.c", "f", 0 },
+	{ "beta",  "b.c", "v", 2 },
+	{ "gamma", "g.c", "f", 0 },
+	{ "omega", "o.c", "m", 0 },
+};
+
+#define COUNT(x) (sizeof(x)/sizeof(x[0]))
+
+static int
+make_tags (const char *output)
+{
+	FILE *fp = fopen (output, "wb");
+	if (fp == NULL)
+		return 1;
+
+	if (fwrite (tags, 1, sizeof (tags) - 1, fp) != sizeof (tags) - 1)
+	{
+		fclose (fp);
+		return 1;
+	}
+	return (fclose (fp) == 0)? 0: 1;
+}
+
+/* Larger than a page so that reading the stale mapping of the truncated
+ * file would raise SIGBUS. */
+static int
+make_padded_tags (const char *output)
+{
+	FILE *fp = fopen (output, "wb");
+	if (fp == NULL)
+		return 1;
+
+	if (fwrite (tags, 1, sizeof (tags) - 1, fp) != sizeof (tags) - 1
+		|| fputc ('\n', fp) == EOF)
+	{
+		fclose (fp);
+		return 1;
+	}
+	for (int i = 0; i < 1000; i++)
+	{
+		if (fprintf (fp, "pad%04d\tp.c\t/^pad$/;\"\tv\n", i) < 0)
+		{
+			fclose (fp);
+			return 1;
+		}
+	}
+	return (fclose (fp) == 0)? 0: 1;
+}
+
+static int
+check_entry (tagEntry *e, struct expectation *x)
+{
+	if (strcmp (e->name, x->name) != 0
+		|| strcmp (e->file, x->file) != 0
+		|| e->kind == NULL
+		|| strcmp (e->kind, x->kind) != 0
+		|| e->address.lineNumber != x->lineNumber)
+	{
+		fprintf (stderr, "unexpected entry: %s %s %s %lu (expected: %s %s %s %lu)\n",
+				 e->name, e->file, e->kind? e->kind: "(null)", e->address.lineNumber,
+				 x->name, x->file, x->kind, x->lineNumber);
+		return 1;
+	}
+	return 0;
+}
+
+int
+main (void)
+{
+	tagFile *t;
+	tagFileInfo info;
+	tagEntry e;
+	int r = 1;
+
+	if (make_tags (TAGS) != 0)
+	{
+		perror ("make_tags");
+		return 99;
+	}
+
+	t = tagsOpen (TAGS, &info);
+	if (t == NULL || info.status.opened == 0)
+	{
+		fprintf (stderr, "unexpected result (t: %p, opened: %d)\n",
+				 t, info.status.opened);
+		goto out;
+	}
+
+	fprintf (stderr, "finding...");
+	for (unsigned int i = 0; i < COUNT (expectations); i++)
+	{
+		if (tagsFind (t, &e, expectations [i].name, TAG_FULLMATCH) != TagSuccess)
+		{
+			fprintf (stderr, "cannot find \"%s\"\n", expectations [i].name);
+			goto out;
+		}
+		if (check_entry (&e, expectations + i))
+			goto out;
+	}
+	if (tagsFind (t, &e, "zeta", TAG_FULLMATCH) == TagSuccess
+		|| tagsGetErrno (t) != 0)
+	{
+		fprintf (stderr, "found \"zeta\" unexpectedly\n");
+		goto out;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "walking after finding...");
+	if (tagsFind (t, &e, "b", TAG_PARTIALMATCH) != TagSuccess
+		|| check_entry (&e, expectations + 1))
+		goto out;
+	for (unsigned int i = 2; i < COUNT (expectations); i++)
+	{
+		if (tagsNext (t, &e) != TagSuccess)
+		{
+			fprintf (stderr, "cannot read the next of \"%s\"\n", expectations [i - 1].name);
+			goto out;
+		}
+		if (check_entry (&e, expectations + i))
+			goto out;
+	}
+	if (tagsNext (t, &e) == TagSuccess || tagsGetErrno (t) != 0)
+	{
+		fprintf (stderr, "unexpected entry after the last one\n");
+		goto out;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "walking from the first...");
+	if (tagsFirst (t, &e) != TagSuccess
+		|| check_entry (&e, expectations + 0))
+		goto out;
+	for (unsigned int i = 1; i < COUNT (expectations); i++)
+	{
+		if (tagsNext (t, &e) != TagSuccess
+			|| check_entry (&e, expectations + i))
+			goto out;
+	}
+	fprintf (stderr, "ok\n");
+
+	tagsClose (t);
+	t = NULL;
+
+	fprintf (stderr, "walking after truncating and rewriting...");
+	if (make_padded_tags (TAGS) != 0)
+	{
+		perror ("make_padded_tags");
+		goto out;
+	}
+	t = tagsOpen (TAGS, &info);
+	if (t == NULL || info.status.opened == 0)
+	{
+		fprintf (stderr, "unexpected result (t: %p, opened: %d)\n",
+				 t, info.status.opened);
+		goto out;
+	}
+	if (tagsFirst (t, &e) != TagSuccess
+		|| check_entry (&e, expectations + 0)
+		|| tagsNext (t, &e) != TagSuccess
+		|| check_entry (&e, expectations + 1))
+		goto out;
+	/* The lines read so far are the same in the rewritten file. */
+	if (make_tags (TAGS) != 0)
+	{
+		perror ("make_tags");
+		goto out;
+	}
+	for (unsigned int i = 2; i < COUNT (expectations); i++)
+	{
+		if (tagsNext (t, &e) != TagSuccess
+			|| check_entry (&e, expectations + i))
+			goto out;
+	}
+	if (tagsNext (t, &e) == TagSuccess || tagsGetErrno (t) != 0)
+	{
+		fprintf (stderr, "unexpected entry after the last one\n");
+		goto out;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "walking pseudo tags after truncating...");
+	if (make_padded_tags (TAGS) != 0)
+	{
+		perror ("make_padded_tags");
+		goto out;
+	}
+	if (tagsFirstPseudoTag (t, &e) != TagSuccess
+		|| strcmp (e.name, "!_TAG_FILE_FORMAT") != 0)
+	{
+		fprintf (stderr, "cannot read the first pseudo tag\n");
+		goto out;
+	}
+	if (make_tags (TAGS) != 0)
+	{
+		perror ("make_tags");
+		goto out;
+	}
+	if (tagsNextPseudoTag (t, &e) != TagSuccess
+		|| strcmp (e.name, "!_TAG_FILE_SORTED") != 0
+		|| tagsNextPseudoTag (t, &e) == TagSuccess)
+	{
+		fprintf (stderr, "unexpected pseudo tags\n");
+		goto out;
+	}
+	fprintf (stderr, "ok\n");
+
+	r = 0;
+ out:
+	if (t)
+		tagsClose (t);
+	remove (TAGS);
+	return r;
+}
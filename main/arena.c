@@ -0,0 +1,184 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for an arena, a bump allocator. Blocks
+*   are carved out of large chunks, and released all at once with
+*   arenaClear(). The chunks are kept for the next use of the arena
+*   up to a limit; an arena used for each input file doesn't call malloc()
+*   after the first few input files.
+*
+*   Overruns and uses after arenaClear() are invisible to AddressSanitizer
+*   in a chunk. If ARENA_DEBUG is defined, or if the code is built with
+*   AddressSanitizer, each block is allocated with malloc() instead.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+
+#include "arena_p.h"
+#include "debug.h"
+#include "ptrarray.h"
+#include "routines.h"
+
+/*
+*   MACROS
+*/
+#if defined (__SANITIZE_ADDRESS__)
+# define ARENA_DEBUG
+#elif defined (__has_feature)
+# if __has_feature (address_sanitizer)
+#  define ARENA_DEBUG
+# endif
+#endif
+
+/* The number of chunks of the default size kept by arenaClear() */
+#define ARENA_SPARE_CHUNKS 16
+
+/*
+*   DATA DECLARATIONS
+*/
+union arenaAlignment {
+	long double ld;
+	uint64_t u64;
+	void *p;
+	void (*fn) (void);
+};
+
+struct arenaAlignmentProbe {
+	char c;
+	union arenaAlignment u;
+};
+
+#define ARENA_ALIGNMENT (offsetof (struct arenaAlignmentProbe, u))
+#define ARENA_ROUND_UP(N) (((N) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+typedef struct sArenaChunk {
+	struct sArenaChunk *next;
+	size_t size;				/* bytes for blocks */
+	size_t used;
+} arenaChunk;
+
+#define ARENA_CHUNK_HEADER_SIZE ARENA_ROUND_UP (sizeof (arenaChunk))
+
+struct sArena {
+	size_t chunkSize;
+	arenaChunk *chunks;			/* the first one is the current chunk */
+	arenaChunk *spares;
+	unsigned int spareCount;
+#ifdef ARENA_DEBUG
+	ptrArray *blocks;
+#endif
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern arena *arenaNew (size_t chunkSize)
+{
+	arena *a = xCalloc (1, arena);
+
+	a->chunkSize = ARENA_ROUND_UP (chunkSize);
+#ifdef ARENA_DEBUG
+	a->blocks = ptrArrayNew (eFree);
+#endif
+	return a;
+}
+
+static void deleteChunks (arenaChunk *chunk)
+{
+	while (chunk)
+	{
+		arenaChunk *next = chunk->next;
+		eFree (chunk);
+		chunk = next;
+	}
+}
+
+extern void arenaDelete (arena *a)
+{
+	deleteChunks (a->chunks);
+	deleteChunks (a->spares);
+#ifdef ARENA_DEBUG
+	ptrArrayDelete (a->blocks);
+#endif
+	eFree (a);
+}
+
+#ifndef ARENA_DEBUG
+static arenaChunk *newChunk (arena *a, size_t size)
+{
+	arenaChunk *chunk;
+
+	if (size <= a->chunkSize && a->spares)
+	{
+		chunk = a->spares;
+		a->spares = chunk->next;
+		a->spareCount--;
+	}
+	else
+	{
+		if (size < a->chunkSize)
+			size = a->chunkSize;
+		chunk = eMalloc (ARENA_CHUNK_HEADER_SIZE + size);
+		chunk->size = size;
+	}
+
+	chunk->used = 0;
+	chunk->next = a->chunks;
+	a->chunks = chunk;
+	return chunk;
+}
+#endif
+
+extern void *arenaAlloc (arena *a, size_t size)
+{
+#ifdef ARENA_DEBUG
+	void *block = eMalloc (size);
+	ptrArrayAdd (a->blocks, block);
+	return block;
+#else
+	arenaChunk *chunk = a->chunks;
+
+	size = ARENA_ROUND_UP (size);
+	if (chunk == NULL || chunk->size - chunk->used < size)
+		chunk = newChunk (a, size);
+
+	void *block = (char *)chunk + ARENA_CHUNK_HEADER_SIZE + chunk->used;
+	chunk->used += size;
+	return block;
+#endif
+}
+
+extern void arenaClear (arena *a)
+{
+	arenaChunk *chunk = a->chunks;
+
+	while (chunk)
+	{
+		arenaChunk *next = chunk->next;
+
+		/* Chunks for large blocks are not reused. */
+		if (chunk->size == a->chunkSize && a->spareCount < ARENA_SPARE_CHUNKS)
+		{
+			chunk->next = a->spares;
+			a->spares = chunk;
+			a->spareCount++;
+		}
+		else
+			eFree (chunk);
+		chunk = next;
+	}
+	a->chunks = NULL;
+
+#ifdef ARENA_DEBUG
+	ptrArrayClear (a->blocks);
+#endif
+}
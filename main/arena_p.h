@@ -0,0 +1,40 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines internal interface to an arena, a bump allocator releasing all
+*   the blocks allocated in it at once.
+*/
+#ifndef CTAGS_MAIN_ARENA_PRIVATE_H
+#define CTAGS_MAIN_ARENA_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stddef.h>
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sArena arena;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* CHUNK_SIZE is the size of the memory chunks blocks are allocated from. */
+extern arena *arenaNew (size_t chunkSize);
+extern void arenaDelete (arena *a);
+
+/* Return a block of SIZE bytes aligned for any type. The block is valid
+ * until arenaClear() or arenaDelete() is called. */
+extern void *arenaAlloc (arena *a, size_t size);
+
+/* Release all the blocks. Some chunks are kept for reusing them. */
+extern void arenaClear (arena *a);
+
+#endif	/* CTAGS_MAIN_ARENA_PRIVATE_H */
@@ -0,0 +1,559 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for the persistent tag cache
+*   (--cache-dir option).
+*
+*   The cache stores the tag lines made from an input file in an entry
+*   file under the cache directory. The name of the entry is a hash of
+*   the contents of the input file, its name as written in the tag file,
+*   the parser and its version, and the options affecting the output.
+*   A hit lets ctags copy the tag lines to the tag file without running
+*   the parser.
+*
+*   The pseudo tags are not stored in entries. Instead, the names of the
+*   parsers that printed their pseudo tags while parsing the input file
+*   are stored, and the pseudo tags are made again on a hit.
+*
+*   Entries are written to temporary files and renamed, so concurrent
+*   ctags processes (and --jobs workers) never see a partial entry. When
+*   the cache grows larger than --cache-size, the least recently used
+*   entries are removed.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+
+#ifdef HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_DIRENT_H
+# include <dirent.h>
+#endif
+#ifdef HAVE_DIRECT_H
+# include <direct.h>  /* to declare _mkdir() */
+#endif
+#ifdef HAVE_UTIME_H
+# include <utime.h>
+#endif
+
+#include "cache_p.h"
+#include "ctags.h"
+#include "debug.h"
+#include "field.h"
+#include "mio.h"
+#include "options_p.h"
+#include "parse_p.h"
+#include "ptrarray.h"
+#include "read_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "strlist.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define CACHE_MAGIC "!_CTAGS_CACHE\t1\n"
+#define plural(value)  (((unsigned long)(value) == 1L) ? "" : "s")
+
+/*
+*   DATA DECLARATIONS
+*/
+
+/* Two 64 bit hashes make the 128 bit name of an entry. */
+typedef struct sCacheHash {
+	uint64_t h1;
+	uint64_t h2;
+} cacheHash;
+
+struct sTagCacheEntry {
+	char *fileName;				/* The name of the entry file */
+	bool hit;
+	bool storing;
+
+	/* Read from the entry on a hit, or collected on a miss */
+	char *tags;
+	size_t length;
+	unsigned long numTags;
+	unsigned long numLines;
+	stringList *ptagParsers;
+
+	size_t inputSize;
+};
+
+typedef struct sCacheFile {
+	char *name;
+	size_t size;
+	time_t mtime;
+} cacheFile;
+
+/*
+*   DATA DEFINITIONS
+*/
+static cacheHash OptionsHash = { 0xcbf29ce484222325ULL, 0x9e3779b97f4a7c15ULL };
+static tagCacheEntry *CurrentEntry;
+static tagCacheStats Stats;
+
+/* Options not affecting the tag lines made from an input file. */
+static const char *const IgnoredOptions [] = {
+	"append", "cache-dir", "cache-size", "cache-stats", "f", "jobs",
+	"L", "o", "options", "quiet", "R", "recurse", "sort", "sort-memory",
+	"totals", "u", "update", "V", "verbose",
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static void hashBytes (cacheHash *hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	uint64_t h1 = hash->h1;
+	uint64_t h2 = hash->h2;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		/* FNV-1a */
+		h1 = (h1 ^ p [i]) * 0x100000001b3ULL;
+		/* A multiplicative hash with rotation */
+		h2 = ((h2 << 5) | (h2 >> 59)) ^ p [i];
+		h2 *= 0x9e3779b97f4a7c15ULL;
+	}
+
+	hash->h1 = h1;
+	hash->h2 = h2;
+}
+
+static void hashString (cacheHash *hash, const char *str)
+{
+	/* Including the terminator separates adjacent strings. */
+	hashBytes (hash, str, strlen (str) + 1);
+}
+
+static void hashNumber (cacheHash *hash, unsigned long long n)
+{
+	char buf [32];
+	snprintf (buf, sizeof (buf), "%llu", n);
+	hashString (hash, buf);
+}
+
+extern bool isTagCacheEnabled (void)
+{
+	return Option.cacheDir != NULL;
+}
+
+extern void hashOptionForTagCache (const char *const option, const char *const parameter)
+{
+	for (unsigned int i = 0; i < ARRAY_SIZE (IgnoredOptions); i++)
+		if (strcmp (option, IgnoredOptions [i]) == 0)
+			return;
+
+	hashString (&OptionsHash, option);
+	hashString (&OptionsHash, parameter? parameter: "");
+}
+
+static bool hashInput (cacheHash *hash, MIO *mio, size_t *size)
+{
+	char buf [64 * 1024];
+	size_t n;
+
+	*size = 0;
+	mio_rewind (mio);
+	while ((n = mio_read (mio, buf, 1, sizeof (buf))) > 0)
+	{
+		hashBytes (hash, buf, n);
+		*size += n;
+	}
+	bool r = !mio_error (mio);
+	mio_rewind (mio);
+	return r;
+}
+
+static char *makeEntryFileName (const cacheHash *hash)
+{
+	char name [3 + 1 + 32 + 1];
+
+	/* Spread the entries over 256 subdirectories. */
+	snprintf (name, sizeof (name), "%02x/%016llx%016llx",
+			  (unsigned int) (hash->h1 >> 56),
+			  (unsigned long long) hash->h1,
+			  (unsigned long long) hash->h2);
+	return combinePathAndFile (Option.cacheDir, name);
+}
+
+extern tagCacheEntry *openTagCacheEntry (const char *const fileName, const langType language,
+										 MIO *mio, time_t mtime)
+{
+	cacheHash hash = { 0xcbf29ce484222325ULL, 0x9e3779b97f4a7c15ULL };
+	size_t size;
+
+	Assert (CurrentEntry == NULL);
+
+	if (!hashInput (&hash, mio, &size))
+		return NULL;
+	hashNumber (&hash, size);
+
+	vString *tagPath = makeTagPathOfFile (fileName);
+	hashString (&hash, vStringValue (tagPath));
+	vStringDelete (tagPath);
+
+	if (isFieldEnabled (FIELD_EPOCH))
+		hashNumber (&hash, (unsigned long long) mtime);
+
+	hashString (&hash, getLanguageName (language));
+	hashNumber (&hash, getLanguageVersionCurrent (language));
+	hashNumber (&hash, getLanguageVersionAge (language));
+	hashString (&hash, PROGRAM_VERSION);
+	hashString (&hash, ctags_repoinfo? ctags_repoinfo: "");
+	hashNumber (&hash, OptionsHash.h1);
+	hashNumber (&hash, OptionsHash.h2);
+
+	tagCacheEntry *entry = xCalloc (1, tagCacheEntry);
+	entry->fileName = makeEntryFileName (&hash);
+	entry->inputSize = size;
+	CurrentEntry = entry;
+	return entry;
+}
+
+static bool readHeaderLine (MIO *mio, char *buf, size_t size, const char *key)
+{
+	size_t len = strlen (key);
+
+	if (mio_gets (mio, buf, size) == NULL
+		|| strncmp (buf, key, len) != 0
+		|| buf [len] != '\t')
+		return false;
+
+	char *nl = strchr (buf + len, '\n');
+	if (nl == NULL)
+		return false;
+	*nl = '\0';
+	return true;
+}
+
+static bool readEntry (tagCacheEntry *entry, MIO *mio)
+{
+	char buf [4096];
+
+	if (mio_gets (mio, buf, sizeof (buf)) == NULL
+		|| strcmp (buf, CACHE_MAGIC) != 0)
+		return false;
+
+	unsigned long length;
+	if (!readHeaderLine (mio, buf, sizeof (buf), "length"))
+		return false;
+	length = strtoul (buf + 7, NULL, 10);
+	if (!readHeaderLine (mio, buf, sizeof (buf), "tags"))
+		return false;
+	entry->numTags = strtoul (buf + 5, NULL, 10);
+	if (!readHeaderLine (mio, buf, sizeof (buf), "lines"))
+		return false;
+	entry->numLines = strtoul (buf + 6, NULL, 10);
+
+	if (!readHeaderLine (mio, buf, sizeof (buf), "ptags"))
+		return false;
+	entry->ptagParsers = stringListNew ();
+	for (char *name = strtok (buf + 6, ","); name; name = strtok (NULL, ","))
+		stringListAdd (entry->ptagParsers, vStringNewInit (name));
+
+	entry->tags = xMalloc (length + 1, char);
+	entry->length = length;
+	if (mio_read (mio, entry->tags, 1, length) != length)
+		return false;
+	entry->tags [length] = '\0';
+	return true;
+}
+
+/* Update the modification time of the entry for the LRU eviction. */
+static void touchEntry (tagCacheEntry *entry)
+{
+#if defined (HAVE_UTIME) && defined (HAVE_UTIME_H)
+	utime (entry->fileName, NULL);
+#endif
+}
+
+extern bool lookupTagCacheEntry (tagCacheEntry *entry)
+{
+	MIO *mio = mio_new_file (entry->fileName, "rb");
+
+	if (mio)
+	{
+		entry->hit = readEntry (entry, mio);
+		mio_unref (mio);
+		if (!entry->hit)
+			verbose ("ignoring broken tag cache entry: %s\n", entry->fileName);
+	}
+
+	if (entry->hit)
+	{
+		touchEntry (entry);
+		Stats.hits++;
+	}
+	else
+	{
+		if (entry->tags)
+		{
+			eFree (entry->tags);
+			entry->tags = NULL;
+		}
+		if (entry->ptagParsers)
+			stringListClear (entry->ptagParsers);
+		else
+			entry->ptagParsers = stringListNew ();
+		entry->storing = true;
+		Stats.misses++;
+	}
+	return entry->hit;
+}
+
+extern const char *getTagCacheEntryTags (tagCacheEntry *entry, size_t *length,
+										 unsigned long *numTags)
+{
+	Assert (entry->hit);
+
+	*length = entry->length;
+	*numTags = entry->numTags;
+	return entry->tags;
+}
+
+extern void getTagCacheEntryTotals (tagCacheEntry *entry,
+									unsigned long *lines, unsigned long *bytes)
+{
+	*lines = entry->numLines;
+	*bytes = entry->inputSize;
+}
+
+extern stringList *getTagCacheEntryPseudoTagParsers (tagCacheEntry *entry)
+{
+	return entry->ptagParsers;
+}
+
+extern void noteParserPseudoTagsForTagCache (const langType language)
+{
+	if (CurrentEntry && CurrentEntry->storing)
+		stringListAdd (CurrentEntry->ptagParsers,
+					   vStringNewInit (getLanguageName (language)));
+}
+
+static bool makeDirectory (const char *const name)
+{
+	int r;
+
+#ifdef _WIN32
+	r = _mkdir (name);
+#else
+	r = mkdir (name, 0777);
+#endif
+	return (r == 0 || errno == EEXIST);
+}
+
+static bool makeEntryDirectory (const char *const entryFileName)
+{
+	char *dir = eStrndup (entryFileName, baseFilename (entryFileName) - entryFileName);
+	bool r = doesDirectoryExist (dir);
+
+	if (!r)
+		r = makeDirectory (Option.cacheDir) && makeDirectory (dir);
+	eFree (dir);
+	return r;
+}
+
+extern void storeTagCacheEntry (tagCacheEntry *entry, const char *const tags, size_t length,
+								unsigned long numTags, unsigned long numLines)
+{
+	Assert (entry->storing);
+
+	if (!makeEntryDirectory (entry->fileName))
+	{
+		error (WARNING | PERROR, "cannot make tag cache directory for %s", entry->fileName);
+		return;
+	}
+
+	vString *tmpName = vStringNewInit (entry->fileName);
+#ifdef HAVE_UNISTD_H
+	char pid [32];
+	snprintf (pid, sizeof (pid), ".%ld", (long) getpid ());
+	vStringCatS (tmpName, pid);
+#endif
+	vStringCatS (tmpName, ".tmp");
+
+	MIO *mio = mio_new_file (vStringValue (tmpName), "wb");
+	if (mio == NULL)
+	{
+		error (WARNING | PERROR, "cannot write tag cache entry: %s", vStringValue (tmpName));
+		vStringDelete (tmpName);
+		return;
+	}
+
+	mio_puts (mio, CACHE_MAGIC);
+	mio_printf (mio, "length\t%lu\n", (unsigned long) length);
+	mio_printf (mio, "tags\t%lu\n", numTags);
+	mio_printf (mio, "lines\t%lu\n", numLines);
+	mio_puts (mio, "ptags\t");
+	for (unsigned int i = 0; i < stringListCount (entry->ptagParsers); i++)
+	{
+		if (i > 0)
+			mio_putc (mio, ',');
+		mio_puts (mio, vStringValue (stringListItem (entry->ptagParsers, i)));
+	}
+	mio_putc (mio, '\n');
+	mio_write (mio, tags, 1, length);
+
+	bool r = !mio_error (mio);
+	r = (mio_unref (mio) == 0) && r;
+	if (r)
+	{
+		/* rename () fails on Windows if the entry exists. */
+		remove (entry->fileName);
+		r = (rename (vStringValue (tmpName), entry->fileName) == 0);
+	}
+
+	if (r)
+		Stats.stored++;
+	else
+	{
+		error (WARNING | PERROR, "cannot write tag cache entry: %s", entry->fileName);
+		remove (vStringValue (tmpName));
+	}
+	vStringDelete (tmpName);
+}
+
+extern void closeTagCacheEntry (tagCacheEntry *entry)
+{
+	Assert (CurrentEntry == entry);
+
+	if (entry->tags)
+		eFree (entry->tags);
+	if (entry->ptagParsers)
+		stringListDelete (entry->ptagParsers);
+	eFree (entry->fileName);
+	eFree (entry);
+	CurrentEntry = NULL;
+}
+
+#ifdef HAVE_OPENDIR
+static void collectCacheFiles (const char *const dirName, ptrArray *files, size_t *total)
+{
+	DIR *const dir = opendir (dirName);
+	struct dirent *e;
+
+	if (dir == NULL)
+		return;
+
+	while ((e = readdir (dir)) != NULL)
+	{
+		if (e->d_name [0] == '.')
+			continue;
+
+		char *name = combinePathAndFile (dirName, e->d_name);
+		fileStatus *status = eStat (name);
+
+		if (status->isDirectory && dirName == Option.cacheDir)
+			collectCacheFiles (name, files, total);
+		else if (status->isNormalFile)
+		{
+			cacheFile *f = xMalloc (1, cacheFile);
+			f->name = name;
+			f->size = status->size;
+			f->mtime = status->mtime;
+			ptrArrayAdd (files, f);
+			*total += f->size;
+			name = NULL;
+		}
+
+		eStatFree (status);
+		if (name)
+			eFree (name);
+	}
+	closedir (dir);
+}
+
+static void deleteCacheFile (void *data)
+{
+	cacheFile *f = data;
+	eFree (f->name);
+	eFree (f);
+}
+
+static int compareCacheFilesByMtime (const void *a, const void *b)
+{
+	const cacheFile *fa = a;
+	const cacheFile *fb = b;
+
+	if (fa->mtime < fb->mtime)
+		return -1;
+	else if (fa->mtime > fb->mtime)
+		return 1;
+	return strcmp (fa->name, fb->name);
+}
+#endif
+
+extern void evictTagCache (void)
+{
+#ifdef HAVE_OPENDIR
+	if (!isTagCacheEnabled () || Stats.stored == 0)
+		return;
+
+	ptrArray *files = ptrArrayNew (deleteCacheFile);
+	size_t total = 0;
+
+	collectCacheFiles (Option.cacheDir, files, &total);
+	verbose ("tag cache: %u entries, %lu bytes\n",
+			 ptrArrayCount (files), (unsigned long) total);
+
+	if (total > Option.cacheSize)
+	{
+		ptrArraySort (files, compareCacheFilesByMtime);
+		for (unsigned int i = 0; i < ptrArrayCount (files) && total > Option.cacheSize; i++)
+		{
+			cacheFile *f = ptrArrayItem (files, i);
+			if (remove (f->name) != 0)
+				continue;
+			total -= f->size;
+			Stats.evicted++;
+		}
+	}
+	ptrArrayDelete (files);
+#endif
+}
+
+extern void getTagCacheStats (tagCacheStats *stats)
+{
+	*stats = Stats;
+}
+
+extern void addTagCacheStats (const tagCacheStats *stats)
+{
+	Stats.hits += stats->hits;
+	Stats.misses += stats->misses;
+	Stats.stored += stats->stored;
+	Stats.evicted += stats->evicted;
+}
+
+extern void printTagCacheStats (void)
+{
+	fprintf (stderr, "%lu file%s found in tag cache, %lu file%s not found\n",
+			 Stats.hits, plural (Stats.hits),
+			 Stats.misses, plural (Stats.misses));
+	fprintf (stderr, "%lu cache entr%s stored, %lu cache entr%s evicted\n",
+			 Stats.stored, Stats.stored == 1? "y": "ies",
+			 Stats.evicted, Stats.evicted == 1? "y": "ies");
+}
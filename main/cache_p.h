@@ -0,0 +1,70 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines internal interface to the persistent tag cache (--cache-dir).
+*/
+#ifndef CTAGS_MAIN_CACHE_PRIVATE_H
+#define CTAGS_MAIN_CACHE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <time.h>
+
+#include "mio.h"
+#include "strlist.h"
+#include "types.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sTagCacheEntry tagCacheEntry;
+
+typedef struct sTagCacheStats {
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long stored;
+	unsigned long evicted;
+} tagCacheStats;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern bool isTagCacheEnabled (void);
+
+/* Called for each option to compute the hash of the options affecting
+ * the output. */
+extern void hashOptionForTagCache (const char *const option, const char *const parameter);
+
+/* Make the entry for the input file in MIO parsed with LANGUAGE.
+ * Returns NULL if the input file cannot be read. */
+extern tagCacheEntry *openTagCacheEntry (const char *const fileName, const langType language,
+										 MIO *mio, time_t mtime);
+extern void closeTagCacheEntry (tagCacheEntry *entry);
+
+/* Returns true on a hit. On a miss, the tags made by the parser should
+ * be stored with storeTagCacheEntry(). */
+extern bool lookupTagCacheEntry (tagCacheEntry *entry);
+extern const char *getTagCacheEntryTags (tagCacheEntry *entry, size_t *length,
+										 unsigned long *numTags);
+extern void getTagCacheEntryTotals (tagCacheEntry *entry,
+									unsigned long *lines, unsigned long *bytes);
+extern stringList *getTagCacheEntryPseudoTagParsers (tagCacheEntry *entry);
+extern void noteParserPseudoTagsForTagCache (const langType language);
+extern void storeTagCacheEntry (tagCacheEntry *entry, const char *const tags, size_t length,
+								unsigned long numTags, unsigned long numLines);
+
+/* Remove the least recently used entries if the cache is larger than
+ * --cache-size. */
+extern void evictTagCache (void);
+
+extern void getTagCacheStats (tagCacheStats *stats);
+extern void addTagCacheStats (const tagCacheStats *stats);
+extern void printTagCacheStats (void);
+
+#endif  /* CTAGS_MAIN_CACHE_PRIVATE_H */
@@ -39,6 +39,8 @@
 #include <stdint.h>
 #include <limits.h>  /* to define INT_MAX */
 
+#include "arena_p.h"
+#include "cache_p.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "field.h"
@@ -46,6 +48,7 @@
 #include "kind.h"
 #include "interval_tree_generic.h"
 #include "nestlevel.h"
+#include "numarray.h"
 #include "options_p.h"
 #include "ptag_p.h"
 #include "rbtree.h"
@@ -59,6 +62,7 @@
 #include "strlist.h"
 #include "subparser_p.h"
 #include "trashbox.h"
+#include "update_p.h"
 #include "writer_p.h"
 #include "xtag_p.h"
 
@@ -66,6 +70,9 @@
 *   MACROS
 */
 
+/* The size of a chunk of the arena for the entries in the cork queue */
+#define CORK_ARENA_CHUNK_SIZE (64 * 1024)
+
 /*
  *  Portability defines
  */
@@ -96,13 +103,35 @@ typedef struct eTagFile {
 	int cork;
 	unsigned int corkFlags;
 	ptrArray *corkQueue;
+	/* The entries in the cork queue and their strings are allocated
+	 * here, and released at once when uncorking. */
+	arena *corkArena;
 	struct rb_root intervaltab;
 
 	bool patternCacheValid;
+
+	/* Start and end offsets of pseudo tags written to the tag file
+	 * of a worker process (--jobs). */
+	longArray *ptagSpans;
+
+	/* Names of the temporary files holding the output of workers sorted
+	 * in the workers. They are merged when sorting the tag file. */
+	stringList *sortedShards;
+
+#ifndef EXTERNAL_SORT
+	/* If non-NULL, the tag file is sorted in memory. Tags are written to
+	 * mio, a memory buffer, while parsing an input file. The lines in the
+	 * buffer are moved to the sorter after parsing the input file. */
+	tagSorter *sorter;
+#endif
 } tagFile;
 
 typedef struct sTagEntryInfoX  {
 	tagEntryInfo slot;
+	/* The end of the block allocated in TagFile.corkArena for this entry
+	 * and the strings copied in copyTagEntry(), or NULL. A string outside
+	 * the block is set by a parser after queuing this entry. */
+	const char *blockEnd;
 	int corkIndex;
 	struct rb_root symtab;
 	struct rb_node symnode;
@@ -123,6 +152,7 @@ static tagFile TagFile = {
 	NULL,                /* vLine */
 	.cork = false,
 	.corkQueue = NULL,
+	.corkArena = NULL,
 	/* .intervaltab = RB_ROOT,
 	 *
 	 * msvc doesn't accept the above expression:
@@ -131,6 +161,11 @@ static tagFile TagFile = {
 	 *
 	 */
 	.patternCacheValid = false,
+	.ptagSpans = NULL,
+	.sortedShards = NULL,
+#ifndef EXTERNAL_SORT
+	.sorter = NULL,
+#endif
 };
 
 static bool TagsToStdout = false;
@@ -162,6 +197,11 @@ extern void freeTagFileResources (void)
 	if (TagFile.directory != NULL)
 		eFree (TagFile.directory);
 	vStringDelete (TagFile.vLine);
+	if (TagFile.corkArena)
+	{
+		arenaDelete (TagFile.corkArena);
+		TagFile.corkArena = NULL;
+	}
 }
 
 extern const char *tagFileName (void)
@@ -391,12 +431,50 @@ static bool isTagFile (const char *const filename)
 		if (line == NULL)
 			ok = true;
 		else
-			ok = (bool) (isCtagsLine (line) || isEtagsLine (line));
+			ok = (bool) (isCtagsLine (line) || isEtagsLine (line)
+						 || isBinaryTagFileHeader (line));
 		mio_unref (mio);
 	}
 	return ok;
 }
 
+static bool canSortTagFileInMemory (void)
+{
+#ifdef EXTERNAL_SORT
+	return false;
+#else
+	/* With --append, the lines in the tag file must be sorted too. */
+	return (Option.sorted != SO_UNSORTED
+			&& ! Option.append
+			&& ! Option.etags
+			&& ! Option.filter
+			&& Option.interactive == INTERACTIVE_NONE);
+#endif
+}
+
+#ifndef EXTERNAL_SORT
+static void openTagFileInMemory (void)
+{
+	if (! TagsToStdout)
+	{
+		/* Make the tag file here so that an error is reported before
+		 * parsing input files. With --update, the tag file is read
+		 * again when closing it; don't truncate it. */
+		if (Option.update && doesFileExist (TagFile.name))
+			loadTagFileForUpdate (TagFile.name);
+		MIO *mio = mio_new_file (TagFile.name, Option.update? "a": "w");
+		if (mio == NULL)
+			error (FATAL | PERROR, "cannot open tag file");
+		mio_unref (mio);
+	}
+
+	TagFile.mio = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
+	TagFile.sorter = newTagSorter (! Option.xref);
+	if (isXtagEnabled (XTAG_PSEUDO_TAGS))
+		addCommonPseudoTags ();
+}
+#endif
+
 extern void openTagFile (void)
 {
 	setDefaultTagFileName ();
@@ -405,9 +483,20 @@ extern void openTagFile (void)
 	if (TagFile.vLine == NULL)
 		TagFile.vLine = vStringNew ();
 
+	/* The pseudo tags are not stored in the tag cache. */
+	if (isTagCacheEnabled () && TagFile.ptagSpans == NULL)
+		TagFile.ptagSpans = longArrayNew ();
+
 	/*  Open the tags file.
 	 */
-	if (TagsToStdout)
+	if (TagsToStdout && canSortTagFileInMemory ())
+	{
+#ifndef EXTERNAL_SORT
+		TagFile.name = NULL;
+		openTagFileInMemory ();
+#endif
+	}
+	else if (TagsToStdout)
 	{
 		if (Option.interactive == INTERACTIVE_SANDBOX)
 		{
@@ -439,7 +528,13 @@ extern void openTagFile (void)
 			  "\"%s\" doesn't look like a tag file; I refuse to overwrite it.",
 				  TagFile.name);
 
-		if (Option.etags)
+		if (canSortTagFileInMemory ())
+		{
+#ifndef EXTERNAL_SORT
+			openTagFileInMemory ();
+#endif
+		}
+		else if (Option.etags)
 		{
 			if (Option.append  &&  fileExists)
 				TagFile.mio = mio_new_file (TagFile.name, "a+b");
@@ -460,7 +555,8 @@ extern void openTagFile (void)
 			}
 			else
 			{
-				TagFile.mio = mio_new_file (TagFile.name, "w");
+				/* Readable for the tag cache */
+				TagFile.mio = mio_new_file (TagFile.name, "w+");
 				if (TagFile.mio != NULL && isXtagEnabled (XTAG_PSEUDO_TAGS))
 					addCommonPseudoTags ();
 			}
@@ -537,6 +633,28 @@ static int replacementTruncate (const char *const name, const long size)
 #endif
 
 #ifndef EXTERNAL_SORT
+static void mergeSortedShards (MIO *mio)
+{
+	unsigned int count = stringListCount (TagFile.sortedShards);
+	MIO **shards = xMalloc (count, MIO *);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const char *shard = vStringValue (stringListItem (TagFile.sortedShards, i));
+		shards [i] = mio_new_file (shard, "rb");
+		if (shards [i] == NULL)
+			failedSort (mio, NULL);
+	}
+
+	/* Only the pseudo tags and the lines of the original file (-a) are
+	 * in the tag file. */
+	internalMergeSortedShards (TagsToStdout, mio, shards, count);
+
+	for (unsigned int i = 0; i < count; i++)
+		mio_unref (shards [i]);
+	eFree (shards);
+}
+
 static void internalSortTagFile (void)
 {
 	MIO *mio;
@@ -555,15 +673,29 @@ static void internalSortTagFile (void)
 			failedSort (mio, NULL);
 	}
 
-	internalSortTags (TagsToStdout,
-			  mio,
-			  TagFile.numTags.added + TagFile.numTags.prev);
+	if (TagFile.sortedShards)
+		mergeSortedShards (mio);
+	else
+		internalSortTags (TagsToStdout,
+				  mio,
+				  TagFile.numTags.added + TagFile.numTags.prev);
 
 	if (! TagsToStdout)
 		mio_unref (mio);
 }
 #endif
 
+static void discardSortedShards (void)
+{
+	if (TagFile.sortedShards == NULL)
+		return;
+
+	for (unsigned int i = 0; i < stringListCount (TagFile.sortedShards); i++)
+		remove (vStringValue (stringListItem (TagFile.sortedShards, i)));
+	stringListDelete (TagFile.sortedShards);
+	TagFile.sortedShards = NULL;
+}
+
 static void sortTagFile (void)
 {
 	if (TagFile.numTags.added > 0L)
@@ -632,10 +764,99 @@ static void writeEtagsIncludes (MIO *const mio)
 	}
 }
 
+extern void moveTagFileToSorter (void)
+{
+#ifndef EXTERNAL_SORT
+	if (TagFile.sorter == NULL)
+		return;
+
+	/* Lines truncated by a rescan are after the current position. */
+	long len = mio_tell (TagFile.mio);
+	if (len > 0)
+	{
+		unsigned char *data = mio_memory_get_data (TagFile.mio, NULL);
+		addTagLinesToSorter (TagFile.sorter, (const char *)data, len);
+		mio_seek (TagFile.mio, 0L, SEEK_SET);
+		if (TagFile.ptagSpans)
+			longArrayClear (TagFile.ptagSpans);
+	}
+#endif
+}
+
+#ifndef EXTERNAL_SORT
+static void addKeptTagsToSorter (void)
+{
+	bool sorted;
+	unsigned long count;
+	char *kept = filterTagFileForUpdate (TagFile.name, &sorted, &count);
+
+	if (kept == NULL)
+		return;
+
+	TagFile.numTags.prev = count;
+	if (sorted)
+	{
+		/* Removed in discardSortedShards (). */
+		addSortedShard (kept);
+		eFree (kept);
+		return;
+	}
+
+	MIO *mio = mio_new_file (kept, "rb");
+	if (mio == NULL)
+		failedSort (mio, NULL);
+	while (readLineRaw (TagFile.vLine, mio) != NULL)
+		addTagLinesToSorter (TagFile.sorter, vStringValue (TagFile.vLine),
+							 vStringLength (TagFile.vLine));
+	mio_unref (mio);
+	remove (kept);
+	eFree (kept);
+}
+
+static void closeTagFileInMemory (void)
+{
+	moveTagFileToSorter ();
+	if (Option.update)
+		addKeptTagsToSorter ();
+
+	if (TagFile.sortedShards)
+	{
+		for (unsigned int i = 0; i < stringListCount (TagFile.sortedShards); i++)
+		{
+			const char *shard = vStringValue (stringListItem (TagFile.sortedShards, i));
+			MIO *mio = mio_new_file (shard, "rb");
+			if (mio == NULL)
+				failedSort (mio, NULL);
+			addSortedRunToSorter (TagFile.sorter, mio);
+			mio_unref (mio);
+		}
+	}
+
+	if (TagFile.numTags.added > 0L || Option.update)
+	{
+		verbose ("sorting tag file\n");
+		writeSortedTags (TagFile.sorter, TagsToStdout);
+	}
+
+	deleteTagSorter (TagFile.sorter);
+	TagFile.sorter = NULL;
+	mio_unref (TagFile.mio);
+}
+#endif
+
 extern void closeTagFile (const bool resize)
 {
 	long desiredSize, size;
 
+#ifndef EXTERNAL_SORT
+	if (TagFile.sorter)
+	{
+		closeTagFileInMemory ();
+		discardSortedShards ();
+		goto out;
+	}
+#endif
+
 	if (Option.etags)
 		writeEtagsIncludes (TagFile.mio);
 	mio_flush (TagFile.mio);
@@ -657,6 +878,7 @@ extern void closeTagFile (const bool resize)
 		resizeTagFile (desiredSize);
 	}
 	sortTagFile ();
+	discardSortedShards ();
 	if (TagsToStdout)
 	{
 		if (mio_unref (TagFile.mio) != 0)
@@ -665,6 +887,7 @@ extern void closeTagFile (const bool resize)
 			remove (TagFile.name);  /* remove temporary file */
 	}
 
+ out:
 	TagFile.mio = NULL;
 	if (TagFile.name)
 		eFree (TagFile.name);
@@ -1105,12 +1328,74 @@ static void copyExtraDynamic (const tagEntryInfo *const src, tagEntryInfo *const
 	}
 }
 
+static size_t tagEntryStringSize (const char *str)
+{
+	return str? strlen (str) + 1: 0;
+}
+
+static const char *copyTagEntryString (char **cursor, const char *str)
+{
+	if (str == NULL)
+		return NULL;
+
+	size_t len = strlen (str) + 1;
+	char *copy = memcpy (*cursor, str, len);
+	*cursor += len;
+	return copy;
+}
+
+static bool isInTagEntryBlock (const tagEntryInfoX *x, const void *p)
+{
+	return (x->blockEnd
+			&& (const char *)x <= (const char *)p
+			&& (const char *)p < x->blockEnd);
+}
+
+/* The entry and the strings in it are allocated in a block of
+ * TagFile.corkArena. They are released at once in uncorkTagFile(). */
 static tagEntryInfoX *copyTagEntry (const tagEntryInfo *const tag,
 									const char *shareInputFileName,
 									const char *sharedSourceFileName,
 									unsigned int corkFlags)
 {
-	tagEntryInfoX *x = xMalloc (1, tagEntryInfoX);
+	bool inputFileNameShared = (tag->inputFileName == getInputFileName ());
+	/* strcmp() is needed here.
+	 * sharedSourceFileName can be changed during parsing a file.
+	 * So we cannot use the condition like:
+	 *
+	 *    if (slot->sourceFileName == getSourceFileTagPath()) { ... }
+	 *
+	 */
+	bool sourceFileNameShared = (tag->sourceFileName
+								 && strcmp(tag->sourceFileName, sharedSourceFileName) == 0);
+	size_t extraDynamicSize = tag->extraDynamic
+		? ((countXtags () - XTAG_COUNT) / 8) + 1
+		: 0;
+	size_t size = sizeof (tagEntryInfoX) + extraDynamicSize;
+	unsigned int i;
+
+	size += tagEntryStringSize (tag->pattern);
+	if (!inputFileNameShared)
+		size += tagEntryStringSize (tag->inputFileName);
+	size += tagEntryStringSize (tag->name);
+	size += tagEntryStringSize (tag->extensionFields.access);
+	size += tagEntryStringSize (tag->extensionFields.implementation);
+	size += tagEntryStringSize (tag->extensionFields.inheritance);
+	size += tagEntryStringSize (tag->extensionFields.scopeName);
+	size += tagEntryStringSize (tag->extensionFields.signature);
+	size += tagEntryStringSize (tag->extensionFields.typeRef[0]);
+	size += tagEntryStringSize (tag->extensionFields.typeRef[1]);
+#ifdef HAVE_LIBXML
+	size += tagEntryStringSize (tag->extensionFields.xpath);
+#endif
+	if (!sourceFileNameShared)
+		size += tagEntryStringSize (tag->sourceFileName);
+	for (i = 0; i < tag->usedParserFields; i++)
+		size += tagEntryStringSize (getParserFieldForIndex (tag, i)->value);
+
+	tagEntryInfoX *x = arenaAlloc (TagFile.corkArena, size);
+	char *cursor = (char *)(x + 1);
+	x->blockEnd = (char *)x + size;
 	x->symtab = RB_ROOT;
 	x->corkIndex = CORK_NIL;
 	memset(&x->intervalnode, 0, sizeof (x->intervalnode));
@@ -1119,70 +1404,63 @@ static tagEntryInfoX *copyTagEntry (const tagEntryInfo *const tag,
 
 	*slot = *tag;
 
-	if (slot->pattern)
-		slot->pattern = eStrdup (slot->pattern);
+	if (slot->extraDynamic)
+	{
+		slot->extraDynamic = memcpy (cursor, tag->extraDynamic, extraDynamicSize);
+		cursor += extraDynamicSize;
+	}
+
+	slot->pattern = copyTagEntryString (&cursor, slot->pattern);
 
-	if (slot->inputFileName == getInputFileName ())
+	if (inputFileNameShared)
 	{
 		slot->inputFileName = shareInputFileName;
 		slot->isInputFileNameShared = 1;
 	}
 	else
 	{
-		slot->inputFileName = eStrdup (slot->inputFileName);
+		slot->inputFileName = copyTagEntryString (&cursor, slot->inputFileName);
 		slot->isInputFileNameShared = 0;
 	}
 
-	slot->name = eStrdup (slot->name);
-	if (slot->extensionFields.access)
-		slot->extensionFields.access = eStrdup (slot->extensionFields.access);
-	if (slot->extensionFields.implementation)
-		slot->extensionFields.implementation = eStrdup (slot->extensionFields.implementation);
-	if (slot->extensionFields.inheritance)
-		slot->extensionFields.inheritance = eStrdup (slot->extensionFields.inheritance);
-	if (slot->extensionFields.scopeName)
-		slot->extensionFields.scopeName = eStrdup (slot->extensionFields.scopeName);
-	if (slot->extensionFields.signature)
-		slot->extensionFields.signature = eStrdup (slot->extensionFields.signature);
-	if (slot->extensionFields.typeRef[0])
-		slot->extensionFields.typeRef[0] = eStrdup (slot->extensionFields.typeRef[0]);
-	if (slot->extensionFields.typeRef[1])
-		slot->extensionFields.typeRef[1] = eStrdup (slot->extensionFields.typeRef[1]);
+	slot->name = copyTagEntryString (&cursor, slot->name);
+	slot->extensionFields.access = copyTagEntryString (&cursor, slot->extensionFields.access);
+	slot->extensionFields.implementation = copyTagEntryString (&cursor, slot->extensionFields.implementation);
+	slot->extensionFields.inheritance = copyTagEntryString (&cursor, slot->extensionFields.inheritance);
+	slot->extensionFields.scopeName = copyTagEntryString (&cursor, slot->extensionFields.scopeName);
+	slot->extensionFields.signature = copyTagEntryString (&cursor, slot->extensionFields.signature);
+	slot->extensionFields.typeRef[0] = copyTagEntryString (&cursor, slot->extensionFields.typeRef[0]);
+	slot->extensionFields.typeRef[1] = copyTagEntryString (&cursor, slot->extensionFields.typeRef[1]);
 #ifdef HAVE_LIBXML
-	if (slot->extensionFields.xpath)
-		slot->extensionFields.xpath = eStrdup (slot->extensionFields.xpath);
+	slot->extensionFields.xpath = copyTagEntryString (&cursor, slot->extensionFields.xpath);
 #endif
 
-	copyExtraDynamic (tag, slot);
-	if (slot->extraDynamic)
-		PARSER_TRASH_BOX_TAKE_BACK(slot->extraDynamic);
-
 	if (slot->sourceFileName == NULL)
 		slot->isSourceFileNameShared = 0;
-	else if (strcmp(slot->sourceFileName, sharedSourceFileName) == 0)
+	else if (sourceFileNameShared)
 	{
-		/* strcmp() is needed here.
-		 * sharedSourceFileName can be changed during parsing a file.
-		 * So we cannot use the condition like:
-		 *
-		 *    if (slot->sourceFileName == getSourceFileTagPath()) { ... }
-		 *
-		 */
 		slot->sourceFileName = sharedSourceFileName;
 		slot->isSourceFileNameShared = 1;
 	}
 	else
 	{
-		slot->sourceFileName = eStrdup (slot->sourceFileName);
+		slot->sourceFileName = copyTagEntryString (&cursor, slot->sourceFileName);
 		slot->isSourceFileNameShared = 0;
 	}
 
 	slot->usedParserFields = 0;
 	slot->parserFieldsDynamic = NULL;
-	copyParserFields (tag, slot);
+	for (i = 0; i < tag->usedParserFields; i++)
+	{
+		const tagField *f = getParserFieldForIndex (tag, i);
+		attachParserFieldGeneric (slot, f->ftype,
+								  copyTagEntryString (&cursor, f->value),
+								  false);
+	}
 	if (slot->parserFieldsDynamic)
 		PARSER_TRASH_BOX_TAKE_BACK(slot->parserFieldsDynamic);
 
+	Assert (cursor == x->blockEnd);
 	return x;
 }
 
@@ -1211,8 +1489,17 @@ static void clearParserFields (tagEntryInfo *const tag)
 	}
 }
 
+/* A parser may replace a string in an entry in the cork queue with
+ * a string allocated with malloc(); only the latter is freed here. */
+static void freeTagEntryMember (const tagEntryInfoX *x, const void *p)
+{
+	if (p && !isInTagEntryBlock (x, p))
+		eFree ((void *)p);
+}
+
 static void deleteTagEnry (void *data)
 {
+	tagEntryInfoX *x = data;
 	tagEntryInfo *slot = data;
 
 	if (slot->kindIndex == KIND_FILE_INDEX)
@@ -1220,46 +1507,45 @@ static void deleteTagEnry (void *data)
 		eFree ((char *)slot->inputFileName);
 		if (slot->sourceFileName)
 			eFree ((char *)slot->sourceFileName);
-		goto out;
+		eFree (slot);
+		return;
 	}
 
-	if (slot->pattern)
-		eFree ((char *)slot->pattern);
+	freeTagEntryMember (x, slot->pattern);
 
 	if (!slot->isInputFileNameShared)
-		eFree ((char *)slot->inputFileName);
+		freeTagEntryMember (x, slot->inputFileName);
 
-	eFree ((char *)slot->name);
-
-	if (slot->extensionFields.access)
-		eFree ((char *)slot->extensionFields.access);
-	if (slot->extensionFields.implementation)
-		eFree ((char *)slot->extensionFields.implementation);
-	if (slot->extensionFields.inheritance)
-		eFree ((char *)slot->extensionFields.inheritance);
-	if (slot->extensionFields.scopeName)
-		eFree ((char *)slot->extensionFields.scopeName);
-	if (slot->extensionFields.signature)
-		eFree ((char *)slot->extensionFields.signature);
-	if (slot->extensionFields.typeRef[0])
-		eFree ((char *)slot->extensionFields.typeRef[0]);
-	if (slot->extensionFields.typeRef[1])
-		eFree ((char *)slot->extensionFields.typeRef[1]);
+	freeTagEntryMember (x, slot->name);
+
+	freeTagEntryMember (x, slot->extensionFields.access);
+	freeTagEntryMember (x, slot->extensionFields.implementation);
+	freeTagEntryMember (x, slot->extensionFields.inheritance);
+	freeTagEntryMember (x, slot->extensionFields.scopeName);
+	freeTagEntryMember (x, slot->extensionFields.signature);
+	freeTagEntryMember (x, slot->extensionFields.typeRef[0]);
+	freeTagEntryMember (x, slot->extensionFields.typeRef[1]);
 #ifdef HAVE_LIBXML
-	if (slot->extensionFields.xpath)
-		eFree ((char *)slot->extensionFields.xpath);
+	freeTagEntryMember (x, slot->extensionFields.xpath);
 #endif
 
-	if (slot->extraDynamic)
-		eFree (slot->extraDynamic);
+	/* markTagExtraBitFull() may allocate extraDynamic after queuing. */
+	freeTagEntryMember (x, slot->extraDynamic);
 
-	if (slot->sourceFileName && !slot->isSourceFileNameShared)
-		eFree ((char *)slot->sourceFileName);
+	if (!slot->isSourceFileNameShared)
+		freeTagEntryMember (x, slot->sourceFileName);
 
 	clearParserFields (slot);
 
- out:
-	eFree (slot);
+	/* The entry itself is released with TagFile.corkArena. */
+}
+
+extern void freeTagEntryString (tagEntryInfo *e, const char *str)
+{
+	if (e->inCorkQueue)
+		freeTagEntryMember ((tagEntryInfoX *)e, str);
+	else if (str)
+		eFree ((char *)str);
 }
 
 static void corkSymtabPut (tagEntryInfoX *scope, const char* name, tagEntryInfoX *item)
@@ -1821,6 +2107,10 @@ extern bool writePseudoTag (const ptagDesc *desc,
 							const char *const parserName)
 {
 	int length;
+	long start = 0;
+
+	if (TagFile.ptagSpans)
+		start = mio_tell (TagFile.mio);
 
 	length = writerWritePtag (TagFile.mio, desc, fileName,
 							  pattern, parserName);
@@ -1829,6 +2119,15 @@ extern bool writePseudoTag (const ptagDesc *desc,
 
 	abort_if_ferror (TagFile.mio);
 
+	if (TagFile.ptagSpans)
+	{
+		longArrayAdd (TagFile.ptagSpans, start);
+		longArrayAdd (TagFile.ptagSpans, mio_tell (TagFile.mio));
+	}
+
+	if (Option.update)
+		noteFreshPseudoTag (desc->name, parserName);
+
 	++TagFile.numTags.added;
 	rememberMaxLengths (strlen (desc->name), (size_t) length);
 
@@ -1842,6 +2141,8 @@ extern void corkTagFile (unsigned int corkFlags)
 	{
 		TagFile.corkFlags = corkFlags;
 		TagFile.corkQueue = ptrArrayNew (deleteTagEnry);
+		if (TagFile.corkArena == NULL)
+			TagFile.corkArena = arenaNew (CORK_ARENA_CHUNK_SIZE);
 		tagEntryInfo *nil = newNilTagEntry (corkFlags);
 		ptrArrayAdd (TagFile.corkQueue, nil);
 		TagFile.intervaltab = RB_ROOT;
@@ -1881,6 +2182,7 @@ extern void uncorkTagFile (void)
 
 	ptrArrayDelete (TagFile.corkQueue);
 	TagFile.corkQueue = NULL;
+	arenaClear (TagFile.corkArena);
 }
 
 extern tagEntryInfo *getEntryInCorkQueue (int n)
@@ -2374,6 +2676,180 @@ extern void setTagFilePosition (MIOPos *p, bool truncation)
 		if (!mio_try_resize (TagFile.mio, (size_t)t1))
 			error (FATAL|PERROR,
 				   "failed to truncate the tag file %ld -> %ld\n", t0, t1);
+
+		/* Forget the pseudo tags discarded with the truncation. */
+		while (TagFile.ptagSpans && longArrayCount (TagFile.ptagSpans) > 0
+			   && longArrayItem (TagFile.ptagSpans,
+								 longArrayCount (TagFile.ptagSpans) - 2) >= t1)
+		{
+			longArrayRemoveLast (TagFile.ptagSpans);
+			longArrayRemoveLast (TagFile.ptagSpans);
+		}
+	}
+}
+
+/*
+ *  Worker process support (--jobs)
+ */
+
+/*  A worker process writes tags to MIO, a private temporary file,
+ *  instead of the tag file opened in the main process. The main process
+ *  merges the output of workers with appendTagFileOfWorker().
+ */
+extern void redirectTagFileForWorker (MIO *mio)
+{
+	TagFile.mio = mio;
+	TagFile.numTags.added = 0;
+	TagFile.numTags.prev = 0;
+	TagFile.max.line = 0;
+	TagFile.max.tag = 0;
+	if (TagFile.ptagSpans)
+		longArrayClear (TagFile.ptagSpans);
+	else
+		TagFile.ptagSpans = longArrayNew ();
+#ifndef EXTERNAL_SORT
+	/* The main process owns the sorter. */
+	TagFile.sorter = NULL;
+#endif
+}
+
+extern long tagFileOffset (void)
+{
+	long offset = mio_tell (TagFile.mio);
+	if (offset == -1)
+		error (FATAL|PERROR, "failed to tell the file position of the tag file");
+	return offset;
+}
+
+/*  Returns an array of pairs: the start and end offsets of each pseudo
+ *  tag written in the worker process. */
+extern const longArray *pseudoTagSpansOfWorker (void)
+{
+	return TagFile.ptagSpans;
+}
+
+extern void getTagFileCounts (unsigned long *added, size_t *maxLine, size_t *maxTag)
+{
+	*added = TagFile.numTags.added;
+	*maxLine = TagFile.max.line;
+	*maxTag = TagFile.max.tag;
+}
+
+extern void appendTagFileOfWorker (const char *buf, size_t len)
+{
+	if (len > 0 && mio_write (TagFile.mio, buf, 1, len) != len)
+		error (FATAL | PERROR, "cannot write tag file");
+}
+
+extern void addTagFileCountsOfWorker (unsigned long added, size_t maxLine, size_t maxTag)
+{
+	TagFile.numTags.added += added;
+	rememberMaxLengths (maxTag, maxLine);
+}
+
+/*  When the tag file is sorted with the internal sort algorithm, workers
+ *  sort their output by themselves. The main process merges the sorted
+ *  output of workers instead of copying it to the tag file.
+ */
+extern bool canMergeSortedShardsOfWorkers (void)
+{
+#ifdef EXTERNAL_SORT
+	return false;
+#else
+	return Option.sorted != SO_UNSORTED;
+#endif
+}
+
+extern void sortTagFileOfWorker (void)
+{
+#ifndef EXTERNAL_SORT
+	internalSortShard (TagFile.mio);
+#endif
+}
+
+extern void addSortedShard (const char *fileName)
+{
+	if (TagFile.sortedShards == NULL)
+		TagFile.sortedShards = stringListNew ();
+	stringListAdd (TagFile.sortedShards, vStringNewInit (fileName));
+}
+
+/*
+ *  Tag cache support (--cache-dir)
+ */
+
+extern void markTagFile (tagFileMark *mark)
+{
+	Assert (TagFile.ptagSpans);
+
+	mark->offset = tagFileOffset ();
+	mark->numTags = TagFile.numTags.added;
+	mark->numPtagSpans = longArrayCount (TagFile.ptagSpans);
+}
+
+static bool readTagFileRange (vString *buf, long start, long end)
+{
+	size_t len = end - start;
+
+	if (len == 0)
+		return true;
+	if (mio_seek (TagFile.mio, start, SEEK_SET) != 0)
+		return false;
+
+	vStringResize (buf, vStringLength (buf) + len + 1);
+	if (mio_read (TagFile.mio, vStringValue (buf) + vStringLength (buf), 1, len) != len)
+		return false;
+	vStringLength (buf) += len;
+	vStringValue (buf) [vStringLength (buf)] = '\0';
+	return true;
+}
+
+extern vString *getTagLinesSinceMark (const tagFileMark *mark, unsigned long *numTags)
+{
+	long end = tagFileOffset ();
+	long pos = mark->offset;
+	unsigned int ptagCount = longArrayCount (TagFile.ptagSpans);
+	vString *lines = vStringNew ();
+	bool r = true;
+
+	for (unsigned int i = mark->numPtagSpans; r && i < ptagCount; i += 2)
+	{
+		long start = longArrayItem (TagFile.ptagSpans, i);
+		r = readTagFileRange (lines, pos, start);
+		pos = longArrayItem (TagFile.ptagSpans, i + 1);
+	}
+	if (r)
+		r = readTagFileRange (lines, pos, end);
+
+	if (mio_seek (TagFile.mio, end, SEEK_SET) != 0)
+		error (FATAL | PERROR, "cannot seek tag file");
+
+	if (!r)
+	{
+		vStringDelete (lines);
+		return NULL;
+	}
+
+	*numTags = TagFile.numTags.added - mark->numTags - (ptagCount - mark->numPtagSpans) / 2;
+	return lines;
+}
+
+extern void writeTagLinesToTagFile (const char *lines, size_t len, unsigned long numTags)
+{
+	if (len > 0 && mio_write (TagFile.mio, lines, 1, len) != len)
+		error (FATAL | PERROR, "cannot write tag file");
+	TagFile.numTags.added += numTags;
+
+	const char *end = lines + len;
+	while (lines < end)
+	{
+		const char *nl = memchr (lines, '\n', end - lines);
+		const char *tab = memchr (lines, '\t', (nl? nl: end) - lines);
+
+		if (nl == NULL)
+			nl = end;
+		rememberMaxLengths (tab? (size_t) (tab - lines): 0, (size_t) (nl - lines));
+		lines = nl + 1;
 	}
 }
 
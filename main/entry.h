@@ -205,6 +205,12 @@ tagEntryInfo *getEntryInCorkQueue   (int n);
 tagEntryInfo *getEntryOfNestingLevel (const NestingLevel *nl);
 size_t        countEntryInCorkQueue (void);
 
+/* The strings in a tag entry in the cork queue are allocated with the
+ * entry, and cannot be passed to eFree(). When replacing a string member
+ * of a tag entry E with one allocated with malloc(), free the old STR
+ * with this function instead of eFree(). */
+extern void freeTagEntryString (tagEntryInfo *e, const char *str);
+
 /* If a parser sets (CORK_QUEUE and )CORK_SYMTAB to useCork,
  * the parsesr can use symbol lookup tables for the current input.
  * Each scope has a symbol lookup table.
@@ -15,6 +15,7 @@
 */
 #include "general.h"  /* must always come first */
 #include "entry.h"
+#include "numarray.h"
 #include "types.h"
 
 /*
@@ -41,6 +42,37 @@ extern void invalidatePatternCache(void);
 extern void tagFilePosition (MIOPos *p);
 extern void setTagFilePosition (MIOPos *p, bool truncation);
 extern const char* getTagFileDirectory (void);
+
+/* Move the tags of the last input file to the sorter when the tag file
+ * is sorted in memory. */
+extern void moveTagFileToSorter (void);
+
+/* For worker processes of --jobs */
+extern void redirectTagFileForWorker (MIO *mio);
+extern long tagFileOffset (void);
+extern const longArray *pseudoTagSpansOfWorker (void);
+extern void getTagFileCounts (unsigned long *added, size_t *maxLine, size_t *maxTag);
+extern void appendTagFileOfWorker (const char *buf, size_t len);
+extern void addTagFileCountsOfWorker (unsigned long added, size_t maxLine, size_t maxTag);
+extern bool canMergeSortedShardsOfWorkers (void);
+extern void sortTagFileOfWorker (void);
+
+/* Merge the sorted tag lines in fileName into the tag file when it is
+ * closed, and remove the file then. Used for the output of workers
+ * (--jobs) and for the tags kept by --update. */
+extern void addSortedShard (const char *fileName);
+
+/* For the tag cache (--cache-dir) */
+typedef struct sTagFileMark {
+	long offset;
+	unsigned long numTags;
+	unsigned int numPtagSpans;
+} tagFileMark;
+extern void markTagFile (tagFileMark *mark);
+/* Return the tag lines written after MARK, excluding pseudo tags. */
+extern vString *getTagLinesSinceMark (const tagFileMark *mark, unsigned long *numTags);
+extern void writeTagLinesToTagFile (const char *lines, size_t len, unsigned long numTags);
+
 extern void getTagScopeInformation (tagEntryInfo *const tag,
 				    const char **kind, const char **name);
 
@@ -1589,7 +1589,7 @@ static EsObject* getFieldValueForName (const tagEntryInfo *tag, const fieldDefin
 
 static EsObject* setFieldValueForName (tagEntryInfo *tag, const fieldDefinition *fdef, const EsObject *val)
 {
-	eFree ((char*) tag->name);
+	freeTagEntryString (tag, tag->name);
 	const char *cstr = opt_string_get_cstr (val);
 	tag->name = eStrdup (cstr);
 	return es_false;
@@ -1687,7 +1687,7 @@ static EsObject* setFieldValueForTyperef (tagEntryInfo *tag, const fieldDefiniti
 
 	for (int i = 0; i < 2; i++)
 		if (tmp [i])
-			eFree ((char*)tmp[i]);
+			freeTagEntryString (tag, tmp[i]);
 
 	return es_false;
 }
@@ -1801,7 +1801,7 @@ static EsObject* getFieldValueForCOMMON (const char *field, const tagEntryInfo *
 static EsObject* setFieldValueForCOMMON (const char **field, tagEntryInfo *tag, const fieldDefinition *fdef, const EsObject *obj)
 {
 	if (*field)
-		eFree ((char *)*field);
+		freeTagEntryString (tag, *field);
 
 	const char *str = opt_string_get_cstr (obj);
 	*field = eStrdup (str);
@@ -1906,7 +1906,7 @@ static EsObject* setFieldValueForInherits (tagEntryInfo *tag, const fieldDefinit
 	if (es_object_get_type (obj) == OPT_TYPE_STRING)
 	{
 		if (tag->extensionFields.inheritance)
-			eFree ((void *)tag->extensionFields.inheritance);
+			freeTagEntryString (tag, tag->extensionFields.inheritance);
 		const char *str = opt_string_get_cstr (obj);
 		tag->extensionFields.inheritance = eStrdup (str);
 	}
@@ -1914,7 +1914,7 @@ static EsObject* setFieldValueForInherits (tagEntryInfo *tag, const fieldDefinit
 	{
 		if (tag->extensionFields.inheritance)
 		{
-			eFree ((void *)tag->extensionFields.inheritance);
+			freeTagEntryString (tag, tag->extensionFields.inheritance);
 			tag->extensionFields.inheritance = NULL;
 		}
 	}
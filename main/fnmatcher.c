@@ -0,0 +1,171 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for matching a file name with many
+*   fnmatch() patterns at once. Patterns without wildcards are put in a
+*   hash table. "*SUFFIX" patterns are put in another hash table, and
+*   the tails of a file name are looked up in it. fnmatch() runs only
+*   for the other patterns.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <fnmatch.h>
+
+#include "fnmatcher_p.h"
+#include "htable.h"
+#include "numarray.h"
+#include "routines.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+struct sFileNameMatcher {
+	hashTable *literals;
+	hashTable *suffixes;		/* SUFFIX of "*SUFFIX" patterns */
+	uintArray *suffixLengths;	/* the lengths of SUFFIXes, no duplicates */
+	ptrArray *globs;			/* the other patterns */
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static bool isGlobbing (const char *const pattern)
+{
+	return strpbrk (pattern, "*?[\\") != NULL;
+}
+
+static hashTable *newPatternTable (void)
+{
+#ifdef CASE_INSENSITIVE_FILENAMES
+	return hashTableNew (31, hashCstrcasehash, hashCstrcaseeq, eFree, NULL);
+#else
+	return hashTableNew (31, hashCstrhash, hashCstreq, eFree, NULL);
+#endif
+}
+
+static void putPattern (hashTable *table, const char *const pattern)
+{
+	char *key = eStrdup (pattern);
+
+	/* NULL as a value means "no such item". */
+	hashTablePutItem (table, key, key);
+}
+
+static void addPattern (fileNameMatcher *matcher, const char *const pattern)
+{
+	if (! isGlobbing (pattern))
+	{
+		if (! hashTableHasItem (matcher->literals, pattern))
+			putPattern (matcher->literals, pattern);
+	}
+	else if (pattern [0] == '*' && ! isGlobbing (pattern + 1))
+	{
+		const char *const suffix = pattern + 1;
+		unsigned int length = strlen (suffix);
+
+		if (hashTableHasItem (matcher->suffixes, suffix))
+			return;
+		putPattern (matcher->suffixes, suffix);
+		if (! uintArrayHas (matcher->suffixLengths, length))
+			uintArrayAdd (matcher->suffixLengths, length);
+	}
+	else
+	{
+#ifdef CASE_INSENSITIVE_FILENAMES
+		ptrArrayAdd (matcher->globs, newUpperString (pattern));
+#else
+		ptrArrayAdd (matcher->globs, eStrdup (pattern));
+#endif
+	}
+}
+
+extern fileNameMatcher *fileNameMatcherNew (const stringList *const patterns)
+{
+	fileNameMatcher *matcher = xMalloc (1, fileNameMatcher);
+
+	matcher->literals = newPatternTable ();
+	matcher->suffixes = newPatternTable ();
+	matcher->suffixLengths = uintArrayNew ();
+	matcher->globs = ptrArrayNew (eFree);
+
+	for (unsigned int i = 0; i < stringListCount (patterns); i++)
+		addPattern (matcher, vStringValue (stringListItem (patterns, i)));
+
+	/* Shorter suffixes are tried first. Passing true to uintArraySort ()
+	 * sorts the array in ascending order, despite the name of the
+	 * parameter. */
+	uintArraySort (matcher->suffixLengths, true);
+
+	return matcher;
+}
+
+extern void fileNameMatcherDelete (fileNameMatcher *matcher)
+{
+	hashTableDelete (matcher->literals);
+	hashTableDelete (matcher->suffixes);
+	uintArrayDelete (matcher->suffixLengths);
+	ptrArrayDelete (matcher->globs);
+	eFree (matcher);
+}
+
+static bool matchGlobs (const fileNameMatcher *const matcher,
+						const char *const fileName)
+{
+	bool matched = false;
+#ifdef CASE_INSENSITIVE_FILENAMES
+	char *const f = newUpperString (fileName);
+#else
+	const char *const f = fileName;
+#endif
+
+	for (unsigned int i = 0; ! matched && i < ptrArrayCount (matcher->globs); i++)
+		matched = (fnmatch (ptrArrayItem (matcher->globs, i), f, 0) == 0);
+
+#ifdef CASE_INSENSITIVE_FILENAMES
+	eFree (f);
+#endif
+	return matched;
+}
+
+static bool matchNormalized (const fileNameMatcher *const matcher,
+							 const char *const fileName)
+{
+	if (hashTableHasItem (matcher->literals, fileName))
+		return true;
+
+	size_t length = strlen (fileName);
+	for (unsigned int i = 0; i < uintArrayCount (matcher->suffixLengths); i++)
+	{
+		unsigned int l = uintArrayItem (matcher->suffixLengths, i);
+		if (l > length)
+			break;
+		if (hashTableHasItem (matcher->suffixes, fileName + length - l))
+			return true;
+	}
+
+	return (ptrArrayCount (matcher->globs) > 0
+			&& matchGlobs (matcher, fileName));
+}
+
+extern bool fileNameMatcherMatch (const fileNameMatcher *const matcher,
+								  const char *const fileName)
+{
+#if defined (_WIN32)
+	vString *tmp = vStringNewInit (fileName);
+	vStringTranslate (tmp, PATH_SEPARATOR, OUTPUT_PATH_SEPARATOR);
+	bool r = matchNormalized (matcher, vStringValue (tmp));
+	vStringDelete (tmp);
+	return r;
+#else
+	return matchNormalized (matcher, fileName);
+#endif
+}
@@ -0,0 +1,37 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines internal interface to a matcher of file names compiled from
+*   a list of fnmatch() patterns.
+*/
+#ifndef CTAGS_MAIN_FNMATCHER_PRIVATE_H
+#define CTAGS_MAIN_FNMATCHER_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "strlist.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sFileNameMatcher fileNameMatcher;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* PATTERNS can be changed or deleted after calling this. */
+extern fileNameMatcher *fileNameMatcherNew (const stringList *const patterns);
+extern void fileNameMatcherDelete (fileNameMatcher *matcher);
+
+/* Same as stringListFileMatched (PATTERNS, FILENAME) */
+extern bool fileNameMatcherMatch (const fileNameMatcher *const matcher,
+								  const char *const fileName);
+
+#endif	/* CTAGS_MAIN_FNMATCHER_PRIVATE_H */
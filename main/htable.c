@@ -18,18 +18,32 @@
 #include <string.h>
 
 
+/* The items are stored in a flat array, and found with linear probing.
+ *
+ * Items for the same key are placed in the order from the newest to the
+ * oldest along the probing sequence: hashTableGetItem() returns the
+ * first one found, and hashTableForeachItemOnChain() visits them in
+ * that order. A deleted item leaves a tombstone so that the items after
+ * it stay reachable. */
+enum hentryState {
+	HENTRY_EMPTY = 0,
+	HENTRY_USED,
+	HENTRY_DELETED,
+};
+
 typedef struct sHashEntry hentry;
 struct sHashEntry {
 	void *key;
 	void *value;
 	unsigned int hash;
-	hentry *next;
+	unsigned char state;
 };
 
 struct sHashTable {
-	hentry** table;
-	unsigned int size;
+	hentry* table;
+	unsigned int size;			/* a power of 2 */
 	unsigned int count;
+	unsigned int deleted;
 	hashTableHashFunc hashfn;
 	hashTableEqualFunc equalfn;
 	hashTableDeleteFunc keyfreefn;
@@ -38,24 +52,7 @@ struct sHashTable {
 	hashTableDeleteFunc valForNotUnknownKeyfreefn;
 };
 
-struct chainTracker {
-	const void *const target_key;
-	hashTableForeachFunc user_proc;
-	void *user_data;
-	hashTableEqualFunc equalfn;
-};
-
-static hentry* entry_new (void *key, void *value, unsigned int hash, hentry* next)
-{
-	hentry* entry = xMalloc (1, hentry);
-
-	entry->key = key;
-	entry->value = value;
-	entry->next = next;
-	entry->hash = hash;
-
-	return entry;
-}
+#define HTABLE_MIN_SIZE 8
 
 static void entry_reset  (hentry* entry,
 						  void *newkey,
@@ -73,99 +70,63 @@ static void entry_reset  (hentry* entry,
 	entry->value = newval;
 }
 
-static hentry* entry_destroy (hentry* entry,
-			      hashTableDeleteFunc keyfreefn,
-			      hashTableDeleteFunc valfreefn)
+/* Hash values given by hashfn may have poor lower bits: hashPtrhash()
+ * returns aligned addresses, and hashInthash() returns small integers.
+ * Take the upper bits of the Fibonacci hashing instead. */
+static unsigned int home_index (const hashTable *htable, unsigned int hash)
 {
-	hentry* tmp;
-
-	entry_reset (entry, NULL, NULL, keyfreefn, valfreefn);
-	tmp = entry->next;
-	eFree (entry);
-
-	return tmp;
+	return (unsigned int)(((uint64_t)hash * 0x9e3779b97f4a7c15ULL) >> 32) & (htable->size - 1);
 }
 
-static void  entry_reclaim (hentry* entry,
-			    hashTableDeleteFunc keyfreefn,
-			    hashTableDeleteFunc valfreefn)
+static unsigned int next_index (const hashTable *htable, unsigned int i)
 {
-	while (entry)
-		entry = entry_destroy (entry, keyfreefn, valfreefn);
+	return (i + 1) & (htable->size - 1);
 }
 
-/* Looking for an entry having KEY as its key in the chain:
- * entry, entry->next, entry->next->next,...
- *
- * We have a chance to optimize for the case when a same key is
- * used repeatedly. By moving the entry found in the last time to
- * the head of the chain, we can avoid taking time for tracking
- * down the ->next-> chain.
- * The cost for the optimization is very small.
- */
-static void *entry_find (hentry** root_entry, const void* const key, hashTableEqualFunc equalfn,
-						 void *valForNotUnknownKey)
-{
-	hentry *entry = *root_entry;
-	hentry *last = NULL;
-	while (entry)
-	{
-		if (equalfn( key, entry->key))
-		{
-			if (last)
-			{
-				last->next = entry->next;
-				entry->next = *root_entry;
-				*root_entry = entry;
-			}
-			return entry->value;
-		}
+static unsigned int round_up_size (unsigned int size)
+{
+	unsigned int s = HTABLE_MIN_SIZE;
 
-		last = entry;
-		entry = entry->next;
-	}
-	return valForNotUnknownKey;
+	while (s < size && s < (1U << 31))
+		s <<= 1;
+	return s;
 }
 
-static bool		entry_delete (hentry **entry, const void *key, hashTableEqualFunc equalfn,
-			      hashTableDeleteFunc keyfreefn, hashTableDeleteFunc valfreefn)
+/* Return the first entry for KEY along the probing sequence, or NULL. */
+static hentry *entry_find (hashTable *htable, const void *key, unsigned int hash)
 {
-	while (*entry)
-	{
-		if (equalfn (key, (*entry)->key))
-		{
-			*entry = entry_destroy (*entry, keyfreefn, valfreefn);
-			return true;
-		}
-		entry = &((*entry)->next);
-	}
-	return false;
-}
+	unsigned int i = home_index (htable, hash);
 
-static bool		entry_update (hentry *entry, void *key, void *value, hashTableEqualFunc equalfn,
-			      hashTableDeleteFunc keyfreefn, hashTableDeleteFunc valfreefn)
-{
-	while (entry)
+	while (htable->table[i].state != HENTRY_EMPTY)
 	{
-		if (equalfn (key, entry->key))
-		{
-			entry_reset (entry, key, value, keyfreefn, valfreefn);
-			return true;
-		}
-		entry = entry->next;
+		hentry *entry = htable->table + i;
+
+		if (entry->state == HENTRY_USED
+			&& entry->hash == hash
+			&& htable->equalfn (key, entry->key))
+			return entry;
+		i = next_index (htable, i);
 	}
-	return false;
+	return NULL;
 }
 
-static bool  entry_foreach (hentry *entry, hashTableForeachFunc proc, void *user_data)
+/* Put an item to the first unused entry along the probing sequence.
+ * This is for filling a table without tombstones. */
+static void entry_place (hashTable *htable, void *key, void *value, unsigned int hash)
 {
-	while (entry)
-	{
-		if (!proc (entry->key, entry->value, user_data))
-			return false;
-		entry = entry->next;
-	}
-	return true;
+	unsigned int i = home_index (htable, hash);
+
+	while (htable->table[i].state == HENTRY_USED)
+		i = next_index (htable, i);
+
+	hentry *entry = htable->table + i;
+	if (entry->state == HENTRY_DELETED)
+		htable->deleted--;
+	entry->key = key;
+	entry->value = value;
+	entry->hash = hash;
+	entry->state = HENTRY_USED;
+	htable->count++;
 }
 
 extern hashTable *hashTableNew    (unsigned int size,
@@ -178,14 +139,10 @@ extern hashTable *hashTableNew    (unsigned int size,
 
 	htable = xMalloc (1, hashTable);
 
-	if (size < 3)
-		size = 3;
-	if ((size % 2) == 0)
-		size++;
-
-	htable->size = size;
+	htable->size = round_up_size (size);
 	htable->count = 0;
-	htable->table = xCalloc (size, hentry*);
+	htable->deleted = 0;
+	htable->table = xCalloc (htable->size, hentry);
 
 	htable->hashfn = hashfn;
 	htable->equalfn = equalfn;
@@ -229,82 +186,106 @@ extern void       hashTableClear (hashTable *htable)
 
 	for (i = 0; i < htable->size; i++)
 	{
-		hentry *entry;
+		hentry *entry = htable->table + i;
 
-		entry = htable->table[i];
-		entry_reclaim (entry, htable->keyfreefn, htable->valfreefn);
-		htable->table[i] = NULL;
+		if (entry->state == HENTRY_USED)
+			entry_reset (entry, NULL, NULL, htable->keyfreefn, htable->valfreefn);
+		entry->state = HENTRY_EMPTY;
 	}
+	htable->count = 0;
+	htable->deleted = 0;
 }
 
-static void       hashTablePutItem00    (hashTable *htable, void *key, void *value, unsigned int h)
+static void       hashTableResize      (hashTable *htable, unsigned int new_size)
 {
-	unsigned int i = h % htable->size;
-	htable->table[i] = entry_new(key, value, h, htable->table[i]);
-	htable->count++;
-}
+	hentry *old_table = htable->table;
+	unsigned int old_size = htable->size;
+	unsigned int start;
 
-/* "doubling" primes smaller than 2^32 */
-static const unsigned int primes[] = {
-	3, 7, 17, 37, 79, 163, 331, 673, 1361, 2729, 5471, 10949, 21911,
-	43853, 87719, 175447, 350899, 701819, 1403641, 2807303, 5614657,
-	11229331, 22458671, 44917381, 89834777, 179669557, 359339171,
-	718678369, 1437356741, 2874713497,
-};
+	htable->table = xCalloc (new_size, hentry);
+	htable->size = new_size;
+	htable->count = 0;
+	htable->deleted = 0;
 
-static unsigned int
-prime_double(unsigned int i)
-{
-	unsigned int j;
+	/* Start from an empty entry so that the items for a key are visited
+	 * in the order of the probing sequence. This keeps the order from the
+	 * newest to the oldest in the new table. */
+	for (start = 0; start < old_size; start++)
+		if (old_table[start].state == HENTRY_EMPTY)
+			break;
+	Assert (start < old_size);
 
-	Assert (i > 2);
-	Assert (i % 2);
+	for (unsigned int n = 0; n < old_size; n++)
+	{
+		hentry *entry = old_table + ((start + n) & (old_size - 1));
 
-	for (j = 0; j < sizeof(primes) / sizeof(primes[0]); ++j)
-		if (primes[j] > i)
-			return primes[j];
+		if (entry->state == HENTRY_USED)
+			entry_place (htable, entry->key, entry->value, entry->hash);
+	}
 
-	return i;
+	eFree (old_table);
 }
 
-static void       hashTableGrow        (hashTable *htable)
+static void       hashTablePutItem0    (hashTable *htable, void *key, void *value, unsigned int h)
 {
-	unsigned int current_size = htable->size;
-	unsigned int new_size = prime_double (current_size);
+	/* Keep at least half of the entries empty: a key not in the table
+	 * is found not in the table after visiting 2.5 entries on average. */
+	if ((htable->count + htable->deleted + 1) * 2 > htable->size)
+	{
+		unsigned int new_size = htable->size;
 
-	if (new_size <= current_size)
-		return;
+		if ((htable->count + 1) * 4 > htable->size && new_size < (1U << 31))
+			new_size <<= 1;
+		hashTableResize (htable, new_size);
+	}
 
-	hentry** new_table = xCalloc (new_size, hentry*);
-	for (unsigned int i = 0; i < current_size; i++)
+	unsigned int i = home_index (htable, h);
+	hentry *last = NULL;
+
+	/* Look for the items for the same key. */
+	while (htable->table[i].state != HENTRY_EMPTY)
 	{
-		hentry *entry;
-		while ((entry = htable->table[i]))
+		hentry *entry = htable->table + i;
+
+		if (entry->state == HENTRY_DELETED)
+		{
+			/* A tombstone before the items for the key. */
+			if (last == NULL)
+				break;
+		}
+		else if (entry->hash == h && htable->equalfn (key, entry->key))
 		{
-			unsigned int hash = entry->hash;
-			unsigned int j = hash % new_size;
-			htable->table[i] = entry->next;
-			entry->next = new_table[j];
-			new_table[j] = entry;
+			/* Put the new item at the place of the newest one by
+			 * shifting the items for the key toward the end of the
+			 * probing sequence. */
+			void *tmp_key = entry->key;
+			void *tmp_value = entry->value;
+
+			entry->key = key;
+			entry->value = value;
+			key = tmp_key;
+			value = tmp_value;
+			last = entry;
 		}
+		i = next_index (htable, i);
 	}
 
-	hentry** old_table = htable->table;
-	htable->table = new_table;
-	htable->size = new_size;
-	eFree (old_table);
-}
-
-static void       hashTablePutItem0    (hashTable *htable, void *key, void *value, unsigned int h)
-{
-	if (((double)htable->count / (double)htable->size) < 0.8)
+	/* The oldest item goes after the last item for the key. */
+	if (last)
 	{
-		hashTablePutItem00 (htable, key, value,  h);
-		return;
+		i = next_index (htable, (unsigned int)(last - htable->table));
+		while (htable->table[i].state == HENTRY_USED)
+			i = next_index (htable, i);
 	}
 
-	hashTableGrow (htable);
-	hashTablePutItem00 (htable, key, value, h);
+	hentry *entry = htable->table + i;
+	if (entry->state == HENTRY_DELETED)
+		htable->deleted--;
+	entry->key = key;
+	entry->value = value;
+	entry->hash = h;
+	entry->state = HENTRY_USED;
+	htable->count++;
 }
 
 extern void       hashTablePutItem    (hashTable *htable, void *key, void *value)
@@ -314,50 +295,75 @@ extern void       hashTablePutItem    (hashTable *htable, void *key, void *value
 
 extern void*      hashTableGetItem   (hashTable *htable, const void * key)
 {
-	unsigned int h, i;
+	hentry *entry = entry_find (htable, key, htable->hashfn (key));
 
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	return entry_find(& (htable->table[i]), key, htable->equalfn, htable->valForNotUnknownKey);
+	return entry? entry->value: htable->valForNotUnknownKey;
 }
 
 extern bool     hashTableDeleteItem (hashTable *htable, const void *key)
 {
-	unsigned int h;
-	unsigned int i;
-	h = htable->hashfn (key);
-	i = h % htable->size;
+	unsigned int h = htable->hashfn (key);
+	unsigned int i = home_index (htable, h);
+	hentry deleted = { .state = HENTRY_EMPTY };
+	hentry *last = NULL;
+
+	/* Delete the newest item for KEY, and move the older ones back to
+	 * keep their order. */
+	while (htable->table[i].state != HENTRY_EMPTY)
+	{
+		hentry *entry = htable->table + i;
+
+		if (entry->state == HENTRY_USED
+			&& entry->hash == h && htable->equalfn (key, entry->key))
+		{
+			if (last == NULL)
+				deleted = *entry;
+			else
+			{
+				last->key = entry->key;
+				last->value = entry->value;
+			}
+			last = entry;
+		}
+		i = next_index (htable, i);
+	}
 
-	bool r = entry_delete(&htable->table[i], key,
-			    htable->equalfn, htable->keyfreefn, htable->valfreefn);
-	if (r)
-		htable->count--;
-	return r;
+	if (last == NULL)
+		return false;
+
+	last->state = HENTRY_DELETED;
+	htable->count--;
+	htable->deleted++;
+
+	/* KEY may be the key of the deleted item. */
+	entry_reset (&deleted, NULL, NULL, htable->keyfreefn, htable->valfreefn);
+	return true;
 }
 
 extern bool    hashTableUpdateItem (hashTable *htable, const void *key, void *value)
 {
-	unsigned int h, i;
+	hentry *entry = entry_find (htable, key, htable->hashfn (key));
 
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	bool r = entry_update(htable->table[i], (void *)key, value,
-						  htable->equalfn, NULL, htable->valfreefn);
-	return r;
+	if (entry == NULL)
+		return false;
+
+	entry_reset (entry, (void *)key, value, NULL, htable->valfreefn);
+	return true;
 }
 
 extern bool    hashTableUpdateOrPutItem (hashTable *htable, void *key, void *value)
 {
-	unsigned int h, i;
+	unsigned int h = htable->hashfn (key);
+	hentry *entry = entry_find (htable, key, h);
 
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	bool r = entry_update(htable->table[i], key, value,
-						  htable->equalfn, NULL, htable->valfreefn);
-	if (!r)
-		hashTablePutItem0(htable, key, value, h);
+	if (entry)
+	{
+		entry_reset (entry, key, value, NULL, htable->valfreefn);
+		return true;
+	}
 
-	return r;
+	hashTablePutItem0 (htable, key, value, h);
+	return false;
 }
 
 extern bool    hashTableHasItem    (hashTable *htable, const void *key)
@@ -370,18 +376,11 @@ extern bool       hashTableForeachItem (hashTable *htable, hashTableForeachFunc
 	unsigned int i;
 
 	for (i = 0; i < htable->size; i++)
-		if (!entry_foreach(htable->table[i], proc, user_data))
-			return false;
-	return true;
-}
-
-static bool track_chain (const void *const key, void *value, void *chain_data)
-{
-	struct chainTracker *chain_tracker = chain_data;
-
-	if (chain_tracker->equalfn (chain_tracker->target_key, key))
 	{
-		if (! chain_tracker->user_proc (key, value, chain_tracker->user_data))
+		hentry *entry = htable->table + i;
+
+		if (entry->state == HENTRY_USED
+			&& !proc (entry->key, entry->value, user_data))
 			return false;
 	}
 	return true;
@@ -389,55 +388,50 @@ static bool track_chain (const void *const key, void *value, void *chain_data)
 
 extern bool       hashTableForeachItemOnChain (hashTable *htable, const void *key, hashTableForeachFunc proc, void *user_data)
 {
-	unsigned int h, i;
-	struct chainTracker chain_tracker = {
-		.target_key = key,
-		.user_proc = proc,
-		.user_data = user_data,
-		.equalfn   = htable->equalfn,
-	};
-
-	h = htable->hashfn (key);
-	i = h % htable->size;
-	if (!entry_foreach(htable->table[i], track_chain, &chain_tracker))
-		return false;
+	unsigned int h = htable->hashfn (key);
+	unsigned int i = home_index (htable, h);
+
+	while (htable->table[i].state != HENTRY_EMPTY)
+	{
+		hentry *entry = htable->table + i;
+
+		if (entry->state == HENTRY_USED
+			&& entry->hash == h && htable->equalfn (key, entry->key))
+		{
+			if (!proc (entry->key, entry->value, user_data))
+				return false;
+		}
+		i = next_index (htable, i);
+	}
 	return true;
 }
 
 extern void hashTablePrintStatistics(hashTable *htable)
 {
 	if (htable->size == 0 || htable->count == 0)
-		fprintf(stderr, "size: %u, count: %u, average: 0\n",
-				htable->size, htable->count);
-
-	double sum = 0.0;
-	for (size_t i = 0; i < htable->size; i++)
 	{
-		hentry *e = htable->table[i];
-		while (e)
-		{
-			sum += 1.0;
-			e = e->next;
-		}
+		fprintf(stderr, "size: %u, count: %u, deleted: %u, average probes: 0\n",
+				htable->size, htable->count, htable->deleted);
+		return;
 	}
-	double average = sum / (double)htable->size;
 
-	double variance = 0.0;
-	for (size_t i = 0; i < htable->size; i++)
+	/* The number of entries visited for finding each item */
+	double sum = 0.0;
+	unsigned int longest = 0;
+	for (unsigned int i = 0; i < htable->size; i++)
 	{
-		double sum0 = 0;
-		hentry *e = htable->table[i];
-		while (e)
-		{
-			sum0 += 1.0;
-			e = e->next;
-		}
-		double d = sum0 - average;
-		variance += (d * d);
+		hentry *e = htable->table + i;
+		if (e->state != HENTRY_USED)
+			continue;
+
+		unsigned int probes = ((i - home_index (htable, e->hash)) & (htable->size - 1)) + 1;
+		sum += probes;
+		if (probes > longest)
+			longest = probes;
 	}
-	variance = variance / (double)htable->size;
-	fprintf(stderr, "size: %u, count: %u, average: %lf, s.d.: sqrt(%lf)\n",
-			htable->size, htable->count, average, variance);
+	fprintf(stderr, "size: %u, count: %u, deleted: %u, average probes: %lf, longest: %u\n",
+			htable->size, htable->count, htable->deleted,
+			sum / (double)htable->count, longest);
 }
 
 extern unsigned int hashTableCountItem   (hashTable *htable)
@@ -463,40 +457,87 @@ bool hashPtreq (const void *const a, const void *const b)
 }
 
 
-/* http://www.cse.yorku.ca/~oz/hash.html */
-static unsigned long
-djb2(const unsigned char *str)
+/* A string hash in the style of wyhash: the bytes are read 8 or 16 at
+ * a time, and mixed with 64x64->128 bit multiplications. */
+#define HASH_SECRET0 0xa0761d6478bd642fULL
+#define HASH_SECRET1 0xe7037ed1a0b428dbULL
+#define HASH_SECRET2 0x8ebc6af09c88c6e3ULL
+
+static uint64_t hash_mix (uint64_t a, uint64_t b)
 {
-	unsigned long hash = 5381;
-	int c;
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 r = (unsigned __int128)a * b;
+	return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+	uint64_t ha = a >> 32, la = (uint32_t)a;
+	uint64_t hb = b >> 32, lb = (uint32_t)b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	return lo ^ hi;
+#endif
+}
 
-	while ((c = *str++))
-		hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+static uint64_t hash_read64 (const unsigned char *p)
+{
+	uint64_t v;
+	memcpy (&v, p, sizeof (v));
+	return v;
+}
 
-	return hash;
+static uint64_t hash_read32 (const unsigned char *p)
+{
+	uint32_t v;
+	memcpy (&v, p, sizeof (v));
+	return v;
 }
 
-static unsigned long
-casedjb2(const unsigned char *str)
+static unsigned int hash_bytes (const unsigned char *p, size_t len)
 {
-	unsigned long hash = 5381;
-	int c;
+	uint64_t seed = HASH_SECRET0 ^ hash_mix (len ^ HASH_SECRET0, HASH_SECRET1);
+	uint64_t a, b;
 
-	while ((c = *str++))
+	if (len <= 16)
 	{
-		if (('a' <= c) && (c <= 'z'))
-			c += ('A' - 'a');
-		hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+		if (len >= 4)
+		{
+			size_t off = (len >> 3) << 2;
+			a = (hash_read32 (p) << 32) | hash_read32 (p + off);
+			b = (hash_read32 (p + len - 4) << 32) | hash_read32 (p + len - 4 - off);
+		}
+		else if (len > 0)
+		{
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else
+	{
+		size_t i = len;
+		while (i > 16)
+		{
+			seed = hash_mix (hash_read64 (p) ^ HASH_SECRET1, hash_read64 (p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = hash_read64 (p + i - 16);
+		b = hash_read64 (p + i - 8);
 	}
 
-	return hash;
+	uint64_t h = hash_mix (a ^ HASH_SECRET1, b ^ seed);
+	h = hash_mix (h ^ HASH_SECRET2, len ^ HASH_SECRET1);
+	return (unsigned int)(h ^ (h >> 32));
 }
 
-
 unsigned int hashCstrhash (const void *const x)
 {
 	const char *const s = x;
-	return (unsigned int)djb2((const unsigned char *)s);
+	return hash_bytes ((const unsigned char *)s, strlen (s));
 }
 
 bool hashCstreq (const void * const a, const void *const b)
@@ -527,8 +568,24 @@ bool hashInteq (const void *const a, const void *const b)
 
 unsigned int hashCstrcasehash (const void *const x)
 {
-	const char *const s = x;
-	return (unsigned int)casedjb2((const unsigned char *)s);
+	const unsigned char *s = x;
+	unsigned char buf [64];
+	size_t len = 0;
+	uint64_t h = 0;
+
+	/* Hash the string folded to upper case in blocks. */
+	do
+	{
+		size_t n = 0;
+		for (; n < sizeof (buf) && s [n] != '\0'; n++)
+			buf [n] = (('a' <= s [n]) && (s [n] <= 'z'))? s [n] + ('A' - 'a'): s [n];
+		h = hash_mix (h ^ hash_bytes (buf, n), HASH_SECRET2);
+		len += n;
+		s += n;
+	}
+	while (*s != '\0');
+
+	return (unsigned int)(h ^ (h >> 32) ^ len);
 }
 
 bool hashCstrcaseeq (const void *const a, const void *const b)
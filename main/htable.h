@@ -88,7 +88,10 @@ extern bool       hashTableUpdateOrPutItem  (hashTable *htable, void *key, void
  * the items, or htable holds no item.
  *
  * Return false if htable holds at least one item and proc returns false
- * for one of the items. */
+ * for one of the items.
+ *
+ * The items are visited in no particular order. Don't depend on it;
+ * it may change when the implementation changes. */
 extern bool       hashTableForeachItem (hashTable *htable, hashTableForeachFunc proc, void *user_data);
 
 /* This function is useful for htable having multiple items for a key.
@@ -0,0 +1,564 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for parsing input files with a pool of
+*   worker processes (--jobs option).
+*
+*   Parsers keep their state in global variables, so a worker is a forked
+*   process rather than a thread: each worker gets private copies of the
+*   input file, the cork queue, the regex engine state, and so on.
+*
+*   The main process collects the names of input files first. Workers then
+*   take the indexes of the files from a shared pipe, one by one, and write
+*   tags to their private temporary files. Each worker reports where the
+*   output for each file starts and ends in its temporary file. Finally the
+*   main process copies the outputs to the tag file in the order the input
+*   files were collected. As the result, the tag file is the same as one
+*   generated without --jobs option.
+*
+*   When the tag file is sorted with the internal sort algorithm, each
+*   worker sorts its temporary file (a shard) instead. The main process
+*   merges the sorted shards with a k-way merge while writing the sorted
+*   tag file, in the same order and with the same duplicate suppression
+*   as the internal sort.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+
+#include "cache_p.h"
+#include "debug.h"
+#include "entry_p.h"
+#include "htable.h"
+#include "jobs_p.h"
+#include "mio.h"
+#include "numarray.h"
+#include "options_p.h"
+#include "parse_p.h"
+#include "ptrarray.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "stats_p.h"
+#include "strlist.h"
+#include "update_p.h"
+#include "vstring.h"
+
+#if defined (HAVE_FORK) && defined (HAVE_UNISTD_H) && defined (HAVE_SYS_WAIT_H)
+# define JOBS_SUPPORTED
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+#ifdef JOBS_SUPPORTED
+
+/* Sent from a worker to the main process at the end of its job. */
+struct sWorkerReport {
+	unsigned int numFiles;
+	unsigned int numPtagSpans;	/* 2 * the number of pseudo tags */
+	unsigned long numTags;
+	size_t maxLine;
+	size_t maxTag;
+	unsigned long files;
+	unsigned long lines;
+	unsigned long bytes;
+	tagCacheStats cache;
+};
+
+/* Where the output for an input file is in the temporary file of a worker. */
+struct sFileSegment {
+	unsigned int fileIndex;
+	long start;
+	long end;
+};
+
+typedef struct sWorker {
+	pid_t pid;
+	int resultFd;
+	char *tagFileName;
+	MIO *mio;
+	struct sWorkerReport report;
+	struct sFileSegment *segments;
+	long *ptagSpans;
+	unsigned int ptagCursor;
+	char *ptagLines;			/* Only for sorted shards */
+} worker;
+
+#endif	/* JOBS_SUPPORTED */
+
+/*
+*   DATA DEFINITIONS
+*/
+static stringList *JobsQueue;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern bool isJobsQueueActive (void)
+{
+#ifdef JOBS_SUPPORTED
+	return Option.jobs > 1;
+#else
+	return false;
+#endif
+}
+
+extern void queueFileForJobs (const char *const fileName)
+{
+	if (JobsQueue == NULL)
+		JobsQueue = stringListNew ();
+	stringListAdd (JobsQueue, vStringNewInit (fileName));
+}
+
+static bool runJobsSequentially (void)
+{
+	bool resize = false;
+
+	for (unsigned int i = 0; i < stringListCount (JobsQueue); i++)
+		resize |= parseFile (vStringValue (stringListItem (JobsQueue, i)));
+	return resize;
+}
+
+#ifdef JOBS_SUPPORTED
+
+static bool readFully (int fd, void *buf, size_t len)
+{
+	char *p = buf;
+
+	while (len > 0)
+	{
+		ssize_t r = read (fd, p, len);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return false;
+		p += r;
+		len -= r;
+	}
+	return true;
+}
+
+static bool writeFully (int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+
+	while (len > 0)
+	{
+		ssize_t r = write (fd, p, len);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return false;
+		p += r;
+		len -= r;
+	}
+	return true;
+}
+
+/* Read the pseudo tags written in this worker. Their lines are sent
+ * to the main process before sorting the tag file of the worker. */
+static char *readPseudoTagsOfWorker (MIO *mio, const longArray *spans, size_t *len)
+{
+	size_t total = 0;
+
+	for (unsigned int i = 0; i < longArrayCount (spans); i += 2)
+		total += longArrayItem (spans, i + 1) - longArrayItem (spans, i);
+
+	char *lines = xMalloc (total + 1, char);
+	char *p = lines;
+	for (unsigned int i = 0; i < longArrayCount (spans); i += 2)
+	{
+		long start = longArrayItem (spans, i);
+		size_t n = longArrayItem (spans, i + 1) - start;
+
+		if (mio_seek (mio, start, SEEK_SET) != 0
+			|| mio_read (mio, p, 1, n) != n)
+			error (FATAL | PERROR, "cannot read tag file of worker");
+		p += n;
+	}
+	*len = total;
+	return lines;
+}
+
+static void runWorker (worker *w, int queueFd)
+{
+	unsigned int fileIndex;
+	char *ptagLines = NULL;
+	size_t ptagLen = 0;
+	ptrArray *segments = ptrArrayNew (eFree);
+
+	redirectTagFileForWorker (w->mio);
+
+	while (readFully (queueFd, &fileIndex, sizeof (fileIndex)))
+	{
+		struct sFileSegment *seg = xMalloc (1, struct sFileSegment);
+
+		seg->fileIndex = fileIndex;
+		seg->start = tagFileOffset ();
+		parseFile (vStringValue (stringListItem (JobsQueue, fileIndex)));
+		seg->end = tagFileOffset ();
+		ptrArrayAdd (segments, seg);
+	}
+
+	if (mio_flush (w->mio) != 0)
+		error (FATAL | PERROR, "cannot write tag file of worker");
+
+	const longArray *spans = pseudoTagSpansOfWorker ();
+	if (canMergeSortedShardsOfWorkers ())
+	{
+		ptagLines = readPseudoTagsOfWorker (w->mio, spans, &ptagLen);
+		sortTagFileOfWorker ();
+	}
+	struct sWorkerReport report = {
+		.numFiles = ptrArrayCount (segments),
+		.numPtagSpans = longArrayCount (spans),
+	};
+	getTagFileCounts (&report.numTags, &report.maxLine, &report.maxTag);
+	getTotals (&report.files, &report.lines, &report.bytes);
+	getTagCacheStats (&report.cache);
+
+	bool r = writeFully (w->resultFd, &report, sizeof (report));
+	for (unsigned int i = 0; r && i < report.numFiles; i++)
+		r = writeFully (w->resultFd, ptrArrayItem (segments, i),
+						sizeof (struct sFileSegment));
+	for (unsigned int i = 0; r && i < report.numPtagSpans; i++)
+	{
+		long offset = longArrayItem (spans, i);
+		r = writeFully (w->resultFd, &offset, sizeof (offset));
+	}
+	if (r && ptagLines)
+		r = writeFully (w->resultFd, ptagLines, ptagLen);
+	if (!r)
+		error (FATAL | PERROR, "cannot report the result of worker");
+
+	_exit (0);
+}
+
+static void feedQueue (int queueFd, unsigned int count)
+{
+	/* Keep each write shorter than PIPE_BUF so that a write is atomic. */
+	enum { batchSize = 64 };
+	unsigned int batch [batchSize];
+	unsigned int i = 0;
+
+	while (i < count)
+	{
+		unsigned int n = 0;
+		while (n < batchSize && i < count)
+			batch [n++] = i++;
+		if (!writeFully (queueFd, batch, n * sizeof (batch [0])))
+			break;		/* All workers are dead. */
+	}
+}
+
+static bool collectReport (worker *w)
+{
+	struct sWorkerReport *report = &w->report;
+
+	if (!readFully (w->resultFd, report, sizeof (*report)))
+		return false;
+
+	w->segments = xMalloc (report->numFiles + 1, struct sFileSegment);
+	if (!readFully (w->resultFd, w->segments,
+					report->numFiles * sizeof (struct sFileSegment)))
+		return false;
+
+	w->ptagSpans = xMalloc (report->numPtagSpans + 1, long);
+	if (!readFully (w->resultFd, w->ptagSpans,
+					report->numPtagSpans * sizeof (long)))
+		return false;
+
+	if (canMergeSortedShardsOfWorkers ())
+	{
+		size_t len = 0;
+		for (unsigned int i = 0; i < report->numPtagSpans; i += 2)
+			len += w->ptagSpans [i + 1] - w->ptagSpans [i];
+		w->ptagLines = xMalloc (len + 1, char);
+		if (!readFully (w->resultFd, w->ptagLines, len))
+			return false;
+	}
+
+	return true;
+}
+
+static void copyTagFileOfWorker (MIO *mio, long from, long to, char *buf, size_t bufSize)
+{
+	while (from < to)
+	{
+		size_t len = (size_t)(to - from) < bufSize? (size_t)(to - from): bufSize;
+		if (mio_read (mio, buf, 1, len) != len)
+			error (FATAL | PERROR, "cannot read tag file of worker");
+		appendTagFileOfWorker (buf, len);
+		from += len;
+	}
+}
+
+/* Copy the output for an input file from the temporary file of a worker
+ * to the tag file. A parser specific pseudo tag may be emitted in more
+ * than one worker. Only its first occurrence is copied. */
+static unsigned long mergeSegment (worker *w, struct sFileSegment *seg,
+								   hashTable *ptags, char *buf, size_t bufSize)
+{
+	unsigned long dropped = 0;
+	long pos = seg->start;
+
+	if (mio_seek (w->mio, pos, SEEK_SET) != 0)
+		error (FATAL | PERROR, "cannot seek tag file of worker");
+
+	while (w->ptagCursor < w->report.numPtagSpans
+		   && w->ptagSpans [w->ptagCursor] < seg->end)
+	{
+		long start = w->ptagSpans [w->ptagCursor];
+		long end = w->ptagSpans [w->ptagCursor + 1];
+		w->ptagCursor += 2;
+
+		if (start < pos)
+			continue;
+
+		copyTagFileOfWorker (w->mio, pos, start, buf, bufSize);
+
+		char *ptag = xMalloc (end - start + 1, char);
+		if (mio_read (w->mio, ptag, 1, end - start) != (size_t)(end - start))
+			error (FATAL | PERROR, "cannot read tag file of worker");
+		ptag [end - start] = '\0';
+		if (hashTableHasItem (ptags, ptag))
+		{
+			dropped++;
+			eFree (ptag);
+		}
+		else
+		{
+			appendTagFileOfWorker (ptag, end - start);
+			noteFreshPseudoTagLine (ptag);
+			hashTablePutItem (ptags, ptag, ptag);
+		}
+		pos = end;
+	}
+	copyTagFileOfWorker (w->mio, pos, seg->end, buf, bufSize);
+
+	return dropped;
+}
+
+/* Count the parser specific pseudo tags emitted in more than one worker.
+ * The duplicated lines themselves are filtered out when merging the
+ * sorted shards. */
+static unsigned long countDuplicatedPseudoTags (worker *w, hashTable *ptags)
+{
+	unsigned long dropped = 0;
+	const char *p = w->ptagLines;
+
+	for (unsigned int i = 0; i < w->report.numPtagSpans; i += 2)
+	{
+		size_t len = w->ptagSpans [i + 1] - w->ptagSpans [i];
+		char *ptag = eStrndup (p, len);
+
+		if (hashTableHasItem (ptags, ptag))
+		{
+			dropped++;
+			eFree (ptag);
+		}
+		else
+		{
+			noteFreshPseudoTagLine (ptag);
+			hashTablePutItem (ptags, ptag, ptag);
+		}
+		p += len;
+	}
+	return dropped;
+}
+
+static void mergeWorkers (worker *workers, unsigned int numWorkers, unsigned int count)
+{
+	enum { bufSize = 64 * 1024 };
+	char *buf = xMalloc (bufSize, char);
+	struct sFileSegment **table = xCalloc (count, struct sFileSegment *);
+	unsigned int *owner = xMalloc (count, unsigned int);
+	hashTable *ptags = hashTableNew (7, hashCstrhash, hashCstreq, eFree, NULL);
+	unsigned long dropped = 0;
+
+	for (unsigned int k = 0; k < numWorkers; k++)
+	{
+		for (unsigned int i = 0; i < workers [k].report.numFiles; i++)
+		{
+			struct sFileSegment *seg = workers [k].segments + i;
+			Assert (seg->fileIndex < count);
+			table [seg->fileIndex] = seg;
+			owner [seg->fileIndex] = k;
+		}
+		workers [k].mio = mio_new_file (workers [k].tagFileName, "rb");
+		if (workers [k].mio == NULL)
+			error (FATAL | PERROR, "cannot open tag file of worker");
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (table [i] == NULL)
+			error (FATAL, "no worker processed \"%s\"",
+				   vStringValue (stringListItem (JobsQueue, i)));
+		if (!canMergeSortedShardsOfWorkers ())
+			dropped += mergeSegment (workers + owner [i], table [i], ptags, buf, bufSize);
+	}
+
+	if (canMergeSortedShardsOfWorkers ())
+	{
+		for (unsigned int k = 0; k < numWorkers; k++)
+		{
+			dropped += countDuplicatedPseudoTags (workers + k, ptags);
+			addSortedShard (workers [k].tagFileName);
+		}
+	}
+
+	for (unsigned int k = 0; k < numWorkers; k++)
+	{
+		struct sWorkerReport *report = &workers [k].report;
+
+		addTagFileCountsOfWorker (report->numTags, report->maxLine, report->maxTag);
+		addTotals (report->files, report->lines, report->bytes);
+		addTagCacheStats (&report->cache);
+		mio_unref (workers [k].mio);
+		workers [k].mio = NULL;
+	}
+	setNumTagsAdded (numTagsAdded () - dropped);
+
+	hashTableDelete (ptags);
+	eFree (owner);
+	eFree (table);
+	eFree (buf);
+}
+
+static bool runJobsInWorkers (unsigned int numWorkers)
+{
+	const unsigned int count = stringListCount (JobsQueue);
+	worker *workers = xCalloc (numWorkers, worker);
+	int queueFds [2];
+	bool failed = false;
+
+	verbose ("parsing %u files with %u workers\n", count, numWorkers);
+
+	/* Nothing buffered must be inherited; a worker may flush it again. */
+	fflush (NULL);
+
+	if (pipe (queueFds) < 0)
+		error (FATAL | PERROR, "cannot make a pipe for workers");
+
+	for (unsigned int k = 0; k < numWorkers; k++)
+	{
+		worker *w = workers + k;
+		int resultFds [2];
+
+		w->mio = tempFile ("w+b", &w->tagFileName);
+		if (pipe (resultFds) < 0)
+			error (FATAL | PERROR, "cannot make a pipe for workers");
+
+		w->pid = fork ();
+		if (w->pid < 0)
+			error (FATAL | PERROR, "cannot fork a worker");
+		else if (w->pid == 0)
+		{
+			close (queueFds [1]);
+			close (resultFds [0]);
+			w->resultFd = resultFds [1];
+			runWorker (w, queueFds [0]);
+		}
+
+		close (resultFds [1]);
+		w->resultFd = resultFds [0];
+		mio_unref (w->mio);
+		w->mio = NULL;
+	}
+	close (queueFds [0]);
+
+	void (* savedHandler) (int) = signal (SIGPIPE, SIG_IGN);
+	feedQueue (queueFds [1], count);
+	close (queueFds [1]);
+	signal (SIGPIPE, savedHandler);
+
+	for (unsigned int k = 0; k < numWorkers; k++)
+	{
+		worker *w = workers + k;
+		int status = 0;
+
+		if (!collectReport (w))
+			failed = true;
+		close (w->resultFd);
+
+		while (waitpid (w->pid, &status, 0) < 0)
+		{
+			if (errno != EINTR)
+			{
+				failed = true;
+				break;
+			}
+		}
+		if (! (WIFEXITED (status) && WEXITSTATUS (status) == 0))
+			failed = true;
+	}
+
+	if (!failed)
+		mergeWorkers (workers, numWorkers, count);
+
+	for (unsigned int k = 0; k < numWorkers; k++)
+	{
+		/* Sorted shards are removed after merging them. */
+		if (failed || !canMergeSortedShardsOfWorkers ())
+			remove (workers [k].tagFileName);
+		eFree (workers [k].tagFileName);
+		if (workers [k].segments)
+			eFree (workers [k].segments);
+		if (workers [k].ptagSpans)
+			eFree (workers [k].ptagSpans);
+		if (workers [k].ptagLines)
+			eFree (workers [k].ptagLines);
+	}
+	eFree (workers);
+
+	if (failed)
+		error (FATAL, "a worker process failed");
+
+	/* The output of workers is packed; nothing to shrink. */
+	return false;
+}
+
+#endif	/* JOBS_SUPPORTED */
+
+extern bool runJobs (void)
+{
+	bool resize = false;
+
+	if (JobsQueue == NULL)
+		return false;
+
+#ifdef JOBS_SUPPORTED
+	unsigned int numWorkers = Option.jobs;
+	if (numWorkers > stringListCount (JobsQueue))
+		numWorkers = stringListCount (JobsQueue);
+
+	if (numWorkers > 1)
+		resize = runJobsInWorkers (numWorkers);
+	else
+#endif
+		resize = runJobsSequentially ();
+
+	stringListDelete (JobsQueue);
+	JobsQueue = NULL;
+	return resize;
+}
@@ -0,0 +1,30 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines internal interface to the worker pool used with --jobs option.
+*/
+#ifndef CTAGS_MAIN_JOBS_PRIVATE_H
+#define CTAGS_MAIN_JOBS_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Return true if input files should be queued with queueFileForJobs()
+ * instead of being parsed immediately. */
+extern bool isJobsQueueActive (void);
+extern void queueFileForJobs (const char *const fileName);
+
+/* Parse the queued files with worker processes and merge their output
+ * into the tag file in the order the files were queued. */
+extern bool runJobs (void);
+
+#endif  /* CTAGS_MAIN_JOBS_PRIVATE_H */
@@ -5,6 +5,13 @@
 *   GNU General Public License version 2 or (at your option) any later version.
 *
 *   Manages a keyword hash.
+*
+*   When a parser is initialized, the keywords added for its language are
+*   moved to a table for the language with a minimal perfect hash: every
+*   keyword has a slot of its own, and looking up a word costs one pass
+*   over the word and one string comparison. The hash table shared by all
+*   languages holds only the keywords added to languages not initialized
+*   yet and the keywords added while parsing.
 */
 
 /*
@@ -13,6 +20,7 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#include <stdlib.h>
 #include <ctype.h>
 
 #include "debug.h"
@@ -31,6 +39,28 @@ typedef struct sHashEntry {
 	int value;
 } hashEntry;
 
+typedef struct sKeywordSlot {
+	const char *string;			/* NULL for an unused slot */
+	size_t length;
+	int value;
+	/* The keywords different from STRING only in case, in the order
+	 * added. lookupCaseKeyword() returns VALUE for them. */
+	hashEntry *variants;
+} keywordSlot;
+
+/* A perfect hash table for the keywords of a language.
+ * A word is hashed to a bucket with the first hash value. For a bucket
+ * having a displacement D >= 0, the slot is given by mixing the second
+ * hash value with D. A bucket having D < 0 is for a keyword in the slot
+ * -D - 1. */
+typedef struct sKeywordHash {
+	unsigned int bucketCount;
+	int *displacements;
+	unsigned int slotCount;
+	keywordSlot *slots;
+	size_t maxLength;
+} keywordHash;
+
 /*
 *   DATA DEFINITIONS
 */
@@ -38,6 +68,17 @@ static const unsigned int TableSize = 2039;  /* prime */
 static hashEntry **HashTable = NULL;
 static unsigned int MaxEntryLen = 0;
 
+/* Indexed by langType */
+static keywordHash **KeywordHashes = NULL;
+static unsigned int *HashEntryCounts = NULL; /* the number of entries in HashTable */
+static unsigned int KeywordLanguageCount = 0;
+
+static unsigned char FoldTable [256];
+static bool FoldTableInitialized = false;
+
+/* The limit for searching the displacement of a bucket */
+#define KEYWORD_MAX_DISPLACEMENT 0xffff
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -98,6 +139,23 @@ static unsigned int hashValue (const char *const string, langType language,
 	return h;
 }
 
+static void prepareLanguage (langType language)
+{
+	unsigned int n = (unsigned int)language + 1;
+
+	if (n <= KeywordLanguageCount)
+		return;
+
+	KeywordHashes = xRealloc (KeywordHashes, n, keywordHash *);
+	HashEntryCounts = xRealloc (HashEntryCounts, n, unsigned int);
+	for (unsigned int i = KeywordLanguageCount; i < n; i++)
+	{
+		KeywordHashes [i] = NULL;
+		HashEntryCounts [i] = 0;
+	}
+	KeywordLanguageCount = n;
+}
+
 static hashEntry *newEntry (
 		const char *const string, langType language, int value)
 {
@@ -126,6 +184,9 @@ extern void addKeyword (const char *const string, langType language, int value)
 	if (len > MaxEntryLen)
 		MaxEntryLen = len;
 
+	prepareLanguage (language);
+	HashEntryCounts [language]++;
+
 	if (entry == NULL)
 	{
 		hashEntry **const table = getHashTable ();
@@ -153,8 +214,104 @@ extern void addKeyword (const char *const string, langType language, int value)
 	}
 }
 
+static void initializeFoldTable (void)
+{
+	for (unsigned int c = 0; c < 256; c++)
+		FoldTable [c] = (unsigned char) tolower ((int) c);
+	FoldTableInitialized = true;
+}
+
+/* Hash STRING case-insensitively. Return false if STRING is longer
+ * than MAXLENGTH. */
+static bool hashKeyword (const char *const string, size_t maxLength,
+						 unsigned int *h1, unsigned int *h2, size_t *length)
+{
+	const unsigned char *p = (const unsigned char *) string;
+	unsigned int fnv = 2166136261U;
+	unsigned int djb = 5381;
+
+	for (; *p != '\0'; p++)
+	{
+		unsigned char c = FoldTable [*p];
+
+		fnv = (fnv ^ c) * 16777619U;
+		djb = (djb << 5) + djb + c;
+		if ((size_t) (p - (const unsigned char *) string) >= maxLength)
+			return false;
+	}
+
+	*h1 = fnv;
+	*h2 = djb;
+	*length = p - (const unsigned char *) string;
+	return true;
+}
+
+static unsigned int keywordSlotIndex (const keywordHash *table,
+									  unsigned int h2, int displacement)
+{
+	unsigned int x = h2 ^ ((unsigned int) displacement * 0x9e3779b9U);
+
+	/* The finalizer of MurmurHash3 */
+	x ^= x >> 16;
+	x *= 0x85ebca6bU;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35U;
+	x ^= x >> 16;
+	return x % table->slotCount;
+}
+
+static keywordSlot *findKeywordSlot (const keywordHash *table,
+									 unsigned int h1, unsigned int h2)
+{
+	int d = table->displacements [h1 % table->bucketCount];
+
+	return table->slots
+		+ (d < 0? (unsigned int) (-d - 1): keywordSlotIndex (table, h2, d));
+}
+
+static int lookupKeywordInHash (const keywordHash *table,
+								 const char *const string, bool caseSensitive)
+{
+	unsigned int h1, h2;
+	size_t length;
+
+	if (!hashKeyword (string, table->maxLength, &h1, &h2, &length))
+		return KEYWORD_NONE;
+
+	const keywordSlot *slot = findKeywordSlot (table, h1, h2);
+
+	if (slot->string == NULL || slot->length != length)
+		return KEYWORD_NONE;
+
+	if (!caseSensitive)
+		return strcasecmp (string, slot->string) == 0? slot->value: KEYWORD_NONE;
+
+	if (strcmp (string, slot->string) == 0)
+		return slot->value;
+	for (const hashEntry *v = slot->variants; v != NULL; v = v->next)
+	{
+		if (strcmp (string, v->string) == 0)
+			return v->value;
+	}
+	return KEYWORD_NONE;
+}
+
 static int lookupKeywordFull (const char *const string, bool caseSensitive, langType language)
 {
+	if (0 <= language && (unsigned int)language < KeywordLanguageCount)
+	{
+		if (KeywordHashes [language])
+		{
+			int r = lookupKeywordInHash (KeywordHashes [language], string, caseSensitive);
+			if (r != KEYWORD_NONE)
+				return r;
+		}
+		if (HashEntryCounts [language] == 0)
+			return KEYWORD_NONE;
+	}
+	else if (language >= 0)
+		return KEYWORD_NONE;
+
 	bool maxLenReached;
 	const unsigned int index = hashValue (string, language, MaxEntryLen, &maxLenReached) % TableSize;
 	hashEntry *entry;
@@ -189,8 +346,250 @@ extern int lookupCaseKeyword (const char *const string, langType language)
 	return lookupKeywordFull (string, false, language);
 }
 
+struct keywordToCompile {
+	hashEntry *entry;
+	unsigned int h1, h2;
+	size_t length;
+	unsigned int bucket;
+};
+
+struct bucketToCompile {
+	unsigned int index;
+	unsigned int start;			/* index of the first keyword in the bucket */
+	unsigned int count;
+};
+
+static int compareKeywordsToCompile (const void *a, const void *b)
+{
+	const struct keywordToCompile *ka = a, *kb = b;
+
+	if (ka->bucket != kb->bucket)
+		return ka->bucket < kb->bucket? -1: 1;
+	return 0;
+}
+
+static int compareBucketsToCompile (const void *a, const void *b)
+{
+	const struct bucketToCompile *ba = a, *bb = b;
+
+	/* The larger buckets are placed first. */
+	if (ba->count != bb->count)
+		return ba->count > bb->count? -1: 1;
+	return ba->index < bb->index? -1: (ba->index > bb->index);
+}
+
+static bool placeBucket (keywordHash *table, struct keywordToCompile *keywords,
+						 const struct bucketToCompile *bucket, unsigned int *slots)
+{
+	for (int d = 0; d <= KEYWORD_MAX_DISPLACEMENT; d++)
+	{
+		unsigned int i;
+
+		for (i = 0; i < bucket->count; i++)
+		{
+			unsigned int s = keywordSlotIndex (table, keywords [bucket->start + i].h2, d);
+
+			if (table->slots [s].string)
+				break;
+			/* Two keywords of the bucket may go to the same slot. */
+			unsigned int j;
+			for (j = 0; j < i; j++)
+				if (slots [j] == s)
+					break;
+			if (j < i)
+				break;
+			slots [i] = s;
+		}
+
+		if (i == bucket->count)
+		{
+			for (i = 0; i < bucket->count; i++)
+			{
+				hashEntry *e = keywords [bucket->start + i].entry;
+				table->slots [slots [i]].string = e->string;
+				table->slots [slots [i]].length = keywords [bucket->start + i].length;
+				table->slots [slots [i]].value = e->value;
+			}
+			table->displacements [bucket->index] = d;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void deleteKeywordHash (keywordHash *table)
+{
+	for (unsigned int i = 0; i < table->slotCount; i++)
+	{
+		hashEntry *v = table->slots [i].variants;
+
+		while (v != NULL)
+		{
+			hashEntry *next = v->next;
+			eFree (v);
+			v = next;
+		}
+	}
+	eFree (table->displacements);
+	eFree (table->slots);
+	eFree (table);
+}
+
+static keywordHash *buildKeywordHash (struct keywordToCompile *keywords, unsigned int count)
+{
+	keywordHash *table = xMalloc (1, keywordHash);
+	table->bucketCount = count / 2 + 1;
+	table->displacements = xCalloc (table->bucketCount, int);
+	table->slotCount = count + count / 4 + 1;
+	table->slots = xCalloc (table->slotCount, keywordSlot);
+	table->maxLength = 0;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		keywords [i].bucket = keywords [i].h1 % table->bucketCount;
+		if (keywords [i].length > table->maxLength)
+			table->maxLength = keywords [i].length;
+	}
+	qsort (keywords, count, sizeof (keywords [0]), compareKeywordsToCompile);
+
+	struct bucketToCompile *buckets = xCalloc (table->bucketCount, struct bucketToCompile);
+	for (unsigned int b = 0; b < table->bucketCount; b++)
+		buckets [b].index = b;
+	for (unsigned int i = count; i > 0; i--)
+	{
+		buckets [keywords [i - 1].bucket].start = i - 1;
+		buckets [keywords [i - 1].bucket].count++;
+	}
+	qsort (buckets, table->bucketCount, sizeof (buckets [0]), compareBucketsToCompile);
+
+	unsigned int *slots = xMalloc (buckets [0].count, unsigned int);
+	unsigned int b, freeSlot = 0;
+	for (b = 0; b < table->bucketCount && buckets [b].count > 1; b++)
+	{
+		if (!placeBucket (table, keywords, buckets + b, slots))
+			goto failed;
+	}
+	for (; b < table->bucketCount && buckets [b].count == 1; b++)
+	{
+		hashEntry *e = keywords [buckets [b].start].entry;
+
+		while (table->slots [freeSlot].string)
+			freeSlot++;
+		table->slots [freeSlot].string = e->string;
+		table->slots [freeSlot].length = keywords [buckets [b].start].length;
+		table->slots [freeSlot].value = e->value;
+		table->displacements [buckets [b].index] = - (int) freeSlot - 1;
+	}
+
+	eFree (slots);
+	eFree (buckets);
+	return table;
+
+ failed:
+	eFree (slots);
+	eFree (buckets);
+	deleteKeywordHash (table);
+	return NULL;
+}
+
+extern void compileKeywordTable (langType language)
+{
+	if (!FoldTableInitialized)
+		initializeFoldTable ();
+
+	prepareLanguage (language);
+	/* Keywords added after compiling the table stay in HashTable. */
+	if (KeywordHashes [language] || HashEntryCounts [language] == 0)
+		return;
+
+	unsigned int count = HashEntryCounts [language];
+	struct keywordToCompile *keywords = xMalloc (count, struct keywordToCompile);
+	struct keywordToCompile *variants = xMalloc (count, struct keywordToCompile);
+	hashEntry **const table = getHashTable ();
+	unsigned int n = 0, nVariants = 0;
+
+	/* Keywords different only in case are in the same chain in the order
+	 * added. The first one gets the slot, and the others are kept as its
+	 * variants. */
+	for (unsigned int i = 0; i < TableSize; i++)
+	{
+		for (hashEntry *entry = table [i]; entry != NULL; entry = entry->next)
+		{
+			if (entry->language != language)
+				continue;
+
+			struct keywordToCompile k = { .entry = entry };
+			hashKeyword (entry->string, (size_t)-1, &k.h1, &k.h2, &k.length);
+
+			unsigned int j;
+			for (j = 0; j < n; j++)
+			{
+				if (keywords [j].h1 == k.h1
+					&& strcasecmp (keywords [j].entry->string, entry->string) == 0)
+					break;
+			}
+			if (j < n)
+				variants [nVariants++] = k;
+			else
+				keywords [n++] = k;
+		}
+	}
+	Assert (n + nVariants == count);
+
+	KeywordHashes [language] = buildKeywordHash (keywords, n);
+	if (KeywordHashes [language] == NULL)
+		goto out;
+
+	for (unsigned int i = 0; i < TableSize; i++)
+	{
+		hashEntry **link = table + i;
+
+		while (*link != NULL)
+		{
+			hashEntry *entry = *link;
+
+			if (entry->language == language)
+				*link = entry->next;
+			else
+				link = &entry->next;
+		}
+	}
+	HashEntryCounts [language] = 0;
+
+	for (unsigned int i = 0; i < n; i++)
+		eFree (keywords [i].entry);
+	for (unsigned int i = 0; i < nVariants; i++)
+	{
+		keywordSlot *slot = findKeywordSlot (KeywordHashes [language],
+											 variants [i].h1, variants [i].h2);
+		hashEntry **tail = &slot->variants;
+
+		while (*tail)
+			tail = &(*tail)->next;
+		variants [i].entry->next = NULL;
+		*tail = variants [i].entry;
+	}
+
+ out:
+	eFree (variants);
+	eFree (keywords);
+}
+
 extern void freeKeywordTable (void)
 {
+	for (unsigned int i = 0; i < KeywordLanguageCount; i++)
+	{
+		if (KeywordHashes [i])
+			deleteKeywordHash (KeywordHashes [i]);
+	}
+	if (KeywordHashes)
+		eFree (KeywordHashes);
+	if (HashEntryCounts)
+		eFree (HashEntryCounts);
+	KeywordHashes = NULL;
+	HashEntryCounts = NULL;
+	KeywordLanguageCount = 0;
+
 	if (HashTable != NULL)
 	{
 		unsigned int i;
@@ -267,6 +666,20 @@ extern void printKeywordTable (void)
 extern void dumpKeywordTable (FILE *fp)
 {
 	unsigned int i;
+
+	for (i = 0; i < KeywordLanguageCount; i++)
+	{
+		keywordHash *table = KeywordHashes [i];
+
+		for (unsigned int s = 0; table && s < table->slotCount; s++)
+		{
+			if (table->slots [s].string)
+				fprintf(fp, "%s	%s\n", table->slots [s].string, getLanguageName (i));
+			for (hashEntry *v = table->slots [s].variants; v != NULL; v = v->next)
+				fprintf(fp, "%s	%s\n", v->string, getLanguageName (i));
+		}
+	}
+
 	for (i = 0  ;  i < TableSize  ;  ++i)
 	{
 		hashEntry **const table = getHashTable ();
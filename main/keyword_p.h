@@ -14,7 +14,10 @@
 */
 #include "general.h"  /* must always come first */
 #include <stdio.h>
+#include "types.h"
 
+/* Build the perfect hash table for the keywords added to LANGUAGE. */
+extern void compileKeywordTable (langType language);
 extern void freeKeywordTable (void);
 
 extern void dumpKeywordTable (FILE *fp);
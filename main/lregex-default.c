@@ -30,6 +30,7 @@ static regexCompiledCode compile (struct regexBackend *backend,
 								  int flags);
 static void delete_code (void *code);
 static void set_icase_flag (int *flags);
+static enum regexSyntax syntax (int flags);
 
 /*
 *    DATA DEFINITIONS
@@ -42,6 +43,7 @@ static struct regexBackend defaultRegexBackend = {
 	.compile = compile,
 	.match = match,
 	.delete_code = delete_code,
+	.syntax = syntax,
 };
 
 /*
@@ -126,3 +128,8 @@ static void set_icase_flag (int *flags)
 {
 	*flags |= REG_ICASE;
 }
+
+static enum regexSyntax syntax (int flags)
+{
+	return (flags & REG_EXTENDED)? REGEX_SYNTAX_EXTENDED: REGEX_SYNTAX_BASIC;
+}
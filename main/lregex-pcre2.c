@@ -23,6 +23,7 @@
 #endif
 
 #include "lregex_p.h"
+#include "routines.h"
 #include "trashbox.h"
 
 #include <string.h>
@@ -38,6 +39,8 @@ static regexCompiledCode compile (struct regexBackend *backend,
 								  int flags);
 static void delete_code (void *code);
 static void set_icase_flag (int *flags);
+static enum regexSyntax syntax (int flags);
+static void get_jit_statistics (void *code, unsigned long *jit, unsigned long *all);
 
 /*
 *    DATA DEFINITIONS
@@ -50,6 +53,19 @@ static struct regexBackend pcre2RegexBackend = {
 	.compile = compile,
 	.match = match,
 	.delete_code = delete_code,
+	.syntax = syntax,
+	.get_jit_statistics = get_jit_statistics,
+};
+
+/* Size of the JIT stack shared by all patterns */
+#define JIT_STACK_START_SIZE (32 * 1024)
+#define JIT_STACK_MAX_SIZE   (1024 * 1024)
+
+struct pcre2Code {
+	pcre2_code *code;
+	bool jit;					/* JIT compilation succeeded */
+	unsigned long jitMatches;
+	unsigned long interpretedMatches;
 };
 
 /*
@@ -78,7 +94,10 @@ extern void pcre2_regex_flag_long (const char* const s, const char* const unused
 
 static void delete_code (void *code)
 {
-	pcre2_code_free (code);
+	struct pcre2Code *c = code;
+
+	pcre2_code_free (c->code);
+	eFree (c);
 }
 
 static regexCompiledCode compile (struct regexBackend *backend,
@@ -101,7 +120,35 @@ static regexCompiledCode compile (struct regexBackend *backend,
 			   buffer);
 		return (regexCompiledCode) { .backend = NULL, .code = NULL };
 	}
-	return (regexCompiledCode) { .backend = &pcre2RegexBackend, .code = regex_code };
+
+	struct pcre2Code *c = xCalloc (1, struct pcre2Code);
+	c->code = regex_code;
+	/* If JIT is not supported on the platform, or the pattern cannot be
+	 * compiled, the interpreter is used. */
+	c->jit = (pcre2_jit_compile (regex_code, PCRE2_JIT_COMPLETE) == 0);
+
+	return (regexCompiledCode) { .backend = &pcre2RegexBackend, .code = c };
+}
+
+static pcre2_match_context *getMatchContext (void)
+{
+	static pcre2_match_context *match_context;
+
+	if (match_context == NULL)
+	{
+		match_context = pcre2_match_context_create (NULL);
+		DEFAULT_TRASH_BOX (match_context, pcre2_match_context_free);
+
+		pcre2_jit_stack *jit_stack = pcre2_jit_stack_create (JIT_STACK_START_SIZE,
+															 JIT_STACK_MAX_SIZE,
+															 NULL);
+		if (jit_stack)
+		{
+			DEFAULT_TRASH_BOX (jit_stack, pcre2_jit_stack_free);
+			pcre2_jit_stack_assign (match_context, NULL, jit_stack);
+		}
+	}
+	return match_context;
 }
 
 static int match (struct regexBackend *backend,
@@ -115,8 +162,26 @@ static int match (struct regexBackend *backend,
 		DEFAULT_TRASH_BOX (match_data, pcre2_match_data_free);
 	}
 
-	int rc = pcre2_match (code, (PCRE2_SPTR)input, size,
-						  0, 0, match_data, NULL);
+	struct pcre2Code *c = code;
+	pcre2_match_context *match_context = getMatchContext ();
+	int rc = PCRE2_ERROR_JIT_STACKLIMIT;
+
+	if (c->jit)
+	{
+		rc = pcre2_jit_match (c->code, (PCRE2_SPTR)input, size,
+							  0, 0, match_data, match_context);
+		if (rc != PCRE2_ERROR_JIT_STACKLIMIT)
+			c->jitMatches++;
+	}
+
+	/* Fall back to the interpreter if the JIT stack is exhausted. */
+	if (rc == PCRE2_ERROR_JIT_STACKLIMIT)
+	{
+		rc = pcre2_match (c->code, (PCRE2_SPTR)input, size,
+						  0, PCRE2_NO_JIT, match_data, match_context);
+		c->interpretedMatches++;
+	}
+
 	if (rc > 0)
 	{
 		PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(match_data);
@@ -139,3 +204,16 @@ static void set_icase_flag (int *flags)
 {
 	*flags |= PCRE2_CASELESS;
 }
+
+static enum regexSyntax syntax (int flags CTAGS_ATTR_UNUSED)
+{
+	return REGEX_SYNTAX_PCRE2;
+}
+
+static void get_jit_statistics (void *code, unsigned long *jit, unsigned long *all)
+{
+	struct pcre2Code *c = code;
+
+	*jit = c->jitMatches;
+	*all = c->jitMatches + c->interpretedMatches;
+}
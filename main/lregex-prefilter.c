@@ -0,0 +1,1045 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for skipping regex patterns that cannot
+*   match an input line.
+*
+*   A literal string that every match of a pattern must contain is
+*   extracted when the pattern is compiled. The literals of all patterns
+*   of a language are put into one Aho-Corasick automaton. An input line
+*   is scanned with the automaton once, and only the patterns whose
+*   literals are found in the line (and the patterns having no literal)
+*   are run.
+*
+*   For multitable patterns, the set of the bytes a match can start with
+*   is computed instead.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "debug.h"
+#include "lregex_p.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sPrefilterLiteral {
+	char *string;
+	size_t length;
+	bool icase;
+	unsigned int *ids;			/* patterns requiring this literal */
+	unsigned int idCount;
+} prefilterLiteral;
+
+struct sLiteralPrefilter {
+	prefilterLiteral *literals;
+	unsigned int literalCount;
+
+	/* The automaton; built when the first line is scanned */
+	bool built;
+	unsigned int classCount;
+	unsigned char byteClass [256];	/* 0 is for bytes in no literal */
+	unsigned int stateCount;
+	unsigned int *delta;		/* stateCount * classCount */
+	unsigned int *outputStart;	/* stateCount + 1 */
+	unsigned int *outputs;		/* indexes of literals ending at the states */
+
+	bool *found;				/* per literal, cleared for each scan */
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static int foldByte (int c)
+{
+	return (c >= 'A' && c <= 'Z')? c - 'A' + 'a': c;
+}
+
+static bool isAsciiAlnum (int c)
+{
+	return ((c >= '0' && c <= '9')
+			|| (c >= 'a' && c <= 'z')
+			|| (c >= 'A' && c <= 'Z'));
+}
+
+/* Return the position after the bracket expression starting at P, or
+ * NULL if the expression is not terminated. */
+static const char *skipBracketExpression (const char *p, enum regexSyntax syntax)
+{
+	Assert (*p == '[');
+	p++;
+
+	if (*p == '^')
+		p++;
+	if (*p == ']')
+		p++;
+
+	while (*p && *p != ']')
+	{
+		if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+		{
+			const char delim = p[1];
+			p += 2;
+			while (*p && !(p[0] == delim && p[1] == ']'))
+				p++;
+			if (*p == '\0')
+				return NULL;
+			p += 2;
+		}
+		else if (*p == '\\' && syntax == REGEX_SYNTAX_PCRE2)
+		{
+			if (p[1] == '\0')
+				return NULL;
+			p += 2;
+		}
+		else
+			p++;
+	}
+
+	return (*p == ']')? p + 1: NULL;
+}
+
+/* Return the position after the interval expression, or NULL if it is
+ * not terminated. */
+static const char *skipInterval (const char *p, enum regexSyntax syntax)
+{
+	const char *end = (syntax == REGEX_SYNTAX_BASIC)
+		? strstr (p, "\\}")
+		: strchr (p, '}');
+
+	if (end == NULL)
+		return NULL;
+	return end + ((syntax == REGEX_SYNTAX_BASIC)? 2: 1);
+}
+
+static void endRun (vString *run, vString *best)
+{
+	if (vStringLength (run) > vStringLength (best))
+		vStringCopy (best, run);
+	vStringClear (run);
+}
+
+/* The previous atom is quantified; it may not appear in the match. */
+static void endRunWithQuantifier (vString *run, vString *best)
+{
+	if (vStringLength (run) > 0)
+		vStringChop (run);
+	endRun (run, best);
+}
+
+/* Only the literal characters at the top level of a pattern are
+ * collected; groups and alternatives inside them are skipped as a whole.
+ * This is conservative: anything not understood ends the current run of
+ * literal characters, or gives up the extraction. */
+extern vString *extractRequiredLiteral (const char *regex, enum regexSyntax syntax,
+										bool icase)
+{
+	vString *run = vStringNew ();
+	vString *best = vStringNew ();
+	int depth = 0;
+	const char *p = regex;
+
+	while (*p)
+	{
+		const char c = *p;
+
+		if (c == '[')
+		{
+			endRun (run, best);
+			p = skipBracketExpression (p, syntax);
+			if (p == NULL)
+				goto giveup;
+			continue;
+		}
+
+		if (c == '\\')
+		{
+			const char n = p[1];
+
+			if (n == '\0')
+				goto giveup;
+
+			if (syntax == REGEX_SYNTAX_BASIC)
+			{
+				if (n == '(')
+				{
+					endRun (run, best);
+					depth++;
+					p += 2;
+					continue;
+				}
+				else if (n == ')')
+				{
+					endRun (run, best);
+					if (--depth < 0)
+						goto giveup;
+					p += 2;
+					continue;
+				}
+				else if (n == '|')
+				{
+					if (depth == 0)
+						goto giveup;
+					endRun (run, best);
+					p += 2;
+					continue;
+				}
+				else if (n == '{')
+				{
+					endRunWithQuantifier (run, best);
+					p = skipInterval (p + 2, syntax);
+					if (p == NULL)
+						goto giveup;
+					continue;
+				}
+				else if (n == '+' || n == '?')
+				{
+					endRunWithQuantifier (run, best);
+					p += 2;
+					continue;
+				}
+			}
+
+			if (isAsciiAlnum ((unsigned char) n))
+			{
+				/* Character classes, anchors, and back references.
+				 * Give up on the escape sequences that may stand for
+				 * a literal character or change the syntax. */
+				const char *known = (syntax == REGEX_SYNTAX_PCRE2)
+					? "dDsSwWbBhHvVRAzZG123456789"
+					: "wWsSbB123456789";
+				if (strchr (known, n) == NULL)
+					goto giveup;
+				endRun (run, best);
+			}
+			else if (syntax != REGEX_SYNTAX_PCRE2 && strchr ("<>`'", n))
+				endRun (run, best);	/* GNU word and buffer anchors */
+			else if (depth == 0)
+				vStringPut (run, n);
+			p += 2;
+			continue;
+		}
+
+		if (syntax == REGEX_SYNTAX_BASIC)
+		{
+			if (c == '*')
+				endRunWithQuantifier (run, best);
+			else if (c == '.' || c == '^' || c == '$')
+				endRun (run, best);
+			else if (depth == 0)
+				vStringPut (run, c);
+			p++;
+			continue;
+		}
+
+		switch (c)
+		{
+		case '(':
+			if (syntax == REGEX_SYNTAX_PCRE2 && (p[1] == '*' || p[1] == '?')
+				&& !(p[1] == '?' && p[2] == ':'))
+				goto giveup;	/* options, verbs, and assertions */
+			endRun (run, best);
+			depth++;
+			break;
+		case ')':
+			endRun (run, best);
+			if (--depth < 0)
+				goto giveup;
+			break;
+		case '|':
+			if (depth == 0)
+				goto giveup;
+			endRun (run, best);
+			break;
+		case '*':
+		case '+':
+		case '?':
+			endRunWithQuantifier (run, best);
+			break;
+		case '{':
+			endRunWithQuantifier (run, best);
+			p = skipInterval (p + 1, syntax);
+			if (p == NULL)
+				goto giveup;
+			continue;
+		case '.':
+		case '^':
+		case '$':
+			endRun (run, best);
+			break;
+		default:
+			if (depth == 0)
+				vStringPut (run, c);
+			break;
+		}
+		p++;
+	}
+
+	if (depth != 0)
+		goto giveup;
+	endRun (run, best);
+	vStringDelete (run);
+
+	if (vStringLength (best) == 0)
+	{
+		vStringDelete (best);
+		return NULL;
+	}
+
+	/* Only ASCII letters are folded in scanning. */
+	if (icase)
+	{
+		for (size_t i = 0; i < vStringLength (best); i++)
+		{
+			if ((unsigned char) vStringChar (best, i) >= 0x80)
+			{
+				vStringDelete (best);
+				return NULL;
+			}
+		}
+	}
+
+	return best;
+
+ giveup:
+	vStringDelete (run);
+	vStringDelete (best);
+	return NULL;
+}
+
+/* Computing the bytes a match of a multitable pattern can start with.
+ *
+ * A multitable pattern anchored with '^' is tried only at the current
+ * position of the input. If the byte at the position is not in the set
+ * of the first bytes of the pattern, the pattern cannot match there. The
+ * set is computed by walking the pattern as a tree of alternatives,
+ * sequences, and quantified atoms. Anything not understood makes the
+ * set full. */
+
+struct firstBytesParser {
+	const char *p;
+	enum regexSyntax syntax;
+	bool icase;
+	bool failed;
+};
+
+#define FIRST_BYTES_SIZE 32
+
+static void addByte (unsigned char *set, int c)
+{
+	set [c / 8] |= (1 << (c % 8));
+}
+
+static bool hasByte (const unsigned char *set, int c)
+{
+	return (set [c / 8] & (1 << (c % 8)));
+}
+
+static void addAllBytes (unsigned char *set)
+{
+	memset (set, 0xff, FIRST_BYTES_SIZE);
+}
+
+static void addBytes (unsigned char *set, const unsigned char *other)
+{
+	for (int i = 0; i < FIRST_BYTES_SIZE; i++)
+		set [i] |= other [i];
+}
+
+static void foldBytes (unsigned char *set)
+{
+	for (int c = 'a'; c <= 'z'; c++)
+	{
+		if (hasByte (set, c) || hasByte (set, c - 'a' + 'A'))
+		{
+			addByte (set, c);
+			addByte (set, c - 'a' + 'A');
+		}
+	}
+}
+
+static void addClassBytes (unsigned char *set, int (* isclass) (int), bool negate)
+{
+	for (int c = 0; c < 256; c++)
+		if ((isclass (c) != 0) != negate)
+			addByte (set, c);
+}
+
+static int isWordByte (int c)
+{
+	return isalnum (c) || c == '_';
+}
+
+static int isPcre2SpaceByte (int c)
+{
+	return (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r');
+}
+
+/* Add the bytes matched by the escape sequence "\N" to SET. Returns false
+ * if the escape sequence is not understood. *ZEROWIDTH is set to true
+ * for anchors. */
+static bool addEscapeBytes (struct firstBytesParser *parser, unsigned char *set,
+							char n, bool inBracket, bool *zerowidth)
+{
+	bool pcre2 = (parser->syntax == REGEX_SYNTAX_PCRE2);
+
+	*zerowidth = false;
+
+	if (!isAsciiAlnum ((unsigned char) n))
+	{
+		if (!pcre2 && !inBracket && strchr ("<>`'", n))
+			*zerowidth = true;	/* GNU word and buffer anchors */
+		else
+			addByte (set, (unsigned char) n);
+		return true;
+	}
+
+	switch (n)
+	{
+	case 'w':
+	case 'W':
+		addClassBytes (set, isWordByte, n == 'W');
+		return true;
+	case 's':
+	case 'S':
+		addClassBytes (set, pcre2? isPcre2SpaceByte: isspace, n == 'S');
+		return true;
+	}
+
+	if (pcre2)
+	{
+		switch (n)
+		{
+		case 'd':
+		case 'D':
+			addClassBytes (set, isdigit, n == 'D');
+			return true;
+		case 't':
+			addByte (set, '\t');
+			return true;
+		case 'n':
+			addByte (set, '\n');
+			return true;
+		case 'r':
+			addByte (set, '\r');
+			return true;
+		case 'f':
+			addByte (set, '\f');
+			return true;
+		case 'h':
+		case 'H':
+		case 'v':
+		case 'V':
+		case 'R':
+			addAllBytes (set);
+			return true;
+		}
+	}
+
+	if (!inBracket && (n == 'b' || n == 'B'
+					   || (pcre2 && strchr ("AzZG", n))))
+	{
+		*zerowidth = true;
+		return true;
+	}
+
+	/* Back references, and the escape sequences standing for a literal
+	 * character or changing the syntax */
+	return false;
+}
+
+static bool posixClass (const char *name, size_t length, int (** isclass) (int))
+{
+	static const struct {
+		const char *name;
+		int (* isclass) (int);
+	} classes [] = {
+		{ "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+		{ "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+		{ "lower", islower }, { "print", isprint }, { "punct", ispunct },
+		{ "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit },
+	};
+
+	for (unsigned int i = 0; i < ARRAY_SIZE (classes); i++)
+	{
+		if (strlen (classes [i].name) == length
+			&& strncmp (classes [i].name, name, length) == 0)
+		{
+			*isclass = classes [i].isclass;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void parseBracketExpression (struct firstBytesParser *parser, unsigned char *set)
+{
+	unsigned char members [FIRST_BYTES_SIZE] = { 0 };
+	const char *p = parser->p + 1;
+	bool negate = false;
+	bool first = true;
+
+	if (*p == '^')
+	{
+		negate = true;
+		p++;
+	}
+
+	while (*p && (*p != ']' || first))
+	{
+		int lo;
+
+		first = false;
+		if (p[0] == '[' && p[1] == ':')
+		{
+			const char *end = strstr (p + 2, ":]");
+			int (* isclass) (int);
+
+			if (end == NULL || !posixClass (p + 2, end - (p + 2), &isclass))
+				goto giveup;
+			addClassBytes (members, isclass, false);
+			p = end + 2;
+			continue;
+		}
+		else if (p[0] == '[' && (p[1] == '.' || p[1] == '='))
+			goto giveup;	/* collating elements and equivalence classes */
+		else if (p[0] == '\\' && parser->syntax == REGEX_SYNTAX_PCRE2)
+		{
+			bool zerowidth;
+			unsigned char escaped [FIRST_BYTES_SIZE] = { 0 };
+
+			if (p[1] == '\0'
+				|| !addEscapeBytes (parser, escaped, p[1], true, &zerowidth))
+				goto giveup;
+			addBytes (members, escaped);
+			p += 2;
+			if (*p == '-' && p[1] != ']')
+				goto giveup;	/* a range starting from an escape sequence */
+			continue;
+		}
+
+		lo = (unsigned char) *p++;
+		if (p[0] == '-' && p[1] != ']' && p[1] != '\0')
+		{
+			int hi = (unsigned char) p[1];
+
+			if (hi == '[' || (hi == '\\' && parser->syntax == REGEX_SYNTAX_PCRE2))
+				goto giveup;
+			for (int c = lo; c <= hi; c++)
+				addByte (members, c);
+			p += 2;
+		}
+		else
+			addByte (members, lo);
+	}
+
+	if (*p != ']')
+	{
+		parser->failed = true;
+		return;
+	}
+	parser->p = p + 1;
+
+	if (parser->icase)
+		foldBytes (members);
+	if (negate)
+	{
+		for (int i = 0; i < FIRST_BYTES_SIZE; i++)
+			members [i] = ~members [i];
+	}
+	addBytes (set, members);
+	return;
+
+ giveup:
+	parser->failed = true;
+}
+
+/* Skip an interval expression "{m,n}" after the opening brace at P.
+ * Returns NULL if it is not an interval expression. *MIN0 is set to true
+ * if the atom may not appear. */
+static const char *skipIntervalQuantifier (const char *p, enum regexSyntax syntax,
+										   bool *min0)
+{
+	const char *start = p;
+	bool comma = false;
+
+	*min0 = true;
+	while (*p && (isdigit ((unsigned char) *p) || (*p == ',' && !comma)))
+	{
+		if (*p == ',')
+			comma = true;
+		else if (!comma && *p != '0')
+			*min0 = false;
+		p++;
+	}
+
+	if (p == start || (p == start + 1 && comma))
+		return NULL;
+	if (syntax == REGEX_SYNTAX_BASIC)
+		return (p[0] == '\\' && p[1] == '}')? p + 2: NULL;
+	return (*p == '}')? p + 1: NULL;
+}
+
+static void parseAlternatives (struct firstBytesParser *parser, unsigned char *set,
+							   bool *nullable);
+
+/* Parse an atom and its quantifiers. Returns false at the end of
+ * a sequence. */
+static bool parseQuantifiedAtom (struct firstBytesParser *parser, unsigned char *set,
+								 bool *nullable, bool atStart)
+{
+	const char *p = parser->p;
+	bool basic = (parser->syntax == REGEX_SYNTAX_BASIC);
+
+	*nullable = false;
+
+	if (*p == '\0')
+		return false;
+
+	if (basic)
+	{
+		if (p[0] == '\\' && (p[1] == ')' || p[1] == '|'))
+			return false;
+	}
+	else if (*p == ')' || *p == '|')
+		return false;
+
+	if (*p == '[')
+	{
+		parseBracketExpression (parser, set);
+		if (parser->failed)
+			return false;
+	}
+	else if (*p == '.')
+	{
+		addAllBytes (set);
+		parser->p++;
+	}
+	else if ((basic && p[0] == '\\' && p[1] == '(')
+			 || (!basic && *p == '('))
+	{
+		if (parser->syntax == REGEX_SYNTAX_PCRE2 && (p[1] == '*' || p[1] == '?'))
+		{
+			if (!(p[1] == '?' && p[2] == ':'))
+			{
+				parser->failed = true;	/* options, verbs, and assertions */
+				return false;
+			}
+			p += 2;
+		}
+		parser->p = p + (basic? 2: 1);
+		parseAlternatives (parser, set, nullable);
+		if (parser->failed)
+			return false;
+		p = parser->p;
+		if (basic && p[0] == '\\' && p[1] == ')')
+			parser->p += 2;
+		else if (!basic && *p == ')')
+			parser->p++;
+		else
+		{
+			parser->failed = true;
+			return false;
+		}
+	}
+	else if (*p == '\\')
+	{
+		bool zerowidth;
+
+		if (p[1] == '\0' || !addEscapeBytes (parser, set, p[1], false, &zerowidth))
+		{
+			parser->failed = true;
+			return false;
+		}
+		if (zerowidth)
+			*nullable = true;
+		else if (parser->icase)
+			foldBytes (set);
+		parser->p += 2;
+	}
+	else if (*p == '^' || *p == '$')
+	{
+		/* An anchor, or a literal character in a basic regular expression */
+		if (basic)
+			addByte (set, (unsigned char) *p);
+		*nullable = true;
+		parser->p++;
+	}
+	else if (!basic && (*p == '*' || *p == '+' || *p == '?'))
+	{
+		parser->failed = true;	/* nothing to repeat */
+		return false;
+	}
+	else if (basic && *p == '*' && atStart)
+	{
+		addByte (set, '*');
+		parser->p++;
+	}
+	else
+	{
+		addByte (set, (unsigned char) *p);
+		if (parser->icase)
+			foldBytes (set);
+		parser->p++;
+	}
+
+	/* Quantifiers */
+	while (true)
+	{
+		const char *q;
+		bool min0;
+
+		p = parser->p;
+		if (*p == '*')
+			*nullable = true;
+		else if (basic && p[0] == '\\' && p[1] == '?')
+			*nullable = true;
+		else if (basic && p[0] == '\\' && p[1] == '+')
+			;
+		else if (!basic && *p == '?')
+			*nullable = true;
+		else if (!basic && *p == '+')
+			;
+		else if (basic && p[0] == '\\' && p[1] == '{'
+				 && (q = skipIntervalQuantifier (p + 2, parser->syntax, &min0)))
+		{
+			if (min0)
+				*nullable = true;
+			parser->p = q;
+			continue;
+		}
+		else if (!basic && *p == '{'
+				 && (q = skipIntervalQuantifier (p + 1, parser->syntax, &min0)))
+		{
+			if (min0)
+				*nullable = true;
+			parser->p = q;
+			continue;
+		}
+		else
+			break;
+		parser->p += (*p == '\\')? 2: 1;
+	}
+
+	return true;
+}
+
+static void parseSequence (struct firstBytesParser *parser, unsigned char *set,
+						   bool *nullable)
+{
+	bool atStart = true;
+
+	*nullable = true;
+	while (!parser->failed)
+	{
+		unsigned char atom [FIRST_BYTES_SIZE] = { 0 };
+		bool atomNullable;
+
+		if (!parseQuantifiedAtom (parser, atom, &atomNullable, atStart))
+			break;
+		if (*nullable)
+			addBytes (set, atom);
+		*nullable = *nullable && atomNullable;
+		atStart = false;
+	}
+}
+
+static void parseAlternatives (struct firstBytesParser *parser, unsigned char *set,
+							   bool *nullable)
+{
+	bool basic = (parser->syntax == REGEX_SYNTAX_BASIC);
+
+	*nullable = false;
+	while (true)
+	{
+		bool seqNullable;
+
+		parseSequence (parser, set, &seqNullable);
+		if (parser->failed)
+			return;
+		*nullable = *nullable || seqNullable;
+
+		if (basic && parser->p[0] == '\\' && parser->p[1] == '|')
+			parser->p += 2;
+		else if (!basic && parser->p[0] == '|')
+			parser->p++;
+		else
+			return;
+	}
+}
+
+extern unsigned char *computeFirstBytes (const char *regex, enum regexSyntax syntax,
+										 bool icase)
+{
+	struct firstBytesParser parser = {
+		.p = regex,
+		.syntax = syntax,
+		.icase = icase,
+		.failed = false,
+	};
+	unsigned char set [FIRST_BYTES_SIZE] = { 0 };
+	bool nullable;
+
+	/* A pattern not anchored can match after the current position. */
+	if (*regex != '^')
+		return NULL;
+	parser.p++;
+
+	parseSequence (&parser, set, &nullable);
+	if (parser.failed || nullable || *parser.p != '\0')
+		return NULL;			/* including top level alternation */
+
+	for (int i = 0; i < FIRST_BYTES_SIZE; i++)
+	{
+		if (set [i] != 0xff)
+		{
+			unsigned char *r = xMalloc (FIRST_BYTES_SIZE, unsigned char);
+			memcpy (r, set, FIRST_BYTES_SIZE);
+			return r;
+		}
+	}
+	return NULL;
+}
+
+extern literalPrefilter *literalPrefilterNew (void)
+{
+	return xCalloc (1, literalPrefilter);
+}
+
+static void clearAutomaton (literalPrefilter *pf)
+{
+	if (pf->delta)
+		eFree (pf->delta);
+	if (pf->outputStart)
+		eFree (pf->outputStart);
+	if (pf->outputs)
+		eFree (pf->outputs);
+	if (pf->found)
+		eFree (pf->found);
+
+	pf->delta = NULL;
+	pf->outputStart = NULL;
+	pf->outputs = NULL;
+	pf->found = NULL;
+	pf->built = false;
+}
+
+extern void literalPrefilterDelete (literalPrefilter *pf)
+{
+	for (unsigned int i = 0; i < pf->literalCount; i++)
+	{
+		eFree (pf->literals[i].string);
+		eFree (pf->literals[i].ids);
+	}
+	if (pf->literals)
+		eFree (pf->literals);
+	clearAutomaton (pf);
+	eFree (pf);
+}
+
+extern void literalPrefilterAdd (literalPrefilter *pf, const vString *literal, bool icase,
+								 unsigned int id)
+{
+	prefilterLiteral *lit = NULL;
+
+	for (unsigned int i = 0; i < pf->literalCount; i++)
+	{
+		prefilterLiteral *l = pf->literals + i;
+		if (l->icase == icase && l->length == vStringLength (literal)
+			&& memcmp (l->string, vStringValue (literal), l->length) == 0)
+		{
+			lit = l;
+			break;
+		}
+	}
+
+	if (lit == NULL)
+	{
+		pf->literals = xRealloc (pf->literals, pf->literalCount + 1, prefilterLiteral);
+		lit = pf->literals + pf->literalCount++;
+		lit->string = eStrndup (vStringValue (literal), vStringLength (literal));
+		lit->length = vStringLength (literal);
+		lit->icase = icase;
+		lit->ids = NULL;
+		lit->idCount = 0;
+	}
+
+	lit->ids = xRealloc (lit->ids, lit->idCount + 1, unsigned int);
+	lit->ids [lit->idCount++] = id;
+
+	clearAutomaton (pf);
+}
+
+static void buildAutomaton (literalPrefilter *pf)
+{
+	unsigned int maxStates = 1;
+	unsigned int nc;
+
+	/* Bytes that don't appear in any literal share class 0. Both cases of
+	 * a letter share a class; case sensitive literals are verified after
+	 * the automaton finds them. */
+	memset (pf->byteClass, 0, sizeof (pf->byteClass));
+	nc = 1;
+	for (unsigned int i = 0; i < pf->literalCount; i++)
+	{
+		prefilterLiteral *lit = pf->literals + i;
+		maxStates += lit->length;
+		for (size_t j = 0; j < lit->length; j++)
+		{
+			int c = foldByte ((unsigned char) lit->string [j]);
+			if (pf->byteClass [c] == 0)
+			{
+				pf->byteClass [c] = nc;
+				if (c >= 'a' && c <= 'z')
+					pf->byteClass [c - 'a' + 'A'] = nc;
+				nc++;
+			}
+		}
+	}
+	pf->classCount = nc;
+
+	/* The trie. 0 in GOTO means no transition except for the root. */
+	unsigned int *go = xCalloc (maxStates * nc, unsigned int);
+	unsigned int *terminal = xMalloc (maxStates, unsigned int);
+	unsigned int stateCount = 1;
+
+	for (unsigned int i = 0; i < maxStates; i++)
+		terminal [i] = (unsigned int) -1;
+
+	/* The literals ending at the same state of the trie are chained. */
+	unsigned int *nextLiteral = xMalloc (pf->literalCount, unsigned int);
+	for (unsigned int i = 0; i < pf->literalCount; i++)
+	{
+		prefilterLiteral *lit = pf->literals + i;
+		unsigned int s = 0;
+
+		for (size_t j = 0; j < lit->length; j++)
+		{
+			unsigned int c = pf->byteClass [(unsigned char) lit->string [j]];
+			if (go [s * nc + c] == 0)
+				go [s * nc + c] = stateCount++;
+			s = go [s * nc + c];
+		}
+		nextLiteral [i] = terminal [s];
+		terminal [s] = i;
+	}
+
+	/* Breadth-first traversal computing failure links, and turning the
+	 * trie into a complete transition table. */
+	unsigned int *fail = xCalloc (stateCount, unsigned int);
+	unsigned int *queue = xMalloc (stateCount, unsigned int);
+	unsigned int head = 0, tail = 0;
+
+	for (unsigned int c = 0; c < nc; c++)
+	{
+		unsigned int t = go [c];
+		if (t)
+		{
+			fail [t] = 0;
+			queue [tail++] = t;
+		}
+	}
+	while (head < tail)
+	{
+		unsigned int s = queue [head++];
+		for (unsigned int c = 0; c < nc; c++)
+		{
+			unsigned int t = go [s * nc + c];
+			if (t)
+			{
+				fail [t] = go [fail [s] * nc + c];
+				queue [tail++] = t;
+			}
+			else
+				go [s * nc + c] = go [fail [s] * nc + c];
+		}
+	}
+
+	/* The outputs of a state include the ones of its failure state.
+	 * QUEUE has the states in breadth-first order, so a failure state is
+	 * always visited before the states referring to it. */
+	unsigned int *outputCount = xCalloc (stateCount, unsigned int);
+	unsigned int total = 0;
+	for (unsigned int k = 0; k < tail; k++)
+	{
+		unsigned int s = queue [k];
+		for (unsigned int l = terminal [s]; l != (unsigned int) -1; l = nextLiteral [l])
+			outputCount [s]++;
+		outputCount [s] += outputCount [fail [s]];
+		total += outputCount [s];
+	}
+
+	pf->outputStart = xMalloc (stateCount + 1, unsigned int);
+	pf->outputs = xMalloc (total? total: 1, unsigned int);
+	pf->outputStart [0] = 0;
+	for (unsigned int s = 0; s < stateCount; s++)
+		pf->outputStart [s + 1] = pf->outputStart [s] + outputCount [s];
+	for (unsigned int k = 0; k < tail; k++)
+	{
+		unsigned int s = queue [k];
+		unsigned int o = pf->outputStart [s];
+		for (unsigned int l = terminal [s]; l != (unsigned int) -1; l = nextLiteral [l])
+			pf->outputs [o++] = l;
+		for (unsigned int f = pf->outputStart [fail [s]]; f < pf->outputStart [fail [s] + 1]; f++)
+			pf->outputs [o++] = pf->outputs [f];
+	}
+
+	eFree (outputCount);
+	eFree (queue);
+	eFree (fail);
+	eFree (nextLiteral);
+	eFree (terminal);
+
+	pf->stateCount = stateCount;
+	pf->delta = xRealloc (go, stateCount * nc, unsigned int);
+	pf->found = xCalloc (pf->literalCount, bool);
+	pf->built = true;
+}
+
+extern void literalPrefilterScan (literalPrefilter *pf, const char *input, size_t length,
+								  unsigned char *hits)
+{
+	if (!pf->built)
+		buildAutomaton (pf);
+
+	const unsigned char *s = (const unsigned char *) input;
+	const unsigned int nc = pf->classCount;
+	unsigned int state = 0;
+	unsigned int rest = pf->literalCount;
+
+	memset (pf->found, 0, sizeof (pf->found[0]) * pf->literalCount);
+
+	for (size_t i = 0; i < length && rest > 0; i++)
+	{
+		state = pf->delta [state * nc + pf->byteClass [s[i]]];
+
+		for (unsigned int o = pf->outputStart [state]; o < pf->outputStart [state + 1]; o++)
+		{
+			unsigned int l = pf->outputs [o];
+			prefilterLiteral *lit = pf->literals + l;
+
+			if (pf->found [l])
+				continue;
+			if (!lit->icase
+				&& memcmp (s + i + 1 - lit->length, lit->string, lit->length) != 0)
+				continue;
+
+			pf->found [l] = true;
+			rest--;
+			for (unsigned int k = 0; k < lit->idCount; k++)
+				hits [lit->ids [k]] = 1;
+		}
+	}
+}
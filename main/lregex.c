@@ -25,6 +25,7 @@
 #endif
 
 #include <inttypes.h>
+#include <time.h>
 
 #include "debug.h"
 #include "colprint_p.h"
@@ -34,6 +35,7 @@
 #include "htable.h"
 #include "kind.h"
 #include "options.h"
+#include "options_p.h"
 #include "optscript.h"
 #include "parse_p.h"
 #include "promise.h"
@@ -130,6 +132,19 @@ struct mGroupSpec {
 	bool nextFromStart;
 };
 
+/* What a pattern tells about the input it can match. Used for skipping
+ * the pattern without running it. */
+struct patternHints {
+	/* A literal string every match contains, or NULL
+	 * (only for REG_PARSER_SINGLE_LINE) */
+	vString *required_literal;
+	bool icase;
+
+	/* A bitmap of the bytes a match can start with, or NULL
+	 * (only for REG_PARSER_MULTI_TABLE) */
+	unsigned char *first_bytes;
+};
+
 struct mTableActionSpec {
 	enum tableAction action;
 	struct regexTable *table;
@@ -168,6 +183,14 @@ typedef struct {
 
 	char *pattern_string;
 
+	struct patternHints hints;
+
+	/* Gathered only with --totals=extra */
+	struct {
+		unsigned long calls;
+		clock_t time;
+	} profile;
+
 	char *anonymous_tag_prefix;
 	langType foreign_lang;
 
@@ -239,6 +262,13 @@ struct lregexControlBlock {
 	ptrArray *hook[SCRIPT_HOOK_MAX];
 	ptrArray *hook_code[SCRIPT_HOOK_MAX];
 
+	/* For skipping the entries of REG_PARSER_SINGLE_LINE that cannot
+	 * match a line. Rebuilt when the entries are changed. */
+	literalPrefilter *prefilter;
+	bool prefilterStale;
+	unsigned char *prefilterHits;
+	unsigned char *prefilterDefaultHits;
+
 	langType owner;
 };
 
@@ -322,6 +352,15 @@ static void deleteTableEntry (void *ptrn)
 	eFree (e);
 }
 
+static void clearPatternHints (struct patternHints *hints)
+{
+	vStringDelete (hints->required_literal);
+	hints->required_literal = NULL;
+	if (hints->first_bytes)
+		eFree (hints->first_bytes);
+	hints->first_bytes = NULL;
+}
+
 static void deletePattern (regexPattern *p)
 {
 	p->refcount--;
@@ -345,6 +384,8 @@ static void deletePattern (regexPattern *p)
 
 	eFree (p->pattern_string);
 
+	clearPatternHints (&p->hints);
+
 	if (p->message.message_string)
 		eFree (p->message.message_string);
 
@@ -359,8 +400,22 @@ static void deletePattern (regexPattern *p)
 	eFree (p);
 }
 
+static void deletePrefilter (struct lregexControlBlock *lcb)
+{
+	if (lcb->prefilter)
+	{
+		literalPrefilterDelete (lcb->prefilter);
+		eFree (lcb->prefilterHits);
+		eFree (lcb->prefilterDefaultHits);
+	}
+	lcb->prefilter = NULL;
+	lcb->prefilterHits = NULL;
+	lcb->prefilterDefaultHits = NULL;
+}
+
 static void clearPatternSet (struct lregexControlBlock *lcb)
 {
+	lcb->prefilterStale = true;
 	ptrArrayClear (lcb->entries [REG_PARSER_SINGLE_LINE]);
 	ptrArrayClear (lcb->entries [REG_PARSER_MULTI_LINE]);
 	ptrArrayClear (lcb->tables);
@@ -413,6 +468,8 @@ extern void freeLregexControlBlock (struct lregexControlBlock* lcb)
 	hashTableDelete (lcb->param_dict);
 	lcb->param_dict = NULL;
 
+	deletePrefilter (lcb);
+
 	for (int i = 0; i < SCRIPT_HOOK_MAX; i++)
 	{
 		ptrArrayDelete (lcb->hook[i]);
@@ -777,6 +834,9 @@ static regexPattern* addCompiledTagCommon (struct lregexControlBlock *lcb,
 	else
 		ptrArrayAdd (lcb->entries[regptype], entry);
 
+	if (regptype == REG_PARSER_SINGLE_LINE)
+		lcb->prefilterStale = true;
+
 	useRegexMethod(lcb->owner);
 
 	return entry->pattern;
@@ -1532,6 +1592,7 @@ static void regex_flag_icase_short (char c CTAGS_ATTR_UNUSED, void* data)
 {
 	struct flagDefsDescriptor *desc = data;
 	desc->backend->set_icase_flag (&desc->flags);
+	desc->icase = true;
 }
 
 static void regex_flag_icase_long (const char* s CTAGS_ATTR_UNUSED, const char* const unused CTAGS_ATTR_UNUSED, void* data)
@@ -1551,6 +1612,7 @@ static struct flagDefsDescriptor choose_backend (const char *flags, enum regexPa
 		.backend  = NULL,
 		.flags = 0,
 		.regptype = regptype,
+		.icase = false,
 	};
 
 	if (flags)
@@ -1574,7 +1636,8 @@ static struct flagDefsDescriptor choose_backend (const char *flags, enum regexPa
 }
 
 static regexCompiledCode compileRegex (enum regexParserType regptype,
-									   const char* const regexp, const char* const flags)
+									   const char* const regexp, const char* const flags,
+									   struct patternHints *hints)
 {
 	struct flagDefsDescriptor desc = choose_backend (flags, regptype, false);
 
@@ -1589,6 +1652,17 @@ static regexCompiledCode compileRegex (enum regexParserType regptype,
 			   ARRAY_SIZE (backendCommonRegexFlagDefs),
 			   &desc);
 
+	if (hints)
+	{
+		enum regexSyntax syntax = desc.backend->syntax (desc.flags);
+
+		hints->icase = desc.icase;
+		if (regptype == REG_PARSER_SINGLE_LINE)
+			hints->required_literal = extractRequiredLiteral (regexp, syntax, desc.icase);
+		else if (regptype == REG_PARSER_MULTI_TABLE)
+			hints->first_bytes = computeFirstBytes (regexp, syntax, desc.icase);
+	}
+
 	return desc.backend->compile (desc.backend, regexp, desc.flags);
 }
 
@@ -1995,6 +2069,21 @@ static bool fillGuestRequest (const char *start,
 	return guestRequestIsFilled (guest_req);
 }
 
+static int runRegexPattern (regexPattern *ptrn, const char *input, size_t size,
+							regmatch_t pmatch [BACK_REFERENCE_COUNT])
+{
+	struct regexBackend *backend = ptrn->pattern.backend;
+
+	if (Option.printTotals < 2)
+		return backend->match (backend, ptrn->pattern.code, input, size, pmatch);
+
+	clock_t start = clock ();
+	int r = backend->match (backend, ptrn->pattern.code, input, size, pmatch);
+	ptrn->profile.time += clock () - start;
+	ptrn->profile.calls++;
+	return r;
+}
+
 static bool matchRegexPattern (struct lregexControlBlock *lcb,
 							   const vString* const line,
 							   regexTableEntry *entry)
@@ -2008,10 +2097,8 @@ static bool matchRegexPattern (struct lregexControlBlock *lcb,
 	if (patbuf->disabled && *(patbuf->disabled))
 		return false;
 
-	match = patbuf->pattern.backend->match (patbuf->pattern.backend,
-											patbuf->pattern.code, vStringValue (line),
-											vStringLength (line),
-											pmatch);
+	match = runRegexPattern (patbuf, vStringValue (line), vStringLength (line),
+							 pmatch);
 
 	if (match == 0)
 	{
@@ -2095,10 +2182,9 @@ static bool matchMultilineRegexPattern (struct lregexControlBlock *lcb,
 	current = start = vStringValue (allLines);
 	do
 	{
-		match = patbuf->pattern.backend->match (patbuf->pattern.backend,
-												patbuf->pattern.code, current,
-												vStringLength (allLines) - (current - start),
-												pmatch);
+		match = runRegexPattern (patbuf, current,
+								 vStringLength (allLines) - (current - start),
+								 pmatch);
 
 		if (match != 0)
 		{
@@ -2195,10 +2281,59 @@ extern bool regexIsPostRun (struct lregexControlBlock *lcb)
 	return false;
 }
 
+static void buildPrefilter (struct lregexControlBlock *lcb)
+{
+	ptrArray *entries = lcb->entries[REG_PARSER_SINGLE_LINE];
+	unsigned int count = ptrArrayCount (entries);
+
+	deletePrefilter (lcb);
+	lcb->prefilterStale = false;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		regexTableEntry *entry = ptrArrayItem (entries, i);
+		regexPattern *ptrn = entry->pattern;
+
+		if (ptrn->hints.required_literal == NULL)
+			continue;
+
+		if (lcb->prefilter == NULL)
+		{
+			lcb->prefilter = literalPrefilterNew ();
+			lcb->prefilterHits = xMalloc (count, unsigned char);
+			lcb->prefilterDefaultHits = xMalloc (count, unsigned char);
+			for (unsigned int j = 0; j < count; j++)
+				lcb->prefilterDefaultHits [j] = 1;
+		}
+		literalPrefilterAdd (lcb->prefilter, ptrn->hints.required_literal,
+							 ptrn->hints.icase, i);
+		lcb->prefilterDefaultHits [i] = 0;
+	}
+}
+
+/* Return an array telling which entries may match the LINE, or NULL
+ * if all entries must be tried. */
+static const unsigned char *prefilterLine (struct lregexControlBlock *lcb,
+										   const vString* const line)
+{
+	if (lcb->prefilterStale)
+		buildPrefilter (lcb);
+	if (lcb->prefilter == NULL)
+		return NULL;
+
+	memcpy (lcb->prefilterHits, lcb->prefilterDefaultHits,
+			ptrArrayCount (lcb->entries[REG_PARSER_SINGLE_LINE]));
+	literalPrefilterScan (lcb->prefilter, vStringValue (line), vStringLength (line),
+						  lcb->prefilterHits);
+	return lcb->prefilterHits;
+}
+
 extern bool matchRegex (struct lregexControlBlock *lcb, const vString* const line, bool postrun)
 {
 	bool result = false;
 	unsigned int i;
+	const unsigned char *hits = prefilterLine (lcb, line);
+
 	for (i = 0  ;  i < ptrArrayCount(lcb->entries[REG_PARSER_SINGLE_LINE])  ;  ++i)
 	{
 		regexTableEntry *entry = ptrArrayItem(lcb->entries[REG_PARSER_SINGLE_LINE], i);
@@ -2213,6 +2348,15 @@ extern bool matchRegex (struct lregexControlBlock *lcb, const vString* const lin
 			&& (!isXtagEnabled (ptrn->xtagType)))
 				continue;
 
+		if (hits && !hits [i])
+		{
+			/* The line doesn't have the literal required by the pattern.
+			 * Count it as matchRegexPattern() does. */
+			if (!(ptrn->disabled && *(ptrn->disabled)))
+				entry->statistics.unmatch++;
+			continue;
+		}
+
 		if (matchRegexPattern (lcb, line, entry))
 		{
 			result = true;
@@ -2339,9 +2483,11 @@ static regexPattern *addTagRegexInternal (struct lregexControlBlock *lcb,
 	if (!regexAvailable)
 		return NULL;
 
-	regexCompiledCode cp = compileRegex (regptype, regex, flags);
+	struct patternHints hints = { .required_literal = NULL, .first_bytes = NULL };
+	regexCompiledCode cp = compileRegex (regptype, regex, flags, &hints);
 	if (cp.code == NULL)
 	{
+		clearPatternHints (&hints);
 		error (WARNING, "pattern: %s", regex);
 		if (table_index != TABLE_INDEX_UNUSED)
 		{
@@ -2427,6 +2573,7 @@ static regexPattern *addTagRegexInternal (struct lregexControlBlock *lcb,
 												explictly_defined,
 												disabled);
 	rptr->pattern_string = escapeRegexPattern(regex);
+	rptr->hints = hints;
 
 	eFree (kindName);
 	if (description)
@@ -2506,9 +2653,11 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 		return;
 
 
-	regexCompiledCode cp = compileRegex (REG_PARSER_SINGLE_LINE, regex, flags);
+	struct patternHints hints = { .required_literal = NULL, .first_bytes = NULL };
+	regexCompiledCode cp = compileRegex (REG_PARSER_SINGLE_LINE, regex, flags, &hints);
 	if (cp.code == NULL)
 	{
+		clearPatternHints (&hints);
 		error (WARNING, "pattern: %s", regex);
 		error (WARNING, "language: %s", getLanguageName (lcb->owner));
 		return;
@@ -2517,6 +2666,7 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 	regexPattern *rptr = addCompiledCallbackPattern (lcb, &cp, callback, flags,
 													 disabled, userData);
 	rptr->pattern_string = escapeRegexPattern(regex);
+	rptr->hints = hints;
 }
 
 static void addTagRegexOption (struct lregexControlBlock *lcb,
@@ -2944,10 +3094,16 @@ static struct regexTable * matchMultitableRegexTable (struct lregexControlBlock
 		if (ptrn->disabled && *(ptrn->disabled))
 			continue;
 
-		match = ptrn->pattern.backend->match (ptrn->pattern.backend,
-											  ptrn->pattern.code, current,
-											  vStringLength(start) - (current - cstart),
-											  pmatch);
+		/* A pattern cannot match if it doesn't start with the byte at
+		 * the current position. */
+		if (ptrn->hints.first_bytes && *offset < vStringLength(start)
+			&& !(ptrn->hints.first_bytes [(unsigned char) *current / 8]
+				 & (1 << ((unsigned char) *current % 8))))
+			match = 1;
+		else
+			match = runRegexPattern (ptrn, current,
+									 vStringLength(start) - (current - cstart),
+									 pmatch);
 		if (match == 0)
 		{
 			entry->statistics.match++;
@@ -3150,6 +3306,82 @@ extern void extendRegexTable (struct lregexControlBlock *lcb, const char *src, c
 	}
 }
 
+static void collectPatterns (ptrArray *patterns, ptrArray *entries)
+{
+	for (unsigned int i = 0; i < ptrArrayCount (entries); i++)
+	{
+		regexTableEntry *entry = ptrArrayItem (entries, i);
+		if (!ptrArrayHas (patterns, entry->pattern))
+			ptrArrayAdd (patterns, entry->pattern);
+	}
+}
+
+static int comparePatternsByTime (const void *a, const void *b)
+{
+	const regexPattern *pa = a;
+	const regexPattern *pb = b;
+
+	if (pa->profile.time != pb->profile.time)
+		return (pa->profile.time < pb->profile.time)? 1: -1;
+	if (pa->profile.calls != pb->profile.calls)
+		return (pa->profile.calls < pb->profile.calls)? 1: -1;
+	return 0;
+}
+
+extern void printRegexStatistics (struct lregexControlBlock *lcb)
+{
+	ptrArray *patterns = ptrArrayNew (NULL);
+
+	collectPatterns (patterns, lcb->entries[REG_PARSER_SINGLE_LINE]);
+	collectPatterns (patterns, lcb->entries[REG_PARSER_MULTI_LINE]);
+	for (unsigned int i = 0; i < ptrArrayCount (lcb->tables); i++)
+	{
+		struct regexTable *table = ptrArrayItem (lcb->tables, i);
+		collectPatterns (patterns, table->entries);
+	}
+
+	if (ptrArrayCount (patterns) == 0)
+	{
+		ptrArrayDelete (patterns);
+		return;
+	}
+
+	ptrArraySort (patterns, comparePatternsByTime);
+
+	unsigned long jitMatches = 0, jitCalls = 0;
+
+	fprintf(stderr, "\nREGEX STATISTICS of %s\n", getLanguageName (lcb->owner));
+	fputs("==============================================\n", stderr);
+	fprintf(stderr, "%10s %10s %7s  %s\n", "calls", "time(ms)", "jit", "pattern");
+	for (unsigned int i = 0; i < ptrArrayCount (patterns); i++)
+	{
+		regexPattern *ptrn = ptrArrayItem (patterns, i);
+		struct regexBackend *backend = ptrn->pattern.backend;
+		char jit [16] = "-";
+
+		if (backend->get_jit_statistics)
+		{
+			unsigned long m, c;
+			backend->get_jit_statistics (ptrn->pattern.code, &m, &c);
+			if (c > 0)
+				snprintf (jit, sizeof (jit), "%.1f%%", 100.0 * m / c);
+			jitMatches += m;
+			jitCalls += c;
+		}
+
+		fprintf(stderr, "%10lu %10.3f %7s  %s\n",
+				ptrn->profile.calls,
+				1000.0 * ptrn->profile.time / CLOCKS_PER_SEC,
+				jit,
+				ptrn->pattern_string);
+	}
+	if (jitCalls > 0)
+		fprintf(stderr, "JIT: %lu of %lu matches (%.1f%%)\n",
+				jitMatches, jitCalls, 100.0 * jitMatches / jitCalls);
+
+	ptrArrayDelete (patterns);
+}
+
 extern void printMultitableStatistics (struct lregexControlBlock *lcb)
 {
 	if (ptrArrayCount(lcb->tables) == 0)
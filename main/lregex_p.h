@@ -43,6 +43,12 @@ enum regexParserType {
 
 struct lregexControlBlock;
 
+enum regexSyntax {
+	REGEX_SYNTAX_BASIC,
+	REGEX_SYNTAX_EXTENDED,
+	REGEX_SYNTAX_PCRE2,
+};
+
 typedef struct sRegexCompiledCode {
 	struct regexBackend *backend;
 	void * code;
@@ -61,14 +67,23 @@ struct regexBackend {
 									   void *, const char *, size_t,
 									   regmatch_t[BACK_REFERENCE_COUNT]);
 	void              (* delete_code) (void *);
+	enum regexSyntax  (* syntax)      (int);
+
+	/* Optional. Store the number of the matches run with JIT compiled
+	 * code, and the number of all matches for the code. */
+	void              (* get_jit_statistics) (void *,
+											   unsigned long *, unsigned long *);
 };
 
 struct flagDefsDescriptor {
 	struct regexBackend *backend;
 	int flags;
 	enum regexParserType regptype;
+	bool icase;
 };
 
+typedef struct sLiteralPrefilter literalPrefilter;
+
 /*
 *   FUNCTION PROTOTYPES
 */
@@ -118,6 +133,7 @@ extern void listRegexOpscriptOperators (FILE *fp);
 extern void addOptscriptToHook (struct lregexControlBlock *lcb, enum scriptHook hook, const char *code);
 extern void propagateParamToOptscript (struct lregexControlBlock *lcb, const char *param, const char *value);
 
+extern void printRegexStatistics (struct lregexControlBlock *lcb);
 extern void printMultitableStatistics (struct lregexControlBlock *lcb);
 
 extern void basic_regex_flag_short (char c, void* data);
@@ -129,4 +145,16 @@ extern void pcre2_regex_flag_short (char c, void* data);
 extern void pcre2_regex_flag_long (const char* const s, const char* const unused, void* data);
 #endif
 
+/* Defined in lregex-prefilter.c */
+extern vString *extractRequiredLiteral (const char *regex, enum regexSyntax syntax,
+										bool icase);
+extern unsigned char *computeFirstBytes (const char *regex, enum regexSyntax syntax,
+										 bool icase);
+extern literalPrefilter *literalPrefilterNew (void);
+extern void literalPrefilterDelete (literalPrefilter *pf);
+extern void literalPrefilterAdd (literalPrefilter *pf, const vString *literal, bool icase,
+								 unsigned int id);
+extern void literalPrefilterScan (literalPrefilter *pf, const char *input, size_t length,
+								  unsigned char *hits);
+
 #endif	/* CTAGS_MAIN_LREGEX_PRIVATEH */
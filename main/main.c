@@ -41,6 +41,10 @@
 # endif
 # include <dirent.h>  /* to declare opendir() */
 #endif
+#if defined (HAVE_FSTATAT) && defined (HAVE_DIRFD)
+# include <fcntl.h>  /* to define AT_SYMLINK_NOFOLLOW */
+# include <sys/stat.h>  /* to declare fstatat() */
+#endif
 #ifdef HAVE_DIRECT_H
 # include <direct.h>  /* to _getcwd() */
 #endif
@@ -49,11 +53,13 @@
 #endif
 
 
+#include "cache_p.h"
 #include "ctags.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "error_p.h"
 #include "field_p.h"
+#include "jobs_p.h"
 #include "keyword_p.h"
 #include "main_p.h"
 #include "options_p.h"
@@ -62,8 +68,10 @@
 #include "read_p.h"
 #include "routines_p.h"
 #include "stats_p.h"
+#include "tagindex_p.h"
 #include "trace.h"
 #include "trashbox_p.h"
+#include "update_p.h"
 #include "writer_p.h"
 #include "xtag_p.h"
 
@@ -73,6 +81,19 @@
 #include <errno.h>
 #endif
 
+/*
+*   DATA DECLARATIONS
+*/
+
+/* What is known about a file before calling stat() with its name. */
+typedef enum {
+	ENTRY_UNKNOWN,
+	ENTRY_IGNORED,
+	ENTRY_DIRECTORY,
+	ENTRY_NORMAL_FILE,
+	ENTRY_SPECIAL_FILE,
+} entryType;
+
 /*
 *   DATA DEFINITIONS
 */
@@ -83,12 +104,48 @@ static void *mainData;
 *   FUNCTION PROTOTYPES
 */
 static bool createTagsForEntry (const char *const entryName);
+static bool createTagsForEntryFull (const char *const entryName, entryType type);
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
 #if defined (HAVE_OPENDIR) && (defined (HAVE_DIRENT_H) || defined (_MSC_VER))
+/* Classify ENTRY with d_type filled by readdir(), or with fstatat()
+ * relative to DIR. Symbolic links are left to createTagsForEntryFull(). */
+static entryType getDirectoryEntryType (DIR *const dir, const struct dirent *const entry)
+{
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+	switch (entry->d_type)
+	{
+	case DT_DIR:
+		return ENTRY_DIRECTORY;
+	case DT_REG:
+		return ENTRY_NORMAL_FILE;
+	case DT_LNK:
+		return ENTRY_UNKNOWN;
+	case DT_UNKNOWN:
+		break;
+	default:
+		return ENTRY_SPECIAL_FILE;
+	}
+#endif
+#if defined (HAVE_FSTATAT) && defined (HAVE_DIRFD)
+	struct stat status;
+
+	if (fstatat (dirfd (dir), entry->d_name, &status, AT_SYMLINK_NOFOLLOW) == 0)
+	{
+		if (S_ISDIR (status.st_mode))
+			return ENTRY_DIRECTORY;
+		else if (S_ISREG (status.st_mode))
+			return ENTRY_NORMAL_FILE;
+		else if (! S_ISLNK (status.st_mode))
+			return ENTRY_SPECIAL_FILE;
+	}
+#endif
+	return ENTRY_UNKNOWN;
+}
+
 static bool recurseUsingOpendir (const char *const dirName)
 {
 	bool resize = false;
@@ -98,25 +155,30 @@ static bool recurseUsingOpendir (const char *const dirName)
 	else
 	{
 		struct dirent *entry;
+		vString *filePath = vStringNew ();
+		size_t dirLength = 0;
+
+		/* The names of entries are put after "DIRNAME/" in FILEPATH. */
+		if (strcmp (dirName, ".") != 0)
+		{
+			char *prefix = combinePathAndFile (dirName, "");
+			vStringCatS (filePath, prefix);
+			eFree (prefix);
+			dirLength = vStringLength (filePath);
+		}
+
 		while ((entry = readdir (dir)) != NULL)
 		{
 			if (strcmp (entry->d_name, ".") != 0  &&
 				strcmp (entry->d_name, "..") != 0)
 			{
-				char *filePath;
-				bool free_p = false;
-				if (strcmp (dirName, ".") == 0)
-					filePath = entry->d_name;
-				else
-				{
-					filePath = combinePathAndFile (dirName, entry->d_name);
-					free_p = true;
-				}
-				resize |= createTagsForEntry (filePath);
-				if (free_p)
-					eFree (filePath);
+				vStringTruncate (filePath, dirLength);
+				vStringCatS (filePath, entry->d_name);
+				resize |= createTagsForEntryFull (vStringValue (filePath),
+												  getDirectoryEntryType (dir, entry));
 			}
 		}
+		vStringDelete (filePath);
 		closedir (dir);
 	}
 	return resize;
@@ -163,14 +225,14 @@ static bool createTagsForWildcardUsingFindfirst (const char *const pattern)
 #endif
 
 
-static bool recurseIntoDirectory (const char *const dirName)
+static bool recurseIntoDirectory (const char *const dirName, bool isSymbolicLink)
 {
 	static unsigned int recursionDepth = 0;
 
 	recursionDepth++;
 
 	bool resize = false;
-	if (isRecursiveLink (dirName))
+	if (isSymbolicLink && isRecursiveLink (dirName))
 		verbose ("ignoring \"%s\" (recursive link)\n", dirName);
 	else if (! Option.recurse)
 		verbose ("ignoring \"%s\" (directory)\n", dirName);
@@ -199,31 +261,69 @@ static bool recurseIntoDirectory (const char *const dirName)
 	return resize;
 }
 
-static bool createTagsForEntry (const char *const entryName)
+/* TYPE is ENTRY_UNKNOWN, or what readdir() tells about ENTRYNAME, which
+ * is not a symbolic link. */
+static bool createTagsForEntryFull (const char *const entryName, entryType type)
 {
 	bool resize = false;
-	fileStatus *status = eStat (entryName);
+	fileStatus *status = NULL;
+	bool isSymbolicLink = false;
 
 	Assert (entryName != NULL);
+	/* An excluded directory is pruned here without stat() and opendir(). */
 	if (isExcludedFile (entryName, true))
+	{
 		verbose ("excluding \"%s\" (the early stage)\n", entryName);
-	else if (status->isSymbolicLink  &&  ! Option.followLinks)
-		verbose ("ignoring \"%s\" (symbolic link)\n", entryName);
-	else if (! status->exists)
-		error (WARNING | PERROR, "cannot open input file \"%s\"", entryName);
-	else if (status->isDirectory)
-		resize = recurseIntoDirectory (entryName);
-	else if (! status->isNormalFile)
+		return resize;
+	}
+
+	if (type == ENTRY_UNKNOWN)
+	{
+		status = eStat (entryName);
+		isSymbolicLink = status->isSymbolicLink;
+		if (status->isSymbolicLink  &&  ! Option.followLinks)
+		{
+			verbose ("ignoring \"%s\" (symbolic link)\n", entryName);
+			type = ENTRY_IGNORED;
+		}
+		else if (! status->exists)
+		{
+			error (WARNING | PERROR, "cannot open input file \"%s\"", entryName);
+			type = ENTRY_IGNORED;
+		}
+		else if (status->isDirectory)
+			type = ENTRY_DIRECTORY;
+		else if (! status->isNormalFile)
+			type = ENTRY_SPECIAL_FILE;
+		else
+			type = ENTRY_NORMAL_FILE;
+	}
+
+	if (type == ENTRY_IGNORED)
+		;
+	else if (type == ENTRY_DIRECTORY)
+		resize = recurseIntoDirectory (entryName, isSymbolicLink);
+	else if (type == ENTRY_SPECIAL_FILE)
 		verbose ("ignoring \"%s\" (special file)\n", entryName);
 	else if (isExcludedFile (entryName, false))
 		verbose ("excluding \"%s\"\n", entryName);
+	else if (Option.update && isInputFileUpToDate (entryName))
+		verbose ("skipping unchanged \"%s\"\n", entryName);
+	else if (isJobsQueueActive ())
+		queueFileForJobs (entryName);
 	else
 		resize = parseFile (entryName);
 
-	eStatFree (status);
+	if (status)
+		eStatFree (status);
 	return resize;
 }
 
+static bool createTagsForEntry (const char *const entryName)
+{
+	return createTagsForEntryFull (entryName, ENTRY_UNKNOWN);
+}
+
 #ifdef MANUAL_GLOBBING
 
 static bool createTagsForWildcardArg (const char *const arg)
@@ -370,15 +470,24 @@ static void batchMakeTags (cookedArgs *args, void *user CTAGS_ATTR_UNUSED)
 		resize = (bool) (createTagsFromFileInput (stdin, true) || resize);
 	}
 	if (! files  &&  Option.recurse)
-		resize = recurseIntoDirectory (".");
+		resize = recurseIntoDirectory (".", false);
+
+	resize = (bool) (runJobs () || resize);
 
 	timeStamp (1);
 
 	if ((! Option.filter) && (!Option.printLanguage))
+	{
 		closeTagFile (resize);
+		writerPostWriteTagFile (Option.tagFileName);
+		if (Option.tagIndex)
+			writeTagIndex (Option.tagFileName);
+	}
 
 	timeStamp (2);
 
+	evictTagCache ();
+
 	if (Option.printTotals)
 	{
 		printTotals (timeStamps, Option.append, Option.sorted);
@@ -386,6 +495,8 @@ static void batchMakeTags (cookedArgs *args, void *user CTAGS_ATTR_UNUSED)
 			for (unsigned int i = 0; i < countParsers(); i++)
 				printParserStatisticsIfUsed (i);
 	}
+	if (Option.cacheStats)
+		printTagCacheStats ();
 
 #undef timeStamp
 }
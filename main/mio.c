@@ -36,11 +36,26 @@
 #include <unistd.h>
 #endif
 
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H)
+#define MIO_MMAP_SUPPORTED
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <signal.h>
+#if !defined (MAP_ANONYMOUS) && defined (MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
 /* minimal reallocation chunk size */
 #define MIO_CHUNK_SIZE 4096
 
 #define MAX(a, b)  (((a) > (b)) ? (a) : (b))
 
+/* A mapped file works in the same way as a memory stream. */
+#define mio_is_memory(mio) ((mio)->type == MIO_TYPE_MEMORY || (mio)->type == MIO_TYPE_MMAP)
+
 
 /**
  * SECTION:mio
@@ -101,11 +116,79 @@ struct _MIO {
 			MIODestroyNotify free_func;
 			bool error;
 			bool eof;
+#ifdef MIO_MMAP_SUPPORTED
+			/* for MIO_TYPE_MMAP */
+			volatile sig_atomic_t truncated;
+			struct _MIO *next_mapped;
+#endif
 		} mem;
 	} impl;
 	MIOUserData udata;
 };
 
+#ifdef MIO_MMAP_SUPPORTED
+/* The MIO objects made with mio_new_mmap() and not destroyed yet */
+static MIO *mapped_mios;
+static size_t mapped_pagesize;
+
+static size_t mio_mmap_length (MIO *mio)
+{
+	return (mio->impl.mem.size + mapped_pagesize - 1) / mapped_pagesize * mapped_pagesize;
+}
+
+/* Reading a page of a mapped file beyond the end of the file raises
+ * SIGBUS. It happens if the file is truncated while it is mapped.
+ * Replace the pages from the faulting one with zero-filled pages, so the
+ * reader sees zeros instead of being killed, and record the truncation
+ * for mio_mmap_is_truncated(). */
+static void mio_mmap_sigbus_handler (int signum, siginfo_t *info,
+									 void *context CTAGS_ATTR_UNUSED)
+{
+	unsigned char *addr = info->si_addr;
+
+	for (MIO *mio = mapped_mios; mio; mio = mio->impl.mem.next_mapped)
+	{
+		unsigned char *start = mio->impl.mem.buf;
+		size_t length = mio_mmap_length (mio);
+
+		if (addr < start || start + length <= addr)
+			continue;
+
+		unsigned char *page = start + (size_t) (addr - start) / mapped_pagesize * mapped_pagesize;
+		if (mmap (page, length - (size_t) (page - start), PROT_READ | PROT_WRITE,
+				  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED)
+			break;
+		mio->impl.mem.truncated = 1;
+		return;
+	}
+
+	/* Not a fault on a mapped file: the default action is taken when the
+	 * faulting instruction runs again. */
+	signal (signum, SIG_DFL);
+}
+
+static bool mio_mmap_install_sigbus_handler (void)
+{
+	static int installed = -1;
+
+	if (installed < 0)
+	{
+		struct sigaction sa;
+		long pagesize = sysconf (_SC_PAGESIZE);
+
+		memset (&sa, 0, sizeof (sa));
+		sa.sa_sigaction = mio_mmap_sigbus_handler;
+		sa.sa_flags = SA_SIGINFO;
+		sigemptyset (&sa.sa_mask);
+
+		installed = (pagesize > 0 && sigaction (SIGBUS, &sa, NULL) == 0);
+		if (installed)
+			mapped_pagesize = (size_t) pagesize;
+	}
+	return installed;
+}
+#endif
+
 
 /**
  * mio_new_file_full:
@@ -290,6 +373,67 @@ MIO *mio_new_memory (unsigned char *data,
 	return mio;
 }
 
+/**
+ * mio_new_mmap:
+ * @filename: Filename to map
+ *
+ * Creates a new #MIO object working on the contents of @filename mapped
+ * into memory. The object behaves like a non-growable memory stream, so
+ * mio_memory_get_data() returns the mapped contents without copying
+ * them. The pages are mapped privately: writing to the stream doesn't
+ * change the file.
+ *
+ * If the file is truncated while the object lives, the pages beyond the
+ * new end of the file read as zeros, and mio_mmap_is_truncated() returns
+ * %TRUE. A SIGBUS handler is installed for that on the first call.
+ *
+ * Free-function: mio_unref()
+ *
+ * Returns: A new #MIO on success, or %NULL on failure or if mapping files
+ *          is not supported on the platform. Empty files cannot be mapped.
+ */
+MIO *mio_new_mmap (const char *filename)
+{
+#ifdef MIO_MMAP_SUPPORTED
+	MIO *mio;
+	struct stat st;
+	void *addr;
+	int fd;
+
+	if (!mio_mmap_install_sigbus_handler ())
+		return NULL;
+
+	fd = open (filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || st.st_size <= 0
+		|| (unsigned long long) st.st_size > (size_t)-1)
+	{
+		close (fd);
+		return NULL;
+	}
+
+	addr = mmap (NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+#ifdef MADV_SEQUENTIAL
+	madvise (addr, (size_t) st.st_size, MADV_SEQUENTIAL);
+#endif
+
+	mio = mio_new_memory (addr, (size_t) st.st_size, NULL, NULL);
+	mio->type = MIO_TYPE_MMAP;
+	mio->impl.mem.truncated = 0;
+	mio->impl.mem.next_mapped = mapped_mios;
+	mapped_mios = mio;
+	return mio;
+#else
+	return NULL;
+#endif
+}
+
 /**
  * mio_new_mio:
  * @base: The original mio
@@ -407,7 +551,7 @@ unsigned char *mio_memory_get_data (MIO *mio, size_t *size)
 {
 	unsigned char *ptr = NULL;
 
-	if (mio->type == MIO_TYPE_MEMORY)
+	if (mio_is_memory (mio))
 	{
 		ptr = mio->impl.mem.buf;
 		if (size)
@@ -417,6 +561,74 @@ unsigned char *mio_memory_get_data (MIO *mio, size_t *size)
 	return ptr;
 }
 
+/**
+ * mio_mmap_is_truncated:
+ * @mio: A #MIO object
+ *
+ * Checks whether the file of a #MIO object made with mio_new_mmap() was
+ * truncated while reading it. The data beyond the new end of the file
+ * reads as zeros then.
+ *
+ * Returns: %true if the file was found truncated, %false otherwise or if
+ *          the stream doesn't work on a mapped file.
+ */
+bool mio_mmap_is_truncated (MIO *mio)
+{
+#ifdef MIO_MMAP_SUPPORTED
+	return (mio->type == MIO_TYPE_MMAP && mio->impl.mem.truncated);
+#else
+	return false;
+#endif
+}
+
+/**
+ * mio_memory_terminate:
+ * @mio: A #MIO object
+ *
+ * Makes the data of a #MIO memory stream followed by a NUL byte, so that
+ * the data returned by mio_memory_get_data() can be used as a C string.
+ * The NUL byte is not a part of the stream. A growable buffer may be
+ * reallocated for storing it. The tail of the last page of a mapped file
+ * is filled with zeros, so nothing is done for it.
+ *
+ * Returns: %true on success, %false if the stream is not a memory stream,
+ *          or the NUL byte cannot be stored.
+ */
+int mio_memory_terminate (MIO *mio)
+{
+	if (mio->type == MIO_TYPE_MEMORY)
+	{
+		if (mio->impl.mem.allocated_size <= mio->impl.mem.size)
+		{
+			unsigned char *newbuf;
+
+			if (! mio->impl.mem.realloc_func)
+				return false;
+
+			newbuf = mio->impl.mem.realloc_func (mio->impl.mem.buf,
+												 mio->impl.mem.size + 1);
+			if (! newbuf)
+				return false;
+			mio->impl.mem.buf = newbuf;
+			mio->impl.mem.allocated_size = mio->impl.mem.size + 1;
+		}
+		mio->impl.mem.buf[mio->impl.mem.size] = '\0';
+		return true;
+	}
+#ifdef MIO_MMAP_SUPPORTED
+	else if (mio->type == MIO_TYPE_MMAP)
+	{
+		long pagesize = sysconf (_SC_PAGESIZE);
+
+		/* If the file fills the last page, the byte after the data is
+		 * not mapped. */
+		return (pagesize > 0 && (mio->impl.mem.size % (size_t) pagesize) != 0);
+	}
+#endif
+
+	return false;
+}
+
 /**
  * mio_unref:
  * @mio: A #MIO object
@@ -445,8 +657,18 @@ int mio_unref (MIO *mio)
 			mio->impl.file.close_func = NULL;
 			mio->impl.file.fp = NULL;
 		}
-		else if (mio->type == MIO_TYPE_MEMORY)
+		else if (mio_is_memory (mio))
 		{
+#ifdef MIO_MMAP_SUPPORTED
+			if (mio->type == MIO_TYPE_MMAP)
+			{
+				MIO **p = &mapped_mios;
+				while (*p != mio)
+					p = &(*p)->impl.mem.next_mapped;
+				*p = mio->impl.mem.next_mapped;
+				munmap (mio->impl.mem.buf, mio->impl.mem.allocated_size);
+			}
+#endif
 			if (mio->impl.mem.free_func)
 				mio->impl.mem.free_func (mio->impl.mem.buf);
 			mio->impl.mem.buf = NULL;
@@ -489,7 +711,7 @@ size_t mio_read (MIO *mio,
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fread (ptr_, size, nmemb, mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		size_t n_read = 0;
 
@@ -617,7 +839,7 @@ static int file_try_resize (MIO *mio, size_t new_size)
 
 int mio_try_resize (MIO *mio, size_t new_size)
 {
-	if (mio->type == MIO_TYPE_MEMORY)
+	if (mio_is_memory (mio))
 		return mem_try_resize (mio, new_size);
 	else
 		return file_try_resize (mio, new_size);
@@ -662,7 +884,7 @@ size_t mio_write (MIO *mio,
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fwrite (ptr, size, nmemb, mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		size_t n_written = 0;
 
@@ -699,7 +921,7 @@ int mio_putc (MIO *mio, int c)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fputc (c, mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		int rv = EOF;
 
@@ -732,7 +954,7 @@ int mio_puts (MIO *mio, const char *s)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fputs (s, mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		int rv = EOF;
 		size_t len;
@@ -770,7 +992,7 @@ int mio_vprintf (MIO *mio, const char *format, va_list ap)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return vfprintf (mio->impl.file.fp, format, ap);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		int rv = -1;
 		size_t n;
@@ -854,7 +1076,7 @@ int mio_getc (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fgetc (mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		int rv = EOF;
 
@@ -901,7 +1123,7 @@ int mio_ungetc (MIO *mio, int ch)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return ungetc (ch, mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		int rv = EOF;
 
@@ -937,7 +1159,7 @@ char *mio_gets (MIO *mio, char *s, size_t size)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fgets (s, (int)size, mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		char *rv = NULL;
 
@@ -989,6 +1211,54 @@ char *mio_gets (MIO *mio, char *s, size_t size)
 	}
 }
 
+/**
+ * mio_memory_get_line:
+ * @mio: A #MIO object
+ * @length: (out): Return location for the length of the line
+ *
+ * Reads a line from a #MIO memory stream without copying it. The line
+ * ends after the first new-line character or at the end of the stream,
+ * like one read with mio_gets(). The returned line is not terminated
+ * with a NUL byte.
+ *
+ * <warning><para>The returned pointer becomes invalid in the same way as
+ * the one returned from mio_memory_get_data().</para></warning>
+ *
+ * Returns: The start of the line in the memory buffer, or %NULL at the
+ *          end of the stream, if the stream is not a memory stream, or if
+ *          a character put back with mio_ungetc() is pending. Use
+ *          mio_gets() in the last two cases.
+ */
+const unsigned char *mio_memory_get_line (MIO *mio, size_t *length)
+{
+	const unsigned char *line;
+	const unsigned char *nl;
+	size_t rest;
+
+	if (! mio_is_memory (mio) || mio->impl.mem.ungetch != EOF)
+		return NULL;
+
+	if (mio->impl.mem.pos >= mio->impl.mem.size)
+	{
+		mio->impl.mem.eof = true;
+		return NULL;
+	}
+
+	line = mio->impl.mem.buf + mio->impl.mem.pos;
+	rest = mio->impl.mem.size - mio->impl.mem.pos;
+	nl = memchr (line, '\n', rest);
+	if (nl)
+		*length = (size_t) (nl - line) + 1;
+	else
+	{
+		*length = rest;
+		mio->impl.mem.eof = true;
+	}
+	mio->impl.mem.pos += *length;
+
+	return line;
+}
+
 /**
  * mio_clearerr:
  * @mio: A #MIO object
@@ -1000,7 +1270,7 @@ void mio_clearerr (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		clearerr (mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		mio->impl.mem.error = false;
 		mio->impl.mem.eof = false;
@@ -1022,7 +1292,7 @@ int mio_eof (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return feof (mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 		return mio->impl.mem.eof != false;
 	else
 	{
@@ -1044,7 +1314,7 @@ int mio_error (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return ferror (mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 		return mio->impl.mem.error != false;
 	else
 	{
@@ -1071,7 +1341,7 @@ int mio_seek (MIO *mio, long offset, int whence)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return fseek (mio->impl.file.fp, offset, whence);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		/* FIXME: should we support seeking out of bounds like lseek() seems to do? */
 		int rv = -1;
@@ -1144,7 +1414,7 @@ long mio_tell (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		return ftell (mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		long rv = -1;
 
@@ -1178,7 +1448,7 @@ void mio_rewind (MIO *mio)
 {
 	if (mio->type == MIO_TYPE_FILE)
 		rewind (mio->impl.file.fp);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		mio->impl.mem.pos = 0;
 		mio->impl.mem.ungetch = EOF;
@@ -1210,7 +1480,7 @@ int mio_getpos (MIO *mio, MIOPos *pos)
 	pos->type = mio->type;
 	if (mio->type == MIO_TYPE_FILE)
 		rv = fgetpos (mio->impl.file.fp, &pos->impl.file);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		rv = -1;
 
@@ -1274,7 +1544,7 @@ int mio_setpos (MIO *mio, MIOPos *pos)
 
 	if (mio->type == MIO_TYPE_FILE)
 		rv = fsetpos (mio->impl.file.fp, &pos->impl.file);
-	else if (mio->type == MIO_TYPE_MEMORY)
+	else if (mio_is_memory (mio))
 	{
 		rv = -1;
 
@@ -40,12 +40,14 @@
  * MIOType:
  * @MIO_TYPE_FILE: #MIO object works on a file
  * @MIO_TYPE_MEMORY: #MIO object works in-memory
+ * @MIO_TYPE_MMAP: #MIO object works on a file mapped into memory
  *
  * Existing implementations.
  */
 enum _MIOType {
 	MIO_TYPE_FILE,
-	MIO_TYPE_MEMORY
+	MIO_TYPE_MEMORY,
+	MIO_TYPE_MMAP
 };
 
 typedef enum _MIOType   MIOType;
@@ -127,6 +129,7 @@ MIO *mio_new_memory (unsigned char *data,
 					 size_t size,
 					 MIOReallocFunc realloc_func,
 					 MIODestroyNotify free_func);
+MIO *mio_new_mmap (const char *filename);
 
 MIO *mio_new_mio    (MIO *base, long start, long size);
 MIO *mio_ref        (MIO *mio);
@@ -134,6 +137,8 @@ MIO *mio_ref        (MIO *mio);
 int mio_unref (MIO *mio);
 FILE *mio_file_get_fp (MIO *mio);
 unsigned char *mio_memory_get_data (MIO *mio, size_t *size);
+bool mio_mmap_is_truncated (MIO *mio);
+int mio_memory_terminate (MIO *mio);
 size_t mio_read (MIO *mio,
 				 void *ptr,
 				 size_t size,
@@ -144,6 +149,7 @@ size_t mio_write (MIO *mio,
 				  size_t nmemb);
 int mio_getc (MIO *mio);
 char *mio_gets (MIO *mio, char *s, size_t size);
+const unsigned char *mio_memory_get_line (MIO *mio, size_t *length);
 int mio_ungetc (MIO *mio, int ch);
 int mio_putc (MIO *mio, int c);
 int mio_puts (MIO *mio, const char *s);
@@ -22,11 +22,14 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>  /* to declare isspace () */
+#include <errno.h>
 
+#include "cache_p.h"
 #include "ctags.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "field_p.h"
+#include "fnmatcher_p.h"
 #include "gvars.h"
 #include "keyword_p.h"
 #include "parse_p.h"
@@ -125,6 +128,8 @@ typedef stringList searchPathList;
 static searchPathList *OptlibPathList;
 
 static stringList *Excluded, *ExcludedException;
+/* Compiled from Excluded and ExcludedException when they are used first. */
+static fileNameMatcher *ExcludedMatcher, *ExcludedExceptionMatcher;
 static bool FilesRequired = true;
 static bool SkipConfiguration;
 
@@ -137,6 +142,7 @@ bool ctags_verbose = false;
 
 optionValues Option = {
 	.append = false,
+	.update = false,
 	.backward = false,
 	.etags = false,
 	.locate =
@@ -173,6 +179,12 @@ optionValues Option = {
 	.patternLengthLimit = 96,
 	.putFieldPrefix = false,
 	.maxRecursionDepth = 0xffffffff,
+	.jobs = 1,
+	.sortMemory = 128 * 1024 * 1024,
+	.cacheDir = NULL,
+	.cacheSize = 1024 * 1024 * 1024,
+	.cacheStats = false,
+	.tagIndex = false,
 	.interactive = false,
 	.fieldsReset = false,
 #ifdef _WIN32
@@ -222,6 +234,12 @@ static optionDescription LongOptionDescription [] = {
  {1,0,"  --filter-terminator=<string>"},
  {1,0,"       Specify <string> to print to stdout following the tags for each file"},
  {1,0,"       parsed when --filter is enabled."},
+ {1,0,"  --jobs=<N>"},
+#ifdef HAVE_FORK
+ {1,0,"       Parse input files with <N> worker processes [1]."},
+#else
+ {1,0,"       Not supported on this platform."},
+#endif
  {1,0,"  --links[=(yes|no)]"},
  {1,0,"       Indicate whether symbolic links should be followed [yes]."},
  {1,0,"  --maxdepth=<N>"},
@@ -244,6 +262,15 @@ static optionDescription LongOptionDescription [] = {
  {1,0,"  --append[=(yes|no)]"},
  {1,0,"       Should tags should be appended to existing tag file [no]?"},
  {1,0,"  -a   Append the tags to an existing tag file."},
+ {1,0,"  --update[=(yes|no)]"},
+ {1,0,"       Should only new and modified input files be parsed to update existing tag file [no]?"},
+ {1,0,"  --cache-dir=<dir>"},
+ {1,0,"       Store the tags of input files in <dir>, and reuse them for input files"},
+ {1,0,"       having the same contents."},
+ {1,0,"  --cache-size=<size>[k|m|g]"},
+ {1,0,"       Remove least recently used entries when the cache is larger than <size> [1g]."},
+ {1,0,"  --cache-stats[=(yes|no)]"},
+ {1,0,"       Print statistics about the tag cache [no]."},
  {1,0,"  -f <tagfile>"},
  {1,0,"       Write tags to specified <tagfile>. Value of \"-\" writes tags to stdout"},
  {1,0,"       [\"tags\"; or \"TAGS\" when -e supplied]."},
@@ -267,6 +294,15 @@ static optionDescription LongOptionDescription [] = {
  {0,0,"  --sort=(yes|no|foldcase)"},
  {0,0,"       Should tags be sorted (optionally ignoring case) [yes]?"},
  {0,0,"  -u   Equivalent to --sort=no."},
+ {1,0,"  --sort-memory=<size>[k|m|g]"},
+#ifdef EXTERNAL_SORT
+ {1,0,"       Ignored; the sort command is used for sorting."},
+#else
+ {1,0,"       Sort tags in runs of up to <size> bytes of memory; larger tag files"},
+ {1,0,"       are sorted with temporary files [128m]."},
+#endif
+ {1,0,"  --tag-index[=(yes|no)]"},
+ {1,0,"       Write the index of the tag file to <tagfile>.idx for fast lookups [no]."},
  {1,0,"  --etags-include=<file>"},
  {1,0,"       Include reference to <file> in Emacs-style tag file (requires -e)."},
 #ifdef HAVE_ICONV
@@ -772,6 +808,47 @@ extern void checkOptions (void)
 		if (isDestinationStdout ())
 			error (FATAL, "%s tags to stdout", notice);
 	}
+	if (writerWritesBinaryFormat ())
+	{
+		notice = "binary output format is not compatible with";
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.append)
+			error (FATAL, "%s append mode", notice);
+		if (Option.update)
+			error (FATAL, "%s update mode", notice);
+		if (Option.tagIndex)
+			error (FATAL, "%s --tag-index", notice);
+	}
+	if (Option.update)
+	{
+		notice = "update mode is not compatible with";
+#ifdef EXTERNAL_SORT
+		error (FATAL, "update mode is not supported with external sort command");
+#endif
+		if (Option.append)
+			error (FATAL, "%s append mode", notice);
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.etags || Option.xref || !writerWritesCtagsFormat ())
+			error (FATAL, "%s output format other than ctags", notice);
+		if (Option.sorted == SO_UNSORTED)
+			error (FATAL, "%s unsorted output", notice);
+	}
+	if (Option.tagIndex)
+	{
+		notice = "--tag-index is not compatible with";
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.etags || Option.xref || !writerWritesCtagsFormat ())
+			error (FATAL, "%s output format other than ctags", notice);
+	}
 	if (Option.filter)
 	{
 		notice = "filter mode";
@@ -782,6 +859,11 @@ extern void checkOptions (void)
 		}
 		if (Option.tagFileName != NULL)
 			error (WARNING, "%s ignores output tag file name", notice);
+		if (Option.jobs > 1)
+		{
+			error (WARNING, "%s disables parallel jobs", notice);
+			Option.jobs = 1;
+		}
 	}
 	writerCheckOptions (Option.fieldsReset);
 }
@@ -1172,10 +1254,22 @@ static void processEtagsInclude (
 	}
 }
 
+static void freeMatcher (fileNameMatcher **matcher)
+{
+	if (*matcher != NULL)
+	{
+		fileNameMatcherDelete (*matcher);
+		*matcher = NULL;
+	}
+}
+
 static void processExcludeOptionCommon (
-	stringList** list, const char *const optname, const char *const parameter)
+	stringList** list, fileNameMatcher **matcher,
+	const char *const optname, const char *const parameter)
 {
 	const char *const fileName = parameter + 1;
+
+	freeMatcher (matcher);
 	if (parameter [0] == '\0')
 		freeList (list);
 	else if (parameter [0] == '@')
@@ -1205,13 +1299,14 @@ static void processExcludeOptionCommon (
 static void processExcludeOption (
 		const char *const option, const char *const parameter)
 {
-	processExcludeOptionCommon (&Excluded, option, parameter);
+	processExcludeOptionCommon (&Excluded, &ExcludedMatcher, option, parameter);
 }
 
 static void processExcludeExceptionOption (
 		const char *const option, const char *const parameter)
 {
-	processExcludeOptionCommon (&ExcludedException, option, parameter);
+	processExcludeOptionCommon (&ExcludedException, &ExcludedExceptionMatcher,
+								option, parameter);
 }
 
 extern bool isExcludedFile (const char* const name,
@@ -1227,18 +1322,22 @@ extern bool isExcludedFile (const char* const name,
 
 	if (Excluded != NULL)
 	{
-		result = stringListFileMatched (Excluded, base);
+		if (ExcludedMatcher == NULL)
+			ExcludedMatcher = fileNameMatcherNew (Excluded);
+		result = fileNameMatcherMatch (ExcludedMatcher, base);
 		if (! result  &&  name != base)
-			result = stringListFileMatched (Excluded, name);
+			result = fileNameMatcherMatch (ExcludedMatcher, name);
 	}
 
 	if (result && ExcludedException != NULL)
 	{
 		bool result_exception;
 
-		result_exception = stringListFileMatched (ExcludedException, base);
+		if (ExcludedExceptionMatcher == NULL)
+			ExcludedExceptionMatcher = fileNameMatcherNew (ExcludedException);
+		result_exception = fileNameMatcherMatch (ExcludedExceptionMatcher, base);
 		if (! result_exception && name != base)
-			result_exception = stringListFileMatched (ExcludedException, name);
+			result_exception = fileNameMatcherMatch (ExcludedExceptionMatcher, name);
 
 		if (result_exception)
 			result = false;
@@ -2443,6 +2542,7 @@ static void processOutputFormat (const char *const option CTAGS_ATTR_UNUSED,
 
 	case WRITER_U_CTAGS:
 	case WRITER_E_CTAGS:
+	case WRITER_BINARY:
 		setTagWriter (t, NULL);
 		break;
 	case WRITER_ETAGS:
@@ -2836,6 +2936,83 @@ static void processMaxRecursionDepthOption (const char *const option, const char
 	Option.maxRecursionDepth = atol(parameter);
 }
 
+static void processJobsOption (const char *const option, const char *const parameter)
+{
+	unsigned int jobs;
+
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToUInt (parameter, 10, &jobs) || jobs < 1)
+		error (FATAL, "-%s: Invalid number of jobs: %s", option, parameter);
+
+#ifndef HAVE_FORK
+	if (jobs > 1)
+	{
+		error (WARNING, "-%s: not supported on this platform", option);
+		jobs = 1;
+	}
+#endif
+	Option.jobs = jobs;
+}
+
+static size_t parseSizeParameter (const char *const option, const char *const parameter)
+{
+	unsigned long size;
+	unsigned long unit = 1;
+	char *end = NULL;
+
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	errno = 0;
+	size = strtoul (parameter, &end, 10);
+	if (end == parameter || errno != 0)
+		error (FATAL, "-%s: Invalid size: %s", option, parameter);
+
+	switch (*end)
+	{
+	case 'g': case 'G':
+		unit *= 1024;
+		/* Fall through */
+	case 'm': case 'M':
+		unit *= 1024;
+		/* Fall through */
+	case 'k': case 'K':
+		unit *= 1024;
+		end++;
+		break;
+	}
+
+	if (*end != '\0')
+		error (FATAL, "-%s: Invalid size: %s", option, parameter);
+	if (size > ((size_t)-1) / unit)
+		error (FATAL, "-%s: Too large size: %s", option, parameter);
+	if (size * unit < 1024)
+		error (FATAL, "-%s: Too small size (must be 1k or larger): %s", option, parameter);
+
+	return size * unit;
+}
+
+static void processSortMemoryOption (const char *const option, const char *const parameter)
+{
+	Option.sortMemory = parseSizeParameter (option, parameter);
+}
+
+static void processCacheDirOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	freeString (&Option.cacheDir);
+	Option.cacheDir = stringCopy (parameter);
+}
+
+static void processCacheSizeOption (const char *const option, const char *const parameter)
+{
+	Option.cacheSize = parseSizeParameter (option, parameter);
+}
+
 static void processPatternLengthLimit(const char *const option, const char *const parameter)
 {
 	if (parameter == NULL || parameter[0] == '\0')
@@ -2883,6 +3060,8 @@ static void processDumpOptionsOption (const char *const option, const char *cons
 static void processDumpPreludeOption (const char *const option, const char *const parameter);
 
 static parametricOption ParametricOptions [] = {
+	{ "cache-dir",              processCacheDirOption,          true,   STAGE_ANY },
+	{ "cache-size",             processCacheSizeOption,         true,   STAGE_ANY },
 	{ "etags-include",          processEtagsInclude,            false,  STAGE_ANY },
 	{ "exclude",                processExcludeOption,           false,  STAGE_ANY },
 	{ "exclude-exception",      processExcludeExceptionOption,  false,  STAGE_ANY },
@@ -2899,6 +3078,7 @@ static parametricOption ParametricOptions [] = {
 	{ "input-encoding",         processInputEncodingOption,     false,  STAGE_ANY },
 	{ "output-encoding",        processOutputEncodingOption,    false,  STAGE_ANY },
 #endif
+	{ "jobs",                   processJobsOption,              true,   STAGE_ANY },
 	{ "lang",                   processLanguageForceOption,     false,  STAGE_ANY },
 	{ "language",               processLanguageForceOption,     false,  STAGE_ANY },
 	{ "language-force",         processLanguageForceOption,     false,  STAGE_ANY },
@@ -2932,6 +3112,7 @@ static parametricOption ParametricOptions [] = {
 	{ "pattern-length-limit",   processPatternLengthLimit,      true,   STAGE_ANY },
 	{ "pseudo-tags",            processPseudoTags,              false,  STAGE_ANY },
 	{ "sort",                   processSortOption,              true,   STAGE_ANY },
+	{ "sort-memory",            processSortMemoryOption,        true,   STAGE_ANY },
 	{ "tag-relative",           processTagRelative,             true,   STAGE_ANY },
 	{ "totals",                 processTotals,                  true,   STAGE_ANY },
 	{ "version",                processVersionOption,           true,   STAGE_ANY },
@@ -2958,6 +3139,7 @@ static parametricOption ParametricOptions [] = {
 
 static booleanOption BooleanOptions [] = {
 	{ "append",         &Option.append,                 true,  STAGE_ANY },
+	{ "cache-stats",    &Option.cacheStats,             true,  STAGE_ANY },
 	{ "file-scope",     ((bool *)XTAG_FILE_SCOPE),      false, STAGE_ANY, setBooleanToXtagWithWarning },
 	{ "file-tags",      ((bool *)XTAG_FILE_NAMES),      false, STAGE_ANY, setBooleanToXtagWithWarning },
 	{ "filter",         &Option.filter,                 true,  STAGE_ANY },
@@ -2971,6 +3153,8 @@ static booleanOption BooleanOptions [] = {
 #ifdef RECURSE_SUPPORTED
 	{ "recurse",        &Option.recurse,                false, STAGE_ANY },
 #endif
+	{ "tag-index",      &Option.tagIndex,               true,  STAGE_ANY },
+	{ "update",         &Option.update,                 true,  STAGE_ANY },
 	{ "verbose",        &ctags_verbose,                 false, STAGE_ANY },
 #ifdef _WIN32
 	{ "use-slash-as-filename-separator", (bool *)&Option.useSlashAsFilenameSeparator, false, STAGE_ANY },
@@ -3536,6 +3720,7 @@ static void parseOption (cookedArgs* const args)
 	Assert (! cArgOff (args));
 	if (args->isOption)
 	{
+		hashOptionForTagCache (args->item, args->parameter);
 		if (args->longOption)
 			processLongOption (args->item, args->parameter);
 		else
@@ -3986,9 +4171,12 @@ extern void freeOptionResources (void)
 	freeString (&Option.tagFileName);
 	freeString (&Option.fileList);
 	freeString (&Option.filterTerminator);
+	freeString (&Option.cacheDir);
 
 	freeList (&Excluded);
 	freeList (&ExcludedException);
+	freeMatcher (&ExcludedMatcher);
+	freeMatcher (&ExcludedExceptionMatcher);
 	freeList (&Option.headerExt);
 	freeList (&Option.etagsInclude);
 
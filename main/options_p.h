@@ -74,6 +74,7 @@ typedef enum eTagRelative {
  */
 typedef struct sOptionValues {
 	bool append;         /* -a  append to "tags" file */
+	bool update;         /* --update  reparse modified input files only */
 	bool backward;       /* -B  regexp patterns search backwards */
 	bool etags;          /* -e  output Emacs style tags file */
 	exCmd locate;           /* --excmd  EX command used to locate tag */
@@ -104,6 +105,12 @@ typedef struct sOptionValues {
 	unsigned int patternLengthLimit; /* --pattern-length-limit=N */
 	bool putFieldPrefix;		 /* --put-field-prefix */
 	unsigned int maxRecursionDepth; /* --maxdepth=<max-recursion-depth> */
+	unsigned int jobs;		/* --jobs=<N> */
+	size_t sortMemory;		/* --sort-memory=<size> */
+	char *cacheDir;			/* --cache-dir=<dir> */
+	size_t cacheSize;		/* --cache-size=<size> */
+	bool cacheStats;		/* --cache-stats */
+	bool tagIndex;			/* --tag-index */
 	bool fieldsReset;				/* --fields=[^+-] */
 	enum interactiveMode { INTERACTIVE_NONE = 0,
 						   INTERACTIVE_DEFAULT,
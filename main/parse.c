@@ -19,6 +19,7 @@
 
 #include <string.h>
 
+#include "cache_p.h"
 #include "ctags.h"
 #include "debug.h"
 #include "entry_p.h"
@@ -26,6 +27,7 @@
 #include "flags_p.h"
 #include "htable.h"
 #include "keyword.h"
+#include "keyword_p.h"
 #include "lxpath_p.h"
 #include "param.h"
 #include "param_p.h"
@@ -159,7 +161,29 @@ static parserDefinitionFunc* BuiltInParsers[] = {
 };
 static parserObject* LanguageTable = NULL;
 static unsigned int LanguageCount = 0;
+static bool InputFileTruncated;	/* set when the last input file is truncated while parsing it */
 static hashTable* LanguageHTable = NULL;
+
+/* The language maps (currentPatterns and currentExtensions) of all the
+ * parsers compiled to hash tables. Choosing a language for a file name
+ * doesn't have to try all the maps of all the parsers with this.
+ * This is built on the first use after changing a map. */
+typedef struct sLanguageMapEntry {
+	langType lang;
+	unsigned int order;			/* the index in currentPatterns */
+	const char *suffix;			/* SUFFIX of "*SUFFIX" pattern */
+	vString *spec;
+} languageMapEntry;
+
+typedef struct sLanguageMap {
+	/* Each value is a ptrArray of languageMapEntry sorted by
+	 * the language and the order. */
+	hashTable *literals;		/* pattern without wildcards -> entries */
+	hashTable *suffixes;		/* extension in "*SUFFIX" pattern -> entries */
+	hashTable *extensions;		/* extension -> entries */
+	intArray *globbingLanguages; /* languages having the other patterns */
+} languageMap;
+static languageMap *LanguageMap = NULL;
 static kindDefinition defaultFileKind = {
 	.enabled     = false,
 	.letter      = KIND_FILE_DEFAULT_LETTER,
@@ -470,55 +494,244 @@ extern langType getLanguageForCommand (const char *const command, langType start
 											&tmp_specType);
 }
 
-static langType getPatternLanguageAndSpec (const char *const baseName, langType start_index,
-					   const char **const spec, enum specType *specType)
+static void deleteLanguageMapEntries (void *entries)
 {
-	langType result = LANG_IGNORE;
+	ptrArrayDelete (entries);
+}
+
+static hashTable *newLanguageMapTable (void)
+{
+#ifdef CASE_INSENSITIVE_FILENAMES
+	return hashTableNew (127, hashCstrcasehash, hashCstrcaseeq,
+						 NULL, deleteLanguageMapEntries);
+#else
+	return hashTableNew (127, hashCstrhash, hashCstreq,
+						 NULL, deleteLanguageMapEntries);
+#endif
+}
+
+static void addLanguageMapEntry (hashTable *table, const char *key,
+								 langType lang, unsigned int order,
+								 const char *suffix, vString *spec)
+{
+	ptrArray *entries = hashTableGetItem (table, key);
+
+	if (entries == NULL)
+	{
+		entries = ptrArrayNew (eFree);
+		hashTablePutItem (table, (void *)key, entries);
+	}
+	else if (suffix == NULL
+			 && ((languageMapEntry *)ptrArrayLast (entries))->lang == lang)
+		return;		/* Only the first one in the map is used. */
+
+	languageMapEntry *e = xMalloc (1, languageMapEntry);
+	e->lang = lang;
+	e->order = order;
+	e->suffix = suffix;
+	e->spec = spec;
+	ptrArrayAdd (entries, e);
+}
+
+static bool isGlobbingPattern (const char *pattern)
+{
+	return strpbrk (pattern, "*?[\\") != NULL;
+}
+
+static void compileLanguagePatternMap (languageMap *map, langType lang)
+{
+	stringList *ptrns = LanguageTable [lang].currentPatterns;
+	unsigned int count = ptrns? stringListCount (ptrns): 0;
 	unsigned int i;
 
-	if (start_index == LANG_AUTO)
-	        start_index = 0;
-	else if (start_index == LANG_IGNORE || start_index >= (int) LanguageCount)
-		return result;
+	/* A language having a pattern fnmatch() must run is matched with
+	 * the original map. */
+	for (i = 0; i < count; i++)
+	{
+		const char *p = vStringValue (stringListItem (ptrns, i));
+		const char *suffix = (p[0] == '*')? p + 1: NULL;
 
-	*spec = NULL;
-	for (i = start_index  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
+		if (isGlobbingPattern (p)
+			&& (suffix == NULL || isGlobbingPattern (suffix)
+				|| strchr (suffix, '.') == NULL))
+		{
+			intArrayAdd (map->globbingLanguages, lang);
+			return;
+		}
+	}
+
+	for (i = 0; i < count; i++)
 	{
-		if (! isLanguageEnabled (i))
-			continue;
+		vString *spec = stringListItem (ptrns, i);
+		const char *p = vStringValue (spec);
 
-		parserObject *parser = LanguageTable + i;
-		stringList* const ptrns = parser->currentPatterns;
-		vString* tmp;
+		if (p[0] == '*')
+			addLanguageMapEntry (map->suffixes, strrchr (p, '.') + 1,
+								 lang, i, p + 1, spec);
+		else
+			addLanguageMapEntry (map->literals, p, lang, i, NULL, spec);
+	}
+}
+
+static void compileLanguageExtensionMap (languageMap *map, langType lang)
+{
+	stringList *exts = LanguageTable [lang].currentExtensions;
+	unsigned int count = exts? stringListCount (exts): 0;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		vString *spec = stringListItem (exts, i);
+		addLanguageMapEntry (map->extensions, vStringValue (spec),
+							 lang, i, NULL, spec);
+	}
+}
+
+static languageMap *getLanguageMap (void)
+{
+	if (LanguageMap)
+		return LanguageMap;
+
+	languageMap *map = xMalloc (1, languageMap);
+	map->literals = newLanguageMapTable ();
+	map->suffixes = newLanguageMapTable ();
+	map->extensions = newLanguageMapTable ();
+	map->globbingLanguages = intArrayNew ();
+
+	for (unsigned int i = 0; i < LanguageCount; i++)
+	{
+		compileLanguagePatternMap (map, i);
+		compileLanguageExtensionMap (map, i);
+	}
+
+	LanguageMap = map;
+	return map;
+}
+
+/* Call this before changing the language map of a parser. */
+static void invalidateLanguageMap (void)
+{
+	if (LanguageMap == NULL)
+		return;
+
+	hashTableDelete (LanguageMap->literals);
+	hashTableDelete (LanguageMap->suffixes);
+	hashTableDelete (LanguageMap->extensions);
+	intArrayDelete (LanguageMap->globbingLanguages);
+	eFree (LanguageMap);
+	LanguageMap = NULL;
+}
+
+static bool hasFileNameSuffix (const char *const baseName, const char *const suffix)
+{
+	size_t blen = strlen (baseName);
+	size_t slen = strlen (suffix);
 
-		if (ptrns != NULL && (tmp = stringListFileFinds (ptrns, baseName)))
+	if (blen < slen)
+		return false;
+#ifdef CASE_INSENSITIVE_FILENAMES
+	return strcasecmp (baseName + blen - slen, suffix) == 0;
+#else
+	return strcmp (baseName + blen - slen, suffix) == 0;
+#endif
+}
+
+/* Return the first enabled language at START or after it, having a
+ * pattern matching BASENAME. SPEC is set to the first matching pattern
+ * in the map of the language. */
+static langType findPatternInLanguageMap (languageMap *map, const char *const baseName,
+										  langType start, const char **const spec)
+{
+	ptrArray *lists [2] = {
+		hashTableGetItem (map->literals, baseName),
+		hashTableGetItem (map->suffixes, fileExtension (baseName)),
+	};
+	languageMapEntry *best = NULL;
+
+	for (unsigned int k = 0; k < ARRAY_SIZE (lists); k++)
+	{
+		for (unsigned int i = 0; lists [k] && i < ptrArrayCount (lists [k]); i++)
 		{
-			result = i;
-			*spec = vStringValue(tmp);
-			*specType = SPEC_PATTERN;
-			goto found;
+			languageMapEntry *e = ptrArrayItem (lists [k], i);
+
+			if (e->lang < start)
+				continue;
+			if (best && e->lang > best->lang)
+				break;
+			if (! isLanguageEnabled (e->lang))
+				continue;
+			if (e->suffix && ! hasFileNameSuffix (baseName, e->suffix))
+				continue;
+			if (best == NULL || e->lang < best->lang || e->order < best->order)
+				best = e;
 		}
 	}
 
-	for (i = start_index  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
+	for (unsigned int i = 0; i < intArrayCount (map->globbingLanguages); i++)
 	{
-		if (! isLanguageEnabled (i))
+		langType lang = intArrayItem (map->globbingLanguages, i);
+		vString *tmp;
+
+		if (lang < start || ! isLanguageEnabled (lang))
 			continue;
+		if (best && lang > best->lang)
+			break;
+		if ((tmp = stringListFileFinds (LanguageTable [lang].currentPatterns,
+										baseName)))
+		{
+			*spec = vStringValue (tmp);
+			return lang;
+		}
+	}
 
-		parserObject *parser = LanguageTable + i;
-		stringList* const exts = parser->currentExtensions;
-		vString* tmp;
+	if (best == NULL)
+		return LANG_IGNORE;
+	*spec = vStringValue (best->spec);
+	return best->lang;
+}
+
+static langType findExtensionInLanguageMap (languageMap *map, const char *const extension,
+											langType start, const char **const spec)
+{
+	ptrArray *entries = hashTableGetItem (map->extensions, extension);
+
+	for (unsigned int i = 0; entries && i < ptrArrayCount (entries); i++)
+	{
+		languageMapEntry *e = ptrArrayItem (entries, i);
 
-		if (exts != NULL && (tmp = stringListExtensionFinds (exts,
-								     fileExtension (baseName))))
+		if (e->lang >= start && isLanguageEnabled (e->lang))
 		{
-			result = i;
-			*spec = vStringValue(tmp);
-			*specType = SPEC_EXTENSION;
-			goto found;
+			*spec = vStringValue (e->spec);
+			return e->lang;
 		}
 	}
-found:
+	return LANG_IGNORE;
+}
+
+static langType getPatternLanguageAndSpec (const char *const baseName, langType start_index,
+					   const char **const spec, enum specType *specType)
+{
+	languageMap *map;
+	langType result;
+
+	if (start_index == LANG_AUTO)
+	        start_index = 0;
+	else if (start_index == LANG_IGNORE || start_index >= (int) LanguageCount)
+		return LANG_IGNORE;
+
+	*spec = NULL;
+	map = getLanguageMap ();
+
+	result = findPatternInLanguageMap (map, baseName, start_index, spec);
+	if (result != LANG_IGNORE)
+	{
+		*specType = SPEC_PATTERN;
+		return result;
+	}
+
+	result = findExtensionInLanguageMap (map, fileExtension (baseName),
+										 start_index, spec);
+	if (result != LANG_IGNORE)
+		*specType = SPEC_EXTENSION;
 	return result;
 }
 
@@ -1632,6 +1845,7 @@ extern void installLanguageMapDefault (const langType language)
 	parserObject* parser;
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	parser = LanguageTable + language;
+	invalidateLanguageMap ();
 	if (parser->currentPatterns != NULL)
 		stringListDelete (parser->currentPatterns);
 	if (parser->currentExtensions != NULL)
@@ -1706,6 +1920,7 @@ extern void installLanguageAliasesDefaults (void)
 extern void clearLanguageMap (const langType language)
 {
 	Assert (0 <= language  &&  language < (int) LanguageCount);
+	invalidateLanguageMap ();
 	stringListClear ((LanguageTable + language)->currentPatterns);
 	stringListClear ((LanguageTable + language)->currentExtensions);
 }
@@ -1724,6 +1939,7 @@ static bool removeLanguagePatternMap1(const langType language, const char *const
 	bool result = false;
 	stringList* const ptrn = (LanguageTable + language)->currentPatterns;
 
+	invalidateLanguageMap ();
 	if (ptrn != NULL && stringListDeleteItemExtension (ptrn, pattern))
 	{
 		verbose (" (removed from %s)", getLanguageName (language));
@@ -1756,6 +1972,7 @@ extern void addLanguagePatternMap (const langType language, const char* ptrn,
 	parser = LanguageTable + language;
 	if (exclusiveInAllLanguages)
 		removeLanguagePatternMap (LANG_AUTO, ptrn);
+	invalidateLanguageMap ();
 	stringListAdd (parser->currentPatterns, str);
 }
 
@@ -1764,6 +1981,7 @@ static bool removeLanguageExtensionMap1 (const langType language, const char *co
 	bool result = false;
 	stringList* const exts = (LanguageTable + language)->currentExtensions;
 
+	invalidateLanguageMap ();
 	if (exts != NULL  &&  stringListDeleteItemExtension (exts, extension))
 	{
 		verbose (" (removed from %s)", getLanguageName (language));
@@ -1795,6 +2013,7 @@ extern void addLanguageExtensionMap (
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	if (exclusiveInAllLanguages)
 		removeLanguageExtensionMap (LANG_AUTO, extension);
+	invalidateLanguageMap ();
 	stringListAdd ((LanguageTable + language)->currentExtensions, str);
 }
 
@@ -1888,6 +2107,8 @@ static void initializeParserOne (langType lang)
 	if (parser->def->initialize != NULL)
 		parser->def->initialize (lang);
 
+	compileKeywordTable (lang);
+
 	initializeDependencies (parser->def, parser->slaveControlBlock);
 
 	Assert (parser->fileKind != NULL);
@@ -2087,6 +2308,8 @@ extern void initializeParsing (void)
 extern void freeParserResources (void)
 {
 	unsigned int i;
+
+	invalidateLanguageMap ();
 	for (i = 0  ;  i < LanguageCount  ;  ++i)
 	{
 		parserObject* const parser = LanguageTable + i;
@@ -2452,6 +2675,7 @@ extern void processLanguageDefineOption (
 	initializeParsingCommon (def, false, NULL);
 	linkDependenciesAtInitializeParsing (def);
 
+	invalidateLanguageMap ();
 	LanguageTable [def->id].currentPatterns = stringListNew ();
 	LanguageTable [def->id].currentExtensions = stringListNew ();
 	LanguageTable [def->id].pretendingAsLanguage = LANG_IGNORE;
@@ -4206,6 +4430,7 @@ extern void printParserStatisticsIfUsed (langType language)
 			fputs("==============================================\n", stderr);
 			parser->def->printStats (language);
 		}
+		printLanguageRegexStatistics (language);
 		printLanguageMultitableStatistics (language);
 	}
 }
@@ -4214,9 +4439,10 @@ static bool createTagsWithFallback1 (const langType language,
 									 langType *exclusive_subparser)
 {
 	bool tagFileResized = false;
-	unsigned long numTags;
-	MIOPos tagfpos;
+	unsigned long numTags, numTags0;
+	MIOPos tagfpos, tagfpos0;
 	int lastPromise = getLastPromise ();
+	int lastPromise0 = lastPromise;
 	unsigned int passCount = 0;
 	rescanReason whyRescan;
 	parserObject *parser;
@@ -4238,6 +4464,8 @@ static bool createTagsWithFallback1 (const langType language,
 	initializeParserStats (parser);
 	numTags = numTagsAdded ();
 	tagFilePosition (&tagfpos);
+	numTags0 = numTags;
+	tagfpos0 = tagfpos;
 
 	anonResetMaybe (parser);
 	parser->justRunForSchedulingBase = 0;
@@ -4280,6 +4508,17 @@ static bool createTagsWithFallback1 (const langType language,
 	if (useCork)
 		uncorkTagFile();
 
+	if (isInputFileTruncated ())
+	{
+		/* The tags made after the truncation come from zero-filled
+		 * pages. Drop all the tags made while parsing the input. */
+		setTagFilePosition (&tagfpos0, true);
+		setNumTagsAdded (numTags0);
+		writerRescanFailed (numTags0);
+		tagFileResized = true;
+		breakPromisesAfter (lastPromise0);
+	}
+
 	{
 		subparser *s = teardownLanguageSubparsersInUse (language);
 		if (exclusive_subparser && s)
@@ -4338,6 +4577,17 @@ static bool createTagsWithFallback (
 											  &exclusive_subparser);
 	tagFileResized = forcePromises()? true: tagFileResized;
 
+	/* If the input file is truncated while the promises run, only the
+	 * tags of the guest parsers are dropped. No file tag is made in any
+	 * case. */
+	if (isInputFileTruncated ())
+	{
+		error (WARNING, "input file truncated while parsing it: %s", fileName);
+		InputFileTruncated = true;
+		closeInputFile ();
+		return tagFileResized;
+	}
+
 	pushLanguage ((exclusive_subparser == LANG_IGNORE)
 				  ? language
 				  : exclusive_subparser);
@@ -4440,6 +4690,7 @@ static void addParserPseudoTags (langType language)
 				makePtagIfEnabled (i, language, parser);
 		}
 		parser->pseudoTagPrinted = 1;
+		noteParserPseudoTagsForTagCache (language);
 	}
 }
 
@@ -4496,6 +4747,7 @@ static bool parseMio (const char *const fileName, langType language, MIO* mio, t
 
 	initParserTrashBox ();
 
+	InputFileTruncated = false;
 	tagFileResized = createTagsWithFallback (fileName, language, mio, mtime, &failureInOpenning);
 
 	finiParserTrashBox ();
@@ -4508,6 +4760,88 @@ static bool parseMio (const char *const fileName, langType language, MIO* mio, t
 		return teardownWriter(fileName);
 }
 
+static bool canUseTagCache (void)
+{
+	/* Only the output of ctags format writers can be cached. */
+	return (isTagCacheEnabled ()
+			&& writerWritesCtagsFormat ()
+			&& ! Option.filter
+			&& Option.interactive == INTERACTIVE_NONE);
+}
+
+static void replayTagCacheEntry (tagCacheEntry *entry)
+{
+	size_t length;
+	unsigned long numTags, lines, bytes;
+	const char *tags = getTagCacheEntryTags (entry, &length, &numTags);
+	stringList *ptagParsers = getTagCacheEntryPseudoTagParsers (entry);
+
+	if (isXtagEnabled (XTAG_PSEUDO_TAGS))
+	{
+		for (unsigned int i = 0; i < stringListCount (ptagParsers); i++)
+		{
+			const char *name = vStringValue (stringListItem (ptagParsers, i));
+			langType language = getNamedLanguage (name, 0);
+			if (language == LANG_IGNORE)
+				continue;
+			initializeParser (language);
+			addParserPseudoTags (language);
+		}
+	}
+
+	writeTagLinesToTagFile (tags, length, numTags);
+	getTagCacheEntryTotals (entry, &lines, &bytes);
+	addTotals (0, lines, bytes);
+}
+
+/* Parse the input file with the tag cache. Returns true if the parser
+ * runs, and the tag file is resized. */
+static bool parseMioWithTagCache (const char *const fileName, langType language,
+								  struct GetLanguageRequest *req, void *clientData)
+{
+	bool tagFileResized = false;
+
+	if (req->mio == NULL)
+	{
+		fileStatus *status = eStat (fileName);
+		req->mtime = status->mtime;
+		eStatFree (status);
+		req->mio = mio_new_file (fileName, "rb");
+	}
+
+	tagCacheEntry *entry = req->mio? openTagCacheEntry (fileName, language, req->mio, req->mtime): NULL;
+	if (entry == NULL)
+		return parseMio (fileName, language, req->mio, req->mtime, true, clientData);
+
+	if (lookupTagCacheEntry (entry))
+	{
+		verbose ("found \"%s\" in tag cache\n", fileName);
+		replayTagCacheEntry (entry);
+	}
+	else
+	{
+		tagFileMark mark;
+		unsigned long lines0, lines1, files, bytes;
+
+		markTagFile (&mark);
+		getTotals (&files, &lines0, &bytes);
+		tagFileResized = parseMio (fileName, language, req->mio, req->mtime, true, clientData);
+		getTotals (&files, &lines1, &bytes);
+
+		unsigned long numTags;
+		vString *tags = InputFileTruncated? NULL: getTagLinesSinceMark (&mark, &numTags);
+		if (tags)
+		{
+			storeTagCacheEntry (entry, vStringValue (tags), vStringLength (tags),
+								numTags, lines1 - lines0);
+			vStringDelete (tags);
+		}
+	}
+	closeTagCacheEntry (entry);
+
+	return tagFileResized;
+}
+
 extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 							  void *clientData)
 {
@@ -4543,7 +4877,11 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 		/* TODO: checkUTF8BOM can be used to update the encodings. */
 		openConverter (getLanguageEncoding (language), Option.outputEncoding);
 #endif
-		tagFileResized = parseMio (fileName, language, req.mio, req.mtime, true, clientData);
+		if (canUseTagCache ())
+			tagFileResized = parseMioWithTagCache (fileName, language, &req, clientData);
+		else
+			tagFileResized = parseMio (fileName, language, req.mio, req.mtime, true, clientData);
+		moveTagFileToSorter ();
 		if (Option.filter && ! Option.interactive)
 			closeTagFile (tagFileResized);
 		addTotals (1, 0L, 0L);
@@ -5401,6 +5739,12 @@ extern void printFielddefFlags (bool withListHeader, bool machinable, FILE *fp)
 	colprintTableDelete(table);
 }
 
+extern void printLanguageRegexStatistics (langType language)
+{
+	parserObject* const parser = LanguageTable + language;
+	printRegexStatistics (parser->lregexControlBlock);
+}
+
 extern void printLanguageMultitableStatistics (langType language)
 {
 	parserObject* const parser = LanguageTable + language;
@@ -5568,6 +5912,9 @@ static parserDefinition *CTagsParser (void)
 #if defined(DEBUG) && defined(HAVE_SECCOMP)
 extern void getppid(void);
 #endif
+#if defined(DEBUG) && defined(HAVE_TRUNCATE)
+#include <unistd.h>
+#endif
 
 static bool CTST_GatherStats;
 static int CTST_num_handled_char;
@@ -5581,6 +5928,9 @@ typedef enum {
 	K_GUEST_END,
 #if defined(DEBUG) && defined(HAVE_SECCOMP)
 	K_CALL_GETPPID,
+#endif
+#if defined(DEBUG) && defined(HAVE_TRUNCATE)
+	K_TRUNCATE_INPUT,
 #endif
 	K_QUIT,
 	K_DISABLED,
@@ -5660,6 +6010,9 @@ static kindDefinition CTST_Kinds[KIND_COUNT] = {
 	{true, 'E', NULL, "end of an area for a guest" },
 #if defined(DEBUG) && defined(HAVE_SECCOMP)
 	{true, 'P', "callGetPPid", "trigger calling getppid(2) that seccomp sandbox disallows"},
+#endif
+#if defined(DEBUG) && defined(HAVE_TRUNCATE)
+	{true, 'T', "truncateInput", "truncate the input file while parsing it (debug)"},
 #endif
 	{true, 'Q', "quit", "stop the parsing"},
 	{false,'d', "disabled", "a kind disabled by default",
@@ -5779,6 +6132,12 @@ static void createCTSTTags (void)
 				    case K_CALL_GETPPID:
 						getppid();
 						break;
+#endif
+#if defined(DEBUG) && defined(HAVE_TRUNCATE)
+					case K_TRUNCATE_INPUT:
+						if (truncate (getInputFileName (), 0) != 0)
+							error (WARNING | PERROR, "cannot truncate %s", getInputFileName ());
+						break;
 #endif
 					case K_QUIT:
 						quit = true;
@@ -189,6 +189,7 @@ extern bool makeRoleDescriptionsPseudoTags (const langType language,
 extern bool makeParserVersionPseudoTags (const langType language,
 										 const ptagDesc *pdesc);
 
+extern void printLanguageRegexStatistics (langType language);
 extern void printLanguageMultitableStatistics (langType language);
 extern void printParserStatisticsIfUsed (langType lang);
 
@@ -113,6 +113,9 @@ typedef struct sInputFile {
 	stringList  * sourceTagPathHolder;
 	inputLineFposMap lineFposMap;
 	vString *allLines;
+	vString allLinesView;	/* allLines refers to this if the lines are not
+							   copied from the memory stream */
+	long allLinesOffset;	/* offset of the first byte of allLinesView */
 	int thinDepth;
 	time_t mtime;
 } inputFile;
@@ -424,6 +427,22 @@ static void setOwnerDirectoryOfInputFile (const char *const fileName)
 	}
 }
 
+extern vString *makeTagPathOfFile (const char *const fileName)
+{
+	if (0)
+		;
+	else if (  Option.tagRelative == TREL_ALWAYS )
+		return vStringNewOwn (relativeFilename (fileName,
+												getTagFileDirectory ()));
+	else if ( Option.tagRelative == TREL_NEVER )
+		return vStringNewOwn (absoluteFilename (fileName));
+	else if ( Option.tagRelative == TREL_NO || isAbsolutePath (fileName) )
+		return vStringNewInit (fileName);
+	else
+		return vStringNewOwn (relativeFilename (fileName,
+												getTagFileDirectory ()));
+}
+
 static void setInputFileParametersCommon (inputFileInfo *finfo, vString *const fileName,
 					  const langType language,
 					  stringList *holder)
@@ -440,21 +459,7 @@ static void setInputFileParametersCommon (inputFileInfo *finfo, vString *const f
 			vStringDelete (finfo->tagPath);
 	}
 
-	if (0)
-		;
-	else if (  Option.tagRelative == TREL_ALWAYS )
-		finfo->tagPath =
-			vStringNewOwn (relativeFilename (vStringValue (fileName),
-							 getTagFileDirectory ()));
-	else if ( Option.tagRelative == TREL_NEVER )
-		finfo->tagPath =
-			vStringNewOwn (absoluteFilename (vStringValue (fileName)));
-	else if ( Option.tagRelative == TREL_NO || isAbsolutePath (vStringValue (fileName)) )
-		finfo->tagPath = vStringNewCopy (fileName);
-	else
-		finfo->tagPath =
-			vStringNewOwn (relativeFilename (vStringValue (fileName),
-							 getTagFileDirectory ()));
+	finfo->tagPath = makeTagPathOfFile (vStringValue (fileName));
 
 	finfo->isHeader = isIncludeFile (vStringValue (fileName));
 }
@@ -651,6 +656,16 @@ static MIO *getMioFull (const char *const fileName, const char *const openMode,
 	if (mtime)
 		*mtime = st->mtime;
 	eStatFree (st);
+
+	/* Map a large file instead of copying it to memory. Reading lines
+	 * for making patterns doesn't need seeking a file then. */
+	if (size > MAX_IN_MEMORY_FILE_SIZE)
+	{
+		MIO *mio = mio_new_mmap (fileName);
+		if (mio)
+			return mio;
+	}
+
 	if ((!memStreamRequired)
 	    && (size > MAX_IN_MEMORY_FILE_SIZE || size == 0))
 		return mio_new_file (fileName, openMode);
@@ -797,6 +812,56 @@ extern time_t getInputFileMtime (void)
 	return File.mtime;
 }
 
+typedef enum eEolType {
+	eol_eof = 0,
+	eol_nl,
+	eol_cr_nl,
+} eolType;
+
+/* The lines in a memory stream are not copied to allLines if they can be
+ * used as is. allLines refers to the part of the stream read so far. */
+static vString *newAllLines (void)
+{
+	size_t size;
+	unsigned char *data;
+
+	if (!mio_memory_terminate (File.mio))
+		return vStringNew ();
+	data = mio_memory_get_data (File.mio, &size);
+
+	File.allLinesOffset = mio_tell (File.mio);
+	File.allLinesView.buffer = (char *) data + File.allLinesOffset;
+	File.allLinesView.length = 0;
+	File.allLinesView.size = size - File.allLinesOffset + 1;
+	return &File.allLinesView;
+}
+
+static void deleteAllLines (void)
+{
+	if (File.allLines != &File.allLinesView)
+		vStringDelete (File.allLines);
+	File.allLines = NULL;
+}
+
+static void appendLineToAllLines (void)
+{
+	if (File.allLines == &File.allLinesView)
+	{
+		size_t length = mio_tell (File.mio) - File.allLinesOffset;
+
+		/* The line differs from the bytes in the stream if readLine()
+		 * turns CR-LF into LF, or drops the bytes after NUL. */
+		if (length - File.allLinesView.length == vStringLength (File.line))
+		{
+			File.allLinesView.length = length;
+			return;
+		}
+		File.allLines = vStringNewNInit (File.allLinesView.buffer,
+										 File.allLinesView.length);
+	}
+	vStringCat (File.allLines, File.line);
+}
+
 extern void resetInputFile (const langType language, bool resetLineFposMap_)
 {
 	Assert (File.mio);
@@ -813,7 +878,10 @@ extern void resetInputFile (const langType language, bool resetLineFposMap_)
 
 	if (hasLanguageMultilineRegexPatterns (language)
 		|| hasLanguagePostRunRegexPatterns (language))
-		File.allLines = vStringNew ();
+	{
+		deleteAllLines ();
+		File.allLines = newAllLines ();
+	}
 
 	if (resetLineFposMap_)
 		resetLineFposMap(&File.lineFposMap);
@@ -849,6 +917,14 @@ extern void *getInputFileUserData(void)
 	return mio_get_user_data (File.mio);
 }
 
+extern bool isInputFileTruncated (void)
+{
+	/* A guest parser reads a copy of an area of the input file. */
+	MIO *mio = BackupFile.mio? BackupFile.mio: File.mio;
+
+	return (mio != NULL && mio_mmap_is_truncated (mio));
+}
+
 /*  Action to take for each encountered input newline.
  */
 static void fileNewline (bool crAdjustment, size_t posInAllLines)
@@ -875,20 +951,51 @@ extern void ungetcToInputFile (int c)
 		File.ungetchBuf[File.ungetchIdx++] = c;
 }
 
-typedef enum eEolType {
-	eol_eof = 0,
-	eol_nl,
-	eol_cr_nl,
-} eolType;
+/* Copy a line found in a memory stream at once. */
+static eolType readLineFromMemory (vString *const vLine, MIO *const mio,
+								   const unsigned char *line, size_t length)
+{
+	eolType r = eol_nl;
+	const unsigned char *nul;
+
+	/* A NUL byte terminates the string read with mio_gets(), and the
+	 * rest of the line is dropped. Do the same. */
+	while ((nul = memchr (line, '\0', length)) != NULL)
+	{
+		vStringNCatSUnsafe (vLine, (const char *) line, nul - line);
+		line = mio_memory_get_line (mio, &length);
+		if (line == NULL)
+			return eol_eof;
+	}
+	vStringNCatSUnsafe (vLine, (const char *) line, length);
+
+	if (mio_eof (mio))
+		r = eol_eof;
+
+	/* See readLine() about CR-LF. */
+	if (vStringLength (vLine) > 1 && vStringLast (vLine) == '\n'
+		&& vStringChar (vLine, vStringLength (vLine) - 2) == '\r')
+	{
+		vStringChar (vLine, vStringLength (vLine) - 2) = '\n';
+		vStringChop (vLine);
+		r = eol_cr_nl;
+	}
+	return r;
+}
 
 static eolType readLine (vString *const vLine, MIO *const mio)
 {
 	char *str;
 	size_t size;
 	eolType r = eol_nl;
+	const unsigned char *line;
 
 	vStringClear (vLine);
 
+	line = mio_memory_get_line (mio, &size);
+	if (line)
+		return readLineFromMemory (vLine, mio, line, size);
+
 	str = vStringValue (vLine);
 	size = vStringSize (vLine);
 
@@ -950,7 +1057,7 @@ static vString *iFileGetLine (bool chop_newline)
 			parseLineDirective (vStringValue (File.line) + 1);
 
 		if (File.allLines)
-			vStringCat (File.allLines, File.line);
+			appendLineToAllLines ();
 
 		bool chopped = vStringStripNewline (File.line);
 
@@ -1000,8 +1107,7 @@ static vString *iFileGetLine (bool chop_newline)
 
 			/* To limit the execution of multiline/multitable parser(s) only
 			   ONCE, clear File.allLines field. */
-			vStringDelete (File.allLines);
-			File.allLines = NULL;
+			deleteAllLines ();
 		}
 		return NULL;
 	}
@@ -1058,6 +1164,28 @@ extern int getNthPrevCFromInputFile (unsigned int nth, int def)
 		return def;
 }
 
+/* returns the characters of the current line that getcFromInputFile () has
+ * not returned yet, without reading them. The string is terminated with '\0',
+ * and includes the newline if any. NULL is returned if characters have been
+ * ungotten, or if no line is being read. */
+extern const unsigned char *peekLineFromInputFile (void)
+{
+	if (File.ungetchIdx > 0)
+		return NULL;
+	return File.currentLine;
+}
+
+/* reads at once the first count characters returned by
+ * peekLineFromInputFile (). */
+extern void skipLineCharsInInputFile (size_t count)
+{
+	Assert (File.ungetchIdx == 0);
+	Assert (File.currentLine != NULL);
+	Assert (strlen ((const char *) File.currentLine) >= count);
+
+	File.currentLine += count;
+}
+
 extern int skipToCharacterInInputFile (int c)
 {
 	int d;
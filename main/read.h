@@ -50,6 +50,8 @@ extern const unsigned char *getInputFileData (size_t *size);
 
 extern int getcFromInputFile (void);
 extern int getNthPrevCFromInputFile (unsigned int nth, int def);
+extern const unsigned char *peekLineFromInputFile (void);
+extern void skipLineCharsInInputFile (size_t count);
 extern int skipToCharacterInInputFile (int c);
 extern int skipToCharacterInInputFile2 (int c0, int c1);
 extern void ungetcToInputFile (int c);
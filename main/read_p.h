@@ -56,10 +56,15 @@ extern MIO *getMio (const char *const fileName, const char *const openMode,
 extern void resetInputFile (const langType language, bool resetLineFposMap_);
 extern void closeInputFile (void);
 extern void *getInputFileUserData(void);
+/* Return true if the input file was truncated while reading it. See
+   mio_new_mmap(). */
+extern bool isInputFileTruncated (void);
 
 extern unsigned int getAreaBoundaryInfo (unsigned long lineNumber);
 
 extern const char *getSourceFileTagPath (void);
+/* Return the path of FILENAME recorded in the tag file. */
+extern vString *makeTagPathOfFile (const char *const fileName);
 extern langType getSourceLanguage (void);
 
 extern time_t getInputFileMtime (void);
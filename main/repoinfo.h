@@ -0,0 +1 @@
+#define CTAGS_REPOINFO "93b88cd"
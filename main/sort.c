@@ -22,13 +22,16 @@
 #endif
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #include "debug.h"
 #include "entry_p.h"
 #include "options_p.h"
 #include "read.h"
 #include "routines.h"
+#include "ptrarray.h"
 #include "sort_p.h"
+#include "vstring.h"
 
 /*
 *   FUNCTION DEFINITIONS
@@ -172,11 +175,58 @@ extern void externalSortTags (const bool toStdout, MIO *tagFile)
 #else
 
 /*
- *  These functions provide a basic internal sort. No great memory
- *  optimization is performed (e.g. recursive subdivided sorts),
- *  so have lots of memory if you have large tag files.
+ *  These functions provide an internal merge sort. Lines are sorted in
+ *  runs fitting in the memory given with --sort-memory option. When a
+ *  run fills the memory, it is sorted and spilled to a temporary file.
+ *  Finally the spilled runs and the run in memory are merged with a heap.
  */
 
+/* The maximum number of runs merged at once; more runs are merged in
+ * several passes so that too many temporary files are not opened. */
+#define SORT_MERGE_FANIN 64
+
+/* The size of a block of the arena where lines in a run are stored. */
+#define SORT_ARENA_BLOCK_SIZE (1024 * 1024)
+
+typedef struct sArenaBlock {
+	struct sArenaBlock *next;
+	size_t used;
+	size_t size;
+	char data [];
+} arenaBlock;
+
+/* A sorted run spilled to a temporary file, or a sorted shard of --jobs. */
+typedef struct sSpilledRun {
+	MIO *mio;
+	char *name;					/* NULL if the run is not owned */
+} spilledRun;
+
+struct sTagSorter {
+	int (*cmpFunc)(const void *, const void *);
+	bool folded;
+	bool dedup;
+	bool newlineReplaced;
+
+	/* The run in memory */
+	char **table;
+	size_t count;
+	size_t tableSize;
+	arenaBlock *blocks;
+	size_t memory;
+	size_t memoryLimit;
+
+	ptrArray *spilledRuns;
+};
+
+typedef struct sSortedRun {
+	MIO *mio;					/* NULL for the run in memory */
+	vString *line;
+	char **table;
+	size_t count;
+	size_t index;
+	const char *current;
+} sortedRun;
+
 extern void failedSort (MIO *const mio, const char* msg)
 {
 	const char* const cannotSort = "cannot sort tag file";
@@ -192,8 +242,11 @@ static int compareTagsFolded(const void *const one, const void *const two)
 {
 	const char *const line1 = *(const char* const*) one;
 	const char *const line2 = *(const char* const*) two;
+	int r = struppercmp (line1, line2);
 
-	return struppercmp (line1, line2);
+	/* Order lines differing only in case deterministically; otherwise
+	 * the result depends on how the lines are split into runs. */
+	return r? r: strcmp (line1, line2);
 }
 
 static int compareTags (const void *const one, const void *const two)
@@ -204,62 +257,215 @@ static int compareTags (const void *const one, const void *const two)
 	return strcmp (line1, line2);
 }
 
-static void writeSortedTags (
-		char **const table, const size_t numTags, const bool toStdout, bool newlineReplaced)
+extern int compareTagLines (const char *line1, const char *line2)
 {
-	MIO *mio;
-	size_t i;
+	return Option.sorted == SO_FOLDSORTED
+		? compareTagsFolded (&line1, &line2)
+		: compareTags (&line1, &line2);
+}
 
-	/*  Write the sorted lines back into the tag file.
-	 */
-	if (toStdout)
-		mio = mio_new_fp (stdout, NULL);
-	else
+static void deleteSpilledRun (void *data)
+{
+	spilledRun *run = data;
+
+	mio_unref (run->mio);
+	if (run->name)
 	{
-		mio = mio_new_file (tagFileName (), "w");
-		if (mio == NULL)
-			failedSort (mio, NULL);
+		remove (run->name);
+		eFree (run->name);
 	}
-	for (i = 0 ; i < numTags ; ++i)
+	eFree (run);
+}
+
+/*
+ *  Multikey quicksort (Bentley and Sedgewick) of the lines in a run.
+ *  A character common to the lines in a partition is not compared again.
+ */
+static int keyOfLine (const char *line, size_t depth, bool folded)
+{
+	unsigned char c = (unsigned char) line [depth];
+	return folded? toupper (c): c;
+}
+
+static void swapLines (char **a, size_t i, size_t j)
+{
+	char *t = a [i];
+	a [i] = a [j];
+	a [j] = t;
+}
+
+static void sortLinesByKey (char **a, size_t n, size_t depth, bool folded,
+							int (*cmpFunc)(const void *, const void *))
+{
+	while (n > 1)
 	{
-		/*  Here we filter out identical tag *lines* (including search
-		 *  pattern) if this is not an xref file.
-		 */
-		if (i == 0  ||  Option.xref  ||  strcmp (table [i], table [i-1]) != 0)
+		if (n < 16)
 		{
-			if (mio_puts (mio, table [i]) == EOF)
-				failedSort (mio, NULL);
-			else if (newlineReplaced)
-				mio_putc (mio, '\n');
+			for (size_t i = 1; i < n; i++)
+				for (size_t j = i; j > 0 && cmpFunc (a + j - 1, a + j) > 0; j--)
+					swapLines (a, j - 1, j);
+			return;
+		}
+
+		/* Median of three */
+		size_t m = n / 2;
+		int k0 = keyOfLine (a [0], depth, folded);
+		int km = keyOfLine (a [m], depth, folded);
+		int kn = keyOfLine (a [n - 1], depth, folded);
+		size_t p = (k0 < km)? ((km < kn)? m: (k0 < kn)? n - 1: 0)
+			: ((k0 < kn)? 0: (km < kn)? n - 1: m);
+		swapLines (a, 0, p);
+		int pivot = keyOfLine (a [0], depth, folded);
+
+		/* a[0, lt) < pivot, a[lt, i) == pivot, a(gt, n) > pivot */
+		size_t lt = 0, i = 1, gt = n - 1;
+		while (i <= gt)
+		{
+			int k = keyOfLine (a [i], depth, folded);
+			if (k < pivot)
+				swapLines (a, lt++, i++);
+			else if (k > pivot)
+				swapLines (a, i, gt--);
+			else
+				i++;
+		}
+
+		sortLinesByKey (a, lt, depth, folded, cmpFunc);
+		sortLinesByKey (a + gt + 1, n - gt - 1, depth, folded, cmpFunc);
+
+		a += lt;
+		n = gt + 1 - lt;
+		if (pivot == 0)
+		{
+			/* The lines are equal, or differ only in case. */
+			if (folded)
+				qsort (a, n, sizeof (*a), compareTags);
+			return;
 		}
+		depth++;
 	}
-	if (toStdout)
-		mio_flush (mio);
-	mio_unref (mio);
 }
 
-extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
+static void sortRunInMemory (tagSorter *sorter)
 {
-	vString *vLine = vStringNew ();
-	const char *line;
-	size_t i;
-	int (*cmpFunc)(const void *, const void *);
-	bool newlineReplaced = false;
+	sortLinesByKey (sorter->table, sorter->count, 0, sorter->folded, sorter->cmpFunc);
+}
 
-	/*  Allocate a table of line pointers to be sorted.
+extern tagSorter *newTagSorter (bool dedup)
+{
+	tagSorter *sorter = xCalloc (1, tagSorter);
+
+	sorter->folded = (Option.sorted == SO_FOLDSORTED);
+	sorter->cmpFunc = sorter->folded ? compareTagsFolded : compareTags;
+	sorter->dedup = dedup;
+	sorter->memoryLimit = Option.sortMemory;
+	sorter->spilledRuns = ptrArrayNew (deleteSpilledRun);
+	return sorter;
+}
+
+static void clearRunInMemory (tagSorter *sorter)
+{
+	arenaBlock *block = sorter->blocks;
+
+	while (block)
+	{
+		arenaBlock *next = block->next;
+		eFree (block);
+		block = next;
+	}
+	sorter->blocks = NULL;
+	sorter->count = 0;
+	sorter->memory = sorter->tableSize * sizeof (char *);
+}
+
+extern void deleteTagSorter (tagSorter *sorter)
+{
+	clearRunInMemory (sorter);
+	if (sorter->table)
+		eFree (sorter->table);
+	ptrArrayDelete (sorter->spilledRuns);
+	eFree (sorter);
+}
+
+static void writeSortedTag (MIO *mio, const char *line, const char *prev,
+							bool dedup, bool newlineReplaced)
+{
+	/*  Here we filter out identical tag *lines* (including search
+	 *  pattern) if this is not an xref file.
 	 */
-	const size_t tableSize = numTags * sizeof (char *);
-	char **table = (char **) malloc (tableSize);  /* line pointers */
-	DebugStatement ( size_t mallocSize = tableSize; )  /* cumulative total */
+	if (prev == NULL  ||  !dedup  ||  strcmp (line, prev) != 0)
+	{
+		if (mio_puts (mio, line) == EOF)
+			failedSort (mio, NULL);
+		else if (newlineReplaced && mio_putc (mio, '\n') == EOF)
+			failedSort (mio, NULL);
+	}
+}
 
+static void spillRunInMemory (tagSorter *sorter)
+{
+	spilledRun *run = xMalloc (1, spilledRun);
+
+	sortRunInMemory (sorter);
+
+	run->name = NULL;
+	run->mio = tempFile ("w+b", &run->name);
+	for (size_t i = 0; i < sorter->count; i++)
+		writeSortedTag (run->mio, sorter->table [i],
+						i == 0? NULL: sorter->table [i - 1], sorter->dedup, true);
+	if (mio_flush (run->mio) != 0)
+		failedSort (NULL, NULL);
+	ptrArrayAdd (sorter->spilledRuns, run);
+
+	verbose ("sort: spilled run %u (%lu lines) to %s\n",
+			 ptrArrayCount (sorter->spilledRuns), (unsigned long)sorter->count,
+			 run->name);
+	clearRunInMemory (sorter);
+}
 
-	cmpFunc = Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
-	if (table == NULL)
-		failedSort (mio, "out of memory");
+/* Add a line to the run in memory. The line must not include the
+ * newline at the end. */
+static void addLineToSorter (tagSorter *sorter, const char *line, size_t len)
+{
+	if (sorter->count > 0 && sorter->memory + len + 1 + sizeof (char *) > sorter->memoryLimit)
+		spillRunInMemory (sorter);
 
-	for (i = 0  ;  i < numTags  &&  ! mio_eof (mio)  ;  )
+	if (sorter->count == sorter->tableSize)
 	{
-		line = readLineRaw (vLine, mio);
+		size_t size = sorter->tableSize? sorter->tableSize * 2: 64;
+		sorter->table = xRealloc (sorter->table, size, char *);
+		sorter->memory += (size - sorter->tableSize) * sizeof (char *);
+		sorter->tableSize = size;
+	}
+
+	arenaBlock *block = sorter->blocks;
+	if (block == NULL || block->size - block->used < len + 1)
+	{
+		size_t size = len + 1 > SORT_ARENA_BLOCK_SIZE? len + 1: SORT_ARENA_BLOCK_SIZE;
+		block = eMalloc (sizeof (arenaBlock) + size);
+		block->next = sorter->blocks;
+		block->used = 0;
+		block->size = size;
+		sorter->blocks = block;
+	}
+
+	char *s = block->data + block->used;
+	memcpy (s, line, len);
+	s [len] = '\0';
+	block->used += len + 1;
+	sorter->memory += len + 1;
+	sorter->table [sorter->count++] = s;
+}
+
+/* Read at most maxLines lines in mio. Blank lines are ignored. */
+static void readLinesIntoSorter (tagSorter *sorter, MIO *mio, size_t maxLines)
+{
+	vString *vLine = vStringNew ();
+	size_t i;
+
+	for (i = 0  ;  i < maxLines  &&  ! mio_eof (mio)  ;  )
+	{
+		const char *line = readLineRaw (vLine, mio);
 		if (line == NULL)
 		{
 			if (! mio_eof (mio))
@@ -270,34 +476,257 @@ extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
 			;  /* ignore blank lines */
 		else
 		{
-			const size_t stringSize = strlen (line) + 1;
-
-			table [i] = (char *) malloc (stringSize);
-			if (table [i] == NULL)
-				failedSort (mio, "out of memory");
-			DebugStatement ( mallocSize += stringSize; )
-			strcpy (table [i], line);
-			if (table[i][stringSize - 2] == '\n')
-			{
-				table[i][stringSize - 2] = '\0';
-				newlineReplaced = true;
-			}
+			if (vStringStripNewline (vLine))
+				sorter->newlineReplaced = true;
+			addLineToSorter (sorter, vStringValue (vLine), vStringLength (vLine));
 			++i;
 		}
 	}
-	numTags = i;
 	vStringDelete (vLine);
+}
 
-	/*  Sort the lines.
+extern void addTagLinesToSorter (tagSorter *sorter, const char *lines, size_t len)
+{
+	const char *end = lines + len;
+
+	while (lines < end)
+	{
+		const char *eol = memchr (lines, '\n', end - lines);
+		size_t n = (eol? eol: end) - lines;
+
+		/* Blank lines are ignored. */
+		if (n > 0)
+			addLineToSorter (sorter, lines, n);
+		if (eol)
+			sorter->newlineReplaced = true;
+		lines += n + 1;
+	}
+}
+
+extern void addSortedRunToSorter (tagSorter *sorter, MIO *mio)
+{
+	spilledRun *run = xMalloc (1, spilledRun);
+
+	run->mio = mio_ref (mio);
+	run->name = NULL;
+	ptrArrayAdd (sorter->spilledRuns, run);
+	sorter->newlineReplaced = true;
+}
+
+static bool advanceSortedRun (sortedRun *run)
+{
+	if (run->mio == NULL)
+	{
+		if (run->index >= run->count)
+			return false;
+		run->current = run->table [run->index++];
+		return true;
+	}
+
+	while (readLineRaw (run->line, run->mio) != NULL)
+	{
+		vStringStripNewline (run->line);
+		if (vStringLength (run->line) > 0)
+		{
+			run->current = vStringValue (run->line);
+			return true;
+		}
+	}
+	return false;
+}
+
+static int compareSortedRuns (sortedRun **heap, unsigned int a, unsigned int b,
+							  int (*cmpFunc)(const void *, const void *))
+{
+	int r = cmpFunc (&heap [a]->current, &heap [b]->current);
+	if (r)
+		return r;
+	/* Keep the order of runs for identical lines. */
+	return heap [a] < heap [b]? -1: (heap [a] > heap [b]);
+}
+
+static void siftDownSortedRun (sortedRun **heap, unsigned int n, unsigned int i,
+							   int (*cmpFunc)(const void *, const void *))
+{
+	for (;;)
+	{
+		unsigned int l = 2 * i + 1, r = l + 1, m = i;
+
+		if (l < n && compareSortedRuns (heap, l, m, cmpFunc) < 0)
+			m = l;
+		if (r < n && compareSortedRuns (heap, r, m, cmpFunc) < 0)
+			m = r;
+		if (m == i)
+			return;
+
+		sortedRun *t = heap [i];
+		heap [i] = heap [m];
+		heap [m] = t;
+		i = m;
+	}
+}
+
+/* Merge the spilled runs in [from, to) and the run in memory (if
+ * withMemory is true) into out. */
+static void mergeRuns (tagSorter *sorter, unsigned int from, unsigned int to,
+					   bool withMemory, MIO *out, bool newlineReplaced)
+{
+	unsigned int numRuns = to - from + (withMemory? 1: 0);
+	sortedRun *runs = xCalloc (numRuns, sortedRun);
+	sortedRun **heap = xMalloc (numRuns, sortedRun *);
+	vString *prev = vStringNew ();
+	bool hasPrev = false;
+	unsigned int n = 0;
+
+	for (unsigned int i = from; i < to; i++)
+	{
+		spilledRun *spilled = ptrArrayItem (sorter->spilledRuns, i);
+		runs [i - from].mio = spilled->mio;
+		runs [i - from].line = vStringNew ();
+		mio_seek (spilled->mio, 0, SEEK_SET);
+	}
+	if (withMemory)
+	{
+		runs [numRuns - 1].table = sorter->table;
+		runs [numRuns - 1].count = sorter->count;
+	}
+
+	for (unsigned int i = 0; i < numRuns; i++)
+		if (advanceSortedRun (runs + i))
+			heap [n++] = runs + i;
+	for (unsigned int i = n / 2; i > 0; i--)
+		siftDownSortedRun (heap, n, i - 1, sorter->cmpFunc);
+
+	while (n > 0)
+	{
+		sortedRun *run = heap [0];
+
+		writeSortedTag (out, run->current, hasPrev? vStringValue (prev): NULL,
+						sorter->dedup, newlineReplaced);
+		vStringCopyS (prev, run->current);
+		hasPrev = true;
+
+		if (! advanceSortedRun (run))
+			heap [0] = heap [--n];
+		siftDownSortedRun (heap, n, 0, sorter->cmpFunc);
+	}
+
+	for (unsigned int i = 0; i < numRuns; i++)
+		vStringDelete (runs [i].line);
+	vStringDelete (prev);
+	eFree (heap);
+	eFree (runs);
+}
+
+/* Merge spilled runs until they can be merged with the run in memory
+ * at once. */
+static void reduceSpilledRuns (tagSorter *sorter)
+{
+	while (ptrArrayCount (sorter->spilledRuns) + 1 > SORT_MERGE_FANIN)
+	{
+		spilledRun *run = xMalloc (1, spilledRun);
+
+		run->name = NULL;
+		run->mio = tempFile ("w+b", &run->name);
+		mergeRuns (sorter, 0, SORT_MERGE_FANIN, false, run->mio, true);
+		if (mio_flush (run->mio) != 0)
+			failedSort (NULL, NULL);
+
+		for (unsigned int i = 0; i < SORT_MERGE_FANIN; i++)
+			ptrArrayDeleteItem (sorter->spilledRuns, 0);
+		ptrArrayAdd (sorter->spilledRuns, run);
+	}
+}
+
+static void writeSorter (tagSorter *sorter, MIO *out)
+{
+	sortRunInMemory (sorter);
+
+	if (ptrArrayCount (sorter->spilledRuns) == 0)
+	{
+		for (size_t i = 0; i < sorter->count; i++)
+			writeSortedTag (out, sorter->table [i],
+							i == 0? NULL: sorter->table [i - 1],
+							sorter->dedup, sorter->newlineReplaced);
+		return;
+	}
+
+	reduceSpilledRuns (sorter);
+	mergeRuns (sorter, 0, ptrArrayCount (sorter->spilledRuns), true,
+			   out, sorter->newlineReplaced);
+}
+
+static MIO *openSortedTagFile (const bool toStdout)
+{
+	MIO *mio;
+
+	if (toStdout)
+		mio = mio_new_fp (stdout, NULL);
+	else
+	{
+		mio = mio_new_file (tagFileName (), "w");
+		if (mio == NULL)
+			failedSort (mio, NULL);
+	}
+	return mio;
+}
+
+extern void writeSortedTags (tagSorter *sorter, const bool toStdout)
+{
+	/*  Write the sorted lines back into the tag file.
 	 */
-	qsort (table, numTags, sizeof (*table), cmpFunc);
+	MIO *mio = openSortedTagFile (toStdout);
+
+	writeSorter (sorter, mio);
+
+	if (toStdout)
+		mio_flush (mio);
+	if (mio_unref (mio) != 0)
+		failedSort (NULL, NULL);
+}
+
+extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
+{
+	tagSorter *sorter = newTagSorter (!Option.xref);
+
+	readLinesIntoSorter (sorter, mio, numTags);
+	writeSortedTags (sorter, toStdout);
+	deleteTagSorter (sorter);
+}
+
+extern void internalSortShard (MIO *mio)
+{
+	/* Duplicated lines are kept here. They are filtered out when
+	 * merging the shards. The size of the file doesn't change. */
+	tagSorter *sorter = newTagSorter (false);
+
+	mio_seek (mio, 0, SEEK_SET);
+	readLinesIntoSorter (sorter, mio, (size_t)-1);
+
+	/* All lines are in the memory or the spilled runs; the shard can be
+	 * overwritten. */
+	sorter->newlineReplaced = true;
+	mio_seek (mio, 0, SEEK_SET);
+	writeSorter (sorter, mio);
+	if (mio_flush (mio) != 0)
+		failedSort (NULL, NULL);
+
+	deleteTagSorter (sorter);
+}
+
+extern void internalMergeSortedShards (const bool toStdout, MIO *mio,
+									   MIO **shards, unsigned int numShards)
+{
+	tagSorter *sorter = newTagSorter (!Option.xref);
 
-	writeSortedTags (table, numTags, toStdout, newlineReplaced);
+	/* Lines written to the tag file by this process, e.g. the pseudo
+	 * tags, are sorted with the sorted shards. */
+	readLinesIntoSorter (sorter, mio, (size_t)-1);
+	for (unsigned int i = 0; i < numShards; i++)
+		addSortedRunToSorter (sorter, shards [i]);
 
-	PrintStatus (("sort memory: %ld bytes\n", (long) mallocSize));
-	for (i = 0 ; i < numTags ; ++i)
-		free (table [i]);
-	free (table);
+	writeSortedTags (sorter, toStdout);
+	deleteTagSorter (sorter);
 }
 
 #endif
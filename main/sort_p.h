@@ -29,6 +29,26 @@ extern void externalSortTags (const bool toStdout, MIO *tagFile);
 extern void internalSortTags (const bool toStdout,
 			      MIO *mio,
 			      size_t numTags);
+
+/* Compare two tag lines in the order specified with --sort option. */
+extern int compareTagLines (const char *line1, const char *line2);
+
+/* A sorter collects tag lines, and writes them sorted to the tag file. */
+typedef struct sTagSorter tagSorter;
+extern tagSorter *newTagSorter (bool dedup);
+extern void deleteTagSorter (tagSorter *sorter);
+extern void addTagLinesToSorter (tagSorter *sorter, const char *lines, size_t len);
+extern void addSortedRunToSorter (tagSorter *sorter, MIO *mio);
+extern void writeSortedTags (tagSorter *sorter, const bool toStdout);
+
+/* Sort the lines in mio in place; used by the workers of --jobs. */
+extern void internalSortShard (MIO *mio);
+
+/* Sort the lines in mio and merge them with sorted shards. */
+extern void internalMergeSortedShards (const bool toStdout,
+				       MIO *mio,
+				       MIO **shards,
+				       unsigned int numShards);
 #endif
 
 /* mio is closed in this function. */
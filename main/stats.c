@@ -44,6 +44,14 @@ extern void addTotals (
 	Totals.bytes += bytes;
 }
 
+extern void getTotals (
+		unsigned long *files, unsigned long *lines, unsigned long *bytes)
+{
+	*files = Totals.files;
+	*lines = Totals.lines;
+	*bytes = Totals.bytes;
+}
+
 extern void printTotals (const clock_t *const timeStamps, bool append, sortType sorted)
 {
 	const unsigned long totalTags = numTagsTotal();
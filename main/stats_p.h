@@ -23,6 +23,7 @@
 *   FUNCTION PROTOTYPES
 */
 extern void addTotals (const unsigned int files, const long unsigned int lines, const long unsigned int bytes);
+extern void getTotals (unsigned long *files, unsigned long *lines, unsigned long *bytes);
 extern void printTotals (const clock_t *const timeStamps, bool append, sortType sorted);
 
 #endif  /* CTAGS_MAIN_STATS_PRIVATE_H */
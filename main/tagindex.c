@@ -0,0 +1,615 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for writing the index of a tag file
+*   (--tag-index option).
+*
+*   The index is written to "<tagfile>.idx" after the tag file is closed.
+*   libreadtags uses it for finding tags without searching the tag file.
+*   It holds:
+*
+*   - the file offsets of the tag lines,
+*   - a minimal perfect hash function mapping each tag name to the first
+*     line having the name in the name order (the CHD "hash, displace"
+*     algorithm without the compression of the displacements; a bucket
+*     having only one name stores its slot directly),
+*   - the line numbers in the name order and in the case-folded name
+*     order unless the lines are already in those orders, and
+*   - a checksum of the tag file, for detecting a stale index.
+*
+*   Names are compared after unescaping them as readTagCharacter() of
+*   libreadtags does, and case is folded with toupper(). The layout, the
+*   hash function, and the checksum must be kept in sync with
+*   libreadtags/readtags.c.
+*
+*   All integers are little endian:
+*
+*     offset  size  field
+*          0     8  magic "CTAGSIDX"
+*          8     4  version (1)
+*         12     4  flags (1: name order is the line order,
+*                          2: folded name order is the line order)
+*         16     8  size of the tag file
+*         24     8  checksum of the tag file
+*         32     8  seed of the hash function
+*         40     4  number of lines (N)
+*         44     4  number of distinct names (K)
+*         48     4  number of buckets (B)
+*         52    12  reserved
+*         64   8*N  offsets of lines
+*              4*B  displacements (or slots | 0x80000000)
+*              4*K  slots: positions in the name order
+*              4*N  lines in the name order (if not flags & 1)
+*              4*N  lines in the folded name order (if not flags & 2)
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "debug.h"
+#include "mio.h"
+#include "options.h"
+#include "read_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "sort_r.h"
+#include "tagindex_p.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define TAG_INDEX_MAGIC "CTAGSIDX"
+#define TAG_INDEX_VERSION 1
+#define TAG_INDEX_HEADER_SIZE 64
+#define TAG_INDEX_NAME_ORDERED   1
+#define TAG_INDEX_FOLD_ORDERED   2
+
+#define TAG_INDEX_BUCKET_SIZE 4
+#define TAG_INDEX_MAX_DISPLACEMENT (1U << 20)
+#define TAG_INDEX_DIRECT_SLOT 0x80000000U
+#define TAG_INDEX_MAX_SEEDS 8
+
+#define TAG_INDEX_SAMPLE_SIZE 4096
+#define TAG_INDEX_SAMPLE_COUNT 64
+
+/*
+*   DATA DECLARATIONS
+*/
+struct indexLine {
+	uint64_t offset;
+	uint64_t hash;
+	uint32_t name;				/* offset in names */
+	uint32_t nameLength;
+};
+
+struct indexBuilder {
+	struct indexLine *lines;
+	uint32_t count;
+	vString *names;				/* unescaped names */
+};
+
+struct indexBucket {
+	uint32_t id;
+	uint32_t start;				/* in keys */
+	uint32_t size;
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/* Same as libreadtags */
+static uint64_t mixHash (uint64_t h)
+{
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return h;
+}
+
+static uint64_t hashName (const unsigned char *name, size_t length, uint64_t seed)
+{
+	uint64_t h = UINT64_C(14695981039346656037) ^ seed;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		h ^= name [i];
+		h *= UINT64_C(1099511628211);
+	}
+	return mixHash (h);
+}
+
+static uint32_t hashBucket (uint64_t h, uint32_t bucketCount)
+{
+	return (uint32_t) ((h >> 32) % bucketCount);
+}
+
+static uint32_t hashSlot (uint64_t h, uint32_t displacement, uint32_t keyCount)
+{
+	return (uint32_t) (mixHash (h + displacement * UINT64_C(0x9e3779b97f4a7c15)) % keyCount);
+}
+
+static uint64_t checksumBytes (uint64_t h, const unsigned char *p, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		h ^= p [i];
+		h *= UINT64_C(1099511628211);
+	}
+	return h;
+}
+
+/* Only some blocks of the tag file are hashed so that libreadtags can
+ * verify the index quickly when opening a large tag file. */
+static uint64_t checksumTagFile (const unsigned char *data, uint64_t size)
+{
+	unsigned char sizeBytes [8];
+	uint64_t h = UINT64_C(14695981039346656037);
+
+	for (int i = 0; i < 8; i++)
+		sizeBytes [i] = (unsigned char) (size >> (8 * i));
+	h = checksumBytes (h, sizeBytes, 8);
+
+	if (size <= (uint64_t) TAG_INDEX_SAMPLE_SIZE * TAG_INDEX_SAMPLE_COUNT)
+		return checksumBytes (h, data, (size_t) size);
+
+	for (uint64_t i = 0; i < TAG_INDEX_SAMPLE_COUNT; i++)
+	{
+		uint64_t offset = (size - TAG_INDEX_SAMPLE_SIZE) * i / (TAG_INDEX_SAMPLE_COUNT - 1);
+		h = checksumBytes (h, data + offset, TAG_INDEX_SAMPLE_SIZE);
+	}
+	return h;
+}
+
+static int xdigitValue (unsigned char digit)
+{
+	if (digit >= '0' && digit <= '9')
+		return digit - '0';
+	else if (digit >= 'a' && digit <= 'f')
+		return 10 + digit - 'a';
+	else
+		return 10 + digit - 'A';
+}
+
+/* Append the name unescaped as readTagCharacter() of libreadtags does.
+ * A name ends at an escaped null character as tagcmp() does. */
+static void appendUnescapedName (vString *names, const unsigned char *p,
+								 const unsigned char *end)
+{
+	while (p < end)
+	{
+		int c = *p++;
+
+		if (c == '\\' && p < end)
+		{
+			switch (*p)
+			{
+			case 't': c = '\t'; p++; break;
+			case 'r': c = '\r'; p++; break;
+			case 'n': c = '\n'; p++; break;
+			case '\\': c = '\\'; p++; break;
+			case 'a': c = '\a'; p++; break;
+			case 'b': c = '\b'; p++; break;
+			case 'v': c = '\v'; p++; break;
+			case 'f': c = '\f'; p++; break;
+			case 'x':
+				if (end - p >= 3 && isxdigit (p[1]) && isxdigit (p[2]))
+				{
+					int val = (xdigitValue (p[1]) << 4) | xdigitValue (p[2]);
+					if (val < 0x80)
+					{
+						p += 3;
+						c = val;
+					}
+				}
+				break;
+			}
+		}
+		if (c == '\0')
+			break;
+		vStringPut (names, c);
+	}
+}
+
+/* Collect the lines as libreadtags reads them: a line ends at a newline
+ * or a null character, and the name of the tag ends at a tab. Lines
+ * having empty names are skipped. */
+static bool collectLines (struct indexBuilder *builder,
+						  const unsigned char *data, size_t size)
+{
+	size_t allocated = 0;
+	size_t pos = 0;
+
+	while (pos < size)
+	{
+		const unsigned char *start = data + pos;
+		const unsigned char *eol = memchr (start, '\n', size - pos);
+		const unsigned char *end = eol? eol: data + size;
+		const unsigned char *nameEnd;
+		size_t nameStart;
+
+		pos = (end - data) + (eol? 1: 0);
+
+		nameEnd = memchr (start, '\0', end - start);
+		if (nameEnd)
+			end = nameEnd;
+		nameEnd = memchr (start, '\t', end - start);
+		if (nameEnd == NULL)
+			nameEnd = memchr (start, '\r', end - start);
+		if (nameEnd == NULL)
+			nameEnd = end;
+		if (nameEnd == start)
+			continue;
+
+		if (builder->count == (uint32_t) TAG_INDEX_DIRECT_SLOT
+			|| vStringLength (builder->names) > UINT32_MAX - (nameEnd - start))
+			return false;
+
+		if (builder->count == allocated)
+		{
+			allocated = allocated? allocated * 2: 1024;
+			builder->lines = xRealloc (builder->lines, allocated, struct indexLine);
+		}
+
+		nameStart = vStringLength (builder->names);
+		appendUnescapedName (builder->names, start, nameEnd);
+
+		struct indexLine *line = builder->lines + builder->count++;
+		line->offset = (uint64_t) (start - data);
+		line->name = (uint32_t) nameStart;
+		line->nameLength = (uint32_t) (vStringLength (builder->names) - nameStart);
+	}
+	return true;
+}
+
+static int compareNames (const unsigned char *a, size_t alen,
+						 const unsigned char *b, size_t blen, bool fold)
+{
+	size_t len = (alen < blen)? alen: blen;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		int ca = fold? toupper (a [i]): a [i];
+		int cb = fold? toupper (b [i]): b [i];
+		if (ca != cb)
+			return ca - cb;
+	}
+	return (alen < blen)? -1: (alen > blen)? 1: 0;
+}
+
+struct orderContext {
+	struct indexBuilder *builder;
+	bool fold;
+};
+
+static int compareLinesByName (const void *a, const void *b, void *data)
+{
+	struct orderContext *ctx = data;
+	uint32_t la = *(const uint32_t *) a;
+	uint32_t lb = *(const uint32_t *) b;
+	const struct indexLine *ia = ctx->builder->lines + la;
+	const struct indexLine *ib = ctx->builder->lines + lb;
+	const unsigned char *names = (const unsigned char *) vStringValue (ctx->builder->names);
+	int r = compareNames (names + ia->name, ia->nameLength,
+						  names + ib->name, ib->nameLength, ctx->fold);
+
+	if (r)
+		return r;
+	return (la < lb)? -1: (la > lb)? 1: 0;
+}
+
+/* Return the lines sorted by their names. *IDENTITY is set to true if
+ * the order is the same as the line order. */
+static uint32_t *makeOrder (struct indexBuilder *builder, bool fold, bool *identity)
+{
+	struct orderContext ctx = { .builder = builder, .fold = fold };
+	uint32_t *order = xMalloc (builder->count, uint32_t);
+
+	for (uint32_t i = 0; i < builder->count; i++)
+		order [i] = i;
+	sort_r (order, builder->count, sizeof (*order), compareLinesByName, &ctx);
+
+	*identity = true;
+	for (uint32_t i = 0; i < builder->count; i++)
+	{
+		if (order [i] != i)
+		{
+			*identity = false;
+			break;
+		}
+	}
+	return order;
+}
+
+static int compareBuckets (const void *a, const void *b)
+{
+	const struct indexBucket *ba = a;
+	const struct indexBucket *bb = b;
+
+	if (ba->size != bb->size)
+		return (ba->size < bb->size)? 1: -1;
+	return (ba->id < bb->id)? -1: (ba->id > bb->id)? 1: 0;
+}
+
+/* Find the displacement of each bucket so that the keys are mapped to
+ * distinct slots. KEYS are the positions in ORDER of the first line of
+ * each name. Returns false if no displacement is found. */
+static bool placeKeys (struct indexBuilder *builder, const uint32_t *order,
+					   const uint32_t *keys, uint32_t keyCount,
+					   uint32_t bucketCount, uint64_t seed,
+					   uint32_t *displacements, uint32_t *slots)
+{
+	struct indexBucket *buckets = xCalloc (bucketCount, struct indexBucket);
+	uint32_t *bucketKeys = xMalloc (keyCount, uint32_t);
+	bool *used = xCalloc (keyCount, bool);
+	uint32_t *trial = xMalloc (keyCount, uint32_t);
+	bool r = true;
+
+	for (uint32_t k = 0; k < keyCount; k++)
+	{
+		struct indexLine *line = builder->lines + order [keys [k]];
+		line->hash = hashName ((const unsigned char *) vStringValue (builder->names) + line->name,
+							   line->nameLength, seed);
+		buckets [hashBucket (line->hash, bucketCount)].size++;
+	}
+
+	uint32_t start = 0;
+	for (uint32_t b = 0; b < bucketCount; b++)
+	{
+		buckets [b].id = b;
+		buckets [b].start = start;
+		start += buckets [b].size;
+		buckets [b].size = 0;
+	}
+	for (uint32_t k = 0; k < keyCount; k++)
+	{
+		struct indexBucket *bucket = buckets
+			+ hashBucket (builder->lines [order [keys [k]]].hash, bucketCount);
+		bucketKeys [bucket->start + bucket->size++] = k;
+	}
+
+	qsort (buckets, bucketCount, sizeof (*buckets), compareBuckets);
+
+	uint32_t freeSlot = 0;
+	for (uint32_t b = 0; b < bucketCount && buckets [b].size > 0; b++)
+	{
+		struct indexBucket *bucket = buckets + b;
+		uint32_t d;
+
+		/* The buckets having one name come last. Searching for
+		 * a displacement hitting one of the few free slots is slow. */
+		if (bucket->size == 1)
+		{
+			while (used [freeSlot])
+				freeSlot++;
+			used [freeSlot] = true;
+			displacements [bucket->id] = TAG_INDEX_DIRECT_SLOT | freeSlot;
+			slots [freeSlot] = keys [bucketKeys [bucket->start]];
+			continue;
+		}
+
+		for (d = 0; d < TAG_INDEX_MAX_DISPLACEMENT; d++)
+		{
+			uint32_t i;
+
+			for (i = 0; i < bucket->size; i++)
+			{
+				uint32_t k = bucketKeys [bucket->start + i];
+				uint32_t s = hashSlot (builder->lines [order [keys [k]]].hash, d, keyCount);
+
+				if (used [s])
+					break;
+				used [s] = true;
+				trial [i] = s;
+			}
+			if (i == bucket->size)
+				break;
+			while (i > 0)
+				used [trial [--i]] = false;
+		}
+		if (d == TAG_INDEX_MAX_DISPLACEMENT)
+		{
+			r = false;
+			break;
+		}
+
+		displacements [bucket->id] = d;
+		for (uint32_t i = 0; i < bucket->size; i++)
+			slots [trial [i]] = keys [bucketKeys [bucket->start + i]];
+	}
+
+	eFree (trial);
+	eFree (used);
+	eFree (bucketKeys);
+	eFree (buckets);
+	return r;
+}
+
+static void putU32 (MIO *mio, uint32_t v)
+{
+	unsigned char b [4];
+
+	for (int i = 0; i < 4; i++)
+		b [i] = (unsigned char) (v >> (8 * i));
+	mio_write (mio, b, 1, 4);
+}
+
+static void putU64 (MIO *mio, uint64_t v)
+{
+	unsigned char b [8];
+
+	for (int i = 0; i < 8; i++)
+		b [i] = (unsigned char) (v >> (8 * i));
+	mio_write (mio, b, 1, 8);
+}
+
+static void putU32Array (MIO *mio, const uint32_t *a, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		putU32 (mio, a [i]);
+}
+
+static bool writeIndexFile (const char *const indexFileName,
+							struct indexBuilder *builder,
+							uint64_t tagFileSize, uint64_t checksum, uint64_t seed,
+							uint32_t flags, const uint32_t *nameOrder, const uint32_t *foldOrder,
+							uint32_t keyCount, uint32_t bucketCount,
+							const uint32_t *displacements, const uint32_t *slots)
+{
+	vString *tmpName = vStringNewInit (indexFileName);
+	vStringCatS (tmpName, ".tmp");
+
+	MIO *mio = mio_new_file (vStringValue (tmpName), "wb");
+	if (mio == NULL)
+	{
+		error (WARNING | PERROR, "cannot open %s", vStringValue (tmpName));
+		vStringDelete (tmpName);
+		return false;
+	}
+
+	mio_write (mio, TAG_INDEX_MAGIC, 1, 8);
+	putU32 (mio, TAG_INDEX_VERSION);
+	putU32 (mio, flags);
+	putU64 (mio, tagFileSize);
+	putU64 (mio, checksum);
+	putU64 (mio, seed);
+	putU32 (mio, builder->count);
+	putU32 (mio, keyCount);
+	putU32 (mio, bucketCount);
+	for (int i = 0; i < 3; i++)
+		putU32 (mio, 0);
+
+	for (uint32_t i = 0; i < builder->count; i++)
+		putU64 (mio, builder->lines [i].offset);
+	putU32Array (mio, displacements, bucketCount);
+	putU32Array (mio, slots, keyCount);
+	if (!(flags & TAG_INDEX_NAME_ORDERED))
+		putU32Array (mio, nameOrder, builder->count);
+	if (!(flags & TAG_INDEX_FOLD_ORDERED))
+		putU32Array (mio, foldOrder, builder->count);
+
+	bool r = (mio_error (mio) == 0);
+	if (mio_unref (mio) != 0)
+		r = false;
+
+	if (r)
+	{
+		/* rename () fails on Windows if the file exists. */
+		remove (indexFileName);
+		r = (rename (vStringValue (tmpName), indexFileName) == 0);
+	}
+	if (!r)
+	{
+		error (WARNING | PERROR, "cannot write %s", indexFileName);
+		remove (vStringValue (tmpName));
+	}
+	vStringDelete (tmpName);
+	return r;
+}
+
+extern void writeTagIndex (const char *const tagFileName)
+{
+	struct indexBuilder builder = { .lines = NULL, .count = 0 };
+	uint32_t *nameOrder = NULL, *foldOrder = NULL;
+	uint32_t *keys = NULL, *displacements = NULL, *slots = NULL;
+	uint32_t keyCount = 0, bucketCount;
+	uint32_t flags = 0;
+	bool identity;
+	uint64_t seed;
+	const unsigned char *data;
+	size_t size;
+	vString *indexFileName = vStringNewInit (tagFileName);
+	MIO *mio;
+
+	vStringCatS (indexFileName, ".idx");
+	verbose ("writing tag index %s\n", vStringValue (indexFileName));
+
+	builder.names = vStringNew ();
+	mio = getMio (tagFileName, "rb", true);
+	if (mio == NULL)
+	{
+		error (WARNING | PERROR, "cannot read %s for making its index", tagFileName);
+		goto out;
+	}
+	data = mio_memory_get_data (mio, &size);
+
+	if (!collectLines (&builder, data, size))
+	{
+		error (WARNING, "too many tags in %s for making its index", tagFileName);
+		goto out;
+	}
+
+	nameOrder = makeOrder (&builder, false, &identity);
+	if (identity)
+		flags |= TAG_INDEX_NAME_ORDERED;
+	foldOrder = makeOrder (&builder, true, &identity);
+	if (identity)
+		flags |= TAG_INDEX_FOLD_ORDERED;
+
+	/* The first line of each name in the name order */
+	keys = xMalloc (builder.count + 1, uint32_t);
+	for (uint32_t i = 0; i < builder.count; i++)
+	{
+		const unsigned char *names = (const unsigned char *) vStringValue (builder.names);
+		const struct indexLine *line = builder.lines + nameOrder [i];
+		const struct indexLine *prev = (i > 0)? builder.lines + nameOrder [i - 1]: NULL;
+
+		if (prev == NULL
+			|| compareNames (names + prev->name, prev->nameLength,
+							 names + line->name, line->nameLength, false) != 0)
+			keys [keyCount++] = i;
+	}
+
+	bucketCount = keyCount / TAG_INDEX_BUCKET_SIZE + 1;
+	displacements = xCalloc (bucketCount, uint32_t);
+	slots = xMalloc (keyCount + 1, uint32_t);
+	for (seed = 0; seed < TAG_INDEX_MAX_SEEDS; seed++)
+	{
+		if (keyCount == 0
+			|| placeKeys (&builder, nameOrder, keys, keyCount, bucketCount, seed,
+						  displacements, slots))
+			break;
+		memset (displacements, 0, bucketCount * sizeof (*displacements));
+	}
+	if (seed == TAG_INDEX_MAX_SEEDS)
+	{
+		error (WARNING, "cannot make the hash function for the index of %s", tagFileName);
+		goto out;
+	}
+
+	writeIndexFile (vStringValue (indexFileName), &builder,
+					(uint64_t) size, checksumTagFile (data, (uint64_t) size), seed,
+					flags, nameOrder, foldOrder, keyCount, bucketCount,
+					displacements, slots);
+
+ out:
+	if (slots)
+		eFree (slots);
+	if (displacements)
+		eFree (displacements);
+	if (keys)
+		eFree (keys);
+	if (foldOrder)
+		eFree (foldOrder);
+	if (nameOrder)
+		eFree (nameOrder);
+	vStringDelete (builder.names);
+	if (builder.lines)
+		eFree (builder.lines);
+	if (mio)
+		mio_unref (mio);
+	vStringDelete (indexFileName);
+}
@@ -0,0 +1,25 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines internal interface to write the index of a tag file (--tag-index).
+*/
+#ifndef CTAGS_MAIN_TAGINDEX_PRIVATE_H
+#define CTAGS_MAIN_TAGINDEX_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Write the index of the tag file to "<tagFileName>.idx" for
+ * libreadtags. */
+extern void writeTagIndex (const char *const tagFileName);
+
+#endif  /* CTAGS_MAIN_TAGINDEX_PRIVATE_H */
@@ -0,0 +1,334 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for updating an existing tag file
+*   (--update option).
+*
+*   When the tag file is opened, the names of the input files recorded in
+*   it are collected. An input file is parsed again only if it is not in
+*   the tag file, or it has been modified since the tag file was made.
+*   The modification time is compared with the epoch field of the file
+*   name tag (F kind) if it is available, and with the modification time
+*   of the tag file otherwise.
+*
+*   When the tag file is closed, the lines of the old tag file are
+*   filtered: the tags of the input files parsed again and of the input
+*   files that no longer exist are dropped. So are the pseudo tags
+*   written again in this run. The lines kept are merged with new tags
+*   by the sorter.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "debug.h"
+#include "entry_p.h"
+#include "htable.h"
+#include "kind.h"
+#include "mio.h"
+#include "options_p.h"
+#include "ptag_p.h"
+#include "read.h"
+#include "read_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "sort_p.h"
+#include "update_p.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum inputFileState {
+	INPUT_NOT_VISITED,			/* Not given in this run */
+	INPUT_UP_TO_DATE,			/* Given in this run, but not modified */
+	INPUT_MODIFIED,				/* Given in this run, and parsed again */
+	INPUT_DELETED,				/* Not given in this run, and removed */
+};
+
+typedef struct sOldInputFile {
+	enum inputFileState state;
+	bool hasEpoch;
+	time_t epoch;
+} oldInputFile;
+
+/*
+*   DATA DEFINITIONS
+*/
+static hashTable *OldInputFiles;
+static hashTable *FreshPseudoTags;
+static time_t OldTagFileMtime;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/* Find the input field, the second field, of a tag line. */
+static const char *findInputField (const char *line, size_t *len)
+{
+	const char *start = strchr (line, '\t');
+	if (start == NULL)
+		return NULL;
+	start++;
+
+	const char *end = strchr (start, '\t');
+	if (end == NULL)
+		return NULL;
+
+	*len = end - start;
+	return start;
+}
+
+/* Find the epoch field of a file name tag (F kind). INPUT and LEN are
+ * the input field of LINE. A file name tag has a line number as its
+ * address, and its kind field comes first in the extension fields. Only
+ * the extension fields are searched: a pattern can include "\tepoch:". */
+static bool findEpochField (const char *line, const char *input, size_t len,
+							time_t *epoch)
+{
+	const char *p = input + len;
+
+	if (*p++ != '\t' || !isdigit ((unsigned char) *p))
+		return false;
+	while (isdigit ((unsigned char) *p))
+		p++;
+	if (strncmp (p, ";\"\t", 3) != 0)
+		return false;
+	p += 3;
+
+	if (strncmp (p, "kind:", 5) == 0)
+		p += 5;
+	size_t kindLen = strcspn (p, "\t");
+	if (! ((kindLen == 1 && *p == KIND_FILE_DEFAULT_LETTER)
+		   || (kindLen == strlen (KIND_FILE_DEFAULT_NAME)
+			   && strncmp (p, KIND_FILE_DEFAULT_NAME, kindLen) == 0)))
+		return false;
+
+	const char *const prefix = "\tepoch:";
+	const char *field = strstr (p + kindLen, prefix);
+	if (field == NULL)
+		return false;
+
+	long long value = strtoll (field + strlen (prefix), NULL, 10);
+	*epoch = (time_t) value;
+	return true;
+}
+
+static oldInputFile *getOldInputFile (const char *tagPath, size_t len)
+{
+	char *key = eStrndup (tagPath, len);
+	oldInputFile *input = hashTableGetItem (OldInputFiles, key);
+
+	if (input == NULL)
+	{
+		input = xCalloc (1, oldInputFile);
+		input->state = INPUT_NOT_VISITED;
+		hashTablePutItem (OldInputFiles, key, input);
+	}
+	else
+		eFree (key);
+	return input;
+}
+
+extern void loadTagFileForUpdate (const char *const tagFileName)
+{
+	fileStatus *status = eStat (tagFileName);
+	OldTagFileMtime = status->mtime;
+	eStatFree (status);
+
+	MIO *mio = mio_new_file (tagFileName, "rb");
+	if (mio == NULL)
+		error (FATAL | PERROR, "cannot open tag file for updating: %s", tagFileName);
+
+	OldInputFiles = hashTableNew (1021, hashCstrhash, hashCstreq, eFree, eFree);
+	FreshPseudoTags = hashTableNew (61, hashCstrhash, hashCstreq, eFree, NULL);
+
+	vString *vLine = vStringNew ();
+	while (readLineRaw (vLine, mio) != NULL)
+	{
+		const char *line = vStringValue (vLine);
+		const char *input;
+		size_t len;
+
+		if (strncmp (line, PSEUDO_TAG_PREFIX, strlen (PSEUDO_TAG_PREFIX)) == 0)
+			continue;
+
+		input = findInputField (line, &len);
+		if (input == NULL)
+			continue;
+
+		oldInputFile *old = getOldInputFile (input, len);
+		if (!old->hasEpoch)
+			old->hasEpoch = findEpochField (line, input, len, &old->epoch);
+	}
+	vStringDelete (vLine);
+	mio_unref (mio);
+
+	verbose ("updating %s: %u input files recorded\n", tagFileName,
+			 hashTableCountItem (OldInputFiles));
+}
+
+extern bool isInputFileUpToDate (const char *const fileName)
+{
+	if (OldInputFiles == NULL)
+		return false;
+
+	vString *tagPath = makeTagPathOfFile (fileName);
+	oldInputFile *old = hashTableGetItem (OldInputFiles, vStringValue (tagPath));
+	vStringDelete (tagPath);
+
+	if (old == NULL)
+		return false;			/* A new input file */
+
+	fileStatus *status = eStat (fileName);
+	time_t mtime = status->mtime;
+	eStatFree (status);
+
+	bool modified;
+	if (old->hasEpoch)
+		modified = (mtime != old->epoch);
+	else
+		/* Files modified in the same second as the tag file are
+		 * parsed again. */
+		modified = (mtime >= OldTagFileMtime);
+
+	old->state = modified? INPUT_MODIFIED: INPUT_UP_TO_DATE;
+	return !modified;
+}
+
+static void noteFreshPseudoTagName (char *name)
+{
+	if (hashTableHasItem (FreshPseudoTags, name))
+		eFree (name);
+	else
+		hashTablePutItem (FreshPseudoTags, name, name);
+}
+
+extern void noteFreshPseudoTag (const char *const ptagName, const char *const parserName)
+{
+	if (FreshPseudoTags == NULL)
+		return;
+
+	vString *name = vStringNewInit (PSEUDO_TAG_PREFIX);
+	vStringCatS (name, ptagName);
+	if (parserName)
+	{
+		vStringCatS (name, PSEUDO_TAG_SEPARATOR);
+		vStringCatS (name, parserName);
+	}
+	noteFreshPseudoTagName (vStringDeleteUnwrap (name));
+}
+
+extern void noteFreshPseudoTagLine (const char *const line)
+{
+	if (FreshPseudoTags == NULL)
+		return;
+
+	const char *tab = strchr (line, '\t');
+	if (tab == NULL)
+		return;
+	noteFreshPseudoTagName (eStrndup (line, tab - line));
+}
+
+static bool doesInputFileExist (const char *tagPath)
+{
+	if (isAbsolutePath (tagPath) || Option.tagRelative == TREL_NO)
+		return doesFileExist (tagPath);
+
+	/* The path is relative to the directory of the tag file. */
+	char *path = combinePathAndFile (getTagFileDirectory (), tagPath);
+	bool r = doesFileExist (path);
+	eFree (path);
+	return r;
+}
+
+static bool isTagLineKept (char *line)
+{
+	if (strncmp (line, PSEUDO_TAG_PREFIX, strlen (PSEUDO_TAG_PREFIX)) == 0)
+	{
+		char *tab = strchr (line, '\t');
+		if (tab == NULL)
+			return true;
+
+		*tab = '\0';
+		bool fresh = hashTableHasItem (FreshPseudoTags, line);
+		*tab = '\t';
+		return !fresh;
+	}
+
+	size_t len;
+	char *input = (char *) findInputField (line, &len);
+	if (input == NULL)
+		return true;
+
+	input [len] = '\0';
+	oldInputFile *old = hashTableGetItem (OldInputFiles, input);
+	if (old && old->state == INPUT_NOT_VISITED)
+		old->state = doesInputFileExist (input)? INPUT_UP_TO_DATE: INPUT_DELETED;
+	input [len] = '\t';
+
+	return (old == NULL || old->state == INPUT_UP_TO_DATE);
+}
+
+extern char *filterTagFileForUpdate (const char *const tagFileName,
+									 bool *sorted, unsigned long *count)
+{
+	if (OldInputFiles == NULL)
+		return NULL;
+
+	MIO *mio = mio_new_file (tagFileName, "rb");
+	if (mio == NULL)
+		error (FATAL | PERROR, "cannot open tag file for updating: %s", tagFileName);
+
+	char *keptName = NULL;
+	MIO *kept = tempFile ("w+b", &keptName);
+
+	vString *vLine = vStringNew ();
+	vString *prev = vStringNew ();
+	*sorted = true;
+	*count = 0;
+	while (readLineRaw (vLine, mio) != NULL)
+	{
+		vStringStripNewline (vLine);
+		if (vStringLength (vLine) == 0
+			|| !isTagLineKept (vStringValue (vLine)))
+			continue;
+
+#ifndef EXTERNAL_SORT
+		if (*sorted && *count > 0
+			&& compareTagLines (vStringValue (prev), vStringValue (vLine)) > 0)
+			*sorted = false;
+#else
+		*sorted = false;
+#endif
+		vStringCopy (prev, vLine);
+
+		mio_puts (kept, vStringValue (vLine));
+		mio_putc (kept, '\n');
+		(*count)++;
+	}
+	vStringDelete (prev);
+	vStringDelete (vLine);
+	mio_unref (mio);
+
+	if (mio_unref (kept) != 0)
+		error (FATAL | PERROR, "cannot write temporary file: %s", keptName);
+
+	verbose ("updating %s: %lu tags kept\n", tagFileName, *count);
+
+	hashTableDelete (OldInputFiles);
+	OldInputFiles = NULL;
+	hashTableDelete (FreshPseudoTags);
+	FreshPseudoTags = NULL;
+
+	return keptName;
+}
@@ -0,0 +1,39 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Defines internal interface to update an existing tag file (--update).
+*/
+#ifndef CTAGS_MAIN_UPDATE_PRIVATE_H
+#define CTAGS_MAIN_UPDATE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Collect the input files recorded in the tag file. */
+extern void loadTagFileForUpdate (const char *const tagFileName);
+
+/* Return true if the tags of FILENAME in the tag file can be reused.
+ * Otherwise, the file must be parsed, and its old tags are dropped. */
+extern bool isInputFileUpToDate (const char *const fileName);
+
+/* Record the pseudo tags written in this run. Old ones having the same
+ * names are dropped. */
+extern void noteFreshPseudoTag (const char *const ptagName, const char *const parserName);
+extern void noteFreshPseudoTagLine (const char *const line);
+
+/* Write the lines of the old tag file to be kept to a temporary file,
+ * and return its name. *SORTED is set to true if the lines are in the
+ * order specified with --sort option. */
+extern char *filterTagFileForUpdate (const char *const tagFileName,
+									 bool *sorted, unsigned long *count);
+
+#endif  /* CTAGS_MAIN_UPDATE_PRIVATE_H */
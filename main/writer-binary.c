@@ -0,0 +1,681 @@
+/*
+*   Copyright (c) 2026, Universal Ctags Team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   This module contains functions for converting a tag file to the binary
+*   format (--output-format=binary).
+*
+*   The tags are written in u-ctags format first, so sorting, parallel
+*   jobs, and the tag cache work as they do for u-ctags output. After the
+*   tag file is closed, its lines are decoded as libreadtags decodes them,
+*   and written again in columns. libreadtags returns the entries of a
+*   binary tag file without parsing nor unescaping anything; the strings
+*   of an entry point into the string pool of the file.
+*
+*   All integers are little endian:
+*
+*     offset  size  field
+*          0     8  magic "CTAGSBIN"
+*          8     4  version (1)
+*         12     4  number of rows (N), including pseudo tags
+*         16     4  number of interned strings (S)
+*         20     4  reserved
+*         24     8  offset of the string pool
+*         32     8  size of the string pool
+*         40     8  offset of the string table
+*         48     8  offset of the name column
+*         56     8  offset of the pattern column
+*         64     8  offset of the file column
+*         72     8  offset of the record column
+*         80     8  offset of the record data
+*         88     8  size of the record data
+*
+*   - string pool: null terminated strings; each string is stored once.
+*   - string table: 4*S offsets of the interned strings in the pool.
+*   - name column: 4*N offsets of the names in the pool.
+*   - pattern column: 4*N offsets of the patterns in the pool, or
+*     0xffffffff for a row having no pattern.
+*   - file column: 4*N string ids of the input files, or 0xffffffff.
+*   - record column: 4*(N+1) offsets of the records in the record data.
+*   - record data: for each row, the line number, the kind (string id + 1,
+*     or 0 if the row has no kind), the file scope flag, the number of
+*     fields, and the string ids of the key and the value of each field.
+*     All of them are unsigned LEB128 numbers.
+*
+*   The rows are in the order of the lines in the tag file, so a sorted
+*   tag file is sorted in the binary format too.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "htable.h"
+#include "mio.h"
+#include "options.h"
+#include "read_p.h"
+#include "routines.h"
+#include "vstring.h"
+#include "writer_p.h"
+
+/*
+*   MACROS
+*/
+#define BINARY_MAGIC "CTAGSBIN"
+#define BINARY_MAGIC_LENGTH 8
+#define BINARY_VERSION 1
+#define BINARY_HEADER_SIZE 96
+#define BINARY_NONE 0xffffffffU
+
+#define PSEUDO_PREFIX "!_"
+
+/*
+*   DATA DECLARATIONS
+*/
+struct binaryField {
+	const char *key;
+	const char *value;
+};
+
+/* A line decoded as parseTagLine() of libreadtags decodes it */
+struct binaryEntry {
+	const char *name;
+	const char *file;
+	const char *pattern;
+	unsigned long lineNumber;
+	const char *kind;
+	bool fileScope;
+	struct binaryField *fields;
+	unsigned int fieldCount;
+	unsigned int fieldMax;
+};
+
+struct binaryBuilder {
+	hashTable *ids;				/* string -> id + 1 */
+	MIO *pool;
+	uint32_t *strings;			/* id -> offset in pool */
+	uint32_t stringCount;
+	uint32_t stringMax;
+
+	uint32_t *names;
+	uint32_t *patterns;
+	uint32_t *files;
+	uint32_t *records;
+	uint32_t rowCount;
+	uint32_t rowMax;
+	MIO *data;
+
+	bool uctagsMode;
+	bool overflow;
+	vString *line;
+	struct binaryEntry entry;
+};
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+static int writeBinaryEntry (tagWriter *writer, MIO * mio,
+							 const tagEntryInfo *const tag,
+							 void *clientData);
+static int writeBinaryPtagEntry (tagWriter *writer, MIO * mio,
+								 const ptagDesc *desc,
+								 const char *const fileName,
+								 const char *const pattern,
+								 const char *const parserName,
+								 void *clientData);
+static bool treatFieldAsFixed (int fieldType);
+static void checkBinaryOptions (tagWriter *writer, bool fieldsWereReset);
+static void writeBinaryTagFile (tagWriter *writer, const char *const tagFileName);
+#ifdef _WIN32
+static enum filenameSepOp overrideFilenameSeparator (enum filenameSepOp currentSetting);
+#endif	/* _WIN32 */
+
+/*
+*   DATA DEFINITIONS
+*/
+extern tagWriter uCtagsWriter;
+
+/* The tags are written with the callbacks of uCtagsWriter, and converted
+ * to the binary format after the tag file is closed. */
+tagWriter binaryWriter = {
+	.oformat = "binary",
+	.writeEntry = writeBinaryEntry,
+	.writePtagEntry = writeBinaryPtagEntry,
+	.printPtagByDefault = true,
+	.preWriteEntry = NULL,
+	.postWriteEntry = NULL,
+	.rescanFailedEntry = NULL,
+	.treatFieldAsFixed = treatFieldAsFixed,
+	.checkOptions = checkBinaryOptions,
+	.postWriteTagFile = writeBinaryTagFile,
+	.canPrintNullTag = false,
+#ifdef _WIN32
+	.overrideFilenameSeparator = overrideFilenameSeparator,
+#endif
+	.defaultFileName = "tags",
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static int writeBinaryEntry (tagWriter *writer, MIO * mio,
+							 const tagEntryInfo *const tag,
+							 void *clientData)
+{
+	return uCtagsWriter.writeEntry (writer, mio, tag, clientData);
+}
+
+static int writeBinaryPtagEntry (tagWriter *writer, MIO * mio,
+								 const ptagDesc *desc,
+								 const char *const fileName,
+								 const char *const pattern,
+								 const char *const parserName,
+								 void *clientData)
+{
+	return uCtagsWriter.writePtagEntry (writer, mio, desc,
+										fileName, pattern, parserName,
+										clientData);
+}
+
+static bool treatFieldAsFixed (int fieldType)
+{
+	return uCtagsWriter.treatFieldAsFixed (fieldType);
+}
+
+static void checkBinaryOptions (tagWriter *writer, bool fieldsWereReset)
+{
+	uCtagsWriter.checkOptions (writer, fieldsWereReset);
+}
+
+#ifdef _WIN32
+static enum filenameSepOp overrideFilenameSeparator (enum filenameSepOp currentSetting)
+{
+	return uCtagsWriter.overrideFilenameSeparator (currentSetting);
+}
+#endif
+
+
+extern bool isBinaryTagFileHeader (const char *const line)
+{
+	return strncmp (line, BINARY_MAGIC, BINARY_MAGIC_LENGTH) == 0;
+}
+
+static int xdigitValue (unsigned char digit)
+{
+	if (digit >= '0' && digit <= '9')
+		return digit - '0';
+	else if (digit >= 'a' && digit <= 'f')
+		return 10 + digit - 'a';
+	else
+		return 10 + digit - 'A';
+}
+
+/* Unescape the string in place as readTagCharacter() of libreadtags
+ * does. An escaped null character terminates the string. */
+static void unescapeInPlace (char *s)
+{
+	char *out = s;
+
+	while (*s != '\0')
+	{
+		int c = (unsigned char) *s++;
+
+		if (c == '\\')
+		{
+			switch (*s)
+			{
+			case 't': c = '\t'; s++; break;
+			case 'r': c = '\r'; s++; break;
+			case 'n': c = '\n'; s++; break;
+			case '\\': c = '\\'; s++; break;
+			case 'a': c = '\a'; s++; break;
+			case 'b': c = '\b'; s++; break;
+			case 'v': c = '\v'; s++; break;
+			case 'f': c = '\f'; s++; break;
+			case 'x':
+				if (isxdigit ((unsigned char) s[1]) && isxdigit ((unsigned char) s[2]))
+				{
+					int val = (xdigitValue (s[1]) << 4) | xdigitValue (s[2]);
+					if (val < 0x80)
+					{
+						s += 3;
+						c = val;
+					}
+				}
+				break;
+			}
+		}
+		*out++ = (char) c;
+		if (c == '\0')
+			return;
+	}
+	*out = '\0';
+}
+
+/* Return the end of the pattern starting at p, or NULL if the pattern
+ * is not terminated. */
+static char *skipPattern (char *p, const char *const start)
+{
+	const int delimiter = (unsigned char) *p;
+
+	do
+	{
+		unsigned int backslashes = 0;
+
+		p = strchr (p + 1, delimiter);
+		if (p == NULL)
+			return NULL;
+		for (const char *q = p - 1; q > start && *q == '\\'; q--)
+			backslashes++;
+		if (backslashes % 2 == 0)
+			break;
+	} while (true);
+
+	return p + 1;
+}
+
+static void addField (struct binaryEntry *entry, const char *key, const char *value)
+{
+	if (entry->fieldCount == entry->fieldMax)
+	{
+		entry->fieldMax = entry->fieldMax? entry->fieldMax * 2: 8;
+		entry->fields = xRealloc (entry->fields, entry->fieldMax, struct binaryField);
+	}
+	entry->fields [entry->fieldCount].key = key;
+	entry->fields [entry->fieldCount].value = value;
+	entry->fieldCount++;
+}
+
+static void parseFields (struct binaryEntry *entry, char *p)
+{
+	while (p != NULL && *p != '\0')
+	{
+		while (*p == '\t')
+			*p++ = '\0';
+		if (*p == '\0')
+			break;
+
+		char *field = p;
+		p = strchr (p, '\t');
+		if (p != NULL)
+			*p++ = '\0';
+
+		char *colon = strchr (field, ':');
+		if (colon == NULL)
+		{
+			entry->kind = field;
+			continue;
+		}
+
+		*colon = '\0';
+		char *value = colon + 1;
+		unescapeInPlace (value);
+
+		if (strcmp (field, "kind") == 0)
+			entry->kind = value;
+		else if (strcmp (field, "file") == 0)
+			entry->fileScope = true;
+		else
+		{
+			char *endptr = NULL;
+			long m;
+
+			if (strcmp (field, "line") == 0
+				&& (m = strtol (value, &endptr, 10), *endptr == '\0' && m >= 0))
+				entry->lineNumber = (unsigned long) m;
+			else
+				addField (entry, field, value);
+		}
+	}
+}
+
+static void parseLine (struct binaryEntry *entry, char *line, bool uctagsMode)
+{
+	char *tab = strchr (line, '\t');
+
+	entry->name = line;
+	entry->file = NULL;
+	entry->pattern = NULL;
+	entry->lineNumber = 0;
+	entry->kind = NULL;
+	entry->fileScope = false;
+	entry->fieldCount = 0;
+
+	if (tab != NULL)
+		*tab = '\0';
+	unescapeInPlace (line);
+	if (tab == NULL)
+		return;
+
+	char *p = tab + 1;
+	entry->file = p;
+	tab = strchr (p, '\t');
+	if (tab != NULL)
+		*tab = '\0';
+	if (uctagsMode)
+		unescapeInPlace (p);
+	if (tab == NULL)
+		return;
+
+	p = tab + 1;
+	if (*p == '/' || *p == '?')
+	{
+		entry->pattern = p;
+		p = skipPattern (p, entry->pattern);
+	}
+	else if (isdigit ((unsigned char) *p))
+	{
+		entry->pattern = p;
+		entry->lineNumber = strtoul (p, NULL, 10);
+		while (isdigit ((unsigned char) *p))
+			++p;
+		if (strncmp (p, ";/", 2) == 0 || strncmp (p, ";?", 2) == 0)
+			p = skipPattern (p + 1, entry->pattern);
+	}
+
+	if (p != NULL)
+	{
+		bool fieldsPresent = (strncmp (p, ";\"", 2) == 0);
+		*p = '\0';
+		if (fieldsPresent)
+			parseFields (entry, p + 2);
+	}
+}
+
+static const char *nextLine (vString *vline, const unsigned char **data,
+							 const unsigned char *const end)
+{
+	const unsigned char *start = *data;
+	const unsigned char *nl;
+	size_t length;
+
+	if (start >= end)
+		return NULL;
+
+	nl = memchr (start, '\n', end - start);
+	length = (nl? nl: end) - start;
+	*data = nl? nl + 1: end;
+
+	while (length > 0 && start [length - 1] == '\r')
+		length--;
+	vStringNCopyS (vline, (const char *) start, length);
+	return vStringValue (vline);
+}
+
+/* libreadtags unescapes the input file field only if the pseudo tags
+ * tell the tag file is written in u-ctags format with slashes as the
+ * file name separator. */
+static bool isUctagsMode (struct binaryBuilder *builder,
+						  const unsigned char *data, const unsigned char *const end)
+{
+	bool mode = false, slash = false;
+
+	while (nextLine (builder->line, &data, end)
+		   && strncmp (vStringValue (builder->line), PSEUDO_PREFIX,
+					   strlen (PSEUDO_PREFIX)) == 0)
+	{
+		struct binaryEntry *entry = &builder->entry;
+
+		parseLine (entry, vStringValue (builder->line), false);
+		if (entry->file == NULL)
+			continue;
+		if (strcmp (entry->name, "!_TAG_OUTPUT_MODE") == 0
+			&& strcmp (entry->file, "u-ctags") == 0)
+			mode = true;
+		else if (strcmp (entry->name, "!_TAG_OUTPUT_FILESEP") == 0
+				 && strcmp (entry->file, "slash") == 0)
+			slash = true;
+	}
+	return mode && slash;
+}
+
+static uint32_t internString (struct binaryBuilder *builder, const char *s)
+{
+	void *v = hashTableGetItem (builder->ids, s);
+	if (v)
+		return HT_PTR_TO_UINT (v) - 1;
+
+	long offset = mio_tell (builder->pool);
+	if (offset < 0 || (unsigned long) offset >= BINARY_NONE
+		|| builder->stringCount == BINARY_NONE - 1)
+	{
+		builder->overflow = true;
+		return 0;
+	}
+
+	if (builder->stringCount == builder->stringMax)
+	{
+		builder->stringMax = builder->stringMax? builder->stringMax * 2: 1024;
+		builder->strings = xRealloc (builder->strings, builder->stringMax, uint32_t);
+	}
+	builder->strings [builder->stringCount] = (uint32_t) offset;
+	mio_write (builder->pool, s, 1, strlen (s) + 1);
+	hashTablePutItem (builder->ids, eStrdup (s),
+					  HT_UINT_TO_PTR (builder->stringCount + 1));
+	return builder->stringCount++;
+}
+
+static uint32_t poolOffset (struct binaryBuilder *builder, const char *s)
+{
+	if (s == NULL)
+		return BINARY_NONE;
+
+	uint32_t id = internString (builder, s);
+	return builder->strings [id];
+}
+
+static void putVarint (MIO *mio, uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		mio_putc (mio, (int) ((v & 0x7f) | 0x80));
+		v >>= 7;
+	}
+	mio_putc (mio, (int) v);
+}
+
+static void addRow (struct binaryBuilder *builder, const struct binaryEntry *entry)
+{
+	if (builder->rowCount == builder->rowMax)
+	{
+		builder->rowMax = builder->rowMax? builder->rowMax * 2: 1024;
+		builder->names = xRealloc (builder->names, builder->rowMax, uint32_t);
+		builder->patterns = xRealloc (builder->patterns, builder->rowMax, uint32_t);
+		builder->files = xRealloc (builder->files, builder->rowMax, uint32_t);
+		builder->records = xRealloc (builder->records, builder->rowMax + 1, uint32_t);
+	}
+
+	long offset = mio_tell (builder->data);
+	if (offset < 0 || (unsigned long) offset >= BINARY_NONE)
+	{
+		builder->overflow = true;
+		return;
+	}
+
+	uint32_t row = builder->rowCount++;
+	builder->names [row] = poolOffset (builder, entry->name);
+	builder->patterns [row] = poolOffset (builder, entry->pattern);
+	builder->files [row] = entry->file? internString (builder, entry->file): BINARY_NONE;
+	builder->records [row] = (uint32_t) offset;
+
+	putVarint (builder->data, entry->lineNumber);
+	putVarint (builder->data, entry->kind? internString (builder, entry->kind) + 1: 0);
+	putVarint (builder->data, entry->fileScope? 1: 0);
+	putVarint (builder->data, entry->fieldCount);
+	for (unsigned int i = 0; i < entry->fieldCount; i++)
+	{
+		putVarint (builder->data, internString (builder, entry->fields [i].key));
+		putVarint (builder->data, internString (builder, entry->fields [i].value));
+	}
+}
+
+static void putU32 (MIO *mio, uint32_t v)
+{
+	unsigned char b [4];
+
+	for (int i = 0; i < 4; i++)
+		b [i] = (unsigned char) (v >> (8 * i));
+	mio_write (mio, b, 1, 4);
+}
+
+static void putU64 (MIO *mio, uint64_t v)
+{
+	unsigned char b [8];
+
+	for (int i = 0; i < 8; i++)
+		b [i] = (unsigned char) (v >> (8 * i));
+	mio_write (mio, b, 1, 8);
+}
+
+static void putU32Array (MIO *mio, const uint32_t *a, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		putU32 (mio, a [i]);
+}
+
+static bool writeBinaryFile (const char *const fileName, struct binaryBuilder *builder)
+{
+	size_t poolSize, dataSize;
+	unsigned char *pool = mio_memory_get_data (builder->pool, &poolSize);
+	unsigned char *data = mio_memory_get_data (builder->data, &dataSize);
+	const uint64_t poolOffset = BINARY_HEADER_SIZE;
+	const uint64_t stringsOffset = poolOffset + poolSize;
+	const uint64_t namesOffset = stringsOffset + 4 * (uint64_t) builder->stringCount;
+	const uint64_t patternsOffset = namesOffset + 4 * (uint64_t) builder->rowCount;
+	const uint64_t filesOffset = patternsOffset + 4 * (uint64_t) builder->rowCount;
+	const uint64_t recordsOffset = filesOffset + 4 * (uint64_t) builder->rowCount;
+	const uint64_t dataOffset = recordsOffset + 4 * ((uint64_t) builder->rowCount + 1);
+
+	MIO *mio = mio_new_file (fileName, "wb");
+	if (mio == NULL)
+		return false;
+
+	mio_write (mio, BINARY_MAGIC, 1, BINARY_MAGIC_LENGTH);
+	putU32 (mio, BINARY_VERSION);
+	putU32 (mio, builder->rowCount);
+	putU32 (mio, builder->stringCount);
+	putU32 (mio, 0);
+	putU64 (mio, poolOffset);
+	putU64 (mio, (uint64_t) poolSize);
+	putU64 (mio, stringsOffset);
+	putU64 (mio, namesOffset);
+	putU64 (mio, patternsOffset);
+	putU64 (mio, filesOffset);
+	putU64 (mio, recordsOffset);
+	putU64 (mio, dataOffset);
+	putU64 (mio, (uint64_t) dataSize);
+
+	mio_write (mio, pool, 1, poolSize);
+	putU32Array (mio, builder->strings, builder->stringCount);
+	putU32Array (mio, builder->names, builder->rowCount);
+	putU32Array (mio, builder->patterns, builder->rowCount);
+	putU32Array (mio, builder->files, builder->rowCount);
+	putU32Array (mio, builder->records, builder->rowCount);
+	putU32 (mio, (uint32_t) dataSize);
+	mio_write (mio, data, 1, dataSize);
+
+	bool r = (mio_error (mio) == 0);
+	if (mio_unref (mio) != 0)
+		r = false;
+	return r;
+}
+
+static bool buildBinaryTagFile (struct binaryBuilder *builder,
+								const unsigned char *data, size_t size)
+{
+	const unsigned char *const end = data + size;
+	uint32_t lineCount = 0;
+
+	for (const unsigned char *p = data; p < end; p++)
+		if (*p == '\n')
+			lineCount++;
+
+	builder->ids = hashTableNew (lineCount | 1, hashCstrhash, hashCstreq, eFree, NULL);
+	builder->uctagsMode = isUctagsMode (builder, data, end);
+
+	while (nextLine (builder->line, &data, end))
+	{
+		char *line = vStringValue (builder->line);
+
+		/* libreadtags reads a line till a null character, and skips
+		 * lines having empty names. */
+		if (vStringLength (builder->line) != strlen (line))
+			vStringTruncate (builder->line, strlen (line));
+		if (line [0] == '\0' || line [0] == '\t')
+			continue;
+
+		parseLine (&builder->entry, line, builder->uctagsMode);
+		addRow (builder, &builder->entry);
+		if (builder->overflow)
+			return false;
+	}
+	return true;
+}
+
+static void writeBinaryTagFile (tagWriter *writer CTAGS_ATTR_UNUSED,
+								const char *const tagFileName)
+{
+	struct binaryBuilder builder = {
+		.ids = NULL,
+		.strings = NULL,
+		.names = NULL,
+		.patterns = NULL,
+		.files = NULL,
+		.records = NULL,
+	};
+	vString *tmpName = vStringNewInit (tagFileName);
+	const unsigned char *data;
+	size_t size;
+	MIO *mio;
+
+	vStringCatS (tmpName, ".tmp");
+	verbose ("converting %s to the binary format\n", tagFileName);
+
+	builder.pool = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
+	builder.data = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
+	builder.line = vStringNew ();
+
+	mio = getMio (tagFileName, "rb", true);
+	if (mio == NULL)
+		error (FATAL | PERROR, "cannot read %s for converting it to the binary format",
+			   tagFileName);
+	data = mio_memory_get_data (mio, &size);
+
+	if (!buildBinaryTagFile (&builder, data, size))
+		error (FATAL, "too many tags in %s for the binary format", tagFileName);
+
+	if (!writeBinaryFile (vStringValue (tmpName), &builder))
+	{
+		remove (vStringValue (tmpName));
+		error (FATAL | PERROR, "cannot write %s", vStringValue (tmpName));
+	}
+	mio_unref (mio);
+
+	/* rename () fails on Windows if the file exists. */
+	remove (tagFileName);
+	if (rename (vStringValue (tmpName), tagFileName) != 0)
+		error (FATAL | PERROR, "cannot rename %s to %s", vStringValue (tmpName), tagFileName);
+
+	eFreeNoNullCheck (builder.entry.fields);
+	vStringDelete (builder.line);
+	eFreeNoNullCheck (builder.records);
+	eFreeNoNullCheck (builder.files);
+	eFreeNoNullCheck (builder.patterns);
+	eFreeNoNullCheck (builder.names);
+	eFreeNoNullCheck (builder.strings);
+	mio_unref (builder.data);
+	mio_unref (builder.pool);
+	hashTableDelete (builder.ids);
+	vStringDelete (tmpName);
+}
@@ -423,7 +423,7 @@ static int writeCtagsPtagEntry (tagWriter *writer,
 	 */
 
 	vString *vfileName = vStringNew ();
-	if (writer->type == WRITER_U_CTAGS
+	if ((writer->type == WRITER_U_CTAGS || writer->type == WRITER_BINARY)
 #ifdef _WIN32
 		&& getFilenameSeparator(Option.useSlashAsFilenameSeparator) == FILENAME_SEP_USE_SLASH
 #endif
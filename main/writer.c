@@ -22,6 +22,7 @@ extern tagWriter eCtagsWriter;
 extern tagWriter etagsWriter;
 extern tagWriter xrefWriter;
 extern tagWriter jsonWriter;
+extern tagWriter binaryWriter;
 
 static tagWriter *writerTable [WRITER_COUNT] = {
 	[WRITER_U_CTAGS] = &uCtagsWriter,
@@ -29,6 +30,7 @@ static tagWriter *writerTable [WRITER_COUNT] = {
 	[WRITER_ETAGS] = &etagsWriter,
 	[WRITER_XREF]  = &xrefWriter,
 	[WRITER_JSON]  = &jsonWriter,
+	[WRITER_BINARY] = &binaryWriter,
 	[WRITER_CUSTOM] = NULL,
 };
 
@@ -99,7 +101,7 @@ extern bool ptagMakeCtagsOutputMode (ptagDesc *desc, langType langType CTAGS_ATT
 {
 	const char *mode ="";
 
-	if (&uCtagsWriter == writer)
+	if (&uCtagsWriter == writer || &binaryWriter == writer)
 		mode = "u-ctags";
 	else if (&eCtagsWriter == writer)
 		mode = "e-ctags";
@@ -124,6 +126,17 @@ extern bool writerCanPrintNullTag (void)
 {
 	return writer->canPrintNullTag;
 }
+
+extern bool writerWritesCtagsFormat (void)
+{
+	return (writer->type == WRITER_U_CTAGS || writer->type == WRITER_E_CTAGS
+			|| writer->type == WRITER_BINARY);
+}
+
+extern bool writerWritesBinaryFormat (void)
+{
+	return (writer->type == WRITER_BINARY);
+}
 extern bool writerDoesTreatFieldAsFixed (int fieldType)
 {
 	if (writer->treatFieldAsFixed)
@@ -190,6 +203,12 @@ extern void writerCheckOptions (bool fieldsWereReset)
 		writer->checkOptions (writer, fieldsWereReset);
 }
 
+extern void writerPostWriteTagFile (const char *tagFileName)
+{
+	if (writer->postWriteTagFile)
+		writer->postWriteTagFile (writer, tagFileName);
+}
+
 extern bool writerPrintPtagByDefault (void)
 {
 	return writer->printPtagByDefault;
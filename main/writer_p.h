@@ -28,6 +28,7 @@ typedef enum eWriterType {
 	WRITER_ETAGS,
 	WRITER_XREF,
 	WRITER_JSON,
+	WRITER_BINARY,
 	WRITER_CUSTOM,
 	WRITER_COUNT,
 } writerType;
@@ -58,6 +59,9 @@ struct sTagWriter {
 
 	void (* checkOptions) (tagWriter *writer, bool fieldsWereReset);
 
+	/* Called after the tag file is closed. */
+	void (* postWriteTagFile) (tagWriter *writer, const char *tagFileName);
+
 	bool canPrintNullTag;
 
 #ifdef _WIN32
@@ -95,6 +99,9 @@ extern size_t truncateTagLineAfterTag (char *const line, const char *const token
 			     const bool discardNewline);
 extern void abort_if_ferror(MIO *const fp);
 
+/* writer-binary.c */
+extern bool isBinaryTagFileHeader (const char *const line);
+
 extern bool ptagMakeJsonOutputVersion (ptagDesc *desc, langType language CTAGS_ATTR_UNUSED, const void *data CTAGS_ATTR_UNUSED);
 extern bool ptagMakeCtagsOutputMode (ptagDesc *desc, langType language CTAGS_ATTR_UNUSED, const void *data CTAGS_ATTR_UNUSED);
 extern bool ptagMakeCtagsOutputFilesep (ptagDesc *desc, langType language CTAGS_ATTR_UNUSED, const void *data);
@@ -102,11 +109,15 @@ extern bool ptagMakeCtagsOutputExcmd (ptagDesc *desc, langType language CTAGS_AT
 
 extern bool writerCanPrintPtag (void);
 extern bool writerCanPrintNullTag (void);
+extern bool writerWritesCtagsFormat (void);
+extern bool writerWritesBinaryFormat (void);
 extern bool writerDoesTreatFieldAsFixed (int fieldType);
 
 extern void writerCheckOptions (bool fieldsWereReset);
 extern bool writerPrintPtagByDefault (void);
 
+extern void writerPostWriteTagFile (const char *tagFileName);
+
 extern writerType getWrierForOutputFormat (const char *oformat);
 extern void printOutputFormats (bool withListHeader, bool machinable, FILE *fp);
 
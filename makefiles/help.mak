@@ -26,6 +26,7 @@ help:
 	@echo "make chop                         - Verify the behavior of parsers for broken input: randomly truncated from tail"
 	@echo "make slap                         - Verify the behavior of parsers for broken input: randomly truncated from head"
 	@echo "make roundtrip                    - Verify the behavior of readtags command"
+	@echo "make htable-bench                 - Build a micro-benchmark of the hash table"
 	@echo
 	@echo "Arguments that can be used in testing targets:"
 	@echo
@@ -0,0 +1,3 @@
+def e():
+ pass
+class F: pass
@@ -765,6 +765,84 @@ static int cppGetcFromUngetBufferOrFile(void)
 	return getcFromInputFile();
 }
 
+/*  Returns the characters of the current input line which
+ *  cppGetcFromUngetBufferOrFile () returns next, or NULL if they are not
+ *  read from the input file directly. Runs of characters that need no
+ *  special handling can be scanned in them and read at once with
+ *  skipLineCharsInInputFile ().
+ */
+static const unsigned char *cppPeekLine (void)
+{
+	if (Cpp.ungetBuffer || Cpp.macroInUse)
+		return NULL;
+	return peekLineFromInputFile ();
+}
+
+/*  Reads the next character if it is "c". Returns whether it was read.
+ */
+static bool cppGetcIf (int c)
+{
+	const unsigned char *line = cppPeekLine ();
+	int next;
+
+	if (line && *line != '\0')
+	{
+		if (*line != c)
+			return false;
+		skipLineCharsInInputFile (1);
+		return true;
+	}
+
+	next = cppGetcFromUngetBufferOrFile ();
+	if (next == c)
+		return true;
+	cppUngetc (next);
+	return false;
+}
+
+/*  Reads at once the identifier characters following the character last
+ *  returned by cppGetc () in the current input line. The characters which
+ *  cppGetc () may not return as they are, like the beginning of a raw string
+ *  literal or a digit followed by a digit separator, are not read.
+ *  Returns the number of characters read, and sets "chars" to them. They
+ *  are valid until the next call of cppGetc ().
+ *
+ *  Calling this instead of calling cppGetc () for each character of
+ *  an identifier is optional.
+ */
+extern size_t cppReadIdentifierChars (const unsigned char **chars)
+{
+	const unsigned char *line = cppPeekLine ();
+	size_t n = 0;
+
+	if (line == NULL)
+		return 0;
+
+	while (cppIsident (line [n]))
+	{
+		if (line [n + 1] == SINGLE_QUOTE ||
+			(line [n] == 'R' && line [n + 1] == DOUBLE_QUOTE))
+			break;
+		n++;
+	}
+
+	skipLineCharsInInputFile (n);
+	*chars = line;
+	return n;
+}
+
+/*  Reads at once the spaces and tabs following the character last returned
+ *  by cppGetc () in the current input line. cppGetc () returns them as they
+ *  are outside directives.
+ */
+extern void cppSkipSpaces (void)
+{
+	const unsigned char *line = cppPeekLine ();
+
+	if (line)
+		skipLineCharsInInputFile (strspn ((const char *) line, " \t"));
+}
+
 extern unsigned long cppGetInputLineNumber (void)
 {
 	if (Cpp.ungetBuffer)
@@ -1439,19 +1517,15 @@ static bool handleDirective (const int c, int *macroCorkIndex, bool *inspect_con
 static Comment isComment (void)
 {
 	Comment comment;
-	const int next = cppGetcFromUngetBufferOrFile ();
 
-	if (next == '*')
+	if (cppGetcIf ('*'))
 		comment = COMMENT_C;
-	else if (next == '/')
+	else if (cppGetcIf ('/'))
 		comment = COMMENT_CPLUS;
-	else if (next == '+')
+	else if (cppGetcIf ('+'))
 		comment = COMMENT_D;
 	else
-	{
-		cppUngetc (next);
 		comment = COMMENT_NONE;
-	}
 	return comment;
 }
 
@@ -1465,7 +1539,13 @@ static int cppSkipOverCComment (void)
 	while (c != EOF)
 	{
 		if (c != '*')
+		{
+			const unsigned char *line = cppPeekLine ();
+
+			if (line)
+				skipLineCharsInInputFile (strcspn ((const char *) line, "*"));
 			c = cppGetcFromUngetBufferOrFile ();
+		}
 		else
 		{
 			const int next = cppGetcFromUngetBufferOrFile ();
@@ -1494,6 +1574,13 @@ static int skipOverCplusComment (void)
 			cppGetcFromUngetBufferOrFile ();  /* throw away next character, too */
 		else if (c == NEWLINE)
 			break;
+		else
+		{
+			const unsigned char *line = cppPeekLine ();
+
+			if (line)
+				skipLineCharsInInputFile (strcspn ((const char *) line, "\\\n"));
+		}
 	}
 	return c;
 }
@@ -1561,7 +1648,21 @@ static int skipToEndOfString (bool ignoreBackslash)
 		else if (c == DOUBLE_QUOTE)
 			break;
 		else
+		{
 			(void)vStringPutWithLimit (Cpp.charOrStringContents, c, 1024);
+
+			const unsigned char *line = cppPeekLine ();
+			if (line)
+			{
+				size_t n = strcspn ((const char *) line,
+									ignoreBackslash? "\"": "\\\"");
+				size_t room = 1024 - vStringLength (Cpp.charOrStringContents);
+
+				vStringNCatSUnsafe (Cpp.charOrStringContents,
+									(const char *) line, n < room? n: room);
+				skipLineCharsInInputFile (n);
+			}
+		}
 	}
 	return STRING_SYMBOL;  /* symbolic representation of string */
 }
@@ -1894,13 +1995,10 @@ process:
 			{
 				condition = conditionMayFlush(condition, false);
 
-				int next = cppGetcFromUngetBufferOrFile ();
-
-				if (next == NEWLINE)
+				if (cppGetcIf (NEWLINE))
 					goto start_loop;
 				else
 				{
-					cppUngetc (next);
 					if (macrodef)
 						vStringPut (macrodef, '\\');
 				}
@@ -1911,16 +2009,14 @@ process:
 			{
 				condition = conditionMayFlush(condition, false);
 
-				int next = cppGetcFromUngetBufferOrFile ();
-				if (next != '?')
+				if (! cppGetcIf ('?'))
 				{
-					cppUngetc (next);
 					if (macrodef)
 						vStringPut (macrodef, '?');
 				}
 				else
 				{
-					next = cppGetcFromUngetBufferOrFile ();
+					int next = cppGetcFromUngetBufferOrFile ();
 					switch (next)
 					{
 						case '(':          c = '[';       break;
@@ -1958,37 +2054,35 @@ process:
 				   treated as a preprocessor token by itself (and not as
 				   the first character of the alternative token */
 				int next[3];
-				next[0] = cppGetcFromUngetBufferOrFile ();
-				switch (next[0])
+				if (cppGetcIf (':'))
 				{
-					case ':':
-						next[1] = cppGetcFromUngetBufferOrFile ();
-						if (next[1] == ':')
+					next[0] = ':';
+					next[1] = cppGetcFromUngetBufferOrFile ();
+					if (next[1] == ':')
+					{
+						next[2] = cppGetcFromUngetBufferOrFile ();
+						if (! (next[2] == ':' || next[2] == '>'))
 						{
-							next[2] = cppGetcFromUngetBufferOrFile ();
-							if (! (next[2] == ':' || next[2] == '>'))
-							{
-								cppUngetc (next[2]);
-								cppUngetc (next[1]);
-								cppUngetc (next[0]);
-								c = '<';
-							}
-							else
-							{
-								cppUngetc (next[2]);
-								cppUngetc (next[1]);
-								c = '[';
-							}
+							cppUngetc (next[2]);
+							cppUngetc (next[1]);
+							cppUngetc (next[0]);
+							c = '<';
 						}
 						else
 						{
+							cppUngetc (next[2]);
 							cppUngetc (next[1]);
 							c = '[';
 						}
-						break;
-					case '%':	c = '{'; break;
-					default: cppUngetc (next[0]);
+					}
+					else
+					{
+						cppUngetc (next[1]);
+						c = '[';
+					}
 				}
+				else if (cppGetcIf ('%'))
+					c = '{';
 
 				if (macrodef)
 					vStringPut (macrodef, c);
@@ -1999,11 +2093,8 @@ process:
 			{
 				condition = conditionMayFlush(condition, false);
 
-				int next = cppGetcFromUngetBufferOrFile ();
-				if (next == '>')
+				if (cppGetcIf ('>'))
 					c = ']';
-				else
-					cppUngetc (next);
 
 				if (macrodef)
 					vStringPut (macrodef, c);
@@ -2014,12 +2105,12 @@ process:
 			{
 				condition = conditionMayFlush(condition, false);
 
-				int next = cppGetcFromUngetBufferOrFile ();
-				switch (next)
+				if (cppGetcIf ('>'))
+					c = '}';
+				else if (cppGetcIf (':'))
 				{
-					case '>':	c = '}'; break;
-					case ':':	c = '#'; goto process;
-					default: cppUngetc (next);
+					c = '#';
+					goto process;
 				}
 
 				if (macrodef)
@@ -2107,9 +2198,7 @@ process:
 				else if(isxdigit(c))
 				{
 					/* Check for digit separator. If we find it we just skip it */
-					int next = cppGetcFromUngetBufferOrFile();
-					if(next != SINGLE_QUOTE)
-						cppUngetc(next);
+					cppGetcIf (SINGLE_QUOTE);
 					if (macrodef)
 						vStringPut (macrodef, c);
 					conditionMayPut(condition, c);
@@ -2240,6 +2329,15 @@ extern cppMacroInfo * cppFindMacro (const char *const name)
 	return NULL;
 }
 
+/*  Determines whether or not cppFindMacro() may find a macro while
+ *  parsing the current input.
+ */
+extern bool cppHasMacros (void)
+{
+	return (cmdlineMacroTable && hashTableCountItem (cmdlineMacroTable) > 0)
+		|| Cpp.fileMacroTable != NULL;
+}
+
 extern cppMacroArg *cppMacroArgNew (const char *str, bool free_str_when_deleting,
 									unsigned long lineNumber, MIOPos filePosition)
 {
@@ -25,6 +25,7 @@
 #include "read.h"
 #include "ptrarray.h"
 #include "trashbox.h"
+#include "xtag.h"
 
 #include <string.h>
 
@@ -1978,6 +1979,22 @@ bool cxxParserParseIfForWhileSwitchCatchParenthesis(void)
 	return true;
 }
 
+//
+// Check if function bodies can be scanned by cxxParserSkipFunctionBody()
+// instead of being parsed. This is possible when the kinds that are emitted
+// only from within function bodies are disabled and no macro replacement
+// may alter the bracket nesting.
+//
+static bool cxxParserCanSkipFunctionBodies(void)
+{
+	return !cxxTagKindEnabled(CXXTagKindLOCAL) &&
+		!cxxTagKindEnabled(CXXTagKindLABEL) &&
+		!cxxTagKindEnabled(CXXTagKindPARAMETER) &&
+		!cxxTagKindEnabled(CXXTagKindEXTERNVAR) &&
+		!isXtagEnabled(XTAG_REFERENCE_TAGS) &&
+		!cppHasMacros();
+}
+
 static rescanReason cxxParserMain(const unsigned int passCount)
 {
 	cxxScopeClear();
@@ -2015,6 +2032,8 @@ static rescanReason cxxParserMain(const unsigned int passCount)
 
 	g_cxx.bInCXX11Attribute = false;
 
+	g_cxx.bSkipFunctionBodies = cxxParserCanSkipFunctionBodies();
+
 	bool bRet = cxxParserParseBlock(false);
 
 	cppTerminate ();
@@ -29,6 +29,390 @@
 #include <string.h>
 
 static bool cxxParserParseBlockFull(bool bExpectClosingBracket, bool bExported);
+static bool cxxParserParseBlockInternal(bool bExpectClosingBracket, bool bExported);
+
+// The maximum number of nested subchains and statement prefix keywords
+// tracked by cxxParserSkipFunctionBody()
+#define CXX_PARSER_SKIP_MAXIMUM_SUBCHAINS 64
+#define CXX_PARSER_SKIP_MAXIMUM_PREFIX_KEYWORDS 8
+
+//
+// Give back to the input what cxxParserSkipFunctionBody() needs to be
+// parsed by cxxParserParseBlockInternal(): the opening characters of the
+// subchains we're in followed by the keywords at the beginning of the
+// current statement.
+//
+// The given back text is reported at the current line. This is exact
+// for the last token, which is what tags are made from.
+//
+static void cxxParserSkipFunctionBodyUnget(
+		const char * aSubchains,
+		int iSubchains,
+		const CXXKeyword * aKeywords,
+		int iKeywords
+	)
+{
+	vString * pText = vStringNew();
+
+	if(iSubchains > 0)
+		vStringNCatSUnsafe(pText,aSubchains,iSubchains);
+	for(int i = 0;i < iKeywords;i++)
+	{
+		if(i > 0)
+			vStringPut(pText,' ');
+		vStringCatS(pText,cxxKeywordName(aKeywords[i]));
+	}
+
+	cppUngetc(g_cxx.iChar);
+	cppUngetString(vStringValue(pText),vStringLength(pText));
+	g_cxx.iChar = cppGetc();
+
+	vStringDelete(pText);
+}
+
+static bool cxxParserSkipFunctionBodyKeywordBeginsDeclaration(CXXKeyword eKeyword)
+{
+	switch(eKeyword)
+	{
+		case CXXKeywordSTRUCT:
+		case CXXKeywordUNION:
+		case CXXKeywordENUM:
+		case CXXKeywordCLASS:
+		case CXXKeywordTYPEDEF:
+		case CXXKeywordUSING:
+		case CXXKeywordNAMESPACE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool cxxParserSkipFunctionBodyKeywordIsQualifier(CXXKeyword eKeyword)
+{
+	switch(eKeyword)
+	{
+		case CXXKeywordSTATIC:
+		case CXXKeywordCONST:
+		case CXXKeywordVOLATILE:
+		case CXXKeywordEXTERN:
+		case CXXKeywordREGISTER:
+		case CXXKeywordINLINE:
+		case CXXKeywordCONSTEXPR:
+		case CXXKeywordCONSTINIT:
+		case CXXKeywordTHREAD_LOCAL:
+		case CXXKeyword_THREAD_LOCAL:
+		case CXXKeyword__THREAD:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//
+// Scan a function body without analyzing its statements. This is called
+// just after the opening bracket of the body and returns just after the
+// matching closing bracket, like cxxParserParseBlockFull() does.
+//
+// cppGetc() already takes care of comments, string and character literals
+// (raw string literals included), preprocessor directives and line counting.
+// Here we only track the nesting of brackets and parentheses and call the
+// preprocessor and subparser hooks where cxxParserParseBlockInternal()
+// would call them, so the same preprocessor conditional branches are chosen.
+//
+// Local structs, unions, enums, classes, typedefs and lambdas produce tags
+// even when g_cxx.bSkipFunctionBodies is set. When one of them may begin,
+// the relevant part of the input is given back and the rest of the current
+// block is parsed by cxxParserParseBlockInternal().
+//
+static bool cxxParserSkipFunctionBody(bool bExported)
+{
+	CXX_DEBUG_ENTER();
+
+	// The opening characters of the (), [] and {} subchains we're in.
+	// The {} subchains are initializer lists.
+	char aSubchains[CXX_PARSER_SKIP_MAXIMUM_SUBCHAINS];
+	int iSubchains = 0;
+
+	// The qualifiers just before the current token
+	CXXKeyword aPrefix[CXX_PARSER_SKIP_MAXIMUM_PREFIX_KEYWORDS + 1];
+	int iPrefix = 0;
+
+	// The number of blocks we're in, including the body itself
+	int iBlocks = 1;
+
+	// The type of the previous token. CXXTokenTypeEOF is used
+	// at the beginning of a statement.
+	enum CXXTokenType ePrevious = CXXTokenTypeEOF;
+	bool bSeenReturn = false;
+	bool bSeenCase = false;
+	// if, for, while, switch or catch seen: the parenthesis follows
+	bool bSeenControlKeyword = false;
+	bool bInControlParenthesis = false;
+
+	bool bIsCPP = cxxParserCurrentLanguageIsCPP();
+	CXXKeyword eKeyword;
+
+	cxxSubparserNotifyEnterBlock();
+	cppPushExternalParserBlock();
+
+	// See cxxParserParseBlockInternal()
+	cxxParserNewStatementFull(bExported);
+	cppBeginStatement();
+
+	for(;;)
+	{
+		enum CXXTokenType eType = cxxParserSkipNextToken(&eKeyword);
+
+		switch(eType)
+		{
+			case CXXTokenTypeEOF:
+				CXX_DEBUG_LEAVE_TEXT("Syntax error: found EOF in function body");
+				goto failed;
+			case CXXTokenTypeKeyword:
+				if(iSubchains == 0)
+				{
+					// Not only at the beginning of a statement: a macro
+					// invocation without a trailing semicolon may precede
+					// the declaration.
+					if(
+						cxxParserSkipFunctionBodyKeywordBeginsDeclaration(eKeyword) &&
+						(
+							// do not trigger on X<struct Y>, like cxxParserParseBlockInternal()
+							(iPrefix > 0) ||
+							(
+								(eKeyword != CXXKeywordSTRUCT) &&
+								(eKeyword != CXXKeywordCLASS) &&
+								(eKeyword != CXXKeywordUNION)
+							) ||
+							(
+								(ePrevious != CXXTokenTypeSmallerThanSign) &&
+								(ePrevious != CXXTokenTypeComma)
+							)
+						)
+					)
+					{
+						CXX_DEBUG_PRINT(
+								"Found %s: parsing the rest of the block",
+								cxxKeywordName(eKeyword)
+							);
+						aPrefix[iPrefix++] = eKeyword;
+						cxxParserSkipFunctionBodyUnget(NULL,0,aPrefix,iPrefix);
+						goto parse_block;
+					}
+
+					if(
+						cxxParserSkipFunctionBodyKeywordIsQualifier(eKeyword) &&
+						(iPrefix < CXX_PARSER_SKIP_MAXIMUM_PREFIX_KEYWORDS)
+					)
+					{
+						aPrefix[iPrefix++] = eKeyword;
+						continue;
+					}
+				}
+
+				switch(eKeyword)
+				{
+					case CXXKeywordRETURN:
+						if(bIsCPP && (iSubchains == 0))
+						{
+							// may be followed by an initializer list or a lambda
+							cppEndStatement();
+							bSeenReturn = true;
+							ePrevious = CXXTokenTypeEOF;
+							continue;
+						}
+					break;
+					case CXXKeywordTRY:
+						if(ePrevious != CXXTokenTypeEOF)
+							break;
+						// fall through
+					case CXXKeywordELSE:
+					case CXXKeywordDO:
+						if(iSubchains == 0)
+						{
+							ePrevious = CXXTokenTypeEOF;
+							continue;
+						}
+					break;
+					case CXXKeywordIF:
+					case CXXKeywordFOR:
+					case CXXKeywordWHILE:
+					case CXXKeywordSWITCH:
+					case CXXKeywordCATCH:
+						if(iSubchains == 0)
+							bSeenControlKeyword = true;
+					break;
+					case CXXKeywordCASE:
+						if(iSubchains == 0)
+							bSeenCase = true;
+					break;
+					default:
+					break;
+				}
+			break;
+			case CXXTokenTypeSemicolon:
+				if(iSubchains > 0)
+					break;
+				cppEndStatement();
+				goto new_statement;
+			case CXXTokenTypeSingleColon:
+				if(!bSeenCase || (iSubchains > 0))
+					break;
+				cppEndStatement();
+				goto new_statement;
+			case CXXTokenTypeOpeningParenthesis:
+			case CXXTokenTypeOpeningSquareParenthesis:
+			case CXXTokenTypeOpeningBracket:
+				if(
+					(eType == CXXTokenTypeOpeningBracket) &&
+					(iSubchains == 0) &&
+					(
+						// initializer lists: see cxxParserParseBlockHandleOpeningBracket()
+						(ePrevious != CXXTokenTypeAssignment) &&
+						(
+							!bIsCPP ||
+							(
+								(ePrevious != CXXTokenTypeIdentifier) &&
+								(ePrevious != CXXTokenTypeClosingSquareParenthesis) &&
+								((ePrevious != CXXTokenTypeEOF) || !bSeenReturn)
+							)
+						)
+					)
+				)
+				{
+					// a nested block
+					cxxSubparserNotifyEnterBlock();
+					cppPushExternalParserBlock();
+					iBlocks++;
+					goto new_statement;
+				}
+
+				if(iSubchains == CXX_PARSER_SKIP_MAXIMUM_SUBCHAINS)
+				{
+					CXX_DEBUG_PRINT("Subchains nested too deep: parsing the rest of the block");
+					cxxParserSkipFunctionBodyUnget(aSubchains,iSubchains,NULL,0);
+					goto parse_block;
+				}
+
+				aSubchains[iSubchains++] =
+					(eType == CXXTokenTypeOpeningParenthesis) ? '(' :
+					(eType == CXXTokenTypeOpeningSquareParenthesis) ? '[' : '{';
+
+				if(
+					bIsCPP &&
+					(eType == CXXTokenTypeOpeningSquareParenthesis) &&
+					!(ePrevious & (
+							CXXTokenTypeIdentifier | CXXTokenTypeKeyword |
+							CXXTokenTypeNumber | CXXTokenTypeStringConstant |
+							CXXTokenTypeCharacterConstant |
+							CXXTokenTypeClosingParenthesis |
+							CXXTokenTypeClosingSquareParenthesis |
+							CXXTokenTypeClosingBracket
+						))
+				)
+				{
+					CXX_DEBUG_PRINT("Found a possible lambda: parsing the rest of the block");
+					cxxParserSkipFunctionBodyUnget(aSubchains,iSubchains,NULL,0);
+					goto parse_block;
+				}
+
+				if(
+					bSeenControlKeyword &&
+					(eType == CXXTokenTypeOpeningParenthesis) &&
+					(iSubchains == 1)
+				)
+				{
+					bSeenControlKeyword = false;
+					bInControlParenthesis = true;
+				}
+			break;
+			case CXXTokenTypeClosingParenthesis:
+			case CXXTokenTypeClosingSquareParenthesis:
+			case CXXTokenTypeClosingBracket:
+				if(iSubchains > 0)
+				{
+					char cOpening = aSubchains[--iSubchains];
+					if(
+						(eType == CXXTokenTypeClosingParenthesis) ? (cOpening != '(') :
+						(eType == CXXTokenTypeClosingSquareParenthesis) ? (cOpening != '[') :
+						(cOpening != '{')
+					)
+					{
+						CXX_DEBUG_LEAVE_TEXT("Mismatched subchain terminator");
+						goto failed;
+					}
+
+					if(bInControlParenthesis && (iSubchains == 0))
+					{
+						// see cxxParserParseBlockInternal(): the statement begins again
+						bInControlParenthesis = false;
+						ePrevious = CXXTokenTypeEOF;
+						bSeenReturn = false;
+						continue;
+					}
+					break;
+				}
+
+				if(eType != CXXTokenTypeClosingBracket)
+					break; // ignored by cxxParserParseBlockInternal() too
+
+				// end of a block
+				cxxParserNewStatement();
+				cppPopExternalParserBlock();
+				cxxSubparserNotifyLeaveBlock();
+				iBlocks--;
+
+				if(iBlocks == 0)
+				{
+					CXX_DEBUG_LEAVE_TEXT("Skipped function body");
+					return true;
+				}
+			goto new_statement;
+			default:
+			break;
+		}
+
+		iPrefix = 0;
+		ePrevious = eType;
+		continue;
+
+parse_block:
+		if(!cxxParserParseBlockInternal(true,bExported && (iBlocks == 1)))
+		{
+			CXX_DEBUG_LEAVE_TEXT("Failed to parse the rest of the block");
+			goto failed;
+		}
+
+		cppPopExternalParserBlock();
+		cxxSubparserNotifyLeaveBlock();
+		iBlocks--;
+
+		if(iBlocks == 0)
+		{
+			CXX_DEBUG_LEAVE_TEXT("Parsed the rest of the function body");
+			return true;
+		}
+
+		iSubchains = 0;
+
+new_statement:
+		iPrefix = 0;
+		ePrevious = CXXTokenTypeEOF;
+		bSeenReturn = false;
+		bSeenCase = false;
+		bSeenControlKeyword = false;
+		bInControlParenthesis = false;
+	}
+
+failed:
+	while(iBlocks > 0)
+	{
+		cppPopExternalParserBlock();
+		cxxSubparserNotifyLeaveBlock();
+		iBlocks--;
+	}
+	return false;
+}
 
 bool cxxParserParseBlockHandleOpeningBracket(void)
 {
@@ -169,7 +553,19 @@ bool cxxParserParseBlockHandleOpeningBracket(void)
 
 	cxxParserNewStatementFull(bExported);
 
-	if(!cxxParserParseBlockFull(true, bExported))
+	bool bRet;
+
+	if(
+		(iScopes > 0) &&
+		g_cxx.bSkipFunctionBodies &&
+		(!g_cxx.pUngetToken) &&
+		(cxxScopeGetType() == CXXScopeTypeFunction)
+	)
+		bRet = cxxParserSkipFunctionBody(bExported);
+	else
+		bRet = cxxParserParseBlockFull(true, bExported);
+
+	if(!bRet)
 	{
 		CXX_DEBUG_LEAVE_TEXT("Failed to parse nested block");
 		return false;
@@ -36,6 +36,7 @@ typedef enum _CXXLanguage
 // cxx_parser_tokenizer.c
 bool cxxParserParseNextToken(void);
 void cxxParserUngetCurrentToken(void);
+enum CXXTokenType cxxParserSkipNextToken(CXXKeyword * peKeyword);
 
 // cxx_parser_lambda.c
 CXXToken * cxxParserOpeningBracketIsLambda(void);
@@ -386,6 +387,12 @@ typedef struct _CXXParserState
 	// bInCXX11Attribute guards the function being called recursively.
 	bool bInCXX11Attribute;
 
+	// The statements in function bodies are not analyzed: the bodies are
+	// scanned by cxxParserSkipFunctionBody() instead. Set by cxxParserMain()
+	// when no kind that is emitted only from within function bodies is
+	// enabled.
+	bool bSkipFunctionBodies;
+
 } CXXParserState;
 
 
@@ -29,7 +29,10 @@
 static void cxxParserSkipToNonWhiteSpace(void)
 {
 	while(cppIsspace(g_cxx.iChar))
+	{
+		cppSkipSpaces();
 		g_cxx.iChar = cppGetc();
+	}
 }
 
 enum CXXCharType
@@ -1357,6 +1360,12 @@ bool cxxParserParseNextToken(void)
 			if(!(uInfo & CXXCharTypePartOfIdentifier))
 				break;
 			vStringPut(t->pszWord,g_cxx.iChar);
+
+			const unsigned char * pChars;
+			size_t uCount = cppReadIdentifierChars(&pChars);
+			if(uCount > 0)
+				vStringNCatSUnsafe(t->pszWord,(const char *)pChars,uCount);
+
 			g_cxx.iChar = cppGetc();
 		}
 
@@ -1733,3 +1742,130 @@ bool cxxParserParseNextToken(void)
 
 	return true;
 }
+
+// Longer words can't be keywords
+#define CXX_PARSER_MAXIMUM_KEYWORD_LENGTH 32
+
+//
+// A lightweight version of cxxParserParseNextToken() used to scan input
+// that doesn't need to be analyzed. It reads the next token without creating
+// a CXXToken and returns its type. If the token is a keyword then *peKeyword
+// is set to its id.
+//
+// Macros are not expanded and [[...]] attributes are not condensed.
+// The caller is expected to handle g_cxx.pUngetToken itself.
+//
+enum CXXTokenType cxxParserSkipNextToken(CXXKeyword * peKeyword)
+{
+	cxxParserSkipToNonWhiteSpace();
+
+	// See cxxParserParseNextToken()
+	cppBeginStatement();
+
+	if(g_cxx.iChar == EOF)
+		return CXXTokenTypeEOF;
+
+	unsigned int uInfo = UINFO(g_cxx.iChar);
+
+	if(uInfo & CXXCharTypeStartOfIdentifier)
+	{
+		char szWord[CXX_PARSER_MAXIMUM_KEYWORD_LENGTH + 1];
+		size_t uLength = 0;
+
+		do {
+			if(uLength < CXX_PARSER_MAXIMUM_KEYWORD_LENGTH)
+				szWord[uLength] = (char)g_cxx.iChar;
+			uLength++;
+
+			const unsigned char * pChars;
+			size_t uCount = cppReadIdentifierChars(&pChars);
+			for(size_t i = 0;i < uCount;i++)
+			{
+				if(uLength < CXX_PARSER_MAXIMUM_KEYWORD_LENGTH)
+					szWord[uLength] = (char)pChars[i];
+				uLength++;
+			}
+
+			g_cxx.iChar = cppGetc();
+		} while(UINFO(g_cxx.iChar) & CXXCharTypePartOfIdentifier);
+
+		if(uLength > CXX_PARSER_MAXIMUM_KEYWORD_LENGTH)
+			return CXXTokenTypeIdentifier;
+
+		szWord[uLength] = '\0';
+
+		int iCXXKeyword = lookupKeyword(szWord,g_cxx.eLangType);
+		if((iCXXKeyword < 0) || cxxKeywordIsDisabled((CXXKeyword)iCXXKeyword))
+		{
+			// The coroutine operators are not keywords for the full parser
+			// but, like return, they may be followed by a lambda: don't let
+			// the caller take a following [ for a subscript.
+			if(
+					cxxParserCurrentLanguageIsCPP() &&
+					(
+						(strcmp(szWord,"co_await") == 0) ||
+						(strcmp(szWord,"co_yield") == 0) ||
+						(strcmp(szWord,"co_return") == 0)
+					)
+				)
+				return CXXTokenTypeOperator;
+			return CXXTokenTypeIdentifier;
+		}
+
+		*peKeyword = (CXXKeyword)iCXXKeyword;
+		return CXXTokenTypeKeyword;
+	}
+
+	if(g_cxx.iChar == CPP_STRING_SYMBOL)
+	{
+		g_cxx.iChar = cppGetc();
+		return CXXTokenTypeStringConstant;
+	}
+
+	if(g_cxx.iChar == CPP_CHAR_SYMBOL)
+	{
+		g_cxx.iChar = cppGetc();
+		return CXXTokenTypeCharacterConstant;
+	}
+
+	if(uInfo & CXXCharTypeDecimalDigit)
+	{
+		do {
+			g_cxx.iChar = cppGetc();
+		} while(UINFO(g_cxx.iChar) & CXXCharTypeValidInNumber);
+		return CXXTokenTypeNumber;
+	}
+
+	if(uInfo & CXXCharTypeNamedSingleOrRepeatedCharToken)
+	{
+		enum CXXTokenType eType = g_aCharTable[g_cxx.iChar].uSingleTokenType;
+		int iChar = g_cxx.iChar;
+		g_cxx.iChar = cppGetc();
+		if(g_cxx.iChar == iChar)
+		{
+			eType = g_aCharTable[iChar].uMultiTokenType;
+			do {
+				g_cxx.iChar = cppGetc();
+			} while(g_cxx.iChar == iChar);
+		}
+		return eType;
+	}
+
+	if(uInfo & (CXXCharTypeNamedSingleCharToken | CXXCharTypeCustomHandling))
+	{
+		enum CXXTokenType eType = g_aCharTable[g_cxx.iChar].uSingleTokenType;
+		g_cxx.iChar = cppGetc();
+		return eType;
+	}
+
+	if(uInfo & CXXCharTypeOperator)
+	{
+		do {
+			g_cxx.iChar = cppGetc();
+		} while(UINFO(g_cxx.iChar) & CXXCharTypeOperator);
+		return CXXTokenTypeOperator;
+	}
+
+	g_cxx.iChar = cppGetc();
+	return CXXTokenTypeUnknown;
+}
@@ -1023,7 +1023,7 @@ static bool parseClassName (tokenInfo *const token)
 
 		if (klass)
 		{
-			eFree ((void *)klass->name);
+			freeTagEntryString (klass, klass->name);
 			klass->name = name;
 			name = NULL;
 			unmarkTagExtraBit (klass, XTAG_ANONYMOUS);
@@ -1047,7 +1047,7 @@ static bool parseClassName (tokenInfo *const token)
 				if (klass)
 				{
 					if (klass->extensionFields.inheritance)
-						eFree ((void *)klass->extensionFields.inheritance);
+						freeTagEntryString (klass, klass->extensionFields.inheritance);
 					klass->extensionFields.inheritance = vStringStrdup (token->string);
 				}
 				else
@@ -1085,7 +1085,7 @@ static bool parseExtends (tokenInfo *const token)
 				if (klass)
 				{
 					if (klass->extensionFields.inheritance)
-						eFree ((void *)klass->extensionFields.inheritance);
+						freeTagEntryString (klass, klass->extensionFields.inheritance);
 					klass->extensionFields.inheritance = vStringStrdup (token->string);
 				}
 			}
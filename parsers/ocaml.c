@@ -2004,6 +2004,8 @@ static void findOcamlTags (void)
 	ocaToken nextTok;
 
 	initStack ();
+	needStrongPoping = false;
+	dirtySpecialParam = false;
 
 	tempIdent = vStringNew ();
 	lastModule = vStringNew ();
@@ -348,7 +348,7 @@ static bool findExtendsClass (const char *line,
 		&& vStringLength (str) > 0)
 	{
 		if (e->extensionFields.inheritance)
-			eFree ((void *)e->extensionFields.inheritance);
+			freeTagEntryString (e, e->extensionFields.inheritance);
 		e->extensionFields.inheritance = vStringStrdup (str);
 	}
 
@@ -377,7 +377,7 @@ static bool findExtendsClassContinuation (const char *line,
 		&& vStringLength (str) > 0)
 	{
 		if (e->extensionFields.inheritance)
-			eFree ((void *)e->extensionFields.inheritance);
+			freeTagEntryString (e, e->extensionFields.inheritance);
 		e->extensionFields.inheritance = vStringStrdup (str);
 	}
 
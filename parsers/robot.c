@@ -46,6 +46,7 @@ static xtagDefinition RobotXtags [] = {
 
 static void findRobotTags (void)
 {
+	section = -1;
 	findRegexTags ();
 }
 
@@ -159,6 +159,7 @@ static void findSmlTags (void)
 	const unsigned char *line;
 	smlKind lastTag = K_NONE;
 
+	CommentLevel = 0;
 	while ((line = readLineFromInputFile ()) != NULL)
 	{
 		const unsigned char *cp = skipSpace (line);
@@ -108,6 +108,12 @@ extern void cppUngetc (const int c);
 extern int cppUngetBufferSize(void);
 extern void cppUngetString(const char * string,int len);
 extern int cppGetc (void);
+
+/* Faster ways to read what cppGetc () returns as it is: runs of identifier
+ * characters, and runs of spaces and tabs outside directives. */
+extern size_t cppReadIdentifierChars (const unsigned char **chars);
+extern void cppSkipSpaces (void);
+
 extern const vString * cppGetLastCharOrStringContents (void);
 
 /*
@@ -194,6 +200,7 @@ typedef struct sCppMacroArg cppMacroArg;
  *
  */
 extern cppMacroInfo * cppFindMacro (const char *const name);
+extern bool cppHasMacros (void);
 extern void cppUngetMacroTokens (cppMacroTokens *tokens);
 
 extern cppMacroArg *cppMacroArgNew (const char *str, bool free_str_when_deleting,
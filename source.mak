@@ -65,6 +65,11 @@ UTILTEST_SRCS  = \
 	$(NULL)
 UTILTEST_OBJS = $(UTILTEST_SRCS:.c=.$(OBJEXT))
 
+HTABLE_BENCH_SRCS = \
+	extra-cmds/htable-bench.c \
+	\
+	$(NULL)
+
 MAIN_PUBLIC_HEADS =		\
 	$(UTIL_PUBLIC_HEADS)	\
 	\
@@ -102,6 +107,8 @@ LIB_PRIVATE_HEADS =		\
 	$(UTIL_PRIVATE_HEADS)	\
 	\
 	main/args_p.h		\
+	main/arena_p.h		\
+	main/cache_p.h		\
 	main/colprint_p.h	\
 	main/dependency_p.h	\
 	main/entry_p.h		\
@@ -109,7 +116,9 @@ LIB_PRIVATE_HEADS =		\
 	main/field_p.h		\
 	main/flags_p.h		\
 	main/fmt_p.h		\
+	main/fnmatcher_p.h	\
 	main/interactive_p.h	\
+	main/jobs_p.h		\
 	main/keyword_p.h	\
 	main/kind_p.h		\
 	main/lregex_p.h		\
@@ -128,7 +137,9 @@ LIB_PRIVATE_HEADS =		\
 	main/sort_p.h		\
 	main/stats_p.h		\
 	main/subparser_p.h	\
+	main/tagindex_p.h	\
 	main/trashbox_p.h	\
+	main/update_p.h		\
 	main/utf8_str.h		\
 	main/writer_p.h		\
 	main/xtag_p.h		\
@@ -146,7 +157,9 @@ LIB_HEADS =			\
 LIB_SRCS =			\
 	$(UTIL_SRCS)			\
 	\
+	main/arena.c			\
 	main/args.c			\
+	main/cache.c			\
 	main/colprint.c			\
 	main/dependency.c		\
 	main/entry.c			\
@@ -155,10 +168,13 @@ LIB_SRCS =			\
 	main/field.c			\
 	main/flags.c			\
 	main/fmt.c			\
+	main/fnmatcher.c		\
+	main/jobs.c			\
 	main/keyword.c			\
 	main/kind.c			\
 	main/lregex.c			\
 	main/lregex-default.c		\
+	main/lregex-prefilter.c		\
 	main/lxpath.c			\
 	main/main.c			\
 	main/mbcs.c			\
@@ -178,11 +194,14 @@ LIB_SRCS =			\
 	main/sort.c			\
 	main/stats.c			\
 	main/strlist.c			\
+	main/tagindex.c			\
 	main/trace.c			\
 	main/tokeninfo.c		\
 	main/unwindi.c			\
+	main/update.c			\
 	main/utf8_str.c			\
 	main/writer.c			\
+	main/writer-binary.c		\
 	main/writer-etags.c		\
 	main/writer-ctags.c		\
 	main/writer-json.c		\